@@ -28,8 +28,17 @@
  * and removal of actors. It is bound to a particular stage, and spreads
  * operations over time so as not to interrupt animations or interactivity.
  *
- * Operations added to the #MxActorManager will strictly be performed in the
- * order in which they were added.
+ * By default, a fixed amount of time is spent on operations in between
+ * frames (see #MxActorManager:time-slice). When
+ * #MxActorManager:target-frame-time is set, the manager instead measures
+ * how long each frame takes to lay out and paint, and sizes the time spent
+ * on operations so that the two together fit in the target frame time.
+ *
+ * Each operation has a priority, following the same convention as #GSource
+ * priorities: operations with a lower priority value are performed first.
+ * Operations of equal priority will strictly be performed in the order in
+ * which they were added. The functions that don't take a priority use
+ * %G_PRIORITY_DEFAULT.
  *
  * Since: 1.2
  */
@@ -53,9 +62,21 @@ enum
 
   PROP_STAGE,
   PROP_TIME_SLICE,
-  PROP_N_OPERATIONS
+  PROP_N_OPERATIONS,
+  PROP_TARGET_FRAME_TIME
 };
 
+/* The shortest slice used when adapting to the frame time, so operations
+ * still progress when frames overrun the target */
+#define MIN_TIME_SLICE 1
+
+/* The interval at which operations are processed when no frames are
+ * being painted, in ms */
+#define FALLBACK_FRAME_TIME 16
+
+/* The weight of a new sample in the moving averages */
+#define AVERAGE_WEIGHT 0.1
+
 enum
 {
   ACTOR_CREATED,
@@ -81,6 +102,8 @@ typedef struct
 {
   MxActorManager              *manager;
   gulong                       id;
+  gint                         priority;
+  GSequenceIter               *iter;
   MxActorManagerOperationType  type;
 
   MxActorManagerCreateFunc     create_func;
@@ -88,13 +111,26 @@ typedef struct
 
   ClutterActor                *actor;
   ClutterContainer            *container;
+
+  /* Links in the queues of operations for the actor and container */
+  GList                       *actor_link;
+  GList                       *container_link;
 } MxActorManagerOperation;
 
+typedef struct
+{
+  guint   n_operations;
+  gdouble average_time;
+  gdouble max_time;
+} MxActorManagerStats;
+
 struct _MxActorManagerPrivate
 {
-  GQueue       *ops;
+  GSequence    *ops;
+  gulong        last_id;
 
-  GHashTable   *actor_op_links;
+  GHashTable   *ops_by_id;
+  GHashTable   *actor_ops;
 
   guint         source;
   gulong        post_paint_handler;
@@ -102,6 +138,13 @@ struct _MxActorManagerPrivate
   GTimer       *timer;
   guint         time_slice;
 
+  guint         target_frame_time;
+  guint         repaint_func;
+  gint64        frame_start;
+  gdouble       frame_time;
+  gdouble       operation_time;
+  GHashTable   *create_stats;
+
   ClutterStage *stage;
 
   guint         quark_set   : 1;
@@ -111,12 +154,13 @@ static guint signals[LAST_SIGNAL] = { 0, };
 
 static void mx_actor_manager_handle_op (MxActorManager *manager);
 
-static guint mx_actor_manager_increment_count (MxActorManager *manager,
-                                               gpointer        actor,
-                                               GList          *op_link);
+static GList *
+mx_actor_manager_increment_count (MxActorManager          *manager,
+                                  gpointer                 actor,
+                                  MxActorManagerOperation *op);
 static guint mx_actor_manager_decrement_count (MxActorManager *manager,
                                                gpointer        actor,
-                                               GList          *op_link);
+                                               GList          *link);
 
 static void mx_actor_manager_ensure_processing (MxActorManager *manager);
 
@@ -139,7 +183,11 @@ mx_actor_manager_get_property (GObject    *object,
       break;
 
     case PROP_N_OPERATIONS:
-      g_value_set_uint (value, g_queue_get_length (priv->ops));
+      g_value_set_uint (value, g_sequence_get_length (priv->ops));
+      break;
+
+    case PROP_TARGET_FRAME_TIME:
+      g_value_set_uint (value, priv->target_frame_time);
       break;
 
     default:
@@ -178,6 +226,10 @@ mx_actor_manager_set_property (GObject      *object,
       mx_actor_manager_set_time_slice (self, g_value_get_uint (value));
       break;
 
+    case PROP_TARGET_FRAME_TIME:
+      mx_actor_manager_set_target_frame_time (self, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -202,9 +254,16 @@ mx_actor_manager_dispose (GObject *object)
       priv->post_paint_handler = 0;
     }
 
-  while (g_queue_get_length (priv->ops))
+  if (priv->repaint_func)
+    {
+      clutter_threads_remove_repaint_func (priv->repaint_func);
+      priv->repaint_func = 0;
+    }
+
+  while (g_sequence_get_length (priv->ops))
     {
-      MxActorManagerOperation *op = g_queue_peek_head (priv->ops);
+      MxActorManagerOperation *op =
+        g_sequence_get (g_sequence_get_begin_iter (priv->ops));
       mx_actor_manager_cancel_operation (self, op->id);
     }
 
@@ -223,11 +282,11 @@ mx_actor_manager_dispose (GObject *object)
 }
 
 static void
-mx_actor_manager_free_op_links (gpointer key,
-                                gpointer value,
-                                gpointer userdata)
+mx_actor_manager_free_actor_ops (gpointer key,
+                                 gpointer value,
+                                 gpointer userdata)
 {
-  g_list_free (value);
+  g_queue_free (value);
 }
 
 static void
@@ -235,16 +294,24 @@ mx_actor_manager_finalize (GObject *object)
 {
   MxActorManagerPrivate *priv = MX_ACTOR_MANAGER (object)->priv;
 
-  g_queue_free (priv->ops);
-  g_hash_table_foreach (priv->actor_op_links,
-                        mx_actor_manager_free_op_links,
+  g_sequence_free (priv->ops);
+  g_hash_table_foreach (priv->actor_ops,
+                        mx_actor_manager_free_actor_ops,
                         NULL);
-  g_hash_table_unref (priv->actor_op_links);
+  g_hash_table_unref (priv->actor_ops);
+  g_hash_table_unref (priv->ops_by_id);
+  g_hash_table_unref (priv->create_stats);
   g_timer_destroy (priv->timer);
 
   G_OBJECT_CLASS (mx_actor_manager_parent_class)->finalize (object);
 }
 
+static void
+mx_actor_manager_stats_free (MxActorManagerStats *stats)
+{
+  g_slice_free (MxActorManagerStats, stats);
+}
+
 static void
 mx_actor_manager_class_init (MxActorManagerClass *klass)
 {
@@ -280,6 +347,16 @@ mx_actor_manager_class_init (MxActorManagerClass *klass)
                              MX_PARAM_READABLE);
   g_object_class_install_property (object_class, PROP_N_OPERATIONS, pspec);
 
+  pspec = g_param_spec_uint ("target-frame-time",
+                             "Target frame time",
+                             "The time each frame should take, including "
+                             "operations, in ms, or 0 to use a fixed "
+                             "time slice",
+                             0, G_MAXUINT, 0,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_TARGET_FRAME_TIME,
+                                   pspec);
+
   /**
    * MxActorManager::actor-created
    * @manager: the object that received the signal
@@ -429,10 +506,14 @@ mx_actor_manager_init (MxActorManager *self)
 {
   MxActorManagerPrivate *priv = self->priv = ACTOR_MANAGER_PRIVATE (self);
 
-  priv->ops = g_queue_new ();
-  priv->actor_op_links = g_hash_table_new (NULL, NULL);
+  priv->ops = g_sequence_new (NULL);
+  priv->ops_by_id = g_hash_table_new (NULL, NULL);
+  priv->actor_ops = g_hash_table_new (NULL, NULL);
   priv->timer = g_timer_new ();
   priv->time_slice = 5;
+  priv->create_stats =
+    g_hash_table_new_full (NULL, NULL, NULL,
+                           (GDestroyNotify)mx_actor_manager_stats_free);
 }
 
 /**
@@ -507,55 +588,78 @@ mx_actor_manager_get_stage (MxActorManager *manager)
   return manager->priv->stage;
 }
 
-static guint
-mx_actor_manager_increment_count (MxActorManager *manager,
-                                  gpointer        actor,
-                                  GList          *op_link)
+static GList *
+mx_actor_manager_increment_count (MxActorManager          *manager,
+                                  gpointer                 actor,
+                                  MxActorManagerOperation *op)
 {
-  GList *op_links;
+  GQueue *ops;
   MxActorManagerPrivate *priv = manager->priv;
 
-  op_links = g_hash_table_lookup (priv->actor_op_links, actor);
-  op_links = g_list_prepend (op_links, op_link);
+  ops = g_hash_table_lookup (priv->actor_ops, actor);
+  if (!ops)
+    {
+      ops = g_queue_new ();
+      g_hash_table_insert (priv->actor_ops, actor, ops);
+    }
 
-  g_hash_table_insert (priv->actor_op_links, actor, op_links);
+  g_queue_push_tail (ops, op);
 
-  return g_list_length (op_links);
+  return g_queue_peek_tail_link (ops);
 }
 
 static guint
 mx_actor_manager_decrement_count (MxActorManager *manager,
                                   gpointer        actor,
-                                  GList          *op_link)
+                                  GList          *link)
 {
   guint count;
-  GList *op_links;
+  GQueue *ops;
   MxActorManagerPrivate *priv = manager->priv;
 
-  op_links = g_hash_table_lookup (priv->actor_op_links, actor);
-  op_links = g_list_remove (op_links, op_link);
+  ops = g_hash_table_lookup (priv->actor_ops, actor);
+  g_queue_delete_link (ops, link);
 
-  count = g_list_length (op_links);
+  count = g_queue_get_length (ops);
 
   if (count == 0)
     {
-      g_hash_table_remove (priv->actor_op_links, actor);
+      g_hash_table_remove (priv->actor_ops, actor);
+      g_queue_free (ops);
       g_signal_emit (manager, signals[ACTOR_FINISHED], 0, actor);
     }
-  else
-    g_hash_table_insert (priv->actor_op_links, actor, op_links);
 
   return count;
 }
 
+static void
+mx_actor_manager_forget_actor (MxActorManager *manager,
+                               gpointer        actor,
+                               GList          *link)
+{
+  GQueue *ops;
+  MxActorManagerPrivate *priv = manager->priv;
+
+  /* Like mx_actor_manager_decrement_count(), but without signalling, as
+   * the actor is being destroyed */
+  ops = g_hash_table_lookup (priv->actor_ops, actor);
+  g_queue_delete_link (ops, link);
+
+  if (g_queue_is_empty (ops))
+    {
+      g_hash_table_remove (priv->actor_ops, actor);
+      g_queue_free (ops);
+    }
+}
+
 static void
 mx_actor_manager_actor_destroyed (gpointer  data,
                                   GObject  *old_actor)
 {
   MxActorManagerOperation *op = data;
-  MxActorManagerPrivate *priv = op->manager->priv;
 
-  g_hash_table_remove (priv->actor_op_links, old_actor);
+  mx_actor_manager_forget_actor (op->manager, old_actor, op->actor_link);
+  op->actor_link = NULL;
   op->actor = NULL;
 }
 
@@ -564,46 +668,67 @@ mx_actor_manager_container_destroyed (gpointer  data,
                                       GObject  *old_actor)
 {
   MxActorManagerOperation *op = data;
-  MxActorManagerPrivate *priv = op->manager->priv;
 
-  g_hash_table_remove (priv->actor_op_links, old_actor);
+  mx_actor_manager_forget_actor (op->manager, old_actor, op->container_link);
+  op->container_link = NULL;
   op->container = NULL;
 }
 
+static gint
+mx_actor_manager_op_compare (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      userdata)
+{
+  const MxActorManagerOperation *op_a = a;
+  const MxActorManagerOperation *op_b = b;
+
+  if (op_a->priority != op_b->priority)
+    return (op_a->priority < op_b->priority) ? -1 : 1;
+
+  /* Operation IDs increase monotonically, so this keeps operations of the
+   * same priority in the order they were added */
+  if (op_a->id != op_b->id)
+    return (op_a->id < op_b->id) ? -1 : 1;
+
+  return 0;
+}
+
 static MxActorManagerOperation *
 mx_actor_manager_op_new (MxActorManager              *manager,
+                         gint                         priority,
                          MxActorManagerOperationType  type,
                          MxActorManagerCreateFunc     create_func,
                          gpointer                     userdata,
                          ClutterActor                *actor,
                          ClutterContainer            *container)
 {
-  GList *op_link;
   MxActorManagerPrivate *priv = manager->priv;
   MxActorManagerOperation *op = g_slice_new0 (MxActorManagerOperation);
 
   op->manager = manager;
 
-  if (g_queue_peek_tail (priv->ops))
-    op->id = ((MxActorManagerOperation *)g_queue_peek_tail (priv->ops))->id + 1;
-  else
-    op->id = 1;
+  if (++priv->last_id == 0)
+    priv->last_id = 1;
+  op->id = priv->last_id;
 
+  op->priority = priority;
   op->type = type;
   op->create_func = create_func;
   op->userdata = userdata;
   op->actor = actor;
   op->container = container;
 
-  g_queue_push_tail (priv->ops, op);
-  op_link = g_queue_peek_tail_link (priv->ops);
+  op->iter = g_sequence_insert_sorted (priv->ops, op,
+                                       mx_actor_manager_op_compare,
+                                       NULL);
+  g_hash_table_insert (priv->ops_by_id, GSIZE_TO_POINTER (op->id), op);
 
   if (actor)
     {
       g_object_weak_ref (G_OBJECT (actor),
                          mx_actor_manager_actor_destroyed,
                          op);
-      mx_actor_manager_increment_count (manager, actor, op_link);
+      op->actor_link = mx_actor_manager_increment_count (manager, actor, op);
 
       if (type == MX_ACTOR_MANAGER_ADD)
         g_object_ref_sink (actor);
@@ -614,23 +739,23 @@ mx_actor_manager_op_new (MxActorManager              *manager,
       g_object_weak_ref (G_OBJECT (container),
                          mx_actor_manager_container_destroyed,
                          op);
-      mx_actor_manager_increment_count (manager, container, op_link);
+      op->container_link =
+        mx_actor_manager_increment_count (manager, container, op);
     }
 
   return op;
 }
 
 static void
-mx_actor_manager_op_free (MxActorManager *manager,
-                          GList          *op_link,
-                          gboolean        _remove)
+mx_actor_manager_op_free (MxActorManager          *manager,
+                          MxActorManagerOperation *op,
+                          gboolean                 _remove)
 {
-  MxActorManagerOperation *op = op_link->data;
-  MxActorManagerPrivate *priv = manager->priv;
+  g_hash_table_remove (manager->priv->ops_by_id, GSIZE_TO_POINTER (op->id));
 
   if (op->actor)
     {
-      mx_actor_manager_decrement_count (manager, op->actor, op_link);
+      mx_actor_manager_decrement_count (manager, op->actor, op->actor_link);
       g_object_weak_unref (G_OBJECT (op->actor),
                            mx_actor_manager_actor_destroyed,
                            op);
@@ -641,32 +766,79 @@ mx_actor_manager_op_free (MxActorManager *manager,
 
   if (op->container)
     {
-      mx_actor_manager_decrement_count (manager, op->container, op_link);
+      mx_actor_manager_decrement_count (manager, op->container,
+                                        op->container_link);
       g_object_weak_unref (G_OBJECT (op->container),
                            mx_actor_manager_container_destroyed,
                            op);
     }
 
   if (_remove)
-    g_queue_delete_link (priv->ops, op_link);
+    g_sequence_remove (op->iter);
 
   g_slice_free (MxActorManagerOperation, op);
 }
 
+static void
+mx_actor_manager_update_stats (MxActorManager          *manager,
+                               MxActorManagerOperation *op,
+                               gdouble                  elapsed)
+{
+  MxActorManagerStats *stats;
+  MxActorManagerPrivate *priv = manager->priv;
+
+  if (priv->operation_time > 0)
+    priv->operation_time += (elapsed - priv->operation_time) * AVERAGE_WEIGHT;
+  else
+    priv->operation_time = elapsed;
+
+  if (op->type != MX_ACTOR_MANAGER_CREATE)
+    return;
+
+  stats = g_hash_table_lookup (priv->create_stats,
+                               (gpointer)op->create_func);
+  if (!stats)
+    {
+      stats = g_slice_new0 (MxActorManagerStats);
+      g_hash_table_insert (priv->create_stats,
+                           (gpointer)op->create_func,
+                           stats);
+    }
+
+  stats->n_operations++;
+  stats->average_time += (elapsed - stats->average_time) / stats->n_operations;
+  stats->max_time = MAX (stats->max_time, elapsed);
+}
+
 static void
 mx_actor_manager_handle_op (MxActorManager *manager)
 {
   ClutterActor *actor;
   MxActorManagerOperation *op;
 
+  gint64 start;
+  gdouble elapsed;
+
   GError *error = NULL;
   MxActorManagerPrivate *priv = manager->priv;
-  GList *op_link = g_queue_peek_head_link (priv->ops);
+  GSequenceIter *iter = g_sequence_get_begin_iter (priv->ops);
 
-  if (!op_link)
+  if (g_sequence_iter_is_end (iter))
     return;
 
-  op = op_link->data;
+  op = g_sequence_get (iter);
+
+  /* Unlink the operation before performing it, so that a signal handler
+   * cancelling it by ID can't free it from under us. It stays in the
+   * queues of its actor and container until it's freed, so that
+   * #MxActorManager::actor-finished is emitted after the operation
+   * completes; mx_actor_manager_cancel_operations() skips it there.
+   */
+  g_hash_table_remove (priv->ops_by_id, GSIZE_TO_POINTER (op->id));
+  g_sequence_remove (iter);
+  op->iter = NULL;
+
+  start = g_get_monotonic_time ();
 
   /* We want the actor and container to remain alive during this function,
    * for the purposes of signal emission.
@@ -765,7 +937,22 @@ mx_actor_manager_handle_op (MxActorManager *manager)
   if (op->container)
     g_object_unref (op->container);
 
-  mx_actor_manager_op_free (manager, op_link, TRUE);
+  elapsed = (g_get_monotonic_time () - start) / 1000.0;
+  mx_actor_manager_update_stats (manager, op, elapsed);
+
+  mx_actor_manager_op_free (manager, op, FALSE);
+}
+
+static gboolean
+mx_actor_manager_pre_frame_cb (MxActorManager *manager)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+
+  /* Repaint functions run before the stages are laid out and painted */
+  priv->frame_start = g_get_monotonic_time ();
+  priv->repaint_func = 0;
+
+  return FALSE;
 }
 
 static void
@@ -777,38 +964,107 @@ mx_actor_manager_post_paint_cb (ClutterActor   *stage,
   g_signal_handler_disconnect (stage, priv->post_paint_handler);
   priv->post_paint_handler = 0;
 
+  if (priv->frame_start)
+    {
+      gdouble frame_time =
+        (g_get_monotonic_time () - priv->frame_start) / 1000.0;
+
+      if (priv->frame_time > 0)
+        priv->frame_time += (frame_time - priv->frame_time) * AVERAGE_WEIGHT;
+      else
+        priv->frame_time = frame_time;
+
+      priv->frame_start = 0;
+    }
+
+  /* Remove the fallback timeout, operations continue now that the frame
+   * has been painted */
+  if (priv->source)
+    {
+      g_source_remove (priv->source);
+      priv->source = 0;
+    }
+
   mx_actor_manager_ensure_processing (manager);
 }
 
+static gdouble
+mx_actor_manager_get_slice (MxActorManager *manager)
+{
+  MxActorManagerPrivate *priv = manager->priv;
+
+  if (!priv->target_frame_time || priv->frame_time <= 0)
+    return priv->time_slice;
+
+  return MAX (MIN_TIME_SLICE, priv->target_frame_time - priv->frame_time);
+}
+
 static gboolean
 mx_actor_manager_process_operations (MxActorManager *manager)
 {
+  gdouble slice;
   MxActorManagerPrivate *priv = manager->priv;
 
   priv->source = 0;
 
+  slice = mx_actor_manager_get_slice (manager);
+
   g_timer_start (priv->timer);
 
-  while (!g_queue_is_empty (priv->ops))
+  while (g_sequence_get_length (priv->ops))
     {
+      gdouble elapsed;
+
       mx_actor_manager_handle_op (manager);
 
-      if (priv->stage &&
-          g_timer_elapsed (priv->timer, NULL) * 1000 >= priv->time_slice)
+      if (!priv->stage)
+        continue;
+
+      /* Stop if the slice is used up, or if the next operation would
+       * likely overrun it */
+      elapsed = g_timer_elapsed (priv->timer, NULL) * 1000;
+      if (elapsed >= slice ||
+          (priv->target_frame_time &&
+           elapsed + priv->operation_time > slice))
         break;
     }
 
   g_timer_stop (priv->timer);
 
-  if (!g_queue_is_empty (priv->ops))
+  if (g_sequence_get_length (priv->ops))
     {
+      if (!priv->stage)
+        {
+          mx_actor_manager_ensure_processing (manager);
+          return FALSE;
+        }
+
+      /* Continue once the next frame has been painted. The frame is timed
+       * from the repaint functions, which run before layout, to the end of
+       * the stage paint.
+       */
       if (!priv->post_paint_handler)
         priv->post_paint_handler =
-          g_signal_connect (priv->stage, "paint",
-                            G_CALLBACK (mx_actor_manager_post_paint_cb),
-                            manager);
-
-      return TRUE;
+          g_signal_connect_after (priv->stage, "paint",
+                                  G_CALLBACK (mx_actor_manager_post_paint_cb),
+                                  manager);
+
+      if (!priv->repaint_func && priv->target_frame_time)
+        priv->repaint_func =
+          clutter_threads_add_repaint_func ((GSourceFunc)
+                                            mx_actor_manager_pre_frame_cb,
+                                            manager,
+                                            NULL);
+
+      /* Nothing may be queued for redraw, so make sure the remaining
+       * operations are processed even if no frame is painted */
+      priv->source =
+        g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE,
+                            priv->target_frame_time ?
+                            priv->target_frame_time : FALLBACK_FRAME_TIME,
+                            (GSourceFunc)mx_actor_manager_process_operations,
+                            manager,
+                            NULL);
     }
 
   return FALSE;
@@ -849,6 +1105,37 @@ mx_actor_manager_create_actor (MxActorManager           *manager,
                                MxActorManagerCreateFunc  create_func,
                                gpointer                  userdata,
                                GDestroyNotify            destroy_func)
+{
+  return mx_actor_manager_create_actor_full (manager,
+                                             G_PRIORITY_DEFAULT,
+                                             create_func,
+                                             userdata,
+                                             destroy_func);
+}
+
+/**
+ * mx_actor_manager_create_actor_full:
+ * @manager: A #MxActorManager
+ * @priority: The priority of the operation
+ * @create_func: A #ClutterActor creation function
+ * @userdata: data to be passed to the function, or %NULL
+ * @destroy_func: callback to invoke before the operation is removed
+ *
+ * Like mx_actor_manager_create_actor(), but the operation is queued with
+ * the given priority. Operations with a lower priority value are performed
+ * before those with a higher one, regardless of the order they were added
+ * in.
+ *
+ * Returns: The ID for this operation.
+ *
+ * Since: 1.6
+ */
+gulong
+mx_actor_manager_create_actor_full (MxActorManager           *manager,
+                                    gint                      priority,
+                                    MxActorManagerCreateFunc  create_func,
+                                    gpointer                  userdata,
+                                    GDestroyNotify            destroy_func)
 {
   MxActorManagerOperation *op;
 
@@ -856,6 +1143,7 @@ mx_actor_manager_create_actor (MxActorManager           *manager,
   g_return_val_if_fail (create_func != NULL, 0);
 
   op = mx_actor_manager_op_new (manager,
+                                priority,
                                 MX_ACTOR_MANAGER_CREATE,
                                 create_func,
                                 userdata,
@@ -887,6 +1175,32 @@ gulong
 mx_actor_manager_add_actor (MxActorManager   *manager,
                             ClutterContainer *container,
                             ClutterActor     *actor)
+{
+  return mx_actor_manager_add_actor_full (manager,
+                                          G_PRIORITY_DEFAULT,
+                                          container,
+                                          actor);
+}
+
+/**
+ * mx_actor_manager_add_actor_full:
+ * @manager: A #MxActorManager
+ * @priority: The priority of the operation
+ * @container: A #ClutterContainer
+ * @actor: A #ClutterActor
+ *
+ * Like mx_actor_manager_add_actor(), but the operation is queued with
+ * the given priority.
+ *
+ * Returns: The ID for this operation.
+ *
+ * Since: 1.6
+ */
+gulong
+mx_actor_manager_add_actor_full (MxActorManager   *manager,
+                                 gint              priority,
+                                 ClutterContainer *container,
+                                 ClutterActor     *actor)
 {
   MxActorManagerOperation *op;
 
@@ -895,6 +1209,7 @@ mx_actor_manager_add_actor (MxActorManager   *manager,
   g_return_val_if_fail (CLUTTER_IS_ACTOR (actor), 0);
 
   op = mx_actor_manager_op_new (manager,
+                                priority,
                                 MX_ACTOR_MANAGER_ADD,
                                 NULL,
                                 NULL,
@@ -930,6 +1245,32 @@ gulong
 mx_actor_manager_remove_actor (MxActorManager   *manager,
                                ClutterContainer *container,
                                ClutterActor     *actor)
+{
+  return mx_actor_manager_remove_actor_full (manager,
+                                             G_PRIORITY_DEFAULT,
+                                             container,
+                                             actor);
+}
+
+/**
+ * mx_actor_manager_remove_actor_full:
+ * @manager: A #MxActorManager
+ * @priority: The priority of the operation
+ * @container: A #ClutterContainer
+ * @actor: A #ClutterActor
+ *
+ * Like mx_actor_manager_remove_actor(), but the operation is queued with
+ * the given priority.
+ *
+ * Returns: The ID for this operation.
+ *
+ * Since: 1.6
+ */
+gulong
+mx_actor_manager_remove_actor_full (MxActorManager   *manager,
+                                    gint              priority,
+                                    ClutterContainer *container,
+                                    ClutterActor     *actor)
 {
   MxActorManagerOperation *op;
 
@@ -938,6 +1279,7 @@ mx_actor_manager_remove_actor (MxActorManager   *manager,
   g_return_val_if_fail (CLUTTER_IS_ACTOR (actor), 0);
 
   op = mx_actor_manager_op_new (manager,
+                                priority,
                                 MX_ACTOR_MANAGER_REMOVE,
                                 NULL,
                                 NULL,
@@ -985,6 +1327,7 @@ mx_actor_manager_remove_container (MxActorManager   *manager,
     {
       ClutterActor *child = children->data;
       mx_actor_manager_op_new (manager,
+                               G_PRIORITY_DEFAULT,
                                MX_ACTOR_MANAGER_REMOVE,
                                NULL,
                                NULL,
@@ -1001,6 +1344,7 @@ mx_actor_manager_remove_container (MxActorManager   *manager,
       clutter_container_remove_actor (CLUTTER_CONTAINER (parent),
                                       CLUTTER_ACTOR (container));
       mx_actor_manager_op_new (manager,
+                               G_PRIORITY_DEFAULT,
                                MX_ACTOR_MANAGER_UNREF,
                                NULL,
                                NULL,
@@ -1011,14 +1355,23 @@ mx_actor_manager_remove_container (MxActorManager   *manager,
   mx_actor_manager_ensure_processing (manager);
 }
 
-static gint
-mx_actor_manager_find_by_id (gconstpointer a,
-                             gconstpointer b)
+static MxActorManagerOperation *
+mx_actor_manager_find_by_id (MxActorManager *manager,
+                             gulong          id)
 {
-  const MxActorManagerOperation *op = a;
-  const gulong *id = b;
+  return g_hash_table_lookup (manager->priv->ops_by_id,
+                              GSIZE_TO_POINTER (id));
+}
+
+static void
+mx_actor_manager_cancel_op (MxActorManager          *manager,
+                            MxActorManagerOperation *op)
+{
+  g_sequence_remove (op->iter);
+
+  g_signal_emit (manager, signals[OP_CANCELLED], 0, op->id);
 
-  return (op->id == *id) ? 0 : -1;
+  mx_actor_manager_op_free (manager, op, FALSE);
 }
 
 /**
@@ -1036,28 +1389,60 @@ void
 mx_actor_manager_cancel_operation (MxActorManager *manager,
                                    gulong          id)
 {
-  GList *op_link;
-  MxActorManagerPrivate *priv;
+  MxActorManagerOperation *op;
 
   g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
   g_return_if_fail (id > 0);
 
-  priv = manager->priv;
-
-  op_link = g_queue_find_custom (priv->ops, &id, mx_actor_manager_find_by_id);
+  op = mx_actor_manager_find_by_id (manager, id);
 
-  if (!op_link)
+  if (!op)
     {
       g_warning (G_STRLOC ": Unknown operation (%lu)", id);
       return;
     }
 
-  g_queue_unlink (priv->ops, op_link);
+  mx_actor_manager_cancel_op (manager, op);
+}
+
+/**
+ * mx_actor_manager_cancel_operation_ids:
+ * @manager: A #MxActorManager
+ * @ids: (array length=n_ids): An array of operation IDs
+ * @n_ids: The length of @ids
+ *
+ * Cancels each of the given operations that is still pending. Unlike
+ * mx_actor_manager_cancel_operation(), IDs of operations that have already
+ * completed or been cancelled are ignored, so a list of IDs can be cancelled
+ * without tracking which of the operations have been performed.
+ *
+ * Returns: The number of operations that were cancelled
+ *
+ * Since: 1.6
+ */
+guint
+mx_actor_manager_cancel_operation_ids (MxActorManager *manager,
+                                       const gulong   *ids,
+                                       guint           n_ids)
+{
+  guint i, n_cancelled;
+
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  g_return_val_if_fail (ids != NULL || n_ids == 0, 0);
 
-  g_signal_emit (manager, signals[OP_CANCELLED], 0, id);
+  for (i = 0, n_cancelled = 0; i < n_ids; i++)
+    {
+      MxActorManagerOperation *op = mx_actor_manager_find_by_id (manager,
+                                                                 ids[i]);
 
-  mx_actor_manager_op_free (manager, op_link, FALSE);
-  g_list_free (op_link);
+      if (!op)
+        continue;
+
+      mx_actor_manager_cancel_op (manager, op);
+      n_cancelled++;
+    }
+
+  return n_cancelled;
 }
 
 /**
@@ -1073,7 +1458,7 @@ void
 mx_actor_manager_cancel_operations (MxActorManager *manager,
                                     ClutterActor   *actor)
 {
-  GList *op_links;
+  GQueue *ops;
   MxActorManagerPrivate *priv;
 
   g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
@@ -1081,21 +1466,92 @@ mx_actor_manager_cancel_operations (MxActorManager *manager,
 
   priv = manager->priv;
 
-  op_links = g_hash_table_lookup (priv->actor_op_links, actor);
-  while (op_links)
+  /* Cancelling the last operation frees the queue, so check the hash
+   * table again each time */
+  while ((ops = g_hash_table_lookup (priv->actor_ops, actor)))
     {
-      GList *op_link = op_links->data;
-      MxActorManagerOperation *op = op_link->data;
+      GList *l;
+
+      /* The operation being performed has no sequence iter and can't be
+       * cancelled, skip it */
+      for (l = ops->head; l; l = l->next)
+        if (((MxActorManagerOperation *)l->data)->iter)
+          break;
+
+      if (!l)
+        break;
+
+      mx_actor_manager_cancel_op (manager, l->data);
+    }
+}
 
-      op_links = op_links->next;
+/**
+ * mx_actor_manager_set_operation_priority:
+ * @manager: A #MxActorManager
+ * @id: An operation ID
+ * @priority: The new priority of the operation
+ *
+ * Changes the priority of a pending operation. The operation keeps its
+ * place relative to other operations of the same priority that were added
+ * before or after it.
+ *
+ * Since: 1.6
+ */
+void
+mx_actor_manager_set_operation_priority (MxActorManager *manager,
+                                         gulong          id,
+                                         gint            priority)
+{
+  MxActorManagerOperation *op;
 
-      g_queue_unlink (priv->ops, op_link);
+  g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
+  g_return_if_fail (id > 0);
 
-      g_signal_emit (manager, signals[OP_CANCELLED], 0, op->id);
+  op = mx_actor_manager_find_by_id (manager, id);
 
-      mx_actor_manager_op_free (manager, op_link, FALSE);
-      g_list_free (op_link);
+  if (!op)
+    {
+      g_warning (G_STRLOC ": Unknown operation (%lu)", id);
+      return;
     }
+
+  if (op->priority == priority)
+    return;
+
+  op->priority = priority;
+  g_sequence_sort_changed (op->iter, mx_actor_manager_op_compare, NULL);
+}
+
+/**
+ * mx_actor_manager_get_operation_priority:
+ * @manager: A #MxActorManager
+ * @id: An operation ID
+ *
+ * Retrieves the priority of a pending operation.
+ *
+ * Returns: The priority of the operation, or %G_PRIORITY_DEFAULT if the
+ *   operation does not exist
+ *
+ * Since: 1.6
+ */
+gint
+mx_actor_manager_get_operation_priority (MxActorManager *manager,
+                                         gulong          id)
+{
+  MxActorManagerOperation *op;
+
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), G_PRIORITY_DEFAULT);
+  g_return_val_if_fail (id > 0, G_PRIORITY_DEFAULT);
+
+  op = mx_actor_manager_find_by_id (manager, id);
+
+  if (!op)
+    {
+      g_warning (G_STRLOC ": Unknown operation (%lu)", id);
+      return G_PRIORITY_DEFAULT;
+    }
+
+  return op->priority;
 }
 
 /**
@@ -1159,6 +1615,144 @@ guint
 mx_actor_manager_get_n_operations (MxActorManager *manager)
 {
   g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
-  return g_queue_get_length (manager->priv->ops);
+  return g_sequence_get_length (manager->priv->ops);
+}
+
+/**
+ * mx_actor_manager_set_target_frame_time:
+ * @manager: A #MxActorManager
+ * @msecs: A time, in milliseconds, or 0
+ *
+ * Sets the time each frame should take, including the time spent performing
+ * operations. The actor manager measures how long frames take to lay out
+ * and paint, and spends the remainder of the target time on operations.
+ * This replaces the fixed #MxActorManager:time-slice, which is used again
+ * when @msecs is 0.
+ *
+ * Since: 1.6
+ */
+void
+mx_actor_manager_set_target_frame_time (MxActorManager *manager,
+                                        guint           msecs)
+{
+  MxActorManagerPrivate *priv;
+
+  g_return_if_fail (MX_IS_ACTOR_MANAGER (manager));
+
+  priv = manager->priv;
+
+  if (priv->target_frame_time != msecs)
+    {
+      priv->target_frame_time = msecs;
+
+      if (!msecs && priv->repaint_func)
+        {
+          clutter_threads_remove_repaint_func (priv->repaint_func);
+          priv->repaint_func = 0;
+        }
+      priv->frame_start = 0;
+
+      g_object_notify (G_OBJECT (manager), "target-frame-time");
+    }
+}
+
+/**
+ * mx_actor_manager_get_target_frame_time:
+ * @manager: A #MxActorManager
+ *
+ * Retrieves the target frame time set with
+ * mx_actor_manager_set_target_frame_time().
+ *
+ * Returns: The target frame time, in milliseconds, or 0
+ *
+ * Since: 1.6
+ */
+guint
+mx_actor_manager_get_target_frame_time (MxActorManager *manager)
+{
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  return manager->priv->target_frame_time;
 }
 
+/**
+ * mx_actor_manager_get_frame_time:
+ * @manager: A #MxActorManager
+ *
+ * Retrieves the moving average of the time frames have taken to lay out
+ * and paint while operations were pending. Frames are only measured when
+ * #MxActorManager:target-frame-time is set.
+ *
+ * Returns: The average frame time, in milliseconds, or 0 if no frames have
+ *   been measured
+ *
+ * Since: 1.6
+ */
+gdouble
+mx_actor_manager_get_frame_time (MxActorManager *manager)
+{
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  return manager->priv->frame_time;
+}
+
+/**
+ * mx_actor_manager_get_operation_time:
+ * @manager: A #MxActorManager
+ *
+ * Retrieves the moving average of the time operations have taken to
+ * perform, including the handlers of the signals emitted for them.
+ *
+ * Returns: The average operation time, in milliseconds, or 0 if no
+ *   operations have been performed
+ *
+ * Since: 1.6
+ */
+gdouble
+mx_actor_manager_get_operation_time (MxActorManager *manager)
+{
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), 0);
+  return manager->priv->operation_time;
+}
+
+/**
+ * mx_actor_manager_get_create_stats:
+ * @manager: A #MxActorManager
+ * @create_func: A #ClutterActor creation function
+ * @n_operations: (out) (allow-none): Return location for the number of
+ *   actors created with @create_func, or %NULL
+ * @average_time: (out) (allow-none): Return location for the average time
+ *   taken to create an actor, in milliseconds, or %NULL
+ * @max_time: (out) (allow-none): Return location for the longest time taken
+ *   to create an actor, in milliseconds, or %NULL
+ *
+ * Retrieves statistics about the creation operations that used
+ * @create_func. This can be used to find actor creation functions that
+ * take too long to fit comfortably in a frame.
+ *
+ * Returns: %TRUE if any operations using @create_func have been performed
+ *
+ * Since: 1.6
+ */
+gboolean
+mx_actor_manager_get_create_stats (MxActorManager           *manager,
+                                   MxActorManagerCreateFunc  create_func,
+                                   guint                    *n_operations,
+                                   gdouble                  *average_time,
+                                   gdouble                  *max_time)
+{
+  MxActorManagerStats *stats;
+
+  g_return_val_if_fail (MX_IS_ACTOR_MANAGER (manager), FALSE);
+  g_return_val_if_fail (create_func != NULL, FALSE);
+
+  stats = g_hash_table_lookup (manager->priv->create_stats,
+                               (gpointer)create_func);
+
+  if (n_operations)
+    *n_operations = stats ? stats->n_operations : 0;
+  if (average_time)
+    *average_time = stats ? stats->average_time : 0;
+  if (max_time)
+    *max_time = stats ? stats->max_time : 0;
+
+  return (stats != NULL);
+}
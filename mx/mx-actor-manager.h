@@ -120,30 +120,65 @@ gulong mx_actor_manager_create_actor (MxActorManager           *manager,
                                       MxActorManagerCreateFunc  create_func,
                                       gpointer                  userdata,
                                       GDestroyNotify            destroy_func);
+gulong mx_actor_manager_create_actor_full (MxActorManager           *manager,
+                                           gint                      priority,
+                                           MxActorManagerCreateFunc  create_func,
+                                           gpointer                  userdata,
+                                           GDestroyNotify            destroy_func);
 
 gulong mx_actor_manager_add_actor (MxActorManager   *manager,
                                    ClutterContainer *container,
                                    ClutterActor     *actor);
+gulong mx_actor_manager_add_actor_full (MxActorManager   *manager,
+                                        gint              priority,
+                                        ClutterContainer *container,
+                                        ClutterActor     *actor);
 
 gulong mx_actor_manager_remove_actor (MxActorManager   *manager,
                                       ClutterContainer *container,
                                       ClutterActor     *actor);
+gulong mx_actor_manager_remove_actor_full (MxActorManager   *manager,
+                                           gint              priority,
+                                           ClutterContainer *container,
+                                           ClutterActor     *actor);
 
 void mx_actor_manager_remove_container (MxActorManager   *manager,
                                         ClutterContainer *container);
 
 void mx_actor_manager_cancel_operation (MxActorManager *manager,
                                         gulong          id);
+guint mx_actor_manager_cancel_operation_ids (MxActorManager *manager,
+                                             const gulong   *ids,
+                                             guint           n_ids);
 
 void mx_actor_manager_cancel_operations (MxActorManager *manager,
                                          ClutterActor   *actor);
 
+void mx_actor_manager_set_operation_priority (MxActorManager *manager,
+                                              gulong          id,
+                                              gint            priority);
+gint mx_actor_manager_get_operation_priority (MxActorManager *manager,
+                                              gulong          id);
+
 void  mx_actor_manager_set_time_slice (MxActorManager *manager,
                                        guint           msecs);
 guint mx_actor_manager_get_time_slice (MxActorManager *manager);
 
 guint mx_actor_manager_get_n_operations (MxActorManager *manager);
 
+void  mx_actor_manager_set_target_frame_time (MxActorManager *manager,
+                                              guint           msecs);
+guint mx_actor_manager_get_target_frame_time (MxActorManager *manager);
+
+gdouble mx_actor_manager_get_frame_time     (MxActorManager *manager);
+gdouble mx_actor_manager_get_operation_time (MxActorManager *manager);
+
+gboolean mx_actor_manager_get_create_stats (MxActorManager           *manager,
+                                            MxActorManagerCreateFunc  create_func,
+                                            guint                    *n_operations,
+                                            gdouble                  *average_time,
+                                            gdouble                  *max_time);
+
 G_END_DECLS
 
 #endif /* _MX_ACTOR_MANAGER_H */
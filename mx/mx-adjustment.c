@@ -63,19 +63,19 @@ struct _MxAdjustmentPrivate
   gdouble  page_size;
 
   /* For signal emission/notification */
-  guint lower_source;
-  guint upper_source;
-  guint value_source;
-  guint step_inc_source;
-  guint page_inc_source;
-  guint page_size_source;
-  guint changed_source;
+  guint   notify_source;
+  guint   pending;
+
+  /* For mx_adjustment_freeze() */
+  guint   freeze_count;
+  gdouble frozen_value;
 
   /* For interpolation */
-  ClutterTimeline *interpolation;
+  guint            interpolation;
+  gulong           interpolation_mode;
+  gboolean         interpolation_bounce;
   gdouble          old_position;
   gdouble          new_position;
-  ClutterAlpha    *interpolate_alpha;
 };
 
 enum
@@ -103,6 +103,21 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0, };
 
+/* Notifications that are emitted from an idle, or when the adjustment is
+ * thawed */
+enum
+{
+  PENDING_LOWER     = 1 << 0,
+  PENDING_UPPER     = 1 << 1,
+  PENDING_VALUE     = 1 << 2,
+  PENDING_STEP_INC  = 1 << 3,
+  PENDING_PAGE_INC  = 1 << 4,
+  PENDING_PAGE_SIZE = 1 << 5,
+  PENDING_CHANGED   = 1 << 6
+};
+
+#define PENDING_BOUNDS (PENDING_LOWER | PENDING_UPPER | PENDING_PAGE_SIZE)
+
 static gboolean _mx_adjustment_set_lower          (MxAdjustment *adjustment,
                                                    gdouble       lower);
 static gboolean _mx_adjustment_set_upper          (MxAdjustment *adjustment,
@@ -239,9 +254,8 @@ stop_interpolation (MxAdjustment *adjustment)
 
   if (priv->interpolation)
     {
-      clutter_timeline_stop (priv->interpolation);
-      g_object_unref (priv->interpolation);
-      priv->interpolation = NULL;
+      _mx_transition_stop (priv->interpolation);
+      priv->interpolation = 0;
     }
 }
 
@@ -263,19 +277,7 @@ mx_adjustment_dispose (GObject *object)
   stop_interpolation (MX_ADJUSTMENT (object));
 
   /* Remove idle handlers */
-  mx_adjustment_remove_idle (&priv->value_source);
-  mx_adjustment_remove_idle (&priv->lower_source);
-  mx_adjustment_remove_idle (&priv->upper_source);
-  mx_adjustment_remove_idle (&priv->page_inc_source);
-  mx_adjustment_remove_idle (&priv->step_inc_source);
-  mx_adjustment_remove_idle (&priv->page_size_source);
-  mx_adjustment_remove_idle (&priv->changed_source);
-
-  if (priv->interpolate_alpha)
-    {
-      g_object_unref (priv->interpolate_alpha);
-      priv->interpolate_alpha = NULL;
-    }
+  mx_adjustment_remove_idle (&priv->notify_source);
 
   G_OBJECT_CLASS (mx_adjustment_parent_class)->dispose (object);
 }
@@ -477,81 +479,54 @@ mx_adjustment_get_value (MxAdjustment *adjustment)
 }
 
 static gboolean
-mx_adjustment_value_notify_cb (MxAdjustment *adjustment)
+mx_adjustment_notify_cb (MxAdjustment *adjustment)
 {
   MxAdjustmentPrivate *priv = adjustment->priv;
+  GObject *object = G_OBJECT (adjustment);
+  guint pending;
 
-  priv->value_source = 0;
+  pending = priv->pending;
+  priv->pending = 0;
+  priv->notify_source = 0;
 
-  g_object_notify (G_OBJECT (adjustment), "value");
+  g_object_freeze_notify (object);
 
-  return FALSE;
-}
+  if (pending & PENDING_LOWER)
+    g_object_notify (object, "lower");
+  if (pending & PENDING_UPPER)
+    g_object_notify (object, "upper");
+  if (pending & PENDING_VALUE)
+    g_object_notify (object, "value");
+  if (pending & PENDING_STEP_INC)
+    g_object_notify (object, "step-increment");
+  if (pending & PENDING_PAGE_INC)
+    g_object_notify (object, "page-increment");
+  if (pending & PENDING_PAGE_SIZE)
+    g_object_notify (object, "page-size");
 
-static gboolean
-mx_adjustment_lower_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
+  g_object_thaw_notify (object);
 
-  priv->lower_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "lower");
+  if (pending & PENDING_CHANGED)
+    g_signal_emit (adjustment, signals[CHANGED], 0);
 
   return FALSE;
 }
 
-static gboolean
-mx_adjustment_upper_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  priv->upper_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "upper");
-
-  return FALSE;
-}
-
-static gboolean
-mx_adjustment_step_inc_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  priv->step_inc_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "step-increment");
-
-  return FALSE;
-}
-
-static gboolean
-mx_adjustment_page_inc_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  priv->page_inc_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "page-increment");
-
-  return FALSE;
-}
-
-static gboolean
-mx_adjustment_page_size_notify_cb (MxAdjustment *adjustment)
-{
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  priv->page_size_source = 0;
-  g_object_notify (G_OBJECT (adjustment), "page-size");
-
-  return FALSE;
-}
-
-static gboolean
-mx_adjustment_emit_changed_cb (MxAdjustment *adjustment)
+static void
+mx_adjustment_queue_notify (MxAdjustment *adjustment,
+                            guint         pending)
 {
   MxAdjustmentPrivate *priv = adjustment->priv;
 
-  priv->changed_source = 0;
-  g_signal_emit (adjustment, signals[CHANGED], 0);
+  priv->pending |= pending;
 
-  return FALSE;
+  /* a frozen adjustment schedules the notifications when it is thawed */
+  if (!priv->notify_source && !priv->freeze_count)
+    priv->notify_source =
+      g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
+                       (GSourceFunc)mx_adjustment_notify_cb,
+                       adjustment,
+                       NULL);
 }
 
 /**
@@ -572,8 +547,9 @@ mx_adjustment_set_value (MxAdjustment *adjustment,
 
   priv = adjustment->priv;
 
-  /* Defer clamp until after construction. */
-  if (!priv->is_constructing)
+  /* Defer clamp until after construction, or until the adjustment is
+   * thawed and all the bounds are known. */
+  if (!priv->is_constructing && !priv->freeze_count)
     {
       if (!priv->elastic && priv->clamp_value)
         value = CLAMP (value,
@@ -587,7 +563,8 @@ mx_adjustment_set_value (MxAdjustment *adjustment,
 
       priv->value = value;
 
-      g_object_notify (G_OBJECT (adjustment), "value");
+      if (!priv->freeze_count)
+        g_object_notify (G_OBJECT (adjustment), "value");
     }
 }
 
@@ -620,25 +597,14 @@ mx_adjustment_clamp_page (MxAdjustment *adjustment,
       changed = TRUE;
     }
 
-  if (changed && !priv->value_source)
-    priv->value_source =
-      g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                       (GSourceFunc)mx_adjustment_value_notify_cb,
-                       adjustment,
-                       NULL);
+  if (changed)
+    mx_adjustment_queue_notify (adjustment, PENDING_VALUE);
 }
 
 static void
 mx_adjustment_emit_changed (MxAdjustment *adjustment)
 {
-  MxAdjustmentPrivate *priv = adjustment->priv;
-
-  if (!priv->changed_source)
-    priv->changed_source =
-      g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                       (GSourceFunc)mx_adjustment_emit_changed_cb,
-                       adjustment,
-                       NULL);
+  mx_adjustment_queue_notify (adjustment, PENDING_CHANGED);
 }
 
 static gboolean
@@ -651,17 +617,11 @@ _mx_adjustment_set_lower (MxAdjustment *adjustment,
     {
       priv->lower = lower;
 
-      mx_adjustment_emit_changed (adjustment);
-
-      if (!priv->lower_source)
-        priv->lower_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_lower_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue_notify (adjustment,
+                                  PENDING_LOWER | PENDING_CHANGED);
 
       /* Defer clamp until after construction. */
-      if (!priv->is_constructing && priv->clamp_value)
+      if (!priv->is_constructing && !priv->freeze_count && priv->clamp_value)
         mx_adjustment_clamp_page (adjustment, priv->lower, priv->upper);
 
       return TRUE;
@@ -710,17 +670,11 @@ _mx_adjustment_set_upper (MxAdjustment *adjustment,
     {
       priv->upper = upper;
 
-      mx_adjustment_emit_changed (adjustment);
-
-      if (!priv->upper_source)
-        priv->upper_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_upper_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue_notify (adjustment,
+                                  PENDING_UPPER | PENDING_CHANGED);
 
       /* Defer clamp until after construction. */
-      if (!priv->is_constructing && priv->clamp_value)
+      if (!priv->is_constructing && !priv->freeze_count && priv->clamp_value)
         mx_adjustment_clamp_page (adjustment, priv->lower, priv->upper);
 
       return TRUE;
@@ -769,14 +723,8 @@ _mx_adjustment_set_step_increment (MxAdjustment *adjustment,
     {
       priv->step_increment = step;
 
-      mx_adjustment_emit_changed (adjustment);
-
-      if (!priv->step_inc_source)
-        priv->step_inc_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_step_inc_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue_notify (adjustment,
+                                  PENDING_STEP_INC | PENDING_CHANGED);
 
       return TRUE;
     }
@@ -824,14 +772,8 @@ _mx_adjustment_set_page_increment (MxAdjustment *adjustment,
     {
       priv->page_increment = page;
 
-      mx_adjustment_emit_changed (adjustment);
-
-      if (!priv->page_inc_source)
-        priv->page_inc_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_page_inc_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue_notify (adjustment,
+                                  PENDING_PAGE_INC | PENDING_CHANGED);
 
       return TRUE;
     }
@@ -879,17 +821,11 @@ _mx_adjustment_set_page_size (MxAdjustment *adjustment,
     {
       priv->page_size = size;
 
-      mx_adjustment_emit_changed (adjustment);
-
-      if (!priv->page_size_source)
-        priv->page_size_source =
-          g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
-                           (GSourceFunc)mx_adjustment_page_size_notify_cb,
-                           adjustment,
-                           NULL);
+      mx_adjustment_queue_notify (adjustment,
+                                  PENDING_PAGE_SIZE | PENDING_CHANGED);
 
       /* Well explicitely clamp after construction. */
-      if (!priv->is_constructing && priv->clamp_value)
+      if (!priv->is_constructing && !priv->freeze_count && priv->clamp_value)
         mx_adjustment_clamp_page (adjustment, priv->lower, priv->upper);
 
       return TRUE;
@@ -962,7 +898,7 @@ mx_adjustment_set_values (MxAdjustment *adjustment,
 
   emit_changed = FALSE;
 
-  g_object_freeze_notify (G_OBJECT (adjustment));
+  mx_adjustment_freeze (adjustment);
 
   emit_changed |= _mx_adjustment_set_lower (adjustment, lower);
   emit_changed |= _mx_adjustment_set_upper (adjustment, upper);
@@ -981,7 +917,75 @@ mx_adjustment_set_values (MxAdjustment *adjustment,
   if (emit_changed)
     mx_adjustment_emit_changed (adjustment);
 
-  g_object_thaw_notify (G_OBJECT (adjustment));
+  mx_adjustment_thaw (adjustment);
+}
+
+/**
+ * mx_adjustment_freeze:
+ * @adjustment: A #MxAdjustment
+ *
+ * Freezes @adjustment, so that several of its properties can be changed
+ * as a single update. Until mx_adjustment_thaw() is called, the value is
+ * not clamped and no notifications are emitted. Calls can be nested.
+ *
+ * Since: 1.6
+ */
+void
+mx_adjustment_freeze (MxAdjustment *adjustment)
+{
+  MxAdjustmentPrivate *priv;
+
+  g_return_if_fail (MX_IS_ADJUSTMENT (adjustment));
+
+  priv = adjustment->priv;
+
+  if (priv->freeze_count++ == 0)
+    priv->frozen_value = priv->value;
+}
+
+/**
+ * mx_adjustment_thaw:
+ * @adjustment: A #MxAdjustment
+ *
+ * Reverts the effect of a previous call to mx_adjustment_freeze(). Once
+ * @adjustment is no longer frozen, the value is clamped to the new bounds
+ * and notified if it changed, then the other properties that changed are
+ * notified and #MxAdjustment::changed is emitted once, from an idle.
+ *
+ * Since: 1.6
+ */
+void
+mx_adjustment_thaw (MxAdjustment *adjustment)
+{
+  MxAdjustmentPrivate *priv;
+
+  g_return_if_fail (MX_IS_ADJUSTMENT (adjustment));
+
+  priv = adjustment->priv;
+
+  g_return_if_fail (priv->freeze_count > 0);
+
+  if (--priv->freeze_count > 0)
+    return;
+
+  /* bounds changes clamp the value even when elastic, like
+   * mx_adjustment_clamp_page() */
+  if (!priv->is_constructing && priv->clamp_value &&
+      (!priv->elastic || (priv->pending & PENDING_BOUNDS)))
+    priv->value = CLAMP (priv->value,
+                         priv->lower,
+                         MAX (priv->lower, priv->upper - priv->page_size));
+
+  /* this also covers a value notification that was still pending from
+   * before the freeze, so don't let the idle send it again */
+  if (priv->value != priv->frozen_value)
+    {
+      priv->pending &= ~PENDING_VALUE;
+      g_object_notify (G_OBJECT (adjustment), "value");
+    }
+
+  if (priv->pending)
+    mx_adjustment_queue_notify (adjustment, 0);
 }
 
 /**
@@ -1032,21 +1036,29 @@ mx_adjustment_get_values (MxAdjustment *adjustment,
 }
 
 static void
-interpolation_new_frame_cb (ClutterTimeline *timeline,
-                            guint            msecs,
-                            MxAdjustment    *adjustment)
+interpolation_frame_cb (gdouble  alpha,
+                        gpointer user_data)
 {
-  gdouble new_value;
+  MxAdjustment *adjustment = user_data;
   MxAdjustmentPrivate *priv = adjustment->priv;
+  gdouble new_value;
+  guint interpolation;
 
-  priv->interpolation = NULL;
+  /* The elastic bounce back runs the interpolation backwards */
+  if (priv->interpolation_bounce)
+    alpha = _mx_transition_ease (priv->interpolation_mode, 1.0 - alpha);
 
   new_value = priv->old_position +
-              (priv->new_position - priv->old_position) *
-              clutter_alpha_get_alpha (priv->interpolate_alpha);
+              (priv->new_position - priv->old_position) * alpha;
 
+  /* Don't let mx_adjustment_set_value() stop the interpolation */
+  interpolation = priv->interpolation;
+  priv->interpolation = 0;
   mx_adjustment_set_value (adjustment, new_value);
-  priv->interpolation = timeline;
+  if (!priv->interpolation)
+    priv->interpolation = interpolation;
+  else
+    _mx_transition_stop (interpolation);
 
   /* Stop the interpolation if we've reached the end of the adjustment */
   if (!priv->elastic && priv->clamp_value &&
@@ -1055,46 +1067,49 @@ interpolation_new_frame_cb (ClutterTimeline *timeline,
     stop_interpolation (adjustment);
 }
 
-static void
-interpolation_completed_cb (ClutterTimeline *timeline,
-                            MxAdjustment    *adjustment)
+static gboolean
+interpolation_done_cb (gpointer user_data)
 {
+  MxAdjustment *adjustment = user_data;
   MxAdjustmentPrivate *priv = adjustment->priv;
 
+  priv->interpolation = 0;
+
   if (priv->elastic && priv->clamp_value)
     {
-      if (clutter_timeline_get_direction (priv->interpolation) ==
-            CLUTTER_TIMELINE_FORWARD)
+      if (!priv->interpolation_bounce)
         {
-          clutter_timeline_set_direction (priv->interpolation,
-                                          CLUTTER_TIMELINE_BACKWARD);
-          clutter_timeline_set_duration (priv->interpolation, 250);
-          clutter_timeline_rewind (priv->interpolation);
+          gboolean bounce = TRUE;
 
           if (priv->new_position < priv->lower)
-            {
-              priv->old_position = priv->lower;
-              clutter_timeline_start (priv->interpolation);
-            }
+            priv->old_position = priv->lower;
           else if (priv->new_position > (priv->upper - priv->page_size))
+            priv->old_position = priv->upper - priv->page_size;
+          else
+            bounce = FALSE;
+
+          if (bounce)
             {
-              priv->old_position = priv->upper - priv->page_size;
-              clutter_timeline_start (priv->interpolation);
+              priv->interpolation_bounce = TRUE;
+              priv->interpolation =
+                _mx_transition_start (250, CLUTTER_LINEAR,
+                                      interpolation_frame_cb,
+                                      interpolation_done_cb,
+                                      adjustment);
             }
         }
       else
         {
-          stop_interpolation (adjustment);
+          priv->interpolation_bounce = FALSE;
           mx_adjustment_set_value (adjustment, priv->old_position);
         }
     }
   else
-    {
-      stop_interpolation (adjustment);
-      mx_adjustment_set_value (adjustment, priv->new_position);
-    }
+    mx_adjustment_set_value (adjustment, priv->new_position);
 
   g_signal_emit (adjustment, signals[INTERPOLATION_COMPLETED], 0);
+
+  return FALSE;
 }
 
 /**
@@ -1124,41 +1139,20 @@ mx_adjustment_interpolate (MxAdjustment *adjustment,
       return;
     }
 
+  /* Restart the animation if it gets interrupted, otherwise frequent calls
+   * to this function will end up with no advancements until the calls
+   * finish (as the animation never gets a chance to start).
+   */
+  stop_interpolation (adjustment);
+
   priv->old_position = priv->value;
   priv->new_position = value;
-
-  if (!priv->interpolation)
-    {
-      priv->interpolation = clutter_timeline_new (duration);
-
-      g_signal_connect (priv->interpolation,
-                        "new-frame",
-                        G_CALLBACK (interpolation_new_frame_cb),
-                        adjustment);
-      g_signal_connect (priv->interpolation,
-                        "completed",
-                        G_CALLBACK (interpolation_completed_cb),
-                        adjustment);
-    }
-  else
-    {
-      /* Extend the animation if it gets interrupted, otherwise frequent calls
-       * to this function will end up with no advancements until the calls
-       * finish (as the animation never gets a chance to start).
-       */
-      clutter_timeline_set_direction (priv->interpolation,
-                                      CLUTTER_TIMELINE_FORWARD);
-      clutter_timeline_rewind (priv->interpolation);
-      clutter_timeline_set_duration (priv->interpolation, duration);
-    }
-
-  if (priv->interpolate_alpha)
-    g_object_unref (priv->interpolate_alpha);
-
-  priv->interpolate_alpha = clutter_alpha_new_full (priv->interpolation,
-                                                    mode);
-
-  clutter_timeline_start (priv->interpolation);
+  priv->interpolation_mode = mode;
+  priv->interpolation_bounce = FALSE;
+  priv->interpolation = _mx_transition_start (duration, mode,
+                                              interpolation_frame_cb,
+                                              interpolation_done_cb,
+                                              adjustment);
 }
 
 /**
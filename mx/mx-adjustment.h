@@ -131,6 +131,9 @@ void          mx_adjustment_get_values         (MxAdjustment *adjustment,
                                                 gdouble      *page_increment,
                                                 gdouble      *page_size);
 
+void          mx_adjustment_freeze             (MxAdjustment *adjustment);
+void          mx_adjustment_thaw               (MxAdjustment *adjustment);
+
 void          mx_adjustment_interpolate          (MxAdjustment *adjustment,
                                                   gdouble       value,
                                                   guint         duration,
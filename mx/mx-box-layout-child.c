@@ -36,6 +36,30 @@ G_DEFINE_TYPE (MxBoxLayoutChild, mx_box_layout_child, CLUTTER_TYPE_CHILD_META)
 #define BOX_LAYOUT_CHILD_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_BOX_LAYOUT_CHILD, MxBoxLayoutChildPrivate))
 
+/* Number of size requests remembered per dimension. MxBoxLayout asks its
+ * children for their size both unconstrained (from get_preferred_*) and for
+ * the allocated size (from allocate), so keep room for both.
+ */
+#define N_CACHED_SIZE_REQUESTS 2
+
+typedef struct
+{
+  gfloat for_size;
+  gfloat min_size;
+  gfloat nat_size;
+  guint  valid : 1;
+} MxBoxLayoutSizeRequest;
+
+struct _MxBoxLayoutChildPrivate
+{
+  MxBoxLayoutSizeRequest width_requests[N_CACHED_SIZE_REQUESTS];
+  MxBoxLayoutSizeRequest height_requests[N_CACHED_SIZE_REQUESTS];
+  guint                  next_width_request;
+  guint                  next_height_request;
+
+  ClutterActor          *actor;
+  gulong                 queue_relayout_id;
+};
 
 enum
 {
@@ -116,9 +140,50 @@ mx_box_layout_child_set_property (GObject      *object,
   clutter_actor_queue_relayout ((ClutterActor*) box);
 }
 
+static void
+mx_box_layout_child_invalidate (MxBoxLayoutChild *child)
+{
+  MxBoxLayoutChildPrivate *priv = BOX_LAYOUT_CHILD_PRIVATE (child);
+  gint i;
+
+  for (i = 0; i < N_CACHED_SIZE_REQUESTS; i++)
+    {
+      priv->width_requests[i].valid = FALSE;
+      priv->height_requests[i].valid = FALSE;
+    }
+}
+
+static void
+mx_box_layout_child_constructed (GObject *object)
+{
+  MxBoxLayoutChild *child = MX_BOX_LAYOUT_CHILD (object);
+  MxBoxLayoutChildPrivate *priv = BOX_LAYOUT_CHILD_PRIVATE (child);
+
+  if (G_OBJECT_CLASS (mx_box_layout_child_parent_class)->constructed)
+    G_OBJECT_CLASS (mx_box_layout_child_parent_class)->constructed (object);
+
+  /* The actor emits queue-relayout whenever it, or any of its descendants,
+   * changes size, which is exactly when the cached sizes become stale */
+  priv->actor = CLUTTER_CHILD_META (object)->actor;
+  if (priv->actor)
+    priv->queue_relayout_id =
+      g_signal_connect_swapped (priv->actor, "queue-relayout",
+                                G_CALLBACK (mx_box_layout_child_invalidate),
+                                child);
+}
+
 static void
 mx_box_layout_child_dispose (GObject *object)
 {
+  MxBoxLayoutChildPrivate *priv = BOX_LAYOUT_CHILD_PRIVATE (object);
+
+  if (priv->queue_relayout_id)
+    {
+      g_signal_handler_disconnect (priv->actor, priv->queue_relayout_id);
+      priv->queue_relayout_id = 0;
+      priv->actor = NULL;
+    }
+
   G_OBJECT_CLASS (mx_box_layout_child_parent_class)->dispose (object);
 }
 
@@ -134,8 +199,11 @@ mx_box_layout_child_class_init (MxBoxLayoutChildClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GParamSpec *pspec;
 
+  g_type_class_add_private (klass, sizeof (MxBoxLayoutChildPrivate));
+
   object_class->get_property = mx_box_layout_child_get_property;
   object_class->set_property = mx_box_layout_child_set_property;
+  object_class->constructed = mx_box_layout_child_constructed;
   object_class->dispose = mx_box_layout_child_dispose;
   object_class->finalize = mx_box_layout_child_finalize;
 
@@ -191,6 +259,106 @@ mx_box_layout_child_init (MxBoxLayoutChild *self)
   self->y_align = MX_ALIGN_MIDDLE;
 }
 
+static void
+mx_box_layout_child_get_cached_size (ClutterActor           *actor,
+                                     MxBoxLayoutSizeRequest *requests,
+                                     guint                  *next_request,
+                                     gboolean                width,
+                                     gfloat                  for_size,
+                                     gfloat                 *min_size_p,
+                                     gfloat                 *nat_size_p)
+{
+  MxBoxLayoutSizeRequest *request;
+  gint i;
+
+  for (i = 0; i < N_CACHED_SIZE_REQUESTS; i++)
+    {
+      request = &requests[i];
+
+      if (request->valid && request->for_size == for_size)
+        {
+          if (min_size_p)
+            *min_size_p = request->min_size;
+          if (nat_size_p)
+            *nat_size_p = request->nat_size;
+
+          return;
+        }
+    }
+
+  request = &requests[*next_request];
+  *next_request = (*next_request + 1) % N_CACHED_SIZE_REQUESTS;
+
+  if (width)
+    clutter_actor_get_preferred_width (actor, for_size,
+                                       &request->min_size,
+                                       &request->nat_size);
+  else
+    clutter_actor_get_preferred_height (actor, for_size,
+                                        &request->min_size,
+                                        &request->nat_size);
+
+  request->for_size = for_size;
+  request->valid = TRUE;
+
+  if (min_size_p)
+    *min_size_p = request->min_size;
+  if (nat_size_p)
+    *nat_size_p = request->nat_size;
+}
+
+/*
+ * _mx_box_layout_child_get_preferred_width:
+ * @child: A #MxBoxLayoutChild
+ * @for_height: available height, or -1
+ * @min_width_p: return location for the minimum width, or %NULL
+ * @nat_width_p: return location for the natural width, or %NULL
+ *
+ * Retrieves the preferred width of the actor @child belongs to, using the
+ * cached value when the actor hasn't queued a relayout since the last query
+ * for the same @for_height.
+ */
+void
+_mx_box_layout_child_get_preferred_width (MxBoxLayoutChild *child,
+                                          gfloat            for_height,
+                                          gfloat           *min_width_p,
+                                          gfloat           *nat_width_p)
+{
+  MxBoxLayoutChildPrivate *priv = BOX_LAYOUT_CHILD_PRIVATE (child);
+
+  mx_box_layout_child_get_cached_size (CLUTTER_CHILD_META (child)->actor,
+                                       priv->width_requests,
+                                       &priv->next_width_request,
+                                       TRUE, for_height,
+                                       min_width_p, nat_width_p);
+}
+
+/*
+ * _mx_box_layout_child_get_preferred_height:
+ * @child: A #MxBoxLayoutChild
+ * @for_width: available width, or -1
+ * @min_height_p: return location for the minimum height, or %NULL
+ * @nat_height_p: return location for the natural height, or %NULL
+ *
+ * Retrieves the preferred height of the actor @child belongs to, using the
+ * cached value when the actor hasn't queued a relayout since the last query
+ * for the same @for_width.
+ */
+void
+_mx_box_layout_child_get_preferred_height (MxBoxLayoutChild *child,
+                                           gfloat            for_width,
+                                           gfloat           *min_height_p,
+                                           gfloat           *nat_height_p)
+{
+  MxBoxLayoutChildPrivate *priv = BOX_LAYOUT_CHILD_PRIVATE (child);
+
+  mx_box_layout_child_get_cached_size (CLUTTER_CHILD_META (child)->actor,
+                                       priv->height_requests,
+                                       &priv->next_height_request,
+                                       FALSE, for_width,
+                                       min_height_p, nat_height_p);
+}
+
 static MxBoxLayoutChild *
 _get_child_meta (MxBoxLayout  *layout,
                  ClutterActor *child)
@@ -92,6 +92,14 @@ enum {
   PROP_SCROLL_TO_FOCUSED
 };
 
+typedef struct
+{
+  ClutterActor     *actor;
+  MxBoxLayoutChild *meta;
+  gfloat            min_size;
+  gfloat            nat_size;
+} MxBoxLayoutAllocChild;
+
 struct _MxBoxLayoutPrivate
 {
   GList        *children;
@@ -105,8 +113,11 @@ struct _MxBoxLayoutPrivate
   MxAdjustment *vadjustment;
 
   GHashTable      *start_allocations;
-  ClutterTimeline *timeline;
-  ClutterAlpha    *alpha;
+  guint            transition;
+  gdouble          alpha;
+  guint            fade_in_transition;
+  GList           *fade_in_pending;
+  GList           *fade_in_actors;
   guint            is_animating : 1;
   guint            enable_animations : 1;
   guint            scroll_to_focused : 1;
@@ -114,10 +125,118 @@ struct _MxBoxLayoutPrivate
   MxOrientation orientation;
 
   MxFocusable *last_focus;
+
+  /* scratch array of MxBoxLayoutAllocChild, reused between allocations */
+  GArray       *alloc_children;
+
+  /* MxChildExtent of the allocated children, in the order they were laid
+   * out. Only valid when the children were allocated without animation
+   * and none have been removed since. */
+  GArray       *extents;
+  guint         extents_valid : 1;
 };
 
 void _mx_box_layout_finish_animation (MxBoxLayout *box);
 
+/* used by subclasses that allocate the children themselves */
+void
+_mx_box_layout_invalidate_extents (MxBoxLayout *box)
+{
+  box->priv->extents_valid = FALSE;
+}
+
+/* unlike mx_scrollable_get_adjustments(), doesn't create the adjustments */
+void
+_mx_box_layout_get_adjustments (MxBoxLayout   *box,
+                                MxAdjustment **hadjustment,
+                                MxAdjustment **vadjustment)
+{
+  if (hadjustment)
+    *hadjustment = box->priv->hadjustment;
+  if (vadjustment)
+    *vadjustment = box->priv->vadjustment;
+}
+
+static void
+mx_box_layout_animation_frame_cb (gdouble  alpha,
+                                  gpointer user_data)
+{
+  MxBoxLayout *box = user_data;
+
+  box->priv->alpha = alpha;
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (box));
+}
+
+static void
+mx_box_layout_fade_in_frame_cb (gdouble  alpha,
+                                gpointer user_data)
+{
+  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (user_data)->priv;
+  guint8 opacity = 0xff * alpha;
+  GList *l;
+
+  /* actors that were already fading in when the fade restarted carry on
+   * from their current opacity */
+  for (l = priv->fade_in_actors; l; l = l->next)
+    if (clutter_actor_get_opacity (l->data) < opacity)
+      clutter_actor_set_opacity (l->data, opacity);
+}
+
+static gboolean
+mx_box_layout_fade_in_done_cb (gpointer user_data)
+{
+  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (user_data)->priv;
+
+  priv->fade_in_transition = 0;
+  g_list_free (priv->fade_in_actors);
+  priv->fade_in_actors = NULL;
+
+  return FALSE;
+}
+
+static gboolean
+mx_box_layout_animation_done_cb (gpointer user_data)
+{
+  MxBoxLayout *box = user_data;
+  MxBoxLayoutPrivate *priv = box->priv;
+
+  priv->transition = 0;
+  priv->is_animating = FALSE;
+
+  /* fade in the actors that were added, now that there is room */
+  if (priv->fade_in_pending)
+    {
+      if (priv->fade_in_transition)
+        _mx_transition_stop (priv->fade_in_transition);
+
+      priv->fade_in_actors = g_list_concat (priv->fade_in_actors,
+                                            priv->fade_in_pending);
+      priv->fade_in_pending = NULL;
+
+      priv->fade_in_transition =
+        _mx_transition_start (300, CLUTTER_LINEAR,
+                              mx_box_layout_fade_in_frame_cb,
+                              mx_box_layout_fade_in_done_cb,
+                              box);
+    }
+
+  return FALSE;
+}
+
+/* fades in a new child once the running animation has made room for it */
+static void
+mx_box_layout_fade_in_child (MxBoxLayout  *box,
+                             ClutterActor *actor)
+{
+  MxBoxLayoutPrivate *priv = box->priv;
+
+  if (!priv->transition)
+    return;
+
+  clutter_actor_set_opacity (actor, 0);
+  priv->fade_in_pending = g_list_prepend (priv->fade_in_pending, actor);
+}
+
 void
 _mx_box_layout_start_animation (MxBoxLayout *box)
 {
@@ -130,17 +249,12 @@ _mx_box_layout_start_animation (MxBoxLayout *box)
     return;
 
   priv->is_animating = TRUE;
+  priv->alpha = 0;
 
-  priv->timeline = clutter_timeline_new (300);
-  g_signal_connect_swapped (priv->timeline, "new-frame",
-                            G_CALLBACK (clutter_actor_queue_relayout), box);
-  g_signal_connect_swapped (priv->timeline, "completed",
-                            G_CALLBACK (_mx_box_layout_finish_animation), box);
-
-  priv->alpha = clutter_alpha_new_full (priv->timeline,
-                                        CLUTTER_EASE_OUT_CUBIC);
-
-  clutter_timeline_start (priv->timeline);
+  priv->transition = _mx_transition_start (300, CLUTTER_EASE_OUT_CUBIC,
+                                           mx_box_layout_animation_frame_cb,
+                                           mx_box_layout_animation_done_cb,
+                                           box);
 }
 
 void
@@ -148,18 +262,23 @@ _mx_box_layout_finish_animation (MxBoxLayout *box)
 {
   MxBoxLayoutPrivate *priv = box->priv;
 
-  if (priv->timeline)
+  if (priv->transition)
     {
-      g_object_unref (priv->timeline);
-      priv->timeline = NULL;
+      _mx_transition_stop (priv->transition);
+      priv->transition = 0;
     }
 
-  if (priv->alpha)
+  if (priv->fade_in_transition)
     {
-      g_object_unref (priv->alpha);
-      priv->alpha = NULL;
+      _mx_transition_stop (priv->fade_in_transition);
+      priv->fade_in_transition = 0;
     }
 
+  g_list_free (priv->fade_in_pending);
+  priv->fade_in_pending = NULL;
+  g_list_free (priv->fade_in_actors);
+  priv->fade_in_actors = NULL;
+
   priv->is_animating = FALSE;
 }
 
@@ -295,12 +414,6 @@ mx_box_scrollable_interface_init (MxScrollableIface *iface)
  * ClutterContainer Implementation
  */
 
-static void
-fade_in_actor (ClutterActor *actor)
-{
-  clutter_actor_animate (actor, CLUTTER_LINEAR, 300, "opacity", 0xff, NULL);
-}
-
 static void
 mx_box_container_add_actor (ClutterContainer *container,
                             ClutterActor     *actor)
@@ -314,14 +427,7 @@ mx_box_container_add_actor (ClutterContainer *container,
   if (priv->enable_animations)
     {
       _mx_box_layout_start_animation (MX_BOX_LAYOUT (container));
-
-      if (priv->timeline)
-        {
-          /* fade in the new actor when there is room */
-          clutter_actor_set_opacity (actor, 0);
-          g_signal_connect_swapped (priv->timeline, "completed",
-                                    G_CALLBACK (fade_in_actor), actor);
-        }
+      mx_box_layout_fade_in_child (MX_BOX_LAYOUT (container), actor);
     }
 
   g_signal_emit_by_name (container, "actor-added", actor);
@@ -353,6 +459,18 @@ mx_box_container_remove_actor (ClutterContainer *container,
   priv->children = g_list_delete_link (priv->children, item);
   clutter_actor_unparent (actor);
 
+  /* the fade in of a removed child won't run, so show it straight away */
+  if (g_list_find (priv->fade_in_pending, actor) ||
+      g_list_find (priv->fade_in_actors, actor))
+    {
+      priv->fade_in_pending = g_list_remove (priv->fade_in_pending, actor);
+      priv->fade_in_actors = g_list_remove (priv->fade_in_actors, actor);
+      clutter_actor_set_opacity (actor, 0xff);
+    }
+
+  /* the extents reference the removed child until the next allocation */
+  priv->extents_valid = FALSE;
+
   if (priv->enable_animations)
     _mx_box_layout_start_animation (MX_BOX_LAYOUT (container));
   else
@@ -817,6 +935,9 @@ mx_box_layout_finalize (GObject *object)
       priv->start_allocations = NULL;
     }
 
+  g_array_free (priv->alloc_children, TRUE);
+  g_array_free (priv->extents, TRUE);
+
   G_OBJECT_CLASS (mx_box_layout_parent_class)->finalize (object);
 }
 
@@ -846,6 +967,7 @@ mx_box_layout_get_preferred_width (ClutterActor *actor,
     {
       gfloat child_min = 0, child_nat = 0;
       gfloat child_for_height;
+      MxBoxLayoutChild *meta;
 
       if (!CLUTTER_ACTOR_IS_VISIBLE ((ClutterActor*) l->data))
         continue;
@@ -857,10 +979,11 @@ mx_box_layout_get_preferred_width (ClutterActor *actor,
       else
         child_for_height = -1;
 
-      clutter_actor_get_preferred_width ((ClutterActor*) l->data,
-                                         child_for_height,
-                                         &child_min,
-                                         &child_nat);
+      meta = (MxBoxLayoutChild *)
+        clutter_container_get_child_meta ((ClutterContainer *) actor,
+                                          (ClutterActor *) l->data);
+      _mx_box_layout_child_get_preferred_width (meta, child_for_height,
+                                                &child_min, &child_nat);
 
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
@@ -926,6 +1049,7 @@ mx_box_layout_get_preferred_height (ClutterActor *actor,
     {
       gfloat child_min = 0, child_nat = 0;
       gfloat child_for_width;
+      MxBoxLayoutChild *meta;
 
       if (!CLUTTER_ACTOR_IS_VISIBLE ((ClutterActor*) l->data))
         continue;
@@ -937,10 +1061,11 @@ mx_box_layout_get_preferred_height (ClutterActor *actor,
       else
         child_for_width = -1;
 
-      clutter_actor_get_preferred_height ((ClutterActor*) l->data,
-                                          child_for_width,
-                                          &child_min,
-                                          &child_nat);
+      meta = (MxBoxLayoutChild *)
+        clutter_container_get_child_meta ((ClutterContainer *) actor,
+                                          (ClutterActor *) l->data);
+      _mx_box_layout_child_get_preferred_height (meta, child_for_width,
+                                                 &child_min, &child_nat);
 
       if (priv->orientation == MX_ORIENTATION_HORIZONTAL)
         {
@@ -983,60 +1108,106 @@ mx_box_layout_allocate (ClutterActor          *actor,
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
   gfloat avail_width, avail_height, pref_width, pref_height;
+  gfloat min_size, nat_size, first_child_size;
   MxPadding padding = { 0, };
+  MxBoxLayoutAllocChild *children;
   gboolean allocate_pref;
   gfloat extra_space = 0;
   gfloat position = 0;
   GList *l;
-  gint n_expand_children, n_children;
+  gint i, n_expand_children, n_children;
 
   CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->allocate (actor, box,
                                                               flags);
 
+  g_array_set_size (priv->extents, 0);
+  priv->extents_valid = !priv->is_animating;
+
   if (priv->children == NULL)
     return;
 
-  /* count the number of children with expand set to TRUE and the
-   * amount of visible children.
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  /* do not take off padding just yet, as we are comparing this to the values
+   * from get_preferred_height/width which will include padding */
+  avail_width  = box->x2 - box->x1;
+  avail_height = box->y2 - box->y1;
+
+  /* Gather the visible children, their child meta and their sizes along the
+   * box orientation in a single pass. The sizes come from the per-child
+   * cache, so children that haven't changed aren't queried again.
    */
+  g_array_set_size (priv->alloc_children, g_list_length (priv->children));
+  children = (MxBoxLayoutAllocChild *) priv->alloc_children->data;
   n_children = n_expand_children = 0;
+  min_size = nat_size = 0;
+  first_child_size = 0;
+
   for (l = priv->children; l; l = l->next)
     {
-      ClutterActor *child;
+      ClutterActor *child = (ClutterActor *) l->data;
+      MxBoxLayoutAllocChild *alloc_child;
+      MxBoxLayoutChild *meta;
+      gfloat child_min, child_nat;
 
-      child = (ClutterActor*) l->data;
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child) && l != priv->children)
+        continue;
 
-      if (CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          MxBoxLayoutChild *meta;
+      meta = (MxBoxLayoutChild *)
+        clutter_container_get_child_meta ((ClutterContainer *) actor, child);
 
-          meta = (MxBoxLayoutChild*)
-            clutter_container_get_child_meta ((ClutterContainer *) actor,
-                                              child);
-          n_children++;
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
+        _mx_box_layout_child_get_preferred_height (meta,
+                                                   MAX (0, avail_width -
+                                                        padding.left -
+                                                        padding.right),
+                                                   &child_min, &child_nat);
+      else
+        _mx_box_layout_child_get_preferred_width (meta,
+                                                  MAX (0, avail_height -
+                                                       padding.top -
+                                                       padding.bottom),
+                                                  &child_min, &child_nat);
 
-          if (meta->expand)
-            n_expand_children++;
+      /* Base the adjustment stepping on the size of the first child.
+       * In the case where all your children are the same size, this
+       * will probably provide the desired behaviour.
+       */
+      if (l == priv->children)
+        {
+          first_child_size = (priv->orientation == MX_ORIENTATION_VERTICAL) ?
+            child_nat : child_min;
 
+          if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+            continue;
         }
+
+      alloc_child = &children[n_children++];
+      alloc_child->actor = child;
+      alloc_child->meta = meta;
+      alloc_child->min_size = child_min;
+      alloc_child->nat_size = child_nat;
+
+      min_size += child_min;
+      nat_size += child_nat;
+
+      if (meta->expand)
+        n_expand_children++;
     }
 
   /* We have no visible children, so bail out */
   if (n_children == 0)
     return;
 
-  mx_widget_get_padding (MX_WIDGET (actor), &padding);
-
-  /* do not take off padding just yet, as we are comparing this to the values
-   * from get_preferred_height/width which will include padding */
-  avail_width  = box->x2 - box->x1;
-  avail_height = box->y2 - box->y1;
+  min_size += priv->spacing * (n_children - 1);
+  nat_size += priv->spacing * (n_children - 1);
 
   if (priv->orientation == MX_ORIENTATION_VERTICAL)
     {
       gfloat min_height;
-      mx_box_layout_get_preferred_height (actor, avail_width,
-                                          &min_height, &pref_height);
+
+      min_height = min_size + padding.top + padding.bottom;
+      pref_height = nat_size + padding.top + padding.bottom;
       pref_width = avail_width;
 
       if (!priv->vadjustment && (pref_height > box->y2 - box->y1))
@@ -1051,8 +1222,9 @@ mx_box_layout_allocate (ClutterActor          *actor,
   else
     {
       gfloat min_width;
-      mx_box_layout_get_preferred_width (actor, avail_height,
-                                         &min_width, &pref_width);
+
+      min_width = min_size + padding.left + padding.right;
+      pref_width = nat_size + padding.left + padding.right;
       pref_height = avail_height;
 
       if (!priv->hadjustment && (pref_width > box->x2 - box->x1))
@@ -1078,19 +1250,9 @@ mx_box_layout_allocate (ClutterActor          *actor,
     {
       gdouble step_inc, page_inc;
 
-      /* Base the adjustment stepping on the size of the first child.
-       * In the case where all your children are the same size, this
-       * will probably provide the desired behaviour.
-       */
-      if (priv->children && priv->orientation == MX_ORIENTATION_VERTICAL)
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
-          gfloat child_height;
-          ClutterActor *first_child = (ClutterActor *)priv->children->data;
-          clutter_actor_get_preferred_height (first_child,
-                                              avail_width,
-                                              NULL,
-                                              &child_height);
-          step_inc = child_height;
+          step_inc = first_child_size;
           page_inc = ((gint)(avail_height / step_inc)) * step_inc;
         }
       else
@@ -1099,6 +1261,7 @@ mx_box_layout_allocate (ClutterActor          *actor,
           page_inc = avail_height;
         }
 
+      mx_adjustment_freeze (priv->vadjustment);
       g_object_set (G_OBJECT (priv->vadjustment),
                     "lower", 0.0,
                     "upper", pref_height,
@@ -1106,21 +1269,16 @@ mx_box_layout_allocate (ClutterActor          *actor,
                     "step-increment", step_inc,
                     "page-increment", page_inc,
                     NULL);
+      mx_adjustment_thaw (priv->vadjustment);
     }
 
   if (priv->hadjustment)
     {
       gdouble step_inc, page_inc;
 
-      if (priv->children && priv->orientation == MX_ORIENTATION_HORIZONTAL)
+      if (priv->orientation == MX_ORIENTATION_HORIZONTAL)
         {
-          gfloat child_width;
-          ClutterActor *first_child = (ClutterActor *)priv->children->data;
-          clutter_actor_get_preferred_width (first_child,
-                                             avail_height,
-                                             &child_width,
-                                             NULL);
-          step_inc = child_width;
+          step_inc = first_child_size;
           page_inc = ((gint)(avail_width / step_inc)) * step_inc;
         }
       else
@@ -1129,6 +1287,7 @@ mx_box_layout_allocate (ClutterActor          *actor,
           page_inc = avail_width;
         }
 
+      mx_adjustment_freeze (priv->hadjustment);
       g_object_set (G_OBJECT (priv->hadjustment),
                     "lower", 0.0,
                     "upper", pref_width,
@@ -1136,6 +1295,7 @@ mx_box_layout_allocate (ClutterActor          *actor,
                     "step-increment", step_inc,
                     "page-increment", page_inc,
                     NULL);
+      mx_adjustment_thaw (priv->hadjustment);
     }
 
   /* We're allocating our preferred size or higher, so calculate
@@ -1161,24 +1321,17 @@ mx_box_layout_allocate (ClutterActor          *actor,
   else
     position = padding.left;
 
-  for (l = priv->children; l; l = l->next)
+  for (i = 0; i < n_children; i++)
     {
-      ClutterActor *child = (ClutterActor*) l->data;
+      ClutterActor *child = children[i].actor;
+      MxBoxLayoutChild *meta = children[i].meta;
+      gfloat child_min = children[i].min_size;
+      gfloat child_nat = children[i].nat_size;
       ClutterActorBox child_box, old_child_box;
-      gfloat child_nat, child_min;
-      MxBoxLayoutChild *meta;
-
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
-
-      meta = (MxBoxLayoutChild*)
-        clutter_container_get_child_meta ((ClutterContainer *) actor, child);
+      gint n_remaining = n_children - i;
 
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
-          clutter_actor_get_preferred_height (child, avail_width,
-                                              &child_min, &child_nat);
-
           child_box.y1 = position;
 
           if (allocate_pref)
@@ -1192,9 +1345,8 @@ mx_box_layout_allocate (ClutterActor          *actor,
             {
               child_box.y2 =
                 position + MIN (child_nat,
-                                child_min + (int)(extra_space / n_children));
+                                child_min + (int)(extra_space / n_remaining));
 
-              n_children --;
               if (extra_space >= (child_box.y2 - child_box.y1 - child_min))
                 extra_space -= child_box.y2 - child_box.y1 - child_min;
               else
@@ -1206,9 +1358,6 @@ mx_box_layout_allocate (ClutterActor          *actor,
         }
       else
         {
-          clutter_actor_get_preferred_width (child, avail_height,
-                                             &child_min, &child_nat);
-
           child_box.x1 = position;
 
           if (allocate_pref)
@@ -1222,9 +1371,8 @@ mx_box_layout_allocate (ClutterActor          *actor,
             {
               child_box.x2 =
                 position + MIN (child_nat,
-                                child_min + (int)(extra_space / n_children));
+                                child_min + (int)(extra_space / n_remaining));
 
-              n_children --;
               if (extra_space >= (child_box.x2 - child_box.x1 - child_min))
                 extra_space -= child_box.x2 - child_box.x1 - child_min;
               else
@@ -1245,13 +1393,9 @@ mx_box_layout_allocate (ClutterActor          *actor,
           ClutterActorBox *start, *end, now;
           gdouble alpha;
 
-          ClutterActorBox *copy = g_new (ClutterActorBox, 1);
-
-          *copy = child_box;
-
           start = g_hash_table_lookup (priv->start_allocations, child);
           end = &child_box;
-          alpha = clutter_alpha_get_alpha (priv->alpha);
+          alpha = priv->alpha;
 
           if (!start)
             {
@@ -1285,6 +1429,13 @@ mx_box_layout_allocate (ClutterActor          *actor,
             }
 
           clutter_actor_allocate (child, copy, flags);
+
+          if (priv->orientation == MX_ORIENTATION_VERTICAL)
+            _mx_child_extents_append (priv->extents, child, &child_box,
+                                      old_child_box.y1, old_child_box.y2);
+          else
+            _mx_child_extents_append (priv->extents, child, &child_box,
+                                      old_child_box.x1, old_child_box.x2);
         }
 
 next:
@@ -1341,7 +1492,7 @@ mx_box_layout_get_paint_volume (ClutterActor       *actor,
 }
 
 static void
-mx_box_layout_paint (ClutterActor *actor)
+mx_box_layout_paint_children (ClutterActor *actor)
 {
   MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
   GList *l;
@@ -1349,8 +1500,6 @@ mx_box_layout_paint (ClutterActor *actor)
   ClutterActorBox child_b;
   ClutterActorBox box_b;
 
-  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->paint (actor);
-
   if (priv->children == NULL)
     return;
 
@@ -1370,6 +1519,14 @@ mx_box_layout_paint (ClutterActor *actor)
   box_b.y2 = (box_b.y2 - box_b.y1) + y;
   box_b.y1 = y;
 
+  /* the children are sorted along the box orientation, so only the visible
+   * ones need to be visited */
+  if (priv->extents_valid)
+    {
+      _mx_child_extents_paint (priv->extents, priv->orientation, &box_b);
+      return;
+    }
+
   for (l = priv->children; l; l = g_list_next (l))
     {
       ClutterActor *child = (ClutterActor*) l->data;
@@ -1379,64 +1536,31 @@ mx_box_layout_paint (ClutterActor *actor)
 
       clutter_actor_get_allocation_box (child, &child_b);
 
-      if ((child_b.x1 < box_b.x2) &&
-          (child_b.x2 > box_b.x1) &&
-          (child_b.y1 < box_b.y2) &&
-          (child_b.y2 > box_b.y1))
+      if ((child_b.x1 < box_b.x2)
+          && (child_b.x2 > box_b.x1)
+          && (child_b.y1 < box_b.y2)
+          && (child_b.y2 > box_b.y1))
         {
           clutter_actor_paint (child);
         }
     }
 }
 
+static void
+mx_box_layout_paint (ClutterActor *actor)
+{
+  CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->paint (actor);
+
+  mx_box_layout_paint_children (actor);
+}
+
 static void
 mx_box_layout_pick (ClutterActor       *actor,
                     const ClutterColor *color)
 {
-  MxBoxLayoutPrivate *priv = MX_BOX_LAYOUT (actor)->priv;
-  GList *l;
-  gdouble x, y;
-  ClutterActorBox child_b;
-  ClutterActorBox box_b;
-
   CLUTTER_ACTOR_CLASS (mx_box_layout_parent_class)->pick (actor, color);
 
-  if (priv->children == NULL)
-    return;
-
-  if (priv->hadjustment)
-    x = mx_adjustment_get_value (priv->hadjustment);
-  else
-    x = 0;
-
-  if (priv->vadjustment)
-    y = mx_adjustment_get_value (priv->vadjustment);
-  else
-    y = 0;
-
-  clutter_actor_get_allocation_box (actor, &box_b);
-  box_b.x2 = (box_b.x2 - box_b.x1) + x;
-  box_b.x1 = x;
-  box_b.y2 = (box_b.y2 - box_b.y1) + y;
-  box_b.y1 = y;
-
-  for (l = priv->children; l; l = g_list_next (l))
-    {
-      ClutterActor *child = (ClutterActor*) l->data;
-
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
-
-      clutter_actor_get_allocation_box (child, &child_b);
-
-      if ((child_b.x1 < box_b.x2)
-          && (child_b.x2 > box_b.x1)
-          && (child_b.y1 < box_b.y2)
-          && (child_b.y2 > box_b.y1))
-        {
-          clutter_actor_paint (child);
-        }
-    }
+  mx_box_layout_paint_children (actor);
 }
 
 static void
@@ -1542,6 +1666,10 @@ mx_box_layout_init (MxBoxLayout *self)
                                                          (GDestroyNotify)
                                                          mx_box_layout_free_allocation);
 
+  self->priv->alloc_children =
+    g_array_new (FALSE, FALSE, sizeof (MxBoxLayoutAllocChild));
+  self->priv->extents = g_array_new (FALSE, FALSE, sizeof (MxChildExtent));
+
   g_signal_connect (self, "style-changed",
                     G_CALLBACK (mx_box_layout_style_changed), NULL);
 
@@ -1790,14 +1918,7 @@ mx_box_layout_add_actor (MxBoxLayout  *box,
   if (priv->enable_animations)
     {
       _mx_box_layout_start_animation (box);
-
-      if (priv->timeline)
-        {
-          /* fade in the new actor when there is room */
-          clutter_actor_set_opacity (actor, 0);
-          g_signal_connect_swapped (priv->timeline, "completed",
-                                    G_CALLBACK (fade_in_actor), actor);
-        }
+      mx_box_layout_fade_in_child (box, actor);
     }
   else
     {
@@ -1808,6 +1929,81 @@ mx_box_layout_add_actor (MxBoxLayout  *box,
 
 }
 
+/**
+ * mx_box_layout_add_actors:
+ * @box: a #MxBoxLayout
+ * @actors: (element-type ClutterActor): the actors to add
+ * @position: the position where to insert the actors
+ *
+ * Inserts all the actors in @actors at @position in @box, keeping their
+ * order. This is the same as calling mx_box_layout_add_actor() for each
+ * actor, but the children list is only walked once, and the layout and
+ * animation are only updated once for all the actors.
+ *
+ * If @position is negative, or is larger than the number of actors in the
+ * layout, the new actors are added on to the end of the list.
+ *
+ * Since: 1.6
+ */
+void
+mx_box_layout_add_actors (MxBoxLayout *box,
+                          GList       *actors,
+                          gint         position)
+{
+  MxBoxLayoutPrivate *priv;
+  GList *l, *new_children, *sibling;
+
+  g_return_if_fail (MX_IS_BOX_LAYOUT (box));
+
+  if (!actors)
+    return;
+
+  /* Check all the actors first, so that nothing is added on failure */
+  if (!_mx_check_new_children (actors))
+    return;
+
+  priv = box->priv;
+
+  if (priv->enable_animations)
+    _mx_box_layout_start_animation (box);
+
+  new_children = NULL;
+  for (l = actors; l; l = l->next)
+    {
+      ClutterActor *actor = l->data;
+
+      new_children = g_list_prepend (new_children, actor);
+      mx_box_layout_create_child_meta (box, actor);
+      clutter_actor_set_parent (actor, (ClutterActor*) box);
+      mx_box_layout_fade_in_child (box, actor);
+    }
+  new_children = g_list_reverse (new_children);
+
+  /* splice the new children in before the child at position */
+  sibling = (position < 0) ? NULL : g_list_nth (priv->children, position);
+  if (!sibling)
+    priv->children = g_list_concat (priv->children, new_children);
+  else
+    {
+      GList *last = g_list_last (new_children);
+
+      new_children->prev = sibling->prev;
+      last->next = sibling;
+
+      if (sibling->prev)
+        sibling->prev->next = new_children;
+      else
+        priv->children = new_children;
+
+      sibling->prev = last;
+    }
+
+  clutter_actor_queue_relayout ((ClutterActor *) box);
+
+  for (l = actors; l; l = l->next)
+    g_signal_emit_by_name (box, "actor-added", l->data);
+}
+
 /**
  * mx_box_layout_add_actor_with_properties:
  * @box: a #MxBoxLayout
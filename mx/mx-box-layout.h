@@ -108,6 +108,9 @@ void          mx_box_layout_add_actor_with_properties (MxBoxLayout  *box,
                                                        gint          position,
                                                        const char   *first_property,
                                                        ...);
+void          mx_box_layout_add_actors     (MxBoxLayout  *box,
+                                            GList        *actors,
+                                            gint          position);
 
 void         mx_box_layout_set_scroll_to_focused (MxBoxLayout *box,
                                                   gboolean     scroll_to_focused);
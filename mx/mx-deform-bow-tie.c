@@ -166,6 +166,47 @@ mx_deform_bow_tie_deform (MxDeformTexture   *texture,
   vertex->z = height_radius * sin (turn_angle);
 }
 
+/* The same deformation as mx_deform_bow_tie_deform(), see there for
+ * comments */
+static const gchar *mx_deform_bow_tie_shader =
+  "uniform float period;\n"
+  "\n"
+  "void\n"
+  "mx_deform (inout vec4 position, inout vec4 color,\n"
+  "           float width, float height)\n"
+  "{\n"
+  "  float cx = period * (width + width / 2.0);\n"
+  "  float cy = height / 2.0;\n"
+  "  float rx = position.x - cx;\n"
+  "  float ry = position.y - cy;\n"
+  "  float turn_angle = clamp ((rx / (width / 4.0)) * MX_PI_2, -MX_PI, 0.0);\n"
+  "\n"
+  "  color.rgb = vec3 (floor ((cos (turn_angle * 2.0) * 96.0) + 159.0) /\n"
+  "                    255.0);\n"
+  "  color.a = 1.0;\n"
+  "\n"
+  "  position.y = (ry * cos (turn_angle)) + cy;\n"
+  "  position.z = ry * sin (turn_angle);\n"
+  "}\n";
+
+static const gchar *
+mx_deform_bow_tie_get_deform_shader (MxDeformTexture *texture)
+{
+  return mx_deform_bow_tie_shader;
+}
+
+static void
+mx_deform_bow_tie_set_shader_uniforms (MxDeformTexture *texture,
+                                       CoglHandle       program)
+{
+  MxDeformBowTiePrivate *priv = ((MxDeformBowTie *)texture)->priv;
+
+  cogl_program_set_uniform_1f (program,
+                               cogl_program_get_uniform_location (program,
+                                                                  "period"),
+                               priv->period);
+}
+
 static void
 mx_deform_bow_tie_back_notify (MxDeformBowTie *self,
                                GParamSpec     *pspec)
@@ -254,6 +295,11 @@ mx_deform_bow_tie_class_init (MxDeformBowTieClass *klass)
   object_class->dispose = mx_deform_bow_tie_dispose;
 
   deform_class->deform = mx_deform_bow_tie_deform;
+  deform_class->get_deform_shader = mx_deform_bow_tie_get_deform_shader;
+  deform_class->set_shader_uniforms = mx_deform_bow_tie_set_shader_uniforms;
+
+  /* the deform vfunc only reads priv and writes the vertex */
+  _mx_deform_texture_class_set_thread_safe (deform_class);
 
   pspec = g_param_spec_double ("period",
                                "Period",
@@ -163,6 +163,71 @@ mx_deform_page_turn_deform (MxDeformTexture   *texture,
     }
 }
 
+/* The same deformation as mx_deform_page_turn_deform(), see there for
+ * comments */
+static const gchar *mx_deform_page_turn_shader =
+  "uniform float period;\n"
+  "uniform float angle;\n"
+  "uniform float radius;\n"
+  "\n"
+  "void\n"
+  "mx_deform (inout vec4 position, inout vec4 color,\n"
+  "           float width, float height)\n"
+  "{\n"
+  "  float cx = (1.0 - period) * width;\n"
+  "  float cy = (1.0 - period) * height;\n"
+  "  float c = cos (angle);\n"
+  "  float s = sin (angle);\n"
+  "  float rx = ((position.x - cx) * c) + ((position.y - cy) * s) - radius;\n"
+  "  float ry = ((position.y - cy) * c) - ((position.x - cx) * s);\n"
+  "  float turn_angle = 0.0;\n"
+  "\n"
+  "  if (rx > -radius * 2.0)\n"
+  "    {\n"
+  "      turn_angle = (rx / radius * MX_PI_2) - MX_PI_2;\n"
+  "      color.rgb = vec3 (floor ((sin (turn_angle) * 96.0) + 159.0) /\n"
+  "                        255.0);\n"
+  "      color.a = 1.0;\n"
+  "    }\n"
+  "\n"
+  "  if (rx > 0.0)\n"
+  "    {\n"
+  "      float small_radius = radius -\n"
+  "        min (radius, (turn_angle * 10.0) / MX_PI);\n"
+  "\n"
+  "      rx = (small_radius * cos (turn_angle)) + radius;\n"
+  "      position.x = (rx * c) - (ry * s) + cx;\n"
+  "      position.y = (rx * s) + (ry * c) + cy;\n"
+  "      position.z = (small_radius * sin (turn_angle)) + radius;\n"
+  "    }\n"
+  "}\n";
+
+static const gchar *
+mx_deform_page_turn_get_deform_shader (MxDeformTexture *texture)
+{
+  return mx_deform_page_turn_shader;
+}
+
+static void
+mx_deform_page_turn_set_shader_uniforms (MxDeformTexture *texture,
+                                         CoglHandle       program)
+{
+  MxDeformPageTurnPrivate *priv = ((MxDeformPageTurn *)texture)->priv;
+
+  cogl_program_set_uniform_1f (program,
+                               cogl_program_get_uniform_location (program,
+                                                                  "period"),
+                               priv->period);
+  cogl_program_set_uniform_1f (program,
+                               cogl_program_get_uniform_location (program,
+                                                                  "angle"),
+                               priv->angle);
+  cogl_program_set_uniform_1f (program,
+                               cogl_program_get_uniform_location (program,
+                                                                  "radius"),
+                               priv->radius);
+}
+
 static void
 mx_deform_page_turn_class_init (MxDeformPageTurnClass *klass)
 {
@@ -177,6 +242,11 @@ mx_deform_page_turn_class_init (MxDeformPageTurnClass *klass)
   object_class->set_property = mx_deform_page_turn_set_property;
 
   deform_class->deform = mx_deform_page_turn_deform;
+  deform_class->get_deform_shader = mx_deform_page_turn_get_deform_shader;
+  deform_class->set_shader_uniforms = mx_deform_page_turn_set_shader_uniforms;
+
+  /* the deform vfunc only reads priv and writes the vertex */
+  _mx_deform_texture_class_set_thread_safe (deform_class);
 
   pspec = g_param_spec_double ("period",
                                "Period",
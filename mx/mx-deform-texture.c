@@ -27,12 +27,30 @@
  *
  * An abstract widget that provides the interface for producing mesh
  * deformation effects with a texture.
+ *
+ * Subclasses that provide a GLSL version of their deformation are deformed
+ * in a vertex shader when it is supported, so that the mesh doesn't need to
+ * be recalculated and uploaded every time the effect changes. See
+ * #MxDeformTextureClass and mx_deform_texture_set_use_shader().
+ *
+ * Otherwise, the mesh is deformed on the CPU whenever it has been
+ * invalidated. The large meshes of the deformations provided by Mx are
+ * split between several threads. The number of threads defaults to the
+ * number of processors, and can be set with the
+ * <envar>MX_DEFORM_THREADS</envar> environment variable.
  */
 
+#include <stdlib.h>
+#include <unistd.h>
+
 #include "mx-deform-texture.h"
 #include "mx-offscreen.h"
 #include "mx-private.h"
 
+/* Meshes with fewer vertices than this are deformed on the painting thread
+ * only, as handing them out to other threads costs more than it saves */
+#define MIN_PARALLEL_VERTICES 4096
+
 G_DEFINE_ABSTRACT_TYPE (MxDeformTexture, mx_deform_texture, MX_TYPE_WIDGET)
 
 #define DEFORM_TEXTURE_PRIVATE(o) \
@@ -49,12 +67,56 @@ struct _MxDeformTexturePrivate
   CoglHandle          bf_indices;
   CoglTextureVertex  *vertices;
 
+  /* The undeformed texture coordinates, which are also the positions of
+   * the undeformed mesh used by the vertex shader */
+  gfloat             *tex_coords;
+
   ClutterActor       *front;
   ClutterActor       *back;
 
   gboolean            dirty;
+
+  /* The size and opacity the vertices were last deformed at */
+  gfloat              deform_width;
+  gfloat              deform_height;
+  guint8              deform_opacity;
+
+  /* The undeformed mesh used by the vertex shader */
+  CoglHandle          grid_vbo;
+  CoglHandle          program;
+
+  guint               use_shader    : 1;
+  guint               shader_failed : 1;
+
+  /* Whether the deformation changed the texture coordinates, in which
+   * case they are uploaded with the vertices */
+  guint               tex_coords_changed : 1;
 };
 
+typedef struct
+{
+  GMutex *mutex;
+  GCond  *cond;
+  gint    pending;
+} MxDeformTextureJob;
+
+typedef struct
+{
+  MxDeformTexture    *texture;
+  MxDeformTextureJob *job;
+
+  gint                first_row;
+  gint                n_rows;
+  gfloat              width;
+  gfloat              height;
+  guint8              opacity;
+
+  gboolean            tex_coords_changed;
+} MxDeformTextureChunk;
+
+static GThreadPool *mx_deform_texture_threads = NULL;
+static gint mx_deform_texture_n_threads = 0;
+
 enum
 {
   PROP_0,
@@ -63,8 +125,30 @@ enum
   PROP_TILES_Y,
   PROP_FRONT,
   PROP_BACK,
+  PROP_USE_SHADER
 };
 
+/* Declarations used by the vertex shader, before the subclass's source */
+static const gchar *mx_deform_texture_shader_prelude =
+  "uniform vec2 mx_deform_size;\n"
+  "uniform float mx_deform_opacity;\n"
+  "#define MX_PI 3.1415926535897932\n"
+  "#define MX_PI_2 1.5707963267948966\n";
+
+/* The vertex shader entry point, after the subclass's source. This mirrors
+ * the CPU path in mx_deform_texture_paint() */
+static const gchar *mx_deform_texture_shader_main =
+  "void\n"
+  "main ()\n"
+  "{\n"
+  "  vec4 position = vec4 (cogl_position_in.xy * mx_deform_size, 0.0, 1.0);\n"
+  "  vec4 color = vec4 (1.0, 1.0, 1.0, mx_deform_opacity);\n"
+  "  mx_deform (position, color, mx_deform_size.x, mx_deform_size.y);\n"
+  "  cogl_position_out = cogl_modelview_projection_matrix * position;\n"
+  "  cogl_color_out = color;\n"
+  "  cogl_tex_coord_out[0] = cogl_texture_matrix[0] * cogl_tex_coord_in;\n"
+  "}\n";
+
 static void
 mx_deform_texture_get_property (GObject    *object,
                                 guint       property_id,
@@ -91,6 +175,10 @@ mx_deform_texture_get_property (GObject    *object,
       g_value_set_object (value, priv->back);
       break;
 
+    case PROP_USE_SHADER:
+      g_value_set_boolean (value, priv->use_shader);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -133,6 +221,10 @@ mx_deform_texture_set_property (GObject      *object,
                                       g_value_get_object (value));
       break;
 
+    case PROP_USE_SHADER:
+      mx_deform_texture_set_use_shader (texture, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -155,8 +247,23 @@ mx_deform_texture_free_arrays (MxDeformTexture *self)
       priv->indices = NULL;
     }
 
+  if (priv->bf_indices)
+    {
+      cogl_handle_unref (priv->bf_indices);
+      priv->bf_indices = NULL;
+    }
+
+  if (priv->grid_vbo)
+    {
+      cogl_handle_unref (priv->grid_vbo);
+      priv->grid_vbo = NULL;
+    }
+
   g_free (priv->vertices);
   priv->vertices = NULL;
+
+  g_free (priv->tex_coords);
+  priv->tex_coords = NULL;
 }
 
 static void
@@ -167,6 +274,12 @@ mx_deform_texture_dispose (GObject *object)
 
   mx_deform_texture_free_arrays (self);
 
+  if (priv->program)
+    {
+      cogl_handle_unref (priv->program);
+      priv->program = NULL;
+    }
+
   if (priv->front)
     {
       clutter_actor_unparent (priv->front);
@@ -188,73 +301,398 @@ mx_deform_texture_finalize (GObject *object)
   G_OBJECT_CLASS (mx_deform_texture_parent_class)->finalize (object);
 }
 
+static gboolean
+mx_deform_texture_ensure_program (MxDeformTexture *self)
+{
+  gchar *source;
+  const gchar *deform_source;
+  CoglHandle shader;
+
+  MxDeformTexturePrivate *priv = self->priv;
+  MxDeformTextureClass *klass = MX_DEFORM_TEXTURE_GET_CLASS (self);
+
+  if (priv->program)
+    return TRUE;
+
+  if (priv->shader_failed)
+    return FALSE;
+
+  deform_source = NULL;
+  if (klass->get_deform_shader &&
+      cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+    deform_source = klass->get_deform_shader (self);
+
+  if (!deform_source)
+    {
+      priv->shader_failed = TRUE;
+      return FALSE;
+    }
+
+  source = g_strconcat (mx_deform_texture_shader_prelude,
+                        deform_source,
+                        mx_deform_texture_shader_main,
+                        NULL);
+
+  shader = cogl_create_shader (COGL_SHADER_TYPE_VERTEX);
+  cogl_shader_source (shader, source);
+  cogl_shader_compile (shader);
+  g_free (source);
+
+  if (!cogl_shader_is_compiled (shader))
+    {
+      gchar *log = cogl_shader_get_info_log (shader);
+
+      g_warning (G_STRLOC ": Unable to compile the deformation shader of "
+                 "'%s', falling back to deforming on the CPU: %s",
+                 G_OBJECT_TYPE_NAME (self), log);
+      g_free (log);
+
+      cogl_handle_unref (shader);
+      priv->shader_failed = TRUE;
+
+      return FALSE;
+    }
+
+  priv->program = cogl_create_program ();
+  cogl_program_attach_shader (priv->program, shader);
+  cogl_program_link (priv->program);
+  cogl_handle_unref (shader);
+
+  return TRUE;
+}
+
+static gboolean
+mx_deform_texture_can_use_shader (MxDeformTexture *self)
+{
+  ClutterActor *actor;
+
+  if (!self->priv->use_shader)
+    return FALSE;
+
+  /* A #ClutterShader on us or an ancestor would be replaced by ours */
+  for (actor = CLUTTER_ACTOR (self);
+       actor;
+       actor = clutter_actor_get_parent (actor))
+    {
+      ClutterShader *shader = clutter_actor_get_shader (actor);
+      if (shader && clutter_shader_get_is_enabled (shader))
+        return FALSE;
+    }
+
+  return mx_deform_texture_ensure_program (self);
+}
+
+static void
+mx_deform_texture_ensure_grid (MxDeformTexture *self)
+{
+  MxDeformTexturePrivate *priv = self->priv;
+
+  if (priv->grid_vbo)
+    return;
+
+  /* The undeformed mesh is in texture coordinates, the vertex shader
+   * scales the positions to the size of the actor.
+   */
+  priv->grid_vbo = cogl_vertex_buffer_new ((priv->tiles_x + 1) *
+                                           (priv->tiles_y + 1));
+  cogl_vertex_buffer_add (priv->grid_vbo,
+                          "gl_Vertex",
+                          2,
+                          COGL_ATTRIBUTE_TYPE_FLOAT,
+                          FALSE,
+                          sizeof (gfloat) * 2,
+                          priv->tex_coords);
+  cogl_vertex_buffer_add (priv->grid_vbo,
+                          "gl_MultiTexCoord0",
+                          2,
+                          COGL_ATTRIBUTE_TYPE_FLOAT,
+                          FALSE,
+                          sizeof (gfloat) * 2,
+                          priv->tex_coords);
+  cogl_vertex_buffer_submit (priv->grid_vbo);
+}
+
+static void
+mx_deform_texture_update_shader (MxDeformTexture *self)
+{
+  gint location;
+  gfloat size[2];
+  guint opacity;
+
+  MxDeformTexturePrivate *priv = self->priv;
+  MxDeformTextureClass *klass = MX_DEFORM_TEXTURE_GET_CLASS (self);
+
+  mx_deform_texture_ensure_grid (self);
+
+  clutter_actor_get_size (CLUTTER_ACTOR (self), &size[0], &size[1]);
+  location = cogl_program_get_uniform_location (priv->program,
+                                                "mx_deform_size");
+  cogl_program_set_uniform_float (priv->program, location, 2, 1, size);
+
+  opacity = clutter_actor_get_paint_opacity (CLUTTER_ACTOR (self));
+  location = cogl_program_get_uniform_location (priv->program,
+                                                "mx_deform_opacity");
+  cogl_program_set_uniform_1f (priv->program, location, opacity / 255.f);
+
+  if (klass->set_shader_uniforms)
+    klass->set_shader_uniforms (self, priv->program);
+}
+
+static void
+mx_deform_texture_deform_chunk (MxDeformTextureChunk *chunk)
+{
+  gint i, j, last_row;
+
+  MxDeformTexture *self = chunk->texture;
+  MxDeformTexturePrivate *priv = self->priv;
+  MxDeformTextureClass *klass = MX_DEFORM_TEXTURE_GET_CLASS (self);
+
+  last_row = chunk->first_row + chunk->n_rows;
+  for (i = chunk->first_row; i < last_row; i++)
+    {
+      for (j = 0; j <= priv->tiles_x; j++)
+        {
+          gint index = (i * (priv->tiles_x + 1)) + j;
+          CoglTextureVertex *vertex = &priv->vertices[index];
+          gfloat *tex_coord = &priv->tex_coords[index * 2];
+
+          vertex->tx = tex_coord[0];
+          vertex->ty = tex_coord[1];
+          vertex->x = chunk->width * vertex->tx;
+          vertex->y = chunk->height * vertex->ty;
+          vertex->z = 0;
+          cogl_color_set_from_4ub (&vertex->color,
+                                   0xff, 0xff, 0xff, chunk->opacity);
+
+          klass->deform (self, vertex, chunk->width, chunk->height);
+
+          if ((vertex->tx != tex_coord[0]) || (vertex->ty != tex_coord[1]))
+            chunk->tex_coords_changed = TRUE;
+        }
+    }
+}
+
+static void
+mx_deform_texture_thread_cb (MxDeformTextureChunk *chunk,
+                             gpointer              user_data)
+{
+  MxDeformTextureJob *job = chunk->job;
+
+  mx_deform_texture_deform_chunk (chunk);
+
+  g_mutex_lock (job->mutex);
+  if (--job->pending == 0)
+    g_cond_signal (job->cond);
+  g_mutex_unlock (job->mutex);
+}
+
+static gint
+mx_deform_texture_ensure_threads (void)
+{
+  if (mx_deform_texture_n_threads)
+    return mx_deform_texture_n_threads;
+
+  /* The number of threads to deform on, including the painting thread */
+  if (g_getenv ("MX_DEFORM_THREADS"))
+    mx_deform_texture_n_threads = atoi (g_getenv ("MX_DEFORM_THREADS"));
+  else
+#ifdef _SC_NPROCESSORS_ONLN
+    mx_deform_texture_n_threads = sysconf (_SC_NPROCESSORS_ONLN);
+#else
+    /* FIXME: add more OSs */
+    mx_deform_texture_n_threads = 1;
+#endif
+
+  if (!g_thread_supported ())
+    mx_deform_texture_n_threads = 1;
+
+  if (mx_deform_texture_n_threads > 1)
+    {
+      GError *error = NULL;
+
+      mx_deform_texture_threads =
+        g_thread_pool_new ((GFunc)mx_deform_texture_thread_cb, NULL,
+                           mx_deform_texture_n_threads - 1,
+                           FALSE, &error);
+      if (!mx_deform_texture_threads)
+        {
+          g_warning (G_STRLOC ": Unable to create deformation threads: %s",
+                     error->message);
+          g_error_free (error);
+        }
+    }
+
+  if (!mx_deform_texture_threads)
+    mx_deform_texture_n_threads = 1;
+
+  return mx_deform_texture_n_threads;
+}
+
+/*
+ * _mx_deform_texture_class_set_thread_safe:
+ * @klass: An #MxDeformTextureClass
+ *
+ * Declares that the current #MxDeformTextureClass.deform of @klass only
+ * writes to the vertex it is given, so that large meshes can be deformed
+ * on several threads at once.
+ */
+void
+_mx_deform_texture_class_set_thread_safe (MxDeformTextureClass *klass)
+{
+  klass->_thread_safe_deform = klass->deform;
+}
+
+static void
+mx_deform_texture_deform_vertices (MxDeformTexture *self,
+                                   gfloat           width,
+                                   gfloat           height,
+                                   guint8           opacity)
+{
+  gint i, n_rows, n_chunks, rows_per_chunk;
+  MxDeformTextureChunk *chunks;
+  MxDeformTextureJob job;
+
+  MxDeformTexturePrivate *priv = self->priv;
+  MxDeformTextureClass *klass = MX_DEFORM_TEXTURE_GET_CLASS (self);
+
+  /* Split the rows of the mesh between the available threads, if the
+   * deform vfunc supports it. A subclass that overrides it doesn't
+   * inherit the support. */
+  n_rows = priv->tiles_y + 1;
+  n_chunks = 1;
+  if (klass->deform == klass->_thread_safe_deform
+      && (priv->tiles_x + 1) * n_rows >= MIN_PARALLEL_VERTICES)
+    n_chunks = MIN (mx_deform_texture_ensure_threads (), n_rows);
+  rows_per_chunk = (n_rows + n_chunks - 1) / n_chunks;
+  n_chunks = (n_rows + rows_per_chunk - 1) / rows_per_chunk;
+
+  chunks = g_newa (MxDeformTextureChunk, n_chunks);
+  for (i = 0; i < n_chunks; i++)
+    {
+      chunks[i].texture = self;
+      chunks[i].job = &job;
+      chunks[i].first_row = i * rows_per_chunk;
+      chunks[i].n_rows = MIN (rows_per_chunk, n_rows - chunks[i].first_row);
+      chunks[i].width = width;
+      chunks[i].height = height;
+      chunks[i].opacity = opacity;
+      chunks[i].tex_coords_changed = FALSE;
+    }
+
+  /* Hand all but the first chunk to other threads, and deform the first
+   * one while they run.
+   */
+  if (n_chunks > 1)
+    {
+      job.mutex = g_mutex_new ();
+      job.cond = g_cond_new ();
+      job.pending = n_chunks - 1;
+
+      for (i = 1; i < n_chunks; i++)
+        g_thread_pool_push (mx_deform_texture_threads, &chunks[i], NULL);
+    }
+
+  mx_deform_texture_deform_chunk (&chunks[0]);
+
+  if (n_chunks > 1)
+    {
+      g_mutex_lock (job.mutex);
+      while (job.pending)
+        g_cond_wait (job.cond, job.mutex);
+      g_mutex_unlock (job.mutex);
+
+      g_mutex_free (job.mutex);
+      g_cond_free (job.cond);
+    }
+
+  priv->tex_coords_changed = FALSE;
+  for (i = 0; i < n_chunks; i++)
+    if (chunks[i].tex_coords_changed)
+      priv->tex_coords_changed = TRUE;
+}
+
 static void
 mx_deform_texture_paint (ClutterActor *actor)
 {
-  gint i, j;
-  gboolean depth, cull;
-  CoglHandle front_material, back_material;
+  gboolean depth, cull, use_shader;
+  CoglHandle front_material, back_material, vbo;
 
   MxDeformTexture *self = MX_DEFORM_TEXTURE (actor);
   MxDeformTexturePrivate *priv = self->priv;
 
-  if (priv->dirty)
+  use_shader = mx_deform_texture_can_use_shader (self);
+
+  if (use_shader)
     {
-      guint opacity;
+      mx_deform_texture_update_shader (self);
+      vbo = priv->grid_vbo;
+    }
+  else
+    vbo = priv->vbo;
+
+  if (!use_shader)
+    {
+      guint8 opacity;
       gfloat width, height;
+      gboolean tex_coords_changed;
 
+      /* Only deform the mesh again if the deformation, our size or our
+       * opacity changed since it was last deformed.
+       */
       opacity = clutter_actor_get_paint_opacity (actor);
       clutter_actor_get_size (actor, &width, &height);
 
-      for (i = 0; i <= priv->tiles_y; i++)
+      if ((width != priv->deform_width) ||
+          (height != priv->deform_height) ||
+          (opacity != priv->deform_opacity))
+        priv->dirty = TRUE;
+
+      if (priv->dirty)
         {
-          for (j = 0; j <= priv->tiles_x; j++)
-            {
-              CoglTextureVertex *vertex =
-                &priv->vertices[(i * (priv->tiles_x + 1)) + j];
-
-              vertex->tx = j/(gfloat)priv->tiles_x;
-              vertex->ty = i/(gfloat)priv->tiles_y;
-              vertex->x = width * vertex->tx;
-              vertex->y = height * vertex->ty;
-              vertex->z = 0;
-              cogl_color_set_from_4ub (&vertex->color,
-                                       0xff, 0xff, 0xff, opacity);
-
-              MX_DEFORM_TEXTURE_GET_CLASS (self)->
-                deform (self, vertex, width, height);
-            }
+          tex_coords_changed = priv->tex_coords_changed;
+          mx_deform_texture_deform_vertices (self, width, height, opacity);
+
+          priv->deform_width = width;
+          priv->deform_height = height;
+          priv->deform_opacity = opacity;
+
+          /* The texture coordinates are kept in a separate buffer, and are
+           * only uploaded again if the deformation changes them.
+           */
+          cogl_vertex_buffer_add (priv->vbo,
+                                  "gl_Vertex",
+                                  3,
+                                  COGL_ATTRIBUTE_TYPE_FLOAT,
+                                  FALSE,
+                                  sizeof (CoglTextureVertex),
+                                  &priv->vertices->x);
+          if (priv->tex_coords_changed)
+            cogl_vertex_buffer_add (priv->vbo,
+                                    "gl_MultiTexCoord0",
+                                    2,
+                                    COGL_ATTRIBUTE_TYPE_FLOAT,
+                                    FALSE,
+                                    sizeof (CoglTextureVertex),
+                                    &priv->vertices->tx);
+          else if (tex_coords_changed)
+            cogl_vertex_buffer_add (priv->vbo,
+                                    "gl_MultiTexCoord0",
+                                    2,
+                                    COGL_ATTRIBUTE_TYPE_FLOAT,
+                                    FALSE,
+                                    sizeof (gfloat) * 2,
+                                    priv->tex_coords);
+          cogl_vertex_buffer_add (priv->vbo,
+                                  "gl_Color",
+                                  4,
+                                  COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE,
+                                  FALSE,
+                                  sizeof (CoglTextureVertex),
+                                  &priv->vertices->color);
+          cogl_vertex_buffer_submit (priv->vbo);
+
+          priv->dirty = FALSE;
         }
-
-      /* We add all three attributes again, although in an ideal case,
-       * we'd add only those that had changed. Because we provide the
-       * ability to change each, unless we had a 'changed' gboolean * in
-       * the function prototype, we have to upload all of it.
-       */
-      cogl_vertex_buffer_add (priv->vbo,
-                              "gl_Vertex",
-                              3,
-                              COGL_ATTRIBUTE_TYPE_FLOAT,
-                              FALSE,
-                              sizeof (CoglTextureVertex),
-                              &priv->vertices->x);
-      cogl_vertex_buffer_add (priv->vbo,
-                              "gl_MultiTexCoord0",
-                              2,
-                              COGL_ATTRIBUTE_TYPE_FLOAT,
-                              FALSE,
-                              sizeof (CoglTextureVertex),
-                              &priv->vertices->tx);
-      cogl_vertex_buffer_add (priv->vbo,
-                              "gl_Color",
-                              4,
-                              COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE,
-                              FALSE,
-                              sizeof (CoglTextureVertex),
-                              &priv->vertices->color);
-      cogl_vertex_buffer_submit (priv->vbo);
-
-      priv->dirty = FALSE;
     }
 
   /* Get materials and update FBOs if necessary */
@@ -286,10 +724,13 @@ mx_deform_texture_paint (ClutterActor *actor)
   else if (!back_material && cull)
     cogl_set_backface_culling_enabled (FALSE);
 
+  if (use_shader)
+    cogl_program_use (priv->program);
+
   if (front_material)
     {
       cogl_set_source (front_material);
-      cogl_vertex_buffer_draw_elements (priv->vbo,
+      cogl_vertex_buffer_draw_elements (vbo,
                                         COGL_VERTICES_MODE_TRIANGLE_STRIP,
                                         priv->indices,
                                         0,
@@ -302,7 +743,7 @@ mx_deform_texture_paint (ClutterActor *actor)
   if (back_material)
     {
       cogl_set_source (back_material);
-      cogl_vertex_buffer_draw_elements (priv->vbo,
+      cogl_vertex_buffer_draw_elements (vbo,
                                         COGL_VERTICES_MODE_TRIANGLE_STRIP,
                                         priv->bf_indices,
                                         0,
@@ -312,6 +753,9 @@ mx_deform_texture_paint (ClutterActor *actor)
                                         priv->n_indices);
     }
 
+  if (use_shader)
+    cogl_program_use (COGL_INVALID_HANDLE);
+
   if (!depth)
     cogl_set_depth_test_enabled (FALSE);
   if (back_material && !cull)
@@ -384,8 +828,7 @@ mx_deform_texture_allocate (ClutterActor           *actor,
   ClutterActorBox child_box;
   MxDeformTexturePrivate *priv = MX_DEFORM_TEXTURE (actor)->priv;
 
-  /* The size has changed, so make sure we recalculate values */
-  priv->dirty = TRUE;
+  /* Changes of size are picked up when painting */
 
   /* Chain up */
   CLUTTER_ACTOR_CLASS (mx_deform_texture_parent_class)->
@@ -488,6 +931,22 @@ mx_deform_texture_class_init (MxDeformTextureClass *klass)
                                CLUTTER_TYPE_TEXTURE,
                                MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_BACK, pspec);
+
+  /**
+   * MxDeformTexture:use-shader:
+   *
+   * Whether to deform the mesh in a vertex shader, when the deformation
+   * provides one and GLSL is supported.
+   *
+   * Since: 1.6
+   */
+  pspec = g_param_spec_boolean ("use-shader",
+                                "Use shader",
+                                "Deform the mesh in a vertex shader when "
+                                "possible.",
+                                TRUE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_USE_SHADER, pspec);
 }
 
 static void
@@ -495,6 +954,7 @@ mx_deform_texture_init_arrays (MxDeformTexture *self)
 {
   GLushort *idx, *bf_idx;
   gint x, y, direction;
+  gfloat *tex_coord;
   GLushort *static_indices, *static_bf_indices;
   MxDeformTexturePrivate *priv = self->priv;
 
@@ -585,8 +1045,30 @@ mx_deform_texture_init_arrays (MxDeformTexture *self)
   priv->vertices = g_new (CoglTextureVertex,
                           (priv->tiles_x + 1) * (priv->tiles_y + 1));
 
+  priv->tex_coords = g_new (gfloat,
+                            (priv->tiles_x + 1) * (priv->tiles_y + 1) * 2);
+  tex_coord = priv->tex_coords;
+  for (y = 0; y <= priv->tiles_y; y++)
+    for (x = 0; x <= priv->tiles_x; x++)
+      {
+        tex_coord[0] = x/(gfloat)priv->tiles_x;
+        tex_coord[1] = y/(gfloat)priv->tiles_y;
+        tex_coord += 2;
+      }
+
+  /* The texture coordinates don't normally change, so they're only added
+   * once here, rather than with the vertices every time they change.
+   */
   priv->vbo = cogl_vertex_buffer_new ((priv->tiles_x + 1) *
                                       (priv->tiles_y + 1));
+  cogl_vertex_buffer_add (priv->vbo,
+                          "gl_MultiTexCoord0",
+                          2,
+                          COGL_ATTRIBUTE_TYPE_FLOAT,
+                          FALSE,
+                          sizeof (gfloat) * 2,
+                          priv->tex_coords);
+  priv->tex_coords_changed = FALSE;
 
   priv->dirty = TRUE;
 }
@@ -598,6 +1080,7 @@ mx_deform_texture_init (MxDeformTexture *self)
 
   priv->tiles_x = 32;
   priv->tiles_y = 32;
+  priv->use_shader = TRUE;
   mx_deform_texture_init_arrays (self);
 }
 /**
@@ -749,3 +1232,49 @@ mx_deform_texture_invalidate (MxDeformTexture *texture)
   priv->dirty = TRUE;
   clutter_actor_queue_redraw (CLUTTER_ACTOR (texture));
 }
+
+/**
+ * mx_deform_texture_set_use_shader:
+ * @texture: A #MxDeformTexture
+ * @use_shader: %TRUE to deform the mesh in a vertex shader when possible
+ *
+ * Sets whether the mesh of @texture is deformed in a vertex shader. The
+ * shader is only used when the deformation provides one and GLSL is
+ * supported, otherwise the mesh is deformed on the CPU.
+ *
+ * Since: 1.6
+ */
+void
+mx_deform_texture_set_use_shader (MxDeformTexture *texture,
+                                  gboolean         use_shader)
+{
+  MxDeformTexturePrivate *priv;
+
+  g_return_if_fail (MX_IS_DEFORM_TEXTURE (texture));
+
+  priv = texture->priv;
+
+  if (priv->use_shader != use_shader)
+    {
+      priv->use_shader = use_shader;
+      g_object_notify (G_OBJECT (texture), "use-shader");
+      mx_deform_texture_invalidate (texture);
+    }
+}
+
+/**
+ * mx_deform_texture_get_use_shader:
+ * @texture: A #MxDeformTexture
+ *
+ * Gets the value of the #MxDeformTexture:use-shader property.
+ *
+ * Returns: %TRUE if the mesh is deformed in a vertex shader when possible
+ *
+ * Since: 1.6
+ */
+gboolean
+mx_deform_texture_get_use_shader (MxDeformTexture *texture)
+{
+  g_return_val_if_fail (MX_IS_DEFORM_TEXTURE (texture), FALSE);
+  return texture->priv->use_shader;
+}
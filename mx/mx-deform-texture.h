@@ -72,22 +72,54 @@ struct _MxDeformTexture
   MxDeformTexturePrivate *priv;
 };
 
+/**
+ * MxDeformTextureClass:
+ * @deform: deforms a single vertex of the mesh on the CPU
+ * @get_deform_shader: returns the GLSL source of a
+ *   <function>mx_deform</function> function that performs the same
+ *   deformation as @deform in a vertex shader, or %NULL
+ * @set_shader_uniforms: sets the uniforms used by the shader returned by
+ *   @get_deform_shader on @program
+ *
+ * When @get_deform_shader returns a shader and GLSL is available, the
+ * undeformed mesh is kept in a vertex buffer and deformed in a vertex
+ * shader. Otherwise, @deform is called for every vertex whenever the
+ * texture is invalidated.
+ *
+ * The shader source must define a function with the signature
+ * <programlisting>
+ * void mx_deform (inout vec4 position, inout vec4 color,
+ *                 float width, float height);
+ * </programlisting>
+ * and may declare any uniforms it uses. The constants
+ * <literal>MX_PI</literal> and <literal>MX_PI_2</literal> are defined.
+ */
 struct _MxDeformTextureClass
 {
+  /*< private >*/
   MxWidgetClass parent_class;
 
+  /*< public >*/
   /* vfuncs */
   void (*deform) (MxDeformTexture   *texture,
                   CoglTextureVertex *vertex,
                   gfloat             width,
                   gfloat             height);
 
+  const gchar * (*get_deform_shader)   (MxDeformTexture *texture);
+  void          (*set_shader_uniforms) (MxDeformTexture *texture,
+                                        CoglHandle       program);
+
+  /*< private >*/
+  /* the @deform that may be called from several threads at once */
+  void (*_thread_safe_deform) (MxDeformTexture   *texture,
+                               CoglTextureVertex *vertex,
+                               gfloat             width,
+                               gfloat             height);
+
   /* padding for future expansion */
   void (*_padding_0) (void);
   void (*_padding_1) (void);
-  void (*_padding_2) (void);
-  void (*_padding_3) (void);
-  void (*_padding_4) (void);
 };
 
 GType mx_deform_texture_get_type (void) G_GNUC_CONST;
@@ -110,6 +142,10 @@ void mx_deform_texture_get_textures (MxDeformTexture  *texture,
 
 void mx_deform_texture_invalidate (MxDeformTexture *texture);
 
+void     mx_deform_texture_set_use_shader (MxDeformTexture *texture,
+                                           gboolean         use_shader);
+gboolean mx_deform_texture_get_use_shader (MxDeformTexture *texture);
+
 G_END_DECLS
 
 #endif /* _MX_DEFORM_TEXTURE_H */
@@ -152,6 +152,63 @@ mx_deform_waves_deform (MxDeformTexture   *texture,
   vertex->z = height_radius * sin (turn_angle) * priv->amplitude;
 }
 
+/* The same deformation as mx_deform_waves_deform(), see there for
+ * comments */
+static const gchar *mx_deform_waves_shader =
+  "uniform float period;\n"
+  "uniform float angle;\n"
+  "uniform float radius;\n"
+  "uniform float amplitude;\n"
+  "\n"
+  "void\n"
+  "mx_deform (inout vec4 position, inout vec4 color,\n"
+  "           float width, float height)\n"
+  "{\n"
+  "  float cx = (1.0 - period) * width;\n"
+  "  float cy = (1.0 - period) * height;\n"
+  "  float rx = ((position.x - cx) * cos (angle)) +\n"
+  "             ((position.y - cy) * sin (angle)) - radius;\n"
+  "  float turn_angle = ((rx / radius) * MX_PI_2) - MX_PI_2;\n"
+  "  float height_radius = (1.0 - rx / width) * radius;\n"
+  "\n"
+  "  color.rgb = vec3 (floor ((255.0 * (1.0 - amplitude)) +\n"
+  "                           (((sin (turn_angle) * 96.0) + 159.0) *\n"
+  "                            amplitude)) / 255.0);\n"
+  "  color.a = 1.0;\n"
+  "\n"
+  "  position.z = height_radius * sin (turn_angle) * amplitude;\n"
+  "}\n";
+
+static const gchar *
+mx_deform_waves_get_deform_shader (MxDeformTexture *texture)
+{
+  return mx_deform_waves_shader;
+}
+
+static void
+mx_deform_waves_set_shader_uniforms (MxDeformTexture *texture,
+                                     CoglHandle       program)
+{
+  MxDeformWavesPrivate *priv = ((MxDeformWaves *)texture)->priv;
+
+  cogl_program_set_uniform_1f (program,
+                               cogl_program_get_uniform_location (program,
+                                                                  "period"),
+                               priv->period);
+  cogl_program_set_uniform_1f (program,
+                               cogl_program_get_uniform_location (program,
+                                                                  "angle"),
+                               priv->angle);
+  cogl_program_set_uniform_1f (program,
+                               cogl_program_get_uniform_location (program,
+                                                                  "radius"),
+                               priv->radius);
+  cogl_program_set_uniform_1f (program,
+                               cogl_program_get_uniform_location (program,
+                                                                  "amplitude"),
+                               priv->amplitude);
+}
+
 static void
 mx_deform_waves_class_init (MxDeformWavesClass *klass)
 {
@@ -166,6 +223,11 @@ mx_deform_waves_class_init (MxDeformWavesClass *klass)
   object_class->set_property = mx_deform_waves_set_property;
 
   deform_class->deform = mx_deform_waves_deform;
+  deform_class->get_deform_shader = mx_deform_waves_get_deform_shader;
+  deform_class->set_shader_uniforms = mx_deform_waves_set_shader_uniforms;
+
+  /* the deform vfunc only reads priv and writes the vertex */
+  _mx_deform_texture_class_set_thread_safe (deform_class);
 
   pspec = g_param_spec_double ("period",
                                "Period",
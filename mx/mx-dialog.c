@@ -33,9 +33,18 @@
  * It also allows actions to be added to it, which will be represented as
  * buttons, using #MxButton.
  *
+ * When GLSL shaders and offscreen rendering are available, the actors
+ * beneath the dialog are shown blurred. The blur is computed on a scaled
+ * down copy of them and only when they change. The -mx-blur-downsample
+ * style property sets the factor they're scaled down by (1, 2 or 4), and
+ * -mx-blur-quality the number of samples taken on each side of a pixel
+ * (0 to 8), which also sets the radius of the blur.
+ *
  * Since: 1.2
  */
 
+#include <math.h>
+
 #include "mx-dialog.h"
 #include "mx-button-group.h"
 #include "mx-offscreen.h"
@@ -55,6 +64,23 @@ G_DEFINE_TYPE_WITH_CODE (MxDialog, mx_dialog, MX_TYPE_BIN,
 #define DIALOG_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_DIALOG, MxDialogPrivate))
 
+/* The buffers the background is blurred in: an intermediate buffer used
+ * when downsampling by four, and two buffers at the downsampled size that
+ * the horizontal and vertical passes of the blur ping-pong between.
+ */
+enum
+{
+  BLUR_BUFFER_HALF,
+  BLUR_BUFFER_0,
+  BLUR_BUFFER_1,
+
+  N_BLUR_BUFFERS
+};
+
+#define DEFAULT_BLUR_DOWNSAMPLE 2
+#define DEFAULT_BLUR_QUALITY    2
+#define MAX_BLUR_QUALITY        8
+
 typedef struct {
   MxAction     *action;
   ClutterActor *button;
@@ -66,15 +92,30 @@ struct _MxDialogPrivate
   guint needs_allocation : 1;
   guint do_paint         : 1;
   guint child_has_focus  : 1;
+  guint blur_dirty       : 1;
+  guint blur_failed      : 1;
 
   guint  transition_time;
   gfloat angle;
 
+  /* Blurred background */
   ClutterActor    *blur;
-  ClutterShader   *shader;
-
-  ClutterTimeline *timeline;
-  ClutterAlpha    *alpha;
+  CoglHandle       blur_program;
+  gint             blur_step_uniform;
+  CoglHandle       blur_material;
+  CoglHandle       copy_material;
+  CoglHandle       blur_textures[N_BLUR_BUFFERS];
+  CoglHandle       blur_fbos[N_BLUR_BUFFERS];
+  guint            blur_downsample;
+  guint            blur_quality;
+
+  /* The transition moves the position linearly between 0.0 (hidden) and
+   * 1.0 (shown), which is eased with the mode to get the opacity */
+  guint            transition;
+  gulong           mode;
+  gdouble          position;
+  gdouble          start_position;
+  guint            showing : 1;
   gfloat           zoom;
 
   /* Dialog-specific variables */
@@ -85,81 +126,317 @@ struct _MxDialogPrivate
   GList         *actions;
 };
 
-static gchar *blur_shader =
-  "uniform sampler2D tex;\n"
-  "uniform float x_step, y_step;\n"
-
-#if 0
-  "void\n"
-  "main ()\n"
-  "  {\n"
-  "    float u, v;\n"
-  "    int count = 0;\n"
-  "    vec4 color = vec4 (0.0, 0.0, 0.0, 0.0);\n"
-
-  "    for (u = -1.0; u <= 1.0; u++)\n"
-  "      for (v = -1.0; v <= 1.0; v++)\n"
-  "        {\n"
-  "          color += texture2D(tex, \n"
-  "              vec2(cogl_tex_coord_in[0].s + u * x_step, \n"
-  "                   cogl_tex_coord_in[0].t + v * y_step));\n"
-  "          count ++;\n"
-  "        }\n"
-
-  "    color = color / float (count);\n"
-  "    cogl_color_out = color * cogl_color_in;\n"
-  "  }\n";
-#else
-  "vec4 get_rgba_rel(sampler2D tex, float dx, float dy)\n"
-  "{\n"
-  "  return texture2D (tex, cogl_tex_coord_in[0].st \n"
-  "                         + vec2(dx, dy));\n"
-  "}\n"
-
-  "void\n"
-  "main ()\n"
-  "  {\n"
-  "    vec4 color;\n"
-  "    color =  get_rgba_rel (tex, -x_step, -y_step);\n"
-  "    color += get_rgba_rel (tex, -x_step,  0.0);\n"
-  "    color += get_rgba_rel (tex, -x_step,  y_step);\n"
-  "    color += get_rgba_rel (tex,  0.0,    -y_step);\n"
-  "    color += get_rgba_rel (tex,  0.0,     0.0);\n"
-  "    color += get_rgba_rel (tex,  0.0,     y_step);\n"
-  "    color += get_rgba_rel (tex,  x_step, -y_step);\n"
-  "    color += get_rgba_rel (tex,  x_step,  0.0);\n"
-  "    color += get_rgba_rel (tex,  x_step,  y_step);\n"
-  "    color = color / 9.0;\n"
-  "    cogl_color_out = color * cogl_color_in;\n"
-  "  }\n";
-#endif
-
 static void mx_dialog_show (ClutterActor *self);
 static void mx_dialog_hide (ClutterActor *self);
 
-static int
-next_p2 (gint a)
+/* Creates the fragment shader for one pass of a separable Gaussian blur of
+ * radius 2 * @quality texels. Each pair of neighbouring texels is read with
+ * a single sample, placed between them so that linear filtering weighs
+ * them as the kernel does, which makes @quality samples on each side.
+ */
+static gchar *
+mx_dialog_create_blur_source (guint quality)
+{
+  gint i, radius;
+  GString *source;
+  gdouble *weights, sigma, sum, weight, offset;
+  gchar weight_str[G_ASCII_DTOSTR_BUF_SIZE];
+  gchar offset_str[G_ASCII_DTOSTR_BUF_SIZE];
+
+  radius = quality * 2;
+  sigma = MAX (radius / 2.0, 0.5);
+
+  weights = g_new (gdouble, radius + 1);
+  for (i = 0, sum = 0; i <= radius; i++)
+    {
+      weights[i] = exp (-(i * i) / (2.0 * sigma * sigma));
+      sum += (i == 0) ? weights[i] : weights[i] * 2;
+    }
+
+  source = g_string_new ("uniform sampler2D tex;\n"
+                         "uniform vec2 pixel_step;\n"
+
+                         "void\n"
+                         "main ()\n"
+                         "  {\n"
+                         "    vec2 coord = cogl_tex_coord_in[0].st;\n"
+                         "    vec4 color;\n");
+
+  g_ascii_formatd (weight_str, sizeof (weight_str), "%.8f",
+                   weights[0] / sum);
+  g_string_append_printf (source,
+                          "    color = texture2D (tex, coord) * %s;\n",
+                          weight_str);
+
+  for (i = 1; i < radius; i += 2)
+    {
+      weight = weights[i] + weights[i + 1];
+      offset = (i * weights[i] + (i + 1) * weights[i + 1]) / weight;
+
+      g_ascii_formatd (weight_str, sizeof (weight_str), "%.8f",
+                       weight / sum);
+      g_ascii_formatd (offset_str, sizeof (offset_str), "%.8f", offset);
+      g_string_append_printf (source,
+                              "    color += (texture2D (tex, coord + "
+                              "pixel_step * %s) +\n"
+                              "              texture2D (tex, coord - "
+                              "pixel_step * %s)) * %s;\n",
+                              offset_str, offset_str, weight_str);
+    }
+
+  g_string_append (source,
+                   "    cogl_color_out = color * cogl_color_in;\n"
+                   "  }\n");
+
+  g_free (weights);
+
+  return g_string_free (source, FALSE);
+}
+
+static gboolean
+mx_dialog_ensure_blur_program (MxDialog *self)
 {
-  /* find the next power of two */
-  int rval = 1;
+  gchar *source;
+  CoglHandle shader;
+
+  MxDialogPrivate *priv = self->priv;
+
+  if (priv->blur_program)
+    return TRUE;
+
+  if (priv->blur_failed)
+    return FALSE;
+
+  if (!clutter_feature_available (CLUTTER_FEATURE_SHADERS_GLSL) ||
+      !clutter_feature_available (CLUTTER_FEATURE_OFFSCREEN))
+    {
+      priv->blur_failed = TRUE;
+      return FALSE;
+    }
+
+  source = mx_dialog_create_blur_source (priv->blur_quality);
 
-  while (rval < a)
-    rval <<= 1;
+  shader = cogl_create_shader (COGL_SHADER_TYPE_FRAGMENT);
+  cogl_shader_source (shader, source);
+  cogl_shader_compile (shader);
+  g_free (source);
 
-  return rval;
+  if (!cogl_shader_is_compiled (shader))
+    {
+      gchar *log = cogl_shader_get_info_log (shader);
+
+      g_warning (G_STRLOC ": Error compiling shader: %s", log);
+      g_free (log);
+
+      cogl_handle_unref (shader);
+      priv->blur_failed = TRUE;
+
+      return FALSE;
+    }
+
+  priv->blur_program = cogl_create_program ();
+  cogl_program_attach_shader (priv->blur_program, shader);
+  cogl_program_link (priv->blur_program);
+  cogl_handle_unref (shader);
+
+  cogl_program_set_uniform_1i (priv->blur_program,
+                               cogl_program_get_uniform_location
+                                 (priv->blur_program, "tex"),
+                               0);
+  priv->blur_step_uniform =
+    cogl_program_get_uniform_location (priv->blur_program, "pixel_step");
+
+  cogl_material_set_user_program (priv->blur_material, priv->blur_program);
+
+  return TRUE;
 }
 
 static void
-mx_dialog_texture_size_change_cb (ClutterActor *texture,
-                                  gint          width,
-                                  gint          height)
+mx_dialog_free_blur_buffer (MxDialogPrivate *priv,
+                            guint            buffer)
 {
-  clutter_actor_set_shader_param_float (texture,
-                                        "x_step",
-                                        (1.0f / next_p2 (width)) * 2);
-  clutter_actor_set_shader_param_float (texture,
-                                        "y_step",
-                                        (1.0f / next_p2 (height)) * 2);
+  if (priv->blur_fbos[buffer])
+    {
+      cogl_handle_unref (priv->blur_fbos[buffer]);
+      priv->blur_fbos[buffer] = NULL;
+    }
+
+  if (priv->blur_textures[buffer])
+    {
+      cogl_handle_unref (priv->blur_textures[buffer]);
+      priv->blur_textures[buffer] = NULL;
+    }
+}
+
+static gboolean
+mx_dialog_ensure_blur_buffer (MxDialogPrivate *priv,
+                              guint            buffer,
+                              guint            width,
+                              guint            height)
+{
+  CoglHandle texture = priv->blur_textures[buffer];
+
+  width = MAX (width, 1);
+  height = MAX (height, 1);
+
+  if (texture && priv->blur_fbos[buffer] &&
+      (cogl_texture_get_width (texture) == width) &&
+      (cogl_texture_get_height (texture) == height))
+    return TRUE;
+
+  mx_dialog_free_blur_buffer (priv, buffer);
+  priv->blur_dirty = TRUE;
+
+  texture = cogl_texture_new_with_size (width, height,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  if (!texture)
+    return FALSE;
+
+  priv->blur_textures[buffer] = texture;
+  priv->blur_fbos[buffer] = cogl_offscreen_new_to_texture (texture);
+
+  return (priv->blur_fbos[buffer] != COGL_INVALID_HANDLE);
+}
+
+static void
+mx_dialog_blur_pass (CoglHandle fbo,
+                     CoglHandle material,
+                     CoglHandle texture)
+{
+  /* Offscreen buffers are drawn to with identity matrices, so cover the
+   * whole of it in normalised device coordinates */
+  cogl_material_set_layer (material, 0, texture);
+  cogl_push_framebuffer (fbo);
+  cogl_set_source (material);
+  cogl_rectangle_with_texture_coords (-1, 1, 1, -1, 0, 0, 1, 1);
+  cogl_pop_framebuffer ();
+}
+
+/* Blurs what's beneath the dialog into the first blur buffer, unless
+ * nothing changed since the last time.
+ */
+static gboolean
+mx_dialog_update_blur (MxDialog *self)
+{
+  gfloat pixel_step[2];
+  CoglHandle texture;
+  guint width, height, downsample;
+
+  MxDialogPrivate *priv = self->priv;
+
+  texture = clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (priv->blur));
+  if (!texture || !mx_dialog_ensure_blur_program (self))
+    return FALSE;
+
+  width = cogl_texture_get_width (texture);
+  height = cogl_texture_get_height (texture);
+  downsample = priv->blur_downsample;
+
+  /* Check the buffers first, as recreating one invalidates the blur */
+  if ((downsample == 4) &&
+      !mx_dialog_ensure_blur_buffer (priv, BLUR_BUFFER_HALF,
+                                     width / 2, height / 2))
+    return FALSE;
+
+  if (!mx_dialog_ensure_blur_buffer (priv, BLUR_BUFFER_0,
+                                     width / downsample,
+                                     height / downsample) ||
+      !mx_dialog_ensure_blur_buffer (priv, BLUR_BUFFER_1,
+                                     width / downsample,
+                                     height / downsample))
+    return FALSE;
+
+  if (!priv->blur_dirty)
+    return TRUE;
+
+  /* Downsample by halving the size at a time. Sampling in the middle of
+   * each 2x2 block of texels with linear filtering averages all four.
+   */
+  if (downsample == 4)
+    {
+      mx_dialog_blur_pass (priv->blur_fbos[BLUR_BUFFER_HALF],
+                           priv->copy_material, texture);
+      texture = priv->blur_textures[BLUR_BUFFER_HALF];
+    }
+
+  if (downsample > 1)
+    {
+      mx_dialog_blur_pass (priv->blur_fbos[BLUR_BUFFER_0],
+                           priv->copy_material, texture);
+      texture = priv->blur_textures[BLUR_BUFFER_0];
+    }
+
+  /* Blur horizontally into the second buffer, then vertically back into
+   * the first. The journal doesn't track uniforms, so each pass is flushed
+   * before they're changed.
+   */
+  pixel_step[0] = 1.f / cogl_texture_get_width (texture);
+  pixel_step[1] = 0;
+  cogl_program_set_uniform_float (priv->blur_program,
+                                  priv->blur_step_uniform,
+                                  2, 1, pixel_step);
+  mx_dialog_blur_pass (priv->blur_fbos[BLUR_BUFFER_1],
+                       priv->blur_material, texture);
+  cogl_flush ();
+
+  texture = priv->blur_textures[BLUR_BUFFER_1];
+  pixel_step[0] = 0;
+  pixel_step[1] = 1.f / cogl_texture_get_height (texture);
+  cogl_program_set_uniform_float (priv->blur_program,
+                                  priv->blur_step_uniform,
+                                  2, 1, pixel_step);
+  mx_dialog_blur_pass (priv->blur_fbos[BLUR_BUFFER_0],
+                       priv->blur_material, texture);
+  cogl_flush ();
+
+  priv->blur_dirty = FALSE;
+
+  return TRUE;
+}
+
+static void
+mx_dialog_parent_queue_redraw_cb (ClutterActor *parent,
+                                  ClutterActor *origin,
+                                  MxDialog     *self)
+{
+  MxDialogPrivate *priv = self->priv;
+
+  /* Redraws of the dialog don't change what's beneath it. The dialog also
+   * queues redraws on its parent while transitioning, so those are ignored
+   * and the blur is refreshed once the transition completes instead.
+   */
+  if (clutter_actor_contains (CLUTTER_ACTOR (self), origin))
+    return;
+
+  if ((origin == parent) && priv->transition)
+    return;
+
+  priv->blur_dirty = TRUE;
+}
+
+static void
+mx_dialog_destroy_blur (MxDialog *self)
+{
+  guint i;
+  ClutterActor *parent;
+
+  MxDialogPrivate *priv = self->priv;
+
+  if (!priv->blur)
+    return;
+
+  parent = mx_offscreen_get_child (MX_OFFSCREEN (priv->blur));
+  if (parent)
+    g_signal_handlers_disconnect_by_func (parent,
+                                          mx_dialog_parent_queue_redraw_cb,
+                                          self);
+
+  clutter_actor_destroy (priv->blur);
+  priv->blur = NULL;
+
+  for (i = 0; i < N_BLUR_BUFFERS; i++)
+    mx_dialog_free_blur_buffer (priv, i);
 }
 
 static MxFocusable *
@@ -278,6 +555,22 @@ mx_stylable_iface_init (MxStylableIface *iface)
                                  0, G_MAXUINT, 12,
                                  MX_PARAM_READWRITE);
       mx_stylable_iface_install_property (iface, MX_TYPE_DIALOG, pspec);
+
+      pspec = g_param_spec_uint ("x-mx-blur-downsample",
+                                 "Blur downsample",
+                                 "The factor the background is scaled down "
+                                 "by before blurring it: 1, 2 or 4",
+                                 1, 4, DEFAULT_BLUR_DOWNSAMPLE,
+                                 MX_PARAM_READWRITE);
+      mx_stylable_iface_install_property (iface, MX_TYPE_DIALOG, pspec);
+
+      pspec = g_param_spec_uint ("x-mx-blur-quality",
+                                 "Blur quality",
+                                 "The number of samples on each side of a "
+                                 "pixel in each direction of the blur",
+                                 0, MAX_BLUR_QUALITY, DEFAULT_BLUR_QUALITY,
+                                 MX_PARAM_READWRITE);
+      mx_stylable_iface_install_property (iface, MX_TYPE_DIALOG, pspec);
     }
 }
 
@@ -357,12 +650,14 @@ mx_dialog_dispose (GObject *object)
                                             mx_dialog_pick_cb, self);
     }
 
-  if (priv->blur)
+  if (priv->transition)
     {
-      clutter_actor_destroy (priv->blur);
-      priv->blur = NULL;
+      _mx_transition_stop (priv->transition);
+      priv->transition = 0;
     }
 
+  mx_dialog_destroy_blur (self);
+
   if (priv->background)
     {
       clutter_actor_destroy (priv->background);
@@ -375,10 +670,22 @@ mx_dialog_dispose (GObject *object)
       priv->button_box = NULL;
     }
 
-  if (priv->shader)
+  if (priv->blur_program)
+    {
+      cogl_handle_unref (priv->blur_program);
+      priv->blur_program = NULL;
+    }
+
+  if (priv->blur_material)
+    {
+      cogl_handle_unref (priv->blur_material);
+      priv->blur_material = NULL;
+    }
+
+  if (priv->copy_material)
     {
-      g_object_unref (priv->shader);
-      priv->shader = NULL;
+      cogl_handle_unref (priv->copy_material);
+      priv->copy_material = NULL;
     }
 
   G_OBJECT_CLASS (mx_dialog_parent_class)->dispose (object);
@@ -655,19 +962,38 @@ mx_dialog_paint (ClutterActor *actor)
 
   clutter_actor_get_size (actor, &width, &height);
 
-  if (priv->blur)
+  if (priv->blur &&
+      clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (priv->blur)))
     {
-      CoglHandle material = cogl_material_new ();
-      CoglHandle texture =
-        clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (priv->blur));
+      gboolean blurred;
+      CoglHandle material, texture;
+      guint8 opacity = clutter_actor_get_paint_opacity (actor);
+
+      /* Blur first, as it draws to other framebuffers */
+      blurred = mx_dialog_update_blur (MX_DIALOG (actor));
 
+      texture =
+        clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (priv->blur));
+      material = cogl_material_new ();
       cogl_material_set_color4ub (material, 0xff, 0xff, 0xff, 0xff);
       cogl_material_set_layer (material, 0, texture);
       cogl_set_source (material);
 
       cogl_rectangle (0, 0, width, height);
 
-      clutter_actor_paint (priv->blur);
+      /* Fade the blurred background in with the dialog */
+      if (blurred)
+        {
+          cogl_material_set_color4ub (material,
+                                      opacity, opacity, opacity, opacity);
+          cogl_material_set_layer (material, 0,
+                                   priv->blur_textures[BLUR_BUFFER_0]);
+          cogl_set_source (material);
+
+          cogl_rectangle (0, 0, width, height);
+        }
+
+      cogl_handle_unref (material);
     }
 
   mx_widget_paint_background (MX_WIDGET (actor));
@@ -839,6 +1165,9 @@ mx_dialog_parent_set_cb (ClutterActor *actor,
                                             mx_dialog_paint_cb, self);
       g_signal_handlers_disconnect_by_func (old_parent,
                                             mx_dialog_pick_cb, self);
+      g_signal_handlers_disconnect_by_func (old_parent,
+                                            mx_dialog_parent_queue_redraw_cb,
+                                            self);
 
       priv->visible = FALSE;
     }
@@ -857,39 +1186,33 @@ mx_dialog_queue_relayout_cb (ClutterActor *actor,
   self->priv->needs_allocation = TRUE;
 }
 
-static void
-mx_dialog_completed_cb (ClutterTimeline *timeline,
-                        ClutterActor    *self)
+static gboolean
+mx_dialog_completed_cb (gpointer user_data)
 {
-  ClutterTimelineDirection direction;
-
+  ClutterActor *self = user_data;
   MxDialogPrivate *priv = MX_DIALOG (self)->priv;
   ClutterActor *parent = clutter_actor_get_parent (self);
 
+  priv->transition = 0;
   priv->zoom = 1.f;
 
-  /* Reverse the direction and rewind the timeline. This means that when
-   * a timeline finishes, its progress stays at 1.0, or 0.0 and it is
-   * ready to start again.
-   */
-  direction = clutter_timeline_get_direction (timeline);
-  clutter_timeline_set_direction (timeline,
-                                  (direction == CLUTTER_TIMELINE_FORWARD) ?
-                                  CLUTTER_TIMELINE_BACKWARD :
-                                  CLUTTER_TIMELINE_FORWARD);
+  if (priv->showing)
+    {
+      /* Redraws queued by the parent on itself were ignored while showing */
+      if (priv->blur)
+        {
+          priv->blur_dirty = TRUE;
+          clutter_actor_queue_redraw (self);
+        }
 
-  if (direction == CLUTTER_TIMELINE_FORWARD)
-    return;
+      return FALSE;
+    }
 
   /* Finish hiding */
   CLUTTER_ACTOR_SET_FLAGS (self, CLUTTER_ACTOR_VISIBLE);
   CLUTTER_ACTOR_CLASS (mx_dialog_parent_class)->hide (self);
 
-  if (priv->blur)
-    {
-      clutter_actor_destroy (priv->blur);
-      priv->blur = NULL;
-    }
+  mx_dialog_destroy_blur (MX_DIALOG (self));
 
   g_signal_handlers_disconnect_by_func (parent,
                                         mx_dialog_paint_cb, self);
@@ -897,17 +1220,24 @@ mx_dialog_completed_cb (ClutterTimeline *timeline,
                                         mx_dialog_pick_cb, self);
   g_signal_handlers_disconnect_by_func (parent,
                                         mx_dialog_allocate_cb, self);
+
+  return FALSE;
 }
 
 static void
-mx_dialog_new_frame_cb (ClutterTimeline *timeline,
-                        gint             msecs,
-                        ClutterActor    *self)
+mx_dialog_new_frame_cb (gdouble  alpha,
+                        gpointer user_data)
 {
+  ClutterActor *self = user_data;
   MxDialog *frame = MX_DIALOG (self);
   MxDialogPrivate *priv = frame->priv;
   ClutterActor *parent = clutter_actor_get_parent (self);
-  gfloat opacity = clutter_alpha_get_alpha (priv->alpha);
+  gdouble end_position = priv->showing ? 1.0 : 0.0;
+  gfloat opacity;
+
+  priv->position = priv->start_position +
+    (end_position - priv->start_position) * alpha;
+  opacity = _mx_transition_ease (priv->mode, priv->position);
 
   priv->zoom = 1.0f + (1.f - opacity) / 2.f;
   clutter_actor_set_opacity (self, (guint8)(opacity * 255.f));
@@ -919,14 +1249,46 @@ mx_dialog_new_frame_cb (ClutterTimeline *timeline,
     clutter_actor_queue_redraw (parent);
 }
 
+/* Starts showing or hiding the dialog, or reverses the transition in
+ * progress, which carries on from where it is with the same easing */
+static void
+mx_dialog_start_transition (MxDialog *self,
+                            gboolean  show)
+{
+  MxDialogPrivate *priv = self->priv;
+  gdouble distance;
+
+  if (priv->transition)
+    _mx_transition_stop (priv->transition);
+  else
+    {
+      priv->position = show ? 0.0 : 1.0;
+
+      /* Hiding runs the show transition in reverse, so use ease-in quad */
+      priv->mode = show ? CLUTTER_EASE_OUT_QUAD : CLUTTER_EASE_IN_QUAD;
+    }
+
+  priv->showing = show;
+  priv->start_position = priv->position;
+  distance = show ? 1.0 - priv->position : priv->position;
+
+  priv->transition = _mx_transition_start (priv->transition_time * distance,
+                                           CLUTTER_LINEAR,
+                                           mx_dialog_new_frame_cb,
+                                           mx_dialog_completed_cb,
+                                           self);
+}
+
 static void
 mx_dialog_style_changed_cb (MxDialog *self)
 {
-  guint spacing;
+  guint spacing, downsample, quality;
   MxDialogPrivate *priv = self->priv;
 
   mx_stylable_get (MX_STYLABLE (self),
                    "x-mx-spacing", &spacing,
+                   "x-mx-blur-downsample", &downsample,
+                   "x-mx-blur-quality", &quality,
                    NULL);
 
   if (priv->spacing != spacing)
@@ -934,6 +1296,35 @@ mx_dialog_style_changed_cb (MxDialog *self)
       priv->spacing = spacing;
       clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
     }
+
+  /* Only downsampling by powers of two is supported */
+  downsample = (downsample >= 4) ? 4 : ((downsample >= 2) ? 2 : 1);
+  quality = MIN (quality, MAX_BLUR_QUALITY);
+
+  if (priv->blur_downsample != downsample)
+    {
+      priv->blur_downsample = downsample;
+      mx_dialog_free_blur_buffer (priv, BLUR_BUFFER_HALF);
+      priv->blur_dirty = TRUE;
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
+    }
+
+  if (priv->blur_quality != quality)
+    {
+      priv->blur_quality = quality;
+
+      /* Rebuild the shader for the new kernel size the next time */
+      if (priv->blur_program)
+        {
+          cogl_material_set_user_program (priv->blur_material,
+                                          COGL_INVALID_HANDLE);
+          cogl_handle_unref (priv->blur_program);
+          priv->blur_program = NULL;
+        }
+      priv->blur_failed = FALSE;
+      priv->blur_dirty = TRUE;
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
+    }
 }
 
 static void
@@ -943,9 +1334,6 @@ mx_dialog_init (MxDialog *self)
   MxDialogPrivate *priv = self->priv = DIALOG_PRIVATE (self);
 
   priv->transition_time = 250;
-  priv->timeline = clutter_timeline_new (priv->transition_time);
-  priv->alpha = clutter_alpha_new_full (priv->timeline,
-                                        CLUTTER_EASE_OUT_QUAD);
 
   priv->background = mx_frame_new ();
   mx_stylable_set_style_class (MX_STYLABLE (priv->background),
@@ -963,11 +1351,6 @@ mx_dialog_init (MxDialog *self)
   clutter_actor_set_parent (priv->button_box, actor);
   clutter_actor_pop_internal (actor);
 
-  g_signal_connect (priv->timeline, "completed",
-                    G_CALLBACK (mx_dialog_completed_cb), self);
-  g_signal_connect (priv->timeline, "new-frame",
-                    G_CALLBACK (mx_dialog_new_frame_cb), self);
-
   g_signal_connect (self, "parent-set",
                     G_CALLBACK (mx_dialog_parent_set_cb), self);
   g_signal_connect (self, "queue-relayout",
@@ -978,28 +1361,22 @@ mx_dialog_init (MxDialog *self)
   g_object_set (G_OBJECT (self), "show-on-set-parent", FALSE, NULL);
   clutter_actor_set_reactive (CLUTTER_ACTOR (self), TRUE);
 
-  /* Compile the shader when creating the instance so it's ready when we need
-   * it */
-  if (clutter_feature_available (CLUTTER_FEATURE_SHADERS_GLSL) &&
-      clutter_feature_available (CLUTTER_FEATURE_OFFSCREEN))
-    {
-      GError *error = NULL;
-      ClutterShader *shader;
+  priv->blur_downsample = DEFAULT_BLUR_DOWNSAMPLE;
+  priv->blur_quality = DEFAULT_BLUR_QUALITY;
 
-      shader = clutter_shader_new ();
-      clutter_shader_set_fragment_source (shader, blur_shader, -1);
+  /* The passes of the blur replace the contents of their buffers, so they
+   * don't need clearing */
+  priv->copy_material = cogl_material_new ();
+  cogl_material_set_blend (priv->copy_material,
+                           "RGBA = ADD (SRC_COLOR, 0)", NULL);
+  cogl_material_set_layer_wrap_mode (priv->copy_material, 0,
+                                     COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
 
-      if (clutter_shader_compile (shader, &error))
-        {
-          priv->shader = shader;
-        }
-      else
-        {
-          g_warning (G_STRLOC ": Error compiling shader: %s", error->message);
-          g_error_free (error);
-          g_object_unref (shader);
-        }
-    }
+  priv->blur_material = cogl_material_copy (priv->copy_material);
+
+  /* Compile the shader when creating the instance so it's ready when we need
+   * it */
+  mx_dialog_ensure_blur_program (self);
 }
 
 /**
@@ -1066,14 +1443,9 @@ mx_dialog_show (ClutterActor *self)
 
       priv->visible = TRUE;
 
-      if (clutter_timeline_is_playing (priv->timeline))
+      if (priv->transition)
         {
-          ClutterTimelineDirection direction =
-            clutter_timeline_get_direction (priv->timeline);
-
-          direction = (direction == CLUTTER_TIMELINE_FORWARD) ?
-            CLUTTER_TIMELINE_BACKWARD : CLUTTER_TIMELINE_FORWARD;
-          clutter_timeline_set_direction (priv->timeline, direction);
+          mx_dialog_start_transition (dialog, TRUE);
 
           CLUTTER_ACTOR_SET_FLAGS (self, CLUTTER_ACTOR_VISIBLE);
           mx_dialog_steal_focus (dialog);
@@ -1081,27 +1453,22 @@ mx_dialog_show (ClutterActor *self)
           return;
         }
 
-      /* Create the blurred background */
-      if (priv->shader)
+      /* Create the blurred background. The offscreen only captures the
+       * parent; it is blurred and drawn when painting the dialog.
+       */
+      if (mx_dialog_ensure_blur_program (dialog))
         {
-          gint width, height;
-
           priv->blur = mx_offscreen_new ();
           clutter_actor_push_internal (self);
           clutter_actor_set_parent (priv->blur, self);
           clutter_actor_pop_internal (self);
 
           mx_offscreen_set_child (MX_OFFSCREEN (priv->blur), parent);
-          clutter_actor_set_shader (priv->blur, priv->shader);
-
-          g_signal_connect (priv->blur, "size-change",
-                            G_CALLBACK (mx_dialog_texture_size_change_cb),
-                            NULL);
-          clutter_texture_get_base_size (CLUTTER_TEXTURE (priv->blur),
-                                         &width, &height);
-          mx_dialog_texture_size_change_cb (priv->blur, width, height);
-          clutter_actor_set_shader_param_int (priv->blur, "tex", 0);
 
+          priv->blur_dirty = TRUE;
+          g_signal_connect (parent, "queue-redraw",
+                            G_CALLBACK (mx_dialog_parent_queue_redraw_cb),
+                            dialog);
         }
 
       /* Hook onto signals necessary for drawing */
@@ -1118,8 +1485,7 @@ mx_dialog_show (ClutterActor *self)
 
       clutter_actor_set_opacity (self, 0x00);
       CLUTTER_ACTOR_CLASS (mx_dialog_parent_class)->show (self);
-      clutter_alpha_set_mode (priv->alpha, CLUTTER_EASE_OUT_QUAD);
-      clutter_timeline_start (priv->timeline);
+      mx_dialog_start_transition (dialog, TRUE);
 
       mx_dialog_steal_focus (dialog);
     }
@@ -1154,21 +1520,7 @@ mx_dialog_hide (ClutterActor *self)
           mx_focus_manager_move_focus (manager, MX_FOCUS_DIRECTION_OUT);
         }
 
-      if (clutter_timeline_is_playing (priv->timeline))
-        {
-          ClutterTimelineDirection direction =
-            clutter_timeline_get_direction (priv->timeline);
-
-          direction = (direction == CLUTTER_TIMELINE_FORWARD) ?
-            CLUTTER_TIMELINE_BACKWARD : CLUTTER_TIMELINE_FORWARD;
-          clutter_timeline_set_direction (priv->timeline, direction);
-
-          return;
-        }
-
-      /* The timeline is running in reverse, so use ease-in quad */
-      clutter_alpha_set_mode (priv->alpha, CLUTTER_EASE_IN_QUAD);
-      clutter_timeline_start (priv->timeline);
+      mx_dialog_start_transition (dialog, FALSE);
     }
 }
 
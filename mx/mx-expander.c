@@ -82,8 +82,9 @@ struct _MxExpanderPrivate {
   ClutterActor    *arrow;
   gfloat           spacing;
 
-  ClutterTimeline *timeline;
-  ClutterAlpha    *alpha;
+  guint            transition;
+  gdouble          position;
+  gdouble          start_position;
   gdouble          progress;
 
   guint            expanded : 1;
@@ -148,16 +149,10 @@ mx_expander_dispose (GObject *object)
       priv->arrow = NULL;
     }
 
-  if (priv->timeline)
+  if (priv->transition)
     {
-      g_object_unref (priv->timeline);
-      priv->timeline = NULL;
-    }
-
-  if (priv->alpha)
-    {
-      g_object_unref (priv->alpha);
-      priv->alpha = NULL;
+      _mx_transition_stop (priv->transition);
+      priv->transition = 0;
     }
 
   G_OBJECT_CLASS (mx_expander_parent_class)->dispose (object);
@@ -169,14 +164,16 @@ mx_expander_finalize (GObject *object)
   G_OBJECT_CLASS (mx_expander_parent_class)->finalize (object);
 }
 
-static void
-timeline_complete (ClutterTimeline *timeline,
-                   ClutterActor    *expander)
+static gboolean
+transition_complete (gpointer user_data)
 {
   guchar opacity;
   ClutterActor *child;
+  ClutterActor *expander = user_data;
   MxExpanderPrivate *priv = MX_EXPANDER (expander)->priv;
 
+  priv->transition = 0;
+
   g_signal_emit (expander, expander_signals[EXPAND_COMPLETE], 0);
 
   /* if the expander is now closed, update the style */
@@ -191,18 +188,18 @@ timeline_complete (ClutterTimeline *timeline,
   child = mx_bin_get_child (MX_BIN (expander));
 
   if (!child)
-    return;
+    return FALSE;
 
   /* continue only if we are "opening" */
   if (!priv->expanded)
-    return;
+    return FALSE;
 
   /* we can't do an animation if there is already one in progress,
    * because we cannot get the actors original opacity */
   if (clutter_actor_get_animation (child))
     {
       clutter_actor_show (child);
-      return;
+      return FALSE;
     }
 
   opacity = clutter_actor_get_opacity (child);
@@ -212,16 +209,24 @@ timeline_complete (ClutterTimeline *timeline,
   clutter_actor_animate (child, CLUTTER_EASE_IN_SINE, 100,
                          "opacity", opacity,
                          NULL);
+
+  return FALSE;
 }
 
 static void
-new_frame (ClutterTimeline *timeline,
-           gint             frame_num,
-           ClutterActor    *expander)
+new_frame (gdouble  alpha,
+           gpointer user_data)
 {
+  ClutterActor *expander = user_data;
   MxExpanderPrivate *priv = MX_EXPANDER (expander)->priv;
+  gdouble end_position = priv->expanded ? 1.0 : 0.0;
 
-  priv->progress = clutter_alpha_get_alpha (priv->alpha);
+  /* the position moves linearly in time and is eased into the progress,
+   * so that reversing half way continues from the same point */
+  priv->position = priv->start_position +
+    (end_position - priv->start_position) * alpha;
+  priv->progress = _mx_transition_ease (CLUTTER_EASE_IN_SINE,
+                                        priv->position);
 
   clutter_actor_queue_relayout (expander);
 }
@@ -244,24 +249,24 @@ mx_expander_update (MxExpander *expander)
   if (!child)
     return;
 
-  /* setup and start the expansion animation */
+  /* setup and start the expansion animation, reversing the one in
+   * progress if there is one */
   if (!priv->expanded)
-    {
-      clutter_actor_hide (child);
-      clutter_timeline_set_direction (priv->timeline,
-                                      CLUTTER_TIMELINE_BACKWARD);
-    }
-  else
-    {
-      clutter_timeline_set_direction (priv->timeline,
-                                      CLUTTER_TIMELINE_FORWARD);
-    }
+    clutter_actor_hide (child);
 
-
-  if (!clutter_timeline_is_playing (priv->timeline))
-    clutter_timeline_rewind (priv->timeline);
-
-  clutter_timeline_start (priv->timeline);
+  if (priv->transition)
+    _mx_transition_stop (priv->transition);
+  else
+    priv->position = priv->expanded ? 0.0 : 1.0;
+
+  priv->start_position = priv->position;
+  priv->transition =
+    _mx_transition_start (250 * (priv->expanded ? 1.0 - priv->position
+                                                : priv->position),
+                          CLUTTER_LINEAR,
+                          new_frame,
+                          transition_complete,
+                          expander);
 }
 
 static gboolean
@@ -640,13 +645,6 @@ mx_expander_init (MxExpander *self)
   /* TODO: make this a style property */
   priv->spacing = 10.0f;
 
-  priv->timeline = clutter_timeline_new (250);
-  g_signal_connect (priv->timeline, "new-frame", G_CALLBACK (new_frame), self);
-  g_signal_connect (priv->timeline, "completed", G_CALLBACK (timeline_complete), self);
-
-  priv->alpha = clutter_alpha_new_full (priv->timeline, CLUTTER_EASE_IN_SINE);
-  g_object_ref_sink (priv->alpha);
-
   clutter_actor_set_reactive ((ClutterActor *) self, TRUE);
 
   g_signal_connect (self, "style-changed",
@@ -29,6 +29,17 @@
  * of a #ClutterActor. It provides a configurable bounding box, border
  * size and colour to control the fading effect.
  *
+ * The contents of the actor are only redrawn into the offscreen buffer when
+ * the actor, or one of its children, queues a redraw, or when its transformed
+ * size or shape changes. Otherwise, the previous contents are composited
+ * again, so moving a faded actor, for example by scrolling it, is cheap.
+ *
+ * When #MxFadeEffect:direct-interior is set, only the faded borders are
+ * drawn through the offscreen buffer, and the unfaded interior of the actor
+ * is painted directly. This avoids drawing most of the actor twice, but
+ * requires the actor to be painted in two passes, so it is only used when
+ * the actor is fully opaque and the effect is the last one applied to it.
+ *
  * Since: 1.2
  */
 
@@ -57,7 +68,9 @@ enum
 
   PROP_COLOR,
 
-  PROP_FREEZE_UPDATE
+  PROP_FREEZE_UPDATE,
+
+  PROP_DIRECT_INTERIOR
 };
 
 struct _MxFadeEffectPrivate
@@ -79,14 +92,30 @@ struct _MxFadeEffectPrivate
   CoglMaterial *old_material;
 
   gulong        blocked_id;
+  gulong        queue_redraw_id;
 
   gfloat        x_offset;
   gfloat        y_offset;
 
-  guint         update_vbo    : 1;
-  guint         freeze_update : 1;
+  CoglMatrix    paint_modelview;
+  gfloat        paint_width;
+  gfloat        paint_height;
+
+  ClutterActorBox fade_box;
+  ClutterActorBox interior_box;
+
+  guint         update_vbo      : 1;
+  guint         freeze_update   : 1;
+  guint         content_dirty   : 1;
+  guint         paint_cached    : 1;
+  guint         direct_interior : 1;
+  guint         clip_interior   : 1;
+  guint         content_clipped : 1;
+  guint         border_clipped  : 1;
 };
 
+static void mx_fade_effect_update_vbo (MxFadeEffect *self);
+
 static void
 mx_fade_effect_get_property (GObject    *object,
                              guint       property_id,
@@ -137,6 +166,10 @@ mx_fade_effect_get_property (GObject    *object,
       g_value_set_boolean (value, priv->freeze_update);
       break;
 
+    case PROP_DIRECT_INTERIOR:
+      g_value_set_boolean (value, priv->direct_interior);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -193,6 +226,10 @@ mx_fade_effect_set_property (GObject      *object,
       priv->freeze_update = g_value_get_boolean (value);
       return;
 
+    case PROP_DIRECT_INTERIOR:
+      mx_fade_effect_set_direct_interior (effect, g_value_get_boolean (value));
+      return;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       return;
@@ -221,6 +258,15 @@ mx_fade_effect_dispose (GObject *object)
       priv->blocked_id = 0;
     }
 
+  if (priv->queue_redraw_id)
+    {
+      ClutterActor *actor =
+        clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (object));
+
+      g_signal_handler_disconnect (actor, priv->queue_redraw_id);
+      priv->queue_redraw_id = 0;
+    }
+
   G_OBJECT_CLASS (mx_fade_effect_parent_class)->dispose (object);
 }
 
@@ -230,6 +276,40 @@ mx_fade_effect_finalize (GObject *object)
   G_OBJECT_CLASS (mx_fade_effect_parent_class)->finalize (object);
 }
 
+static void
+mx_fade_effect_queue_redraw_cb (ClutterActor *actor,
+                                ClutterActor *origin,
+                                MxFadeEffect *self)
+{
+  /* The actor or one of its children has changed, so the contents of the
+   * offscreen buffer need to be redrawn */
+  self->priv->content_dirty = TRUE;
+}
+
+static void
+mx_fade_effect_set_actor (ClutterActorMeta *meta,
+                          ClutterActor     *actor)
+{
+  MxFadeEffectPrivate *priv = MX_FADE_EFFECT (meta)->priv;
+  ClutterActor *old_actor = clutter_actor_meta_get_actor (meta);
+
+  if (priv->queue_redraw_id)
+    {
+      g_signal_handler_disconnect (old_actor, priv->queue_redraw_id);
+      priv->queue_redraw_id = 0;
+    }
+
+  CLUTTER_ACTOR_META_CLASS (mx_fade_effect_parent_class)->
+    set_actor (meta, actor);
+
+  if (actor)
+    priv->queue_redraw_id =
+      g_signal_connect (actor, "queue-redraw",
+                        G_CALLBACK (mx_fade_effect_queue_redraw_cb), meta);
+
+  priv->content_dirty = TRUE;
+}
+
 static CoglHandle
 mx_fade_effect_create_texture (ClutterOffscreenEffect *effect,
                                gfloat                  width,
@@ -258,24 +338,151 @@ mx_fade_effect_paint_cb (ClutterActor *actor,
   priv->blocked_id = 0;
 }
 
+static void
+mx_fade_effect_get_target_modelview (MxFadeEffect *self,
+                                     CoglMatrix   *modelview)
+{
+  ClutterActor *actor, *stage;
+  MxFadeEffectPrivate *priv = self->priv;
+
+  actor = clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (self));
+  stage = clutter_actor_get_stage (actor);
+
+  /* This maps the coordinates of the offscreen texture to the absolute
+   * coordinates of the actor-box */
+  cogl_matrix_init_identity (modelview);
+  CLUTTER_ACTOR_CLASS (G_OBJECT_GET_CLASS (stage))->
+    apply_transform (stage, modelview);
+  cogl_matrix_translate (modelview, priv->x_offset, priv->y_offset, 0.f);
+}
+
+static void
+mx_fade_effect_push_border_clip (MxFadeEffect *self)
+{
+  CoglMatrix modelview;
+  MxFadeEffectPrivate *priv = self->priv;
+
+  /* Restrict drawing into the offscreen buffer to the faded borders */
+  cogl_push_matrix ();
+  mx_fade_effect_get_target_modelview (self, &modelview);
+  cogl_set_modelview_matrix (&modelview);
+
+  cogl_path_new ();
+  cogl_path_set_fill_rule (COGL_PATH_FILL_RULE_EVEN_ODD);
+  cogl_path_rectangle (priv->fade_box.x1, priv->fade_box.y1,
+                       priv->fade_box.x2, priv->fade_box.y2);
+  cogl_path_rectangle (priv->interior_box.x1, priv->interior_box.y1,
+                       priv->interior_box.x2, priv->interior_box.y2);
+  cogl_clip_push_from_path ();
+
+  cogl_pop_matrix ();
+
+  priv->border_clipped = TRUE;
+}
+
+static gboolean
+mx_fade_effect_can_reuse_content (MxFadeEffect    *self,
+                                  ClutterActorBox *box,
+                                  CoglMatrix      *modelview)
+{
+  MxFadeEffectPrivate *priv = self->priv;
+
+  if (priv->content_dirty ||
+      !clutter_offscreen_effect_get_target (CLUTTER_OFFSCREEN_EFFECT (self)))
+    return FALSE;
+
+  /* Contents drawn for a direct interior only cover the borders, so they
+   * can't be reused when painting the whole actor offscreen, or when the
+   * borders have moved */
+  if (priv->content_clipped != priv->clip_interior ||
+      (priv->content_clipped && priv->update_vbo))
+    return FALSE;
+
+  if (clutter_actor_box_get_width (box) != priv->paint_width ||
+      clutter_actor_box_get_height (box) != priv->paint_height)
+    return FALSE;
+
+  /* The cached contents are composited at the new position of the actor,
+   * so only a translation can be applied to them. Any other change of the
+   * transformation needs the actor to be drawn again.
+   */
+  return (modelview->xx == priv->paint_modelview.xx &&
+          modelview->yx == priv->paint_modelview.yx &&
+          modelview->zx == priv->paint_modelview.zx &&
+          modelview->wx == priv->paint_modelview.wx &&
+          modelview->xy == priv->paint_modelview.xy &&
+          modelview->yy == priv->paint_modelview.yy &&
+          modelview->zy == priv->paint_modelview.zy &&
+          modelview->wy == priv->paint_modelview.wy &&
+          modelview->xz == priv->paint_modelview.xz &&
+          modelview->yz == priv->paint_modelview.yz &&
+          modelview->zz == priv->paint_modelview.zz &&
+          modelview->wz == priv->paint_modelview.wz &&
+          modelview->zw == priv->paint_modelview.zw &&
+          modelview->ww == priv->paint_modelview.ww);
+}
+
 static gboolean
 mx_fade_effect_pre_paint (ClutterEffect *effect)
 {
-  MxFadeEffectPrivate *priv = MX_FADE_EFFECT (effect)->priv;
+  ClutterActorBox box;
+  CoglMatrix modelview;
+  gboolean has_box;
+
+  MxFadeEffect *self = MX_FADE_EFFECT (effect);
+  MxFadeEffectPrivate *priv = self->priv;
+  ClutterActor *actor =
+    clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (effect));
 
-  if (!priv->freeze_update)
+  has_box = clutter_actor_get_paint_box (actor, &box);
+  cogl_get_modelview_matrix (&modelview);
+
+  if (!priv->freeze_update &&
+      !(has_box && mx_fade_effect_can_reuse_content (self, &box, &modelview)))
     {
-      return CLUTTER_EFFECT_CLASS (mx_fade_effect_parent_class)->
-        pre_paint (effect);
+      priv->paint_cached = FALSE;
+
+      if (!CLUTTER_EFFECT_CLASS (mx_fade_effect_parent_class)->
+          pre_paint (effect))
+        return FALSE;
+
+      /* Remember what the contents were drawn with, so we can tell if they
+       * can be reused on the next paint */
+      priv->content_dirty = FALSE;
+      priv->paint_modelview = modelview;
+      if (has_box)
+        {
+          priv->paint_width = clutter_actor_box_get_width (&box);
+          priv->paint_height = clutter_actor_box_get_height (&box);
+          clutter_actor_box_get_origin (&box, &priv->x_offset,
+                                        &priv->y_offset);
+        }
+      else
+        {
+          priv->content_dirty = TRUE;
+          priv->clip_interior = FALSE;
+        }
+
+      /* The fade geometry is needed now to clip the borders */
+      if (priv->clip_interior && priv->update_vbo)
+        mx_fade_effect_update_vbo (self);
+
+      if (priv->clip_interior &&
+          (priv->interior_box.x2 <= priv->interior_box.x1 ||
+           priv->interior_box.y2 <= priv->interior_box.y1))
+        priv->clip_interior = FALSE;
+
+      priv->content_clipped = priv->clip_interior;
+      if (priv->clip_interior)
+        mx_fade_effect_push_border_clip (self);
+
+      return TRUE;
     }
   else
     {
-      ClutterActorBox box;
-      ClutterActor *actor =
-        clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (effect));
+      priv->paint_cached = TRUE;
 
       /* Store the stage coordinates of the actor for when we post-paint */
-      clutter_actor_get_paint_box (actor, &box);
       clutter_actor_box_get_origin (&box, &priv->x_offset, &priv->y_offset);
 
       /* Connect to the paint signal so we can block it */
@@ -292,15 +499,21 @@ mx_fade_effect_post_paint (ClutterEffect *effect)
 {
   MxFadeEffectPrivate *priv = MX_FADE_EFFECT (effect)->priv;
 
-  if (!priv->freeze_update)
-    CLUTTER_EFFECT_CLASS (mx_fade_effect_parent_class)->post_paint (effect);
+  if (!priv->paint_cached)
+    {
+      /* The clip is on the offscreen buffer's stack, so pop it before the
+       * buffer is */
+      if (priv->border_clipped)
+        {
+          cogl_clip_pop ();
+          priv->border_clipped = FALSE;
+        }
+
+      CLUTTER_EFFECT_CLASS (mx_fade_effect_parent_class)->post_paint (effect);
+    }
   else
     {
       CoglMatrix modelview;
-      ClutterActor *actor, *stage;
-
-      actor = clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (effect));
-      stage = clutter_actor_get_stage (actor);
 
       /* Set up the draw matrix so we draw the offscreen texture at the
        * absolute coordinates of the actor-box. We need to do this to
@@ -309,10 +522,8 @@ mx_fade_effect_post_paint (ClutterEffect *effect)
        */
       cogl_push_matrix ();
 
-      cogl_matrix_init_identity (&modelview);
-      CLUTTER_ACTOR_CLASS (G_OBJECT_GET_CLASS (stage))->
-        apply_transform (stage, &modelview);
-      cogl_matrix_translate (&modelview, priv->x_offset, priv->y_offset, 0.f);
+      mx_fade_effect_get_target_modelview (MX_FADE_EFFECT (effect),
+                                           &modelview);
       cogl_set_modelview_matrix (&modelview);
 
       clutter_offscreen_effect_paint_target (CLUTTER_OFFSCREEN_EFFECT (effect));
@@ -321,6 +532,78 @@ mx_fade_effect_post_paint (ClutterEffect *effect)
     }
 }
 
+static gboolean
+mx_fade_effect_can_clip_interior (MxFadeEffect *self,
+                                  ClutterActor *actor)
+{
+  GList *effects;
+  gboolean is_last;
+
+  MxFadeEffectPrivate *priv = self->priv;
+
+  if (!priv->direct_interior || priv->freeze_update)
+    return FALSE;
+
+  /* Painting in two passes gives a different result when the actor is
+   * translucent, as overlapping children would be blended individually */
+  if (clutter_actor_get_paint_opacity (actor) != 0xff)
+    return FALSE;
+
+  /* The actor can only be continued twice if no other effect follows */
+  effects = clutter_actor_get_effects (actor);
+  is_last = (g_list_last (effects)->data == (gpointer)self);
+  g_list_free (effects);
+
+  return is_last;
+}
+
+static void
+mx_fade_effect_paint (ClutterEffect           *effect,
+                      ClutterEffectPaintFlags  flags)
+{
+  CoglMatrix modelview;
+
+  MxFadeEffect *self = MX_FADE_EFFECT (effect);
+  MxFadeEffectPrivate *priv = self->priv;
+  ClutterActor *actor =
+    clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (effect));
+
+  priv->clip_interior = mx_fade_effect_can_clip_interior (self, actor);
+
+  if (!priv->clip_interior)
+    {
+      CLUTTER_EFFECT_CLASS (mx_fade_effect_parent_class)->
+        paint (effect, flags);
+      return;
+    }
+
+  /* Draw the faded borders through the offscreen buffer */
+  if (!mx_fade_effect_pre_paint (effect))
+    {
+      clutter_actor_continue_paint (actor);
+      return;
+    }
+
+  clutter_actor_continue_paint (actor);
+  mx_fade_effect_post_paint (effect);
+
+  /* Pre-paint may have decided to draw the whole actor offscreen */
+  if (!priv->content_clipped)
+    return;
+
+  /* Then draw the interior directly */
+  cogl_push_matrix ();
+  mx_fade_effect_get_target_modelview (self, &modelview);
+  cogl_set_modelview_matrix (&modelview);
+  cogl_clip_push_rectangle (priv->interior_box.x1, priv->interior_box.y1,
+                            priv->interior_box.x2, priv->interior_box.y2);
+  cogl_pop_matrix ();
+
+  clutter_actor_continue_paint (actor);
+
+  cogl_clip_pop ();
+}
+
 static void
 mx_fade_effect_draw_rect (CoglTextureVertex *verts,
                           gfloat             x1,
@@ -501,16 +784,6 @@ mx_fade_effect_update_vbo (MxFadeEffect *self)
       n_quads ++;
     }
 
-  /* Generate the middle square */
-  mx_fade_effect_draw_rect (&verts[n_quads*4],
-                            x1 + bl, y1 + bu,
-                            x2 - br, y2 - bb,
-                            priv->width, priv->height,
-                            &opaque, &opaque,
-                            &opaque, &opaque,
-                            TRUE);
-  n_quads ++;
-
   /* Generate the right square */
   if (br)
     {
@@ -563,6 +836,26 @@ mx_fade_effect_update_vbo (MxFadeEffect *self)
       n_quads ++;
     }
 
+  /* Generate the middle square. This is generated last, so it can be left
+   * out when the interior is painted directly */
+  mx_fade_effect_draw_rect (&verts[n_quads*4],
+                            x1 + bl, y1 + bu,
+                            x2 - br, y2 - bb,
+                            priv->width, priv->height,
+                            &opaque, &opaque,
+                            &opaque, &opaque,
+                            TRUE);
+  n_quads ++;
+
+  priv->fade_box.x1 = x1;
+  priv->fade_box.y1 = y1;
+  priv->fade_box.x2 = x2;
+  priv->fade_box.y2 = y2;
+  priv->interior_box.x1 = x1 + bl;
+  priv->interior_box.y1 = y1 + bu;
+  priv->interior_box.x2 = x2 - br;
+  priv->interior_box.y2 = y2 - bb;
+
   /* Unref the old vbo if it's a different size - otherwise we reuse it */
   if (priv->vbo && (n_quads != priv->n_quads))
     {
@@ -612,6 +905,7 @@ mx_fade_effect_update_vbo (MxFadeEffect *self)
 static void
 mx_fade_effect_paint_target (ClutterOffscreenEffect *effect)
 {
+  guint n_quads;
   guint8 opacity;
   CoglColor color;
   ClutterActor *actor;
@@ -651,15 +945,20 @@ mx_fade_effect_paint_target (ClutterOffscreenEffect *effect)
   cogl_color_init_from_4ub (&color, opacity, opacity, opacity, opacity);
   cogl_material_set_layer_combine_constant (material, 1, &color);
 
-  /* Draw the texture */
+  /* Draw the texture. The middle square is the last one, and is left out
+   * when the interior is painted directly */
+  n_quads = priv->content_clipped ? priv->n_quads - 1 : priv->n_quads;
+  if (!n_quads)
+    return;
+
   cogl_set_source (material);
   cogl_vertex_buffer_draw_elements (priv->vbo,
                                     COGL_VERTICES_MODE_TRIANGLES,
                                     priv->indices,
                                     0,
-                                    (priv->n_quads * 4) - 1,
+                                    (n_quads * 4) - 1,
                                     0,
-                                    priv->n_quads * 6);
+                                    n_quads * 6);
 }
 
 static void
@@ -669,6 +968,7 @@ mx_fade_effect_class_init (MxFadeEffectClass *klass)
 
   ClutterColor transparent = { 0, };
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  ClutterActorMetaClass *meta_class = CLUTTER_ACTOR_META_CLASS (klass);
   ClutterEffectClass *effect_class = CLUTTER_EFFECT_CLASS (klass);
   ClutterOffscreenEffectClass *offscreen_class =
     CLUTTER_OFFSCREEN_EFFECT_CLASS (klass);
@@ -680,8 +980,11 @@ mx_fade_effect_class_init (MxFadeEffectClass *klass)
   object_class->dispose = mx_fade_effect_dispose;
   object_class->finalize = mx_fade_effect_finalize;
 
+  meta_class->set_actor = mx_fade_effect_set_actor;
+
   effect_class->pre_paint = mx_fade_effect_pre_paint;
   effect_class->post_paint = mx_fade_effect_post_paint;
+  effect_class->paint = mx_fade_effect_paint;
 
   offscreen_class->create_texture = mx_fade_effect_create_texture;
   offscreen_class->paint_target = mx_fade_effect_paint_target;
@@ -757,12 +1060,22 @@ mx_fade_effect_class_init (MxFadeEffectClass *klass)
                                 MX_PARAM_READWRITE |
                                 MX_PARAM_TRANSLATEABLE);
   g_object_class_install_property (object_class, PROP_FREEZE_UPDATE, pspec);
+
+  pspec = g_param_spec_boolean ("direct-interior",
+                                "Direct interior",
+                                "Paint the interior of the actor directly, "
+                                "only drawing the faded borders offscreen",
+                                FALSE,
+                                MX_PARAM_READWRITE |
+                                MX_PARAM_TRANSLATEABLE);
+  g_object_class_install_property (object_class, PROP_DIRECT_INTERIOR, pspec);
 }
 
 static void
 mx_fade_effect_init (MxFadeEffect *self)
 {
   self->priv = FADE_EFFECT_PRIVATE (self);
+  self->priv->content_dirty = TRUE;
 }
 
 /**
@@ -811,29 +1124,31 @@ mx_fade_effect_set_border (MxFadeEffect *effect,
   if (priv->border[0] != top)
     {
       priv->border[0] = top;
+      priv->update_vbo = TRUE;
       g_object_notify (G_OBJECT (effect), "border-top");
     }
 
   if (priv->border[1] != right)
     {
       priv->border[1] = right;
+      priv->update_vbo = TRUE;
       g_object_notify (G_OBJECT (effect), "border-right");
     }
 
   if (priv->border[2] != bottom)
     {
       priv->border[2] = bottom;
+      priv->update_vbo = TRUE;
       g_object_notify (G_OBJECT (effect), "border-bottom");
     }
 
   if (priv->border[3] != left)
     {
       priv->border[3] = left;
+      priv->update_vbo = TRUE;
       g_object_notify (G_OBJECT (effect), "border-left");
     }
 
-  priv->update_vbo = TRUE;
-
   g_object_thaw_notify (G_OBJECT (effect));
 }
 
@@ -959,29 +1274,31 @@ mx_fade_effect_set_bounds (MxFadeEffect *effect,
   if (priv->x != x)
     {
       priv->x = x;
+      priv->update_vbo = TRUE;
       g_object_notify (G_OBJECT (effect), "bounds-x");
     }
 
   if (priv->y != y)
     {
       priv->y = y;
+      priv->update_vbo = TRUE;
       g_object_notify (G_OBJECT (effect), "bounds-y");
     }
 
   if (priv->bounds_width != width)
     {
       priv->bounds_width = width;
+      priv->update_vbo = TRUE;
       g_object_notify (G_OBJECT (effect), "bounds-width");
     }
 
   if (priv->bounds_height != height)
     {
       priv->bounds_height = height;
+      priv->update_vbo = TRUE;
       g_object_notify (G_OBJECT (effect), "bounds-height");
     }
 
-  priv->update_vbo = TRUE;
-
   g_object_thaw_notify (G_OBJECT (effect));
 }
 
@@ -1020,6 +1337,61 @@ mx_fade_effect_get_bounds (MxFadeEffect *effect,
     *height = priv->bounds_height;
 }
 
+/**
+ * mx_fade_effect_set_direct_interior:
+ * @effect: A #MxFadeEffect
+ * @direct: %TRUE to paint the interior of the actor directly
+ *
+ * Sets whether the unfaded interior of the actor should be painted directly,
+ * rather than through the offscreen buffer. Only the faded borders are then
+ * drawn offscreen, which saves drawing most of the actor twice.
+ *
+ * This has no effect while the actor is translucent, or when another effect
+ * is applied to the actor after @effect.
+ *
+ * Since: 1.6
+ */
+void
+mx_fade_effect_set_direct_interior (MxFadeEffect *effect,
+                                    gboolean      direct)
+{
+  MxFadeEffectPrivate *priv;
+
+  g_return_if_fail (MX_IS_FADE_EFFECT (effect));
+
+  priv = effect->priv;
+  if (priv->direct_interior != direct)
+    {
+      ClutterActor *actor =
+        clutter_actor_meta_get_actor (CLUTTER_ACTOR_META (effect));
+
+      priv->direct_interior = direct;
+
+      if (actor)
+        clutter_actor_queue_redraw (actor);
+
+      g_object_notify (G_OBJECT (effect), "direct-interior");
+    }
+}
+
+/**
+ * mx_fade_effect_get_direct_interior:
+ * @effect: A #MxFadeEffect
+ *
+ * Retrieves whether the interior of the actor is painted directly. See
+ * mx_fade_effect_set_direct_interior().
+ *
+ * Returns: %TRUE if the interior is painted directly
+ *
+ * Since: 1.6
+ */
+gboolean
+mx_fade_effect_get_direct_interior (MxFadeEffect *effect)
+{
+  g_return_val_if_fail (MX_IS_FADE_EFFECT (effect), FALSE);
+  return effect->priv->direct_interior;
+}
+
 /*
  * mx_fade_effect_set_freeze_update:
  * @effect: A #MxFadeEffect
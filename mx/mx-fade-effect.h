@@ -98,6 +98,10 @@ void mx_fade_effect_set_color (MxFadeEffect       *effect,
 void mx_fade_effect_get_color (MxFadeEffect       *effect,
                                ClutterColor       *color);
 
+void     mx_fade_effect_set_direct_interior (MxFadeEffect *effect,
+                                             gboolean      direct);
+gboolean mx_fade_effect_get_direct_interior (MxFadeEffect *effect);
+
 G_END_DECLS
 
 #endif /* _MX_FADE_EFFECT_H */
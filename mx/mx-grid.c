@@ -105,6 +105,7 @@
 #include "mx-private.h"
 
 typedef struct _MxGridActorData MxGridActorData;
+typedef struct _MxGridLayoutKey MxGridLayoutKey;
 
 static void mx_grid_dispose             (GObject *object);
 static void mx_grid_finalize            (GObject *object);
@@ -211,6 +212,20 @@ struct _MxGridPrivate
   MxAdjustment *vadjustment;
 
   MxFocusable  *last_focus;
+
+  /* MxChildExtent of the allocated children, sorted by line. Invalid
+   * between the removal of a child and the next allocation. */
+  GArray       *extents;
+  gboolean      extents_valid;
+
+  /* The last layout is kept in the MxGridActorData of each child, and the
+   * state at the start of each line in the lines array. When the layout
+   * constraints are the same as the ones in layout_key, only the children
+   * from the line containing dirty_index onwards need to be laid out again.
+   */
+  MxGridLayoutKey *layout_key;
+  GArray          *lines;
+  gint             dirty_index;
 };
 
 enum
@@ -234,8 +249,63 @@ struct _MxGridActorData
   gboolean xpos_set,   ypos_set;
   gfloat   xpos,       ypos;
   gfloat   pref_width, pref_height;
+
+  /* the preferred size is cached in min_width, min_height, pref_width and
+   * pref_height, and invalidated when the child queues a relayout */
+  gboolean size_valid;
+  gfloat   min_width,  min_height;
+
+  /* position in the list and allocation in the last layout */
+  gint            index;
+  ClutterActorBox box;
+  ClutterActorBox min_box;
+  gfloat          line_start;
 };
 
+/* Everything the positions of the children depend on, apart from the sizes
+ * of the children themselves */
+struct _MxGridLayoutKey
+{
+  MxPadding     padding;
+  gfloat        a_wrap;
+  gfloat        max_extent_a;
+  gfloat        max_extent_b;
+  gfloat        column_spacing, row_spacing;
+  gboolean      homogenous_rows;
+  gboolean      homogenous_columns;
+  MxAlign       line_alignment;
+  MxAlign       child_x_align;
+  MxAlign       child_y_align;
+  MxOrientation orientation;
+  gint          max_stride;
+};
+
+typedef struct
+{
+  gint   first_index;
+  gfloat current_b;
+  gfloat next_b;
+} MxGridLine;
+
+/* used by subclasses that allocate the children themselves */
+void
+_mx_grid_invalidate_extents (MxGrid *grid)
+{
+  grid->priv->extents_valid = FALSE;
+}
+
+/* unlike mx_scrollable_get_adjustments(), doesn't create the adjustments */
+void
+_mx_grid_get_adjustments (MxGrid        *grid,
+                          MxAdjustment **hadjustment,
+                          MxAdjustment **vadjustment)
+{
+  if (hadjustment)
+    *hadjustment = grid->priv->hadjustment;
+  if (vadjustment)
+    *vadjustment = grid->priv->vadjustment;
+}
+
 /* scrollable interface */
 static void
 adjustment_value_notify_cb (MxAdjustment *adjustment,
@@ -709,6 +779,11 @@ mx_grid_init (MxGrid *self)
                              g_direct_equal,
                              NULL,
                              mx_grid_free_actor_data);
+
+  priv->extents = g_array_new (FALSE, FALSE, sizeof (MxChildExtent));
+
+  priv->layout_key = g_slice_new0 (MxGridLayoutKey);
+  priv->lines = g_array_new (FALSE, FALSE, sizeof (MxGridLine));
 }
 
 static void
@@ -730,6 +805,9 @@ mx_grid_finalize (GObject *object)
   MxGridPrivate *priv = self->priv;
 
   g_hash_table_destroy (priv->hash_table);
+  g_array_free (priv->extents, TRUE);
+  g_array_free (priv->lines, TRUE);
+  g_slice_free (MxGridLayoutKey, priv->layout_key);
 
   G_OBJECT_CLASS (mx_grid_parent_class)->finalize (object);
 }
@@ -1013,6 +1091,39 @@ mx_grid_free_actor_data (gpointer data)
   g_slice_free (MxGridActorData, data);
 }
 
+static void
+mx_grid_invalidate_child (MxGrid       *grid,
+                          ClutterActor *child,
+                          gboolean      size_changed)
+{
+  MxGridPrivate *priv = grid->priv;
+  MxGridActorData *data;
+
+  data = g_hash_table_lookup (priv->hash_table, child);
+  if (!data)
+    return;
+
+  if (size_changed)
+    data->size_valid = FALSE;
+
+  priv->dirty_index = MIN (priv->dirty_index, data->index);
+}
+
+static void
+mx_grid_child_queue_relayout_cb (ClutterActor *child,
+                                 MxGrid       *grid)
+{
+  mx_grid_invalidate_child (grid, child, TRUE);
+}
+
+static void
+mx_grid_child_visible_cb (ClutterActor *child,
+                          GParamSpec   *pspec,
+                          MxGrid       *grid)
+{
+  mx_grid_invalidate_child (grid, child, FALSE);
+}
+
 ClutterActor *
 mx_grid_new (void)
 {
@@ -1041,6 +1152,14 @@ mx_grid_real_add (ClutterContainer *container,
   priv->list = g_list_append (priv->list, actor);
   g_hash_table_insert (priv->hash_table, actor, data);
 
+  data->index = g_list_length (priv->list) - 1;
+  priv->dirty_index = MIN (priv->dirty_index, data->index);
+
+  g_signal_connect (actor, "queue-relayout",
+                    G_CALLBACK (mx_grid_child_queue_relayout_cb), container);
+  g_signal_connect (actor, "notify::visible",
+                    G_CALLBACK (mx_grid_child_visible_cb), container);
+
   g_signal_emit_by_name (container, "actor-added", actor);
 
   clutter_actor_queue_relayout (CLUTTER_ACTOR (container));
@@ -1048,19 +1167,95 @@ mx_grid_real_add (ClutterContainer *container,
   g_object_unref (actor);
 }
 
+/**
+ * mx_grid_add_actors:
+ * @self: a #MxGrid
+ * @actors: (element-type ClutterActor): the actors to add
+ *
+ * Adds the actors in @actors to the end of @self, invalidating the layout
+ * once for all of them.
+ *
+ * Since: 1.6
+ */
+void
+mx_grid_add_actors (MxGrid *self,
+                    GList  *actors)
+{
+  MxGridPrivate *priv;
+  GList *l, *new_list;
+  gint index;
+
+  g_return_if_fail (MX_IS_GRID (self));
+
+  if (!actors)
+    return;
+
+  /* Check all the actors first, so that nothing is added on failure */
+  if (!_mx_check_new_children (actors))
+    return;
+
+  priv = self->priv;
+  index = g_list_length (priv->list);
+
+  priv->dirty_index = MIN (priv->dirty_index, index);
+
+  new_list = NULL;
+  for (l = actors; l; l = l->next)
+    {
+      ClutterActor *actor = l->data;
+      MxGridActorData *data;
+
+      clutter_actor_set_parent (actor, CLUTTER_ACTOR (self));
+
+      data = g_slice_alloc0 (sizeof (MxGridActorData));
+      data->index = index++;
+
+      new_list = g_list_prepend (new_list, actor);
+      g_hash_table_insert (priv->hash_table, actor, data);
+
+      g_signal_connect (actor, "queue-relayout",
+                        G_CALLBACK (mx_grid_child_queue_relayout_cb), self);
+      g_signal_connect (actor, "notify::visible",
+                        G_CALLBACK (mx_grid_child_visible_cb), self);
+    }
+
+  priv->list = g_list_concat (priv->list, g_list_reverse (new_list));
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+
+  for (l = actors; l; l = l->next)
+    g_signal_emit_by_name (self, "actor-added", l->data);
+}
+
 static void
 mx_grid_real_remove (ClutterContainer *container,
                      ClutterActor     *actor)
 {
   MxGrid *layout = MX_GRID (container);
   MxGridPrivate *priv = layout->priv;
+  MxGridActorData *data;
 
   g_object_ref (actor);
 
+  data = g_hash_table_lookup (priv->hash_table, actor);
+  if (data)
+    {
+      priv->dirty_index = MIN (priv->dirty_index, data->index);
+
+      g_signal_handlers_disconnect_by_func (actor,
+                                            mx_grid_child_queue_relayout_cb,
+                                            container);
+      g_signal_handlers_disconnect_by_func (actor,
+                                            mx_grid_child_visible_cb,
+                                            container);
+    }
+
   if (g_hash_table_remove (priv->hash_table, actor))
     {
       clutter_actor_unparent (actor);
 
+      priv->extents_valid = FALSE;
+
       clutter_actor_queue_relayout (CLUTTER_ACTOR (layout));
 
       g_signal_emit_by_name (container, "actor-removed", actor);
@@ -1091,7 +1286,9 @@ mx_grid_real_raise (ClutterContainer *container,
                     ClutterActor     *sibling)
 {
   MxGridPrivate *priv = MX_GRID (container)->priv;
+  gint old_index;
 
+  old_index = g_list_index (priv->list, actor);
   priv->list = g_list_remove (priv->list, actor);
 
   if (sibling == NULL)
@@ -1103,6 +1300,10 @@ mx_grid_real_raise (ClutterContainer *container,
       priv->list = g_list_insert (priv->list, actor, index_);
     }
 
+  /* only the children from the old or new position on have moved */
+  priv->dirty_index = MIN (priv->dirty_index,
+                           MIN (old_index, g_list_index (priv->list, actor)));
+
   clutter_actor_queue_relayout (CLUTTER_ACTOR (container));
 }
 
@@ -1112,7 +1313,9 @@ mx_grid_real_lower (ClutterContainer *container,
                     ClutterActor     *sibling)
 {
   MxGridPrivate *priv = MX_GRID (container)->priv;
+  gint old_index;
 
+  old_index = g_list_index (priv->list, actor);
   priv->list = g_list_remove (priv->list, actor);
 
   if (sibling == NULL)
@@ -1124,6 +1327,10 @@ mx_grid_real_lower (ClutterContainer *container,
       priv->list = g_list_insert (priv->list, actor, index_);
     }
 
+  /* only the children from the old or new position on have moved */
+  priv->dirty_index = MIN (priv->dirty_index,
+                           MIN (old_index, g_list_index (priv->list, actor)));
+
   clutter_actor_queue_relayout (CLUTTER_ACTOR (container));
 }
 
@@ -1150,11 +1357,13 @@ mx_grid_real_sort_depth_order (ClutterContainer *container)
 
   priv->list = g_list_sort (priv->list, sort_by_depth);
 
+  priv->dirty_index = 0;
+
   clutter_actor_queue_relayout (CLUTTER_ACTOR (container));
 }
 
 static void
-mx_grid_paint (ClutterActor *actor)
+mx_grid_paint_children (ClutterActor *actor)
 {
   MxGrid *layout = (MxGrid *) actor;
   MxGridPrivate *priv = layout->priv;
@@ -1172,14 +1381,24 @@ mx_grid_paint (ClutterActor *actor)
   else
     y = 0;
 
-  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->paint (actor);
-
   clutter_actor_get_allocation_box (actor, &grid_b);
   grid_b.x2 = (grid_b.x2 - grid_b.x1) + x;
   grid_b.x1 = x;
   grid_b.y2 = (grid_b.y2 - grid_b.y1) + y;
   grid_b.y1 = y;
 
+  /* lines are laid out along the secondary axis, so the children can be
+   * searched for the first visible line */
+  if (priv->extents_valid)
+    {
+      _mx_child_extents_paint (priv->extents,
+                               (priv->orientation == MX_ORIENTATION_VERTICAL)
+                               ? MX_ORIENTATION_HORIZONTAL
+                               : MX_ORIENTATION_VERTICAL,
+                               &grid_b);
+      return;
+    }
+
   for (child_item = priv->list;
        child_item != NULL;
        child_item = child_item->next)
@@ -1204,56 +1423,21 @@ mx_grid_paint (ClutterActor *actor)
 }
 
 static void
-mx_grid_pick (ClutterActor       *actor,
-              const ClutterColor *color)
+mx_grid_paint (ClutterActor *actor)
 {
-  MxGrid *layout = (MxGrid *) actor;
-  MxGridPrivate *priv = layout->priv;
-  GList *child_item;
-  gfloat x, y;
-  ClutterActorBox grid_b;
-
-  if (priv->hadjustment)
-    x = mx_adjustment_get_value (priv->hadjustment);
-  else
-    x = 0;
+  CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->paint (actor);
 
-  if (priv->vadjustment)
-    y = mx_adjustment_get_value (priv->vadjustment);
-  else
-    y = 0;
+  mx_grid_paint_children (actor);
+}
 
+static void
+mx_grid_pick (ClutterActor       *actor,
+              const ClutterColor *color)
+{
   /* Chain up so we get a bounding box pained (if we are reactive) */
   CLUTTER_ACTOR_CLASS (mx_grid_parent_class)->pick (actor, color);
 
-
-  clutter_actor_get_allocation_box (actor, &grid_b);
-  grid_b.x2 = (grid_b.x2 - grid_b.x1) + x;
-  grid_b.x1 = x;
-  grid_b.y2 = (grid_b.y2 - grid_b.y1) + y;
-  grid_b.y1 = y;
-
-  for (child_item = priv->list;
-       child_item != NULL;
-       child_item = child_item->next)
-    {
-      ClutterActor *child = child_item->data;
-      ClutterActorBox child_b;
-
-      g_assert (child != NULL);
-
-      /* ensure the child is "on screen" */
-      clutter_actor_get_allocation_box (CLUTTER_ACTOR (child), &child_b);
-
-      if ((child_b.x1 < grid_b.x2)
-          && (child_b.x2 > grid_b.x1)
-          && (child_b.y1 < grid_b.y2)
-          && (child_b.y2 > grid_b.y1)
-          && CLUTTER_ACTOR_IS_VISIBLE (child))
-        {
-          clutter_actor_paint (child);
-        }
-    }
+  mx_grid_paint_children (actor);
 }
 
 static void
@@ -1302,6 +1486,34 @@ mx_grid_get_preferred_height (ClutterActor *self,
     *natural_height_p = actual_height;
 }
 
+static void
+mx_grid_get_child_size (MxGridPrivate *priv,
+                        ClutterActor  *child,
+                        gfloat        *min_width_p,
+                        gfloat        *min_height_p,
+                        gfloat        *natural_width_p,
+                        gfloat        *natural_height_p)
+{
+  MxGridActorData *data = g_hash_table_lookup (priv->hash_table, child);
+
+  if (!data->size_valid)
+    {
+      clutter_actor_get_preferred_size (child,
+                                        &data->min_width, &data->min_height,
+                                        &data->pref_width, &data->pref_height);
+      data->size_valid = TRUE;
+    }
+
+  if (min_width_p)
+    *min_width_p = data->min_width;
+  if (min_height_p)
+    *min_height_p = data->min_height;
+  if (natural_width_p)
+    *natural_width_p = data->pref_width;
+  if (natural_height_p)
+    *natural_height_p = data->pref_height;
+}
+
 static gfloat
 compute_row_height (GList         *siblings,
                     gfloat         best_yet,
@@ -1329,10 +1541,13 @@ compute_row_height (GList         *siblings,
       ClutterActor *child = l->data;
       gfloat natural_width, natural_height;
 
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
       /* each child will get as much space as they require */
-      clutter_actor_get_preferred_size (CLUTTER_ACTOR (child),
-                                        NULL, NULL,
-                                        &natural_width, &natural_height);
+      mx_grid_get_child_size (priv, child,
+                              NULL, NULL,
+                              &natural_width, &natural_height);
 
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
         {
@@ -1389,10 +1604,13 @@ compute_row_start (GList         *siblings,
       ClutterActor *child = l->data;
       gfloat natural_width, natural_height;
 
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
       /* each child will get as much space as they require */
-      clutter_actor_get_preferred_size (CLUTTER_ACTOR (child),
-                                        NULL, NULL,
-                                        &natural_width, &natural_height);
+      mx_grid_get_child_size (priv, child,
+                              NULL, NULL,
+                              &natural_width, &natural_height);
 
 
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
@@ -1414,6 +1632,56 @@ compute_row_start (GList         *siblings,
   return (priv->a_wrap - current_a);
 }
 
+static void
+mx_grid_place_child (MxGrid                 *layout,
+                     ClutterActor           *child,
+                     const ClutterActorBox  *child_box,
+                     const ClutterActorBox  *min_child_box,
+                     gfloat                  line_start,
+                     const MxPadding        *padding,
+                     ClutterAllocationFlags  flags,
+                     gboolean                calculate_extents_only,
+                     gfloat                 *actual_width,
+                     gfloat                 *actual_height,
+                     gfloat                 *min_width,
+                     gfloat                 *min_height)
+{
+  MxGridPrivate *priv = layout->priv;
+
+  /* update the allocation, and record the extent of the child along the
+   * secondary axis, starting from the start of its line */
+  if (!calculate_extents_only)
+    {
+      clutter_actor_allocate (child, child_box, flags);
+
+      if (priv->orientation == MX_ORIENTATION_VERTICAL)
+        _mx_child_extents_append (priv->extents, child, child_box,
+                                  line_start, child_box->x2);
+      else
+        _mx_child_extents_append (priv->extents, child, child_box,
+                                  line_start, child_box->y2);
+    }
+
+  /* update extents */
+  if (actual_width && (child_box->x2 + padding->right) > *actual_width)
+    *actual_width = child_box->x2 + padding->right;
+
+  if (actual_height && (child_box->y2 + padding->bottom) > *actual_height)
+    *actual_height = child_box->y2 + padding->bottom;
+
+  if (min_width &&
+      padding->left + min_child_box->x2 + padding->right > *min_width)
+    {
+      *min_width = padding->left + min_child_box->x2 + padding->right;
+    }
+
+  if (min_height &&
+      padding->top + min_child_box->y2 + padding->bottom > *min_height)
+    {
+      *min_height = padding->left + min_child_box->y2 + padding->right;
+    }
+}
+
 static void
 mx_grid_do_allocate (ClutterActor          *self,
                      const ClutterActorBox *box,
@@ -1426,6 +1694,7 @@ mx_grid_do_allocate (ClutterActor          *self,
 {
   MxGrid *layout = (MxGrid *) self;
   MxGridPrivate *priv = layout->priv;
+  MxGridLayoutKey key;
   MxPadding padding;
 
   gfloat current_a;
@@ -1433,6 +1702,7 @@ mx_grid_do_allocate (ClutterActor          *self,
   gfloat next_b;
   gfloat agap;
   gfloat bgap;
+  gfloat row_height;
 
   gboolean homogenous_a;
   gboolean homogenous_b;
@@ -1440,6 +1710,12 @@ mx_grid_do_allocate (ClutterActor          *self,
   gdouble balign;
   int current_stride;
 
+  gboolean store_layout;
+  gboolean new_line;
+  gboolean skip_wrap;
+  gint restart_index;
+  gint index;
+
   mx_widget_get_padding (MX_WIDGET (self), &padding);
 
   if (actual_width)
@@ -1455,6 +1731,13 @@ mx_grid_do_allocate (ClutterActor          *self,
     *min_height = 0;
 
   current_a = current_b = next_b = 0;
+  row_height = 0;
+
+  if (!calculate_extents_only)
+    {
+      g_array_set_size (priv->extents, 0);
+      priv->extents_valid = TRUE;
+    }
 
   GList *iter;
 
@@ -1497,9 +1780,9 @@ mx_grid_do_allocate (ClutterActor          *self,
             continue;
 
           /* each child will get as much space as they require */
-          clutter_actor_get_preferred_size (CLUTTER_ACTOR (child),
-                                            NULL, NULL,
-                                            &natural_width, &natural_height);
+          mx_grid_get_child_size (priv, child,
+                                  NULL, NULL,
+                                  &natural_width, &natural_height);
           if (natural_width > priv->max_extent_a)
             priv->max_extent_a = natural_width;
           if (natural_height > priv->max_extent_b)
@@ -1514,22 +1797,116 @@ mx_grid_do_allocate (ClutterActor          *self,
       priv->max_extent_b = temp;
     }
 
+  /* The cached layout can be reused up to the first changed child if it was
+   * laid out with the same constraints. A real allocation with different
+   * constraints replaces the cached layout, but size requests for other
+   * sizes are computed without touching it.
+   */
+  memset (&key, 0, sizeof (key));
+  key.padding = padding;
+  key.a_wrap = priv->a_wrap;
+  key.max_extent_a = priv->max_extent_a;
+  key.max_extent_b = priv->max_extent_b;
+  key.column_spacing = priv->column_spacing;
+  key.row_spacing = priv->row_spacing;
+  key.homogenous_rows = priv->homogenous_rows;
+  key.homogenous_columns = priv->homogenous_columns;
+  key.line_alignment = priv->line_alignment;
+  key.child_x_align = priv->child_x_align;
+  key.child_y_align = priv->child_y_align;
+  key.orientation = priv->orientation;
+  key.max_stride = priv->max_stride;
+
+  if (memcmp (&key, priv->layout_key, sizeof (key)) == 0)
+    store_layout = TRUE;
+  else if (!calculate_extents_only)
+    {
+      *priv->layout_key = key;
+      priv->dirty_index = 0;
+      store_layout = TRUE;
+    }
+  else
+    store_layout = FALSE;
+
+  /* Find the last line that starts before the first changed child. The
+   * child that starts a line must not have changed either, as its size
+   * decides whether it wraps.
+   */
+  restart_index = 0;
+  skip_wrap = FALSE;
   current_stride = 0;
-  for (iter = priv->list; iter; iter=iter->next)
+
+  if (store_layout && priv->dirty_index == G_MAXINT)
+    {
+      /* nothing changed since the last layout */
+      restart_index = G_MAXINT;
+    }
+  else if (store_layout)
+    {
+      guint n_lines = priv->lines->len;
+
+      while (n_lines > 0 &&
+             g_array_index (priv->lines, MxGridLine, n_lines - 1).first_index
+             >= priv->dirty_index)
+        n_lines--;
+
+      g_array_set_size (priv->lines, n_lines);
+
+      if (n_lines > 0)
+        {
+          MxGridLine *line = &g_array_index (priv->lines, MxGridLine,
+                                             n_lines - 1);
+
+          restart_index = line->first_index;
+          current_b = line->current_b;
+          next_b = line->next_b;
+          skip_wrap = TRUE;
+        }
+
+      /* children that change while being laid out are laid out again next
+       * time */
+      priv->dirty_index = G_MAXINT;
+    }
+
+  /* children before the restart point keep their previous layout */
+  for (iter = priv->list, index = 0;
+       iter && index < restart_index;
+       iter = iter->next, index++)
+    {
+      ClutterActor *child = iter->data;
+      MxGridActorData *data;
+
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      data = g_hash_table_lookup (priv->hash_table, child);
+
+      mx_grid_place_child (layout, child, &data->box, &data->min_box,
+                           data->line_start, &padding, flags,
+                           calculate_extents_only, actual_width,
+                           actual_height, min_width, min_height);
+    }
+
+  new_line = TRUE;
+  for (; iter; iter = iter->next, index++)
     {
       ClutterActor *child = iter->data;
+      MxGridActorData *data;
       gfloat natural_a;
       gfloat natural_b;
       gfloat min_a;
       gfloat min_b;
 
+      data = g_hash_table_lookup (priv->hash_table, child);
+      data->index = index;
+
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
       /* each child will get as much space as they require */
-      clutter_actor_get_preferred_size (CLUTTER_ACTOR (child),
-                                        &min_a, &min_b,
-                                        &natural_a, &natural_b);
+      mx_grid_get_child_size (priv, child,
+                              &min_a, &min_b,
+                              &natural_a, &natural_b);
 
       /* swap axes around if column is major */
       if (priv->orientation == MX_ORIENTATION_VERTICAL)
@@ -1546,15 +1923,32 @@ mx_grid_do_allocate (ClutterActor          *self,
       /* if the child is overflowing, or the max-stride has been reached,
        * we wrap to next line */
       current_stride++;
-      if ((priv->max_stride > 0 && current_stride > priv->max_stride)
-          || (current_a + natural_a > priv->a_wrap
-              || (homogenous_a && current_a + priv->max_extent_a > priv->a_wrap)))
+      if (skip_wrap)
+        {
+          /* restarting from the first child of a cached line */
+          skip_wrap = FALSE;
+        }
+      else if ((priv->max_stride > 0 && current_stride > priv->max_stride)
+               || (current_a + natural_a > priv->a_wrap
+                   || (homogenous_a
+                       && current_a + priv->max_extent_a > priv->a_wrap)))
         {
           current_b = next_b + bgap;
           current_a = 0;
           next_b = current_b + bgap;
           priv->first_of_batch = TRUE;
           current_stride = 1;
+          new_line = TRUE;
+
+          if (store_layout)
+            {
+              MxGridLine line;
+
+              line.first_index = index;
+              line.current_b = current_b;
+              line.next_b = next_b;
+              g_array_append_val (priv->lines, line);
+            }
         }
 
       if (priv->line_alignment &&
@@ -1567,20 +1961,27 @@ mx_grid_do_allocate (ClutterActor          *self,
       if (next_b-current_b < natural_b)
         next_b = current_b + natural_b;
 
+      /* the height of a line only needs to be computed once, at its first
+       * child */
+      if (new_line)
+        {
+          if (homogenous_b)
+            {
+              row_height = priv->max_extent_b;
+            }
+          else
+            {
+              row_height = compute_row_height (iter, next_b-current_b,
+                                               current_a, priv);
+            }
+
+          new_line = FALSE;
+        }
+
       {
-        gfloat row_height;
         ClutterActorBox child_box;
         ClutterActorBox min_child_box;
-
-        if (homogenous_b)
-          {
-            row_height = priv->max_extent_b;
-          }
-        else
-          {
-            row_height = compute_row_height (iter, next_b-current_b,
-                                             current_a, priv);
-          }
+        gfloat line_start;
 
         if (homogenous_a)
           {
@@ -1619,7 +2020,11 @@ mx_grid_do_allocate (ClutterActor          *self,
             temp = min_child_box.x2;
             min_child_box.x2 = min_child_box.y2;
             min_child_box.y2 = temp;
+
+            line_start = (int)(current_b + padding.left);
           }
+        else
+          line_start = (int)(current_b + padding.top);
 
         /* account for padding and pixel-align */
         child_box.x1 = (int)(child_box.x1 + padding.left);
@@ -1627,30 +2032,17 @@ mx_grid_do_allocate (ClutterActor          *self,
         child_box.x2 = (int)(child_box.x2 + padding.left);
         child_box.y2 = (int)(child_box.y2 + padding.top);
 
-        /* update the allocation */
-        if (!calculate_extents_only)
-          clutter_actor_allocate (CLUTTER_ACTOR (child),
-                                  &child_box,
-                                  flags);
-
-        /* update extents */
-        if (actual_width && (child_box.x2 + padding.right) > *actual_width)
-          *actual_width = child_box.x2 + padding.right;
-
-        if (actual_height && (child_box.y2 + padding.bottom) > *actual_height)
-          *actual_height = child_box.y2 + padding.bottom;
-
-        if (min_width &&
-            padding.left + min_child_box.x2 + padding.right > *min_width)
+        if (store_layout)
           {
-            *min_width = padding.left + min_child_box.x2 + padding.right;
+            data->box = child_box;
+            data->min_box = min_child_box;
+            data->line_start = line_start;
           }
 
-        if (min_height &&
-            padding.top + min_child_box.y2 + padding.bottom > *min_height)
-          {
-            *min_height = padding.left + min_child_box.y2 + padding.right;
-          }
+        mx_grid_place_child (layout, child, &child_box, &min_child_box,
+                             line_start, &padding, flags,
+                             calculate_extents_only, actual_width,
+                             actual_height, min_width, min_height);
 
         if (homogenous_a)
           {
@@ -1685,7 +2077,6 @@ mx_grid_allocate (ClutterActor          *self,
   /* only update vadjustment - we don't really want horizontal scrolling */
   if (priv->vadjustment && priv->orientation == MX_ORIENTATION_HORIZONTAL)
     {
-      gdouble prev_value;
       gfloat height;
 
       /* get preferred height for this width */
@@ -1695,6 +2086,10 @@ mx_grid_allocate (ClutterActor          *self,
        */
       alloc_box.y2 = alloc_box.y1 + height;
 
+      /* apply the new bounds as a single change, so the value is only
+       * clamped once */
+      mx_adjustment_freeze (priv->vadjustment);
+
       g_object_set (G_OBJECT (priv->vadjustment),
                     "lower", 0.0,
                     "upper", height,
@@ -1708,15 +2103,13 @@ mx_grid_allocate (ClutterActor          *self,
           g_object_set (G_OBJECT (priv->hadjustment),
                         "lower", 0.0,
                         "upper", 0.0,
-                        NULL);;
+                        NULL);
         }
 
-      prev_value = mx_adjustment_get_value (priv->vadjustment);
-      mx_adjustment_set_value (priv->vadjustment, prev_value);
+      mx_adjustment_thaw (priv->vadjustment);
     }
   if (priv->hadjustment && priv->orientation == MX_ORIENTATION_VERTICAL)
     {
-      gdouble prev_value;
       gfloat width;
 
       /* get preferred width for this height */
@@ -1726,6 +2119,10 @@ mx_grid_allocate (ClutterActor          *self,
        */
       alloc_box.x2 = alloc_box.x1 + width;
 
+      /* apply the new bounds as a single change, so the value is only
+       * clamped once */
+      mx_adjustment_freeze (priv->hadjustment);
+
       g_object_set (G_OBJECT (priv->hadjustment),
                     "lower", 0.0,
                     "upper", width,
@@ -1739,11 +2136,10 @@ mx_grid_allocate (ClutterActor          *self,
           g_object_set (G_OBJECT (priv->vadjustment),
                         "lower", 0.0,
                         "upper", 0.0,
-                        NULL);;
+                        NULL);
         }
 
-      prev_value = mx_adjustment_get_value (priv->hadjustment);
-      mx_adjustment_set_value (priv->hadjustment, prev_value);
+      mx_adjustment_thaw (priv->hadjustment);
     }
 
 
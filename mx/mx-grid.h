@@ -119,6 +119,9 @@ void mx_grid_set_max_stride (MxGrid *self,
                              gint    value);
 gint mx_grid_get_max_stride (MxGrid *self);
 
+void mx_grid_add_actors (MxGrid *self,
+                         GList  *actors);
+
 G_END_DECLS
 
 #endif /* __MX_GRID_H__ */
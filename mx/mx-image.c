@@ -35,6 +35,8 @@
 #include "mx-enum-types.h"
 #include "mx-marshal.h"
 #include "mx-texture-cache.h"
+#include "mx-scrollable.h"
+#include "mx-private.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
@@ -45,6 +47,9 @@ G_DEFINE_TYPE (MxImage, mx_image, MX_TYPE_WIDGET)
 
 #define DEFAULT_DURATION 250
 
+/* the shortest time between re-sorting the pending loads, in ms */
+#define REPRIORITIZE_INTERVAL 100
+
 /* This stucture holds all that is necessary for cancellable async
  * image loading using thread pools.
  *
@@ -85,6 +90,11 @@ typedef struct
 
   GdkPixbuf      *pixbuf;
   GError         *error;
+
+  /* Queued loads are sorted by priority, then in the order they were
+   * queued. Only accessed from the main thread. */
+  gint            priority;
+  guint           serial;
 } MxImageAsyncData;
 
 struct _MxImagePrivate
@@ -107,9 +117,9 @@ struct _MxImagePrivate
   CoglMaterial *template_material;
   CoglMaterial *material;
 
-  ClutterTimeline *timeline;
-  ClutterTimeline *redraw_timeline;
-  ClutterAlpha *redraw_alpha;
+  guint   transition;
+  guint   redraw_transition;
+  gdouble redraw_progress;
 
   guint transition_duration;
 
@@ -140,6 +150,10 @@ enum
 static guint signals[LAST_SIGNAL] = { 0, };
 
 static GThreadPool *mx_image_threads = NULL;
+static GList *mx_image_pending_loads = NULL;
+static guint mx_image_load_serial = 0;
+static guint mx_image_reprioritize_id = 0;
+static gint64 mx_image_reprioritize_time = 0;
 static GQuark mx_image_cache_quark = 0;
 
 static gboolean
@@ -197,6 +211,202 @@ mx_image_async_data_new (MxImage *parent)
   return data;
 }
 
+static gint
+mx_image_async_compare (gconstpointer a,
+                        gconstpointer b,
+                        gpointer      user_data)
+{
+  const MxImageAsyncData *data_a = a;
+  const MxImageAsyncData *data_b = b;
+
+  if (data_a->priority != data_b->priority)
+    return (data_a->priority < data_b->priority) ? -1 : 1;
+
+  return (data_a->serial < data_b->serial) ? -1 :
+         (data_a->serial > data_b->serial);
+}
+
+static gfloat
+mx_image_get_range_distance (gfloat  start,
+                             gfloat  end,
+                             gdouble lower,
+                             gdouble upper)
+{
+  if (end < lower)
+    return lower - end;
+  else if (start > upper)
+    return start - upper;
+  else
+    return 0;
+}
+
+/* Gets the adjustments of @actor, if it's a scrollable that a scroll view
+ * drives or that has a predicted area. Unlike
+ * mx_scrollable_get_adjustments(), this doesn't create adjustments for a
+ * scrollable that has none, such as a box layout that isn't scrolled. */
+static gboolean
+mx_image_get_scrolled_adjustments (ClutterActor  *actor,
+                                   MxAdjustment **hadjust,
+                                   MxAdjustment **vadjust)
+{
+  ClutterActor *parent = clutter_actor_get_parent (actor);
+
+  if (!MX_IS_SCROLL_VIEW (parent) &&
+      !MX_IS_KINETIC_SCROLL_VIEW (parent) &&
+      !mx_scrollable_get_predicted_area (MX_SCROLLABLE (actor), NULL))
+    return FALSE;
+
+  *hadjust = *vadjust = NULL;
+
+  if (MX_IS_BOX_LAYOUT (actor))
+    _mx_box_layout_get_adjustments (MX_BOX_LAYOUT (actor), hadjust, vadjust);
+  else if (MX_IS_GRID (actor))
+    _mx_grid_get_adjustments (MX_GRID (actor), hadjust, vadjust);
+  else if (MX_IS_VIEWPORT (actor))
+    _mx_viewport_get_adjustments (MX_VIEWPORT (actor), hadjust, vadjust);
+
+  return (*hadjust || *vadjust);
+}
+
+/* Images in the visible area of their scrollable load first, followed by
+ * the images nearest to it. When a scrollable predicts that an area will
+ * become visible, images outside of that area load last. Images that
+ * aren't in a scrolled scrollable, or that haven't been allocated yet,
+ * load in the order they were queued with the visible ones.
+ */
+static gint
+mx_image_get_load_priority (MxImage *image)
+{
+  ClutterActor *actor = CLUTTER_ACTOR (image);
+  MxAdjustment *hadjust, *vadjust;
+  ClutterActorBox box, area;
+  gfloat x, y, width, height, distance;
+  gint priority;
+
+  if (!clutter_actor_has_allocation (actor))
+    return 0;
+
+  clutter_actor_get_allocation_box (actor, &box);
+  clutter_actor_box_get_size (&box, &width, &height);
+
+  /* find the position of the image in the content of the scrollable that
+   * is scrolled, skipping any scrollables nested in it that aren't */
+  x = y = 0;
+  while (actor &&
+         !(MX_IS_SCROLLABLE (actor) &&
+           mx_image_get_scrolled_adjustments (actor, &hadjust, &vadjust)))
+    {
+      if (!clutter_actor_has_allocation (actor))
+        return 0;
+
+      clutter_actor_get_allocation_box (actor, &box);
+      x += box.x1;
+      y += box.y1;
+
+      actor = clutter_actor_get_parent (actor);
+    }
+
+  if (!actor)
+    return 0;
+
+  distance = 0;
+  if (hadjust)
+    {
+      gdouble value, page_size;
+
+      mx_adjustment_get_values (hadjust, &value, NULL, NULL,
+                                NULL, NULL, &page_size);
+      distance += mx_image_get_range_distance (x, x + width,
+                                               value, value + page_size);
+    }
+  if (vadjust)
+    {
+      gdouble value, page_size;
+
+      mx_adjustment_get_values (vadjust, &value, NULL, NULL,
+                                NULL, NULL, &page_size);
+      distance += mx_image_get_range_distance (y, y + height,
+                                               value, value + page_size);
+    }
+
+  priority = MIN (distance, G_MAXINT / 4);
+
+  if (mx_scrollable_get_predicted_area (MX_SCROLLABLE (actor), &area) &&
+      (mx_image_get_range_distance (x, x + width, area.x1, area.x2) > 0 ||
+       mx_image_get_range_distance (y, y + height, area.y1, area.y2) > 0))
+    priority += G_MAXINT / 2;
+
+  return priority;
+}
+
+static gboolean
+mx_image_reprioritize_cb (gpointer user_data)
+{
+  GList *l;
+  gboolean changed = FALSE;
+
+  mx_image_reprioritize_id = 0;
+  mx_image_reprioritize_time = g_get_monotonic_time ();
+
+  for (l = mx_image_pending_loads; l; l = l->next)
+    {
+      MxImageAsyncData *data = l->data;
+      gint priority;
+
+      /* the image of a cancelled load may have been destroyed */
+      if (data->cancelled)
+        continue;
+
+      priority = mx_image_get_load_priority (data->parent);
+      if (priority != data->priority)
+        {
+          data->priority = priority;
+          changed = TRUE;
+        }
+    }
+
+  /* setting the sort function re-sorts the queued loads, which is only
+   * worth doing when the order changed */
+  if (changed && mx_image_threads)
+    g_thread_pool_set_sort_function (mx_image_threads,
+                                     mx_image_async_compare, NULL);
+
+  return FALSE;
+}
+
+static void
+mx_image_queue_reprioritize (void)
+{
+  gint64 elapsed;
+
+  if (mx_image_reprioritize_id || !mx_image_pending_loads)
+    return;
+
+  /* every allocation of an image with a pending load queues this, so
+   * re-sort the loads at most once per REPRIORITIZE_INTERVAL */
+  elapsed = (g_get_monotonic_time () - mx_image_reprioritize_time) / 1000;
+  if (elapsed >= REPRIORITIZE_INTERVAL || elapsed < 0)
+    mx_image_reprioritize_id =
+      clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                     mx_image_reprioritize_cb, NULL, NULL);
+  else
+    mx_image_reprioritize_id =
+      clutter_threads_add_timeout_full (G_PRIORITY_HIGH_IDLE,
+                                        REPRIORITIZE_INTERVAL - elapsed,
+                                        mx_image_reprioritize_cb, NULL, NULL);
+}
+
+static gboolean
+mx_image_predicted_area_changed_hook (GSignalInvocationHint *ihint,
+                                      guint                  n_param_values,
+                                      const GValue          *param_values,
+                                      gpointer               user_data)
+{
+  mx_image_queue_reprioritize ();
+
+  return TRUE;
+}
+
 static void
 get_center_coords (CoglHandle  tex,
                    float       rotation,
@@ -316,14 +526,14 @@ mx_image_paint (ClutterActor *actor)
   /* current texture */
   scale = calculate_scale (priv->texture, priv->rotation, aw, ah, priv->mode);
 
-  if (clutter_timeline_is_playing (priv->redraw_timeline))
+  if (priv->redraw_transition)
     {
       gfloat progress, previous_scale;
 
       previous_scale = calculate_scale (priv->texture, priv->rotation, aw, ah,
                                         priv->previous_mode);
 
-      progress = clutter_alpha_get_alpha (priv->redraw_alpha);
+      progress = priv->redraw_progress;
       scale = scale + (previous_scale - scale) * (1 - progress);
     }
 
@@ -416,6 +626,20 @@ mx_image_get_preferred_height (ClutterActor *actor,
     *pref_height = height + padding.top + padding.bottom;
 }
 
+static void
+mx_image_allocate (ClutterActor           *actor,
+                   const ClutterActorBox  *box,
+                   ClutterAllocationFlags  flags)
+{
+  MxImagePrivate *priv = MX_IMAGE (actor)->priv;
+
+  CLUTTER_ACTOR_CLASS (mx_image_parent_class)->allocate (actor, box, flags);
+
+  /* the position of the image decides when a pending load runs */
+  if (priv->async_load_data)
+    mx_image_queue_reprioritize ();
+}
+
 static void
 mx_image_set_property (GObject      *object,
                        guint         prop_id,
@@ -509,29 +733,16 @@ mx_image_dispose (GObject *object)
 {
   MxImagePrivate *priv = MX_IMAGE (object)->priv;
 
-  if (priv->timeline)
+  if (priv->transition)
     {
-      clutter_timeline_stop (priv->timeline);
-
-      g_object_unref (priv->timeline);
-
-      priv->timeline = NULL;
+      _mx_transition_stop (priv->transition);
+      priv->transition = 0;
     }
 
-  if (priv->redraw_timeline)
+  if (priv->redraw_transition)
     {
-      clutter_timeline_stop (priv->redraw_timeline);
-
-      g_object_unref (priv->redraw_timeline);
-
-      priv->redraw_timeline = NULL;
-    }
-
-  if (priv->redraw_alpha)
-    {
-      g_object_unref (priv->redraw_alpha);
-
-      priv->redraw_alpha = NULL;
+      _mx_transition_stop (priv->redraw_transition);
+      priv->redraw_transition = 0;
     }
 
   if (priv->material)
@@ -595,6 +806,7 @@ mx_image_class_init (MxImageClass *klass)
   actor_class->paint = mx_image_paint;
   actor_class->get_preferred_width = mx_image_get_preferred_width;
   actor_class->get_preferred_height = mx_image_get_preferred_height;
+  actor_class->allocate = mx_image_allocate;
 
   pspec = g_param_spec_enum ("scale-mode",
                              "Scale Mode",
@@ -695,6 +907,14 @@ mx_image_class_init (MxImageClass *klass)
                   G_TYPE_NONE, 1, G_TYPE_ERROR);
 
   mx_image_cache_quark = g_quark_from_static_string ("mx-image-cache");
+
+  /* Load the images that a scrollable predicts will become visible first */
+  g_type_default_interface_unref (
+    g_type_default_interface_ref (MX_TYPE_SCROLLABLE));
+  g_signal_add_emission_hook (g_signal_lookup ("predicted-area-changed",
+                                               MX_TYPE_SCROLLABLE),
+                              0, mx_image_predicted_area_changed_hook,
+                              NULL, NULL);
 }
 
 static void
@@ -725,7 +945,7 @@ create_new_material (MxImage *image,
 
   /* Create the constant color to be used when combining the two
    * material layers; we use a black color with an alpha component
-   * depending on the current progress of the timeline
+   * depending on the current progress of the transition
    */
   cogl_color_init_from_4ub (&constant, 0x00, 0x00, 0x00, 0xff * progress);
 
@@ -741,33 +961,56 @@ create_new_material (MxImage *image,
 }
 
 static void
-new_frame_cb (ClutterTimeline *timeline,
-              guint            elapsed_msecs,
-              MxImage         *image)
+new_frame_cb (gdouble  progress,
+              gpointer user_data)
 {
+  MxImage *image = user_data;
   MxImagePrivate *priv = image->priv;
-  gdouble progress;
 
   if (priv->material == COGL_INVALID_HANDLE)
     return;
 
-  progress = clutter_timeline_get_progress (priv->timeline);
-
   create_new_material (image, progress);
 
   clutter_actor_queue_redraw (CLUTTER_ACTOR (image));
 }
 
-static void
-timeline_complete (ClutterTimeline *timeline,
-                   MxImage         *image)
+static gboolean
+transition_complete (gpointer user_data)
 {
+  MxImage *image = user_data;
+
+  image->priv->transition = 0;
+
   if (image->priv->old_texture)
     {
       cogl_object_unref (image->priv->old_texture);
       image->priv->old_texture = NULL;
     }
   create_new_material (image, 1.0);
+
+  return FALSE;
+}
+
+static void
+redraw_frame_cb (gdouble  progress,
+                 gpointer user_data)
+{
+  MxImage *image = user_data;
+
+  image->priv->redraw_progress = progress;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (image));
+}
+
+static gboolean
+redraw_complete (gpointer user_data)
+{
+  MxImage *image = user_data;
+
+  image->priv->redraw_transition = 0;
+
+  return FALSE;
 }
 
 static void
@@ -779,18 +1022,6 @@ mx_image_init (MxImage *self)
   priv = self->priv = MX_IMAGE_GET_PRIVATE (self);
 
   priv->transition_duration = DEFAULT_DURATION;
-  priv->timeline = clutter_timeline_new (priv->transition_duration);
-  priv->redraw_timeline = clutter_timeline_new (200);
-  priv->redraw_alpha = clutter_alpha_new_full (priv->redraw_timeline,
-                                               CLUTTER_EASE_OUT_CUBIC);
-
-  g_signal_connect (priv->timeline, "new-frame", G_CALLBACK (new_frame_cb),
-                    self);
-  g_signal_connect (priv->timeline, "completed", G_CALLBACK (timeline_complete),
-                    self);
-
-  g_signal_connect_swapped (priv->redraw_timeline, "new-frame",
-                            G_CALLBACK (clutter_actor_queue_redraw), self);
 
   priv->blank_texture = cogl_texture_new_from_data (1, 1, COGL_TEXTURE_NO_ATLAS,
                                                     COGL_PIXEL_FORMAT_RGBA_8888,
@@ -902,10 +1133,12 @@ mx_image_animate_scale_mode (MxImage          *image,
       priv->previous_mode = priv->mode;
       priv->mode = scale_mode;
 
-      clutter_timeline_stop (priv->redraw_timeline);
-      clutter_timeline_set_duration (priv->redraw_timeline, duration);
-      clutter_alpha_set_mode (priv->redraw_alpha, mode);
-      clutter_timeline_start (priv->redraw_timeline);
+      _mx_transition_stop (priv->redraw_transition);
+      priv->redraw_progress = 0;
+      priv->redraw_transition = _mx_transition_start (duration, mode,
+                                                      redraw_frame_cb,
+                                                      redraw_complete,
+                                                      image);
 
       g_object_notify (G_OBJECT (image), "scale-mode");
     }
@@ -947,9 +1180,14 @@ mx_image_prepare_texture (MxImage  *image)
   /* start the cross fade animation. When not having a transition duration,
    * we directly jump forward a create the material corresponding to the end
    * of the transition animation */
-  clutter_timeline_stop (priv->timeline);
+  _mx_transition_stop (priv->transition);
+  priv->transition = 0;
   if (priv->transition_duration)
-    clutter_timeline_start (priv->timeline);
+    priv->transition = _mx_transition_start (priv->transition_duration,
+                                             CLUTTER_LINEAR,
+                                             new_frame_cb,
+                                             transition_complete,
+                                             image);
   else
     create_new_material (image, 1.0);
 
@@ -1325,6 +1563,7 @@ mx_image_load_complete_cb (gpointer task_data)
     }
 
   /* Free the async loading struct */
+  mx_image_pending_loads = g_list_remove (mx_image_pending_loads, data);
   mx_image_async_data_free (data);
 
   return FALSE;
@@ -1590,6 +1829,9 @@ mx_image_set_async (MxImage         *image,
           g_propagate_error (error, err);
           return FALSE;
         }
+
+      g_thread_pool_set_sort_function (mx_image_threads,
+                                       mx_image_async_compare, NULL);
     }
 
   /* Cancel/free any in-progress load */
@@ -1624,6 +1866,10 @@ mx_image_set_async (MxImage         *image,
               g_mutex_unlock (old_data->mutex);
 
               data = old_data;
+
+              /* The load is still queued, re-sort it */
+              data->priority = mx_image_get_load_priority (image);
+              mx_image_queue_reprioritize ();
             }
         }
     }
@@ -1638,6 +1884,9 @@ mx_image_set_async (MxImage         *image,
       data->free_func = free_func;
       data->width = width;
       data->height = height;
+      data->priority = mx_image_get_load_priority (image);
+      data->serial = mx_image_load_serial++;
+      mx_image_pending_loads = g_list_prepend (mx_image_pending_loads, data);
       g_thread_pool_push (mx_image_threads, data, NULL);
     }
 
@@ -2218,9 +2467,6 @@ mx_image_set_transition_duration (MxImage *image, guint duration)
     {
       image->priv->transition_duration = duration;
 
-      if (duration != 0)
-        clutter_timeline_set_duration (image->priv->timeline, duration);
-
       g_object_notify (G_OBJECT (image), "transition-duration");
     }
 }
@@ -32,38 +32,40 @@
  *
  * Data is set on the children by mapping columns in the model to object
  * properties on the children.
+ *
+ * For large models, #MxItemView can be made #MxItemView:virtualized. Items
+ * are then only created for the rows of cells in the visible part of the
+ * view, and they are reused for other rows of the model as the view
+ * scrolls.
  */
 
+#include <math.h>
+
 #include "mx-item-view.h"
 #include "mx-private.h"
+#include "mx-scrollable.h"
 
 G_DEFINE_TYPE (MxItemView, mx_item_view, MX_TYPE_GRID)
 
 #define ITEM_VIEW_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_ITEM_VIEW, MxItemViewPrivate))
 
-typedef struct
-{
-  gchar *name;
-  gint   col;
-} AttributeData;
-
 enum
 {
   PROP_0,
 
   PROP_MODEL,
   PROP_ITEM_TYPE,
-  PROP_FACTORY
+  PROP_FACTORY,
+  PROP_VIRTUALIZED,
+  PROP_OVERSCAN
 };
 
+#define DEFAULT_OVERSCAN 2
+
 struct _MxItemViewPrivate
 {
-  ClutterModel  *model;
-  GSList        *attributes;
-  GType          item_type;
-
-  MxItemFactory *factory;
+  MxItemWindow   window;
 
   gulong         filter_changed;
   gulong         row_added;
@@ -71,7 +73,11 @@ struct _MxItemViewPrivate
   gulong         row_removed;
   gulong         sort_changed;
 
-  guint          is_frozen : 1;
+  guint          virtualized : 1;
+  guint          overscan;
+  gfloat         cell_width;
+  gfloat         cell_height;
+  gfloat         page_width;
 };
 
 /* gobject implementations */
@@ -86,13 +92,19 @@ mx_item_view_get_property (GObject    *object,
   switch (property_id)
     {
     case PROP_MODEL:
-      g_value_set_object (value, priv->model);
+      g_value_set_object (value, priv->window.model);
       break;
     case PROP_ITEM_TYPE:
-      g_value_set_gtype (value, priv->item_type);
+      g_value_set_gtype (value, priv->window.item_type);
       break;
     case PROP_FACTORY:
-      g_value_set_object (value, priv->factory);
+      g_value_set_object (value, priv->window.factory);
+      break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, priv->virtualized);
+      break;
+    case PROP_OVERSCAN:
+      g_value_set_uint (value, priv->overscan);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -118,6 +130,14 @@ mx_item_view_set_property (GObject      *object,
       mx_item_view_set_factory ((MxItemView*) object,
                                 (MxItemFactory*) g_value_get_object (value));
       break;
+    case PROP_VIRTUALIZED:
+      mx_item_view_set_virtualized ((MxItemView*) object,
+                                    g_value_get_boolean (value));
+      break;
+    case PROP_OVERSCAN:
+      mx_item_view_set_overscan ((MxItemView*) object,
+                                 g_value_get_uint (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -126,9 +146,13 @@ mx_item_view_set_property (GObject      *object,
 static void
 mx_item_view_dispose (GObject *object)
 {
+  MxItemViewPrivate *priv = MX_ITEM_VIEW (object)->priv;
+
   /* This will cause the unref of the model and also disconnect the signals */
   mx_item_view_set_model (MX_ITEM_VIEW (object), NULL);
 
+  _mx_item_window_dispose (&priv->window);
+
   G_OBJECT_CLASS (mx_item_view_parent_class)->dispose (object);
 }
 
@@ -137,20 +161,253 @@ mx_item_view_finalize (GObject *object)
 {
   MxItemViewPrivate *priv = MX_ITEM_VIEW (object)->priv;
 
-  if (priv->attributes)
+  _mx_item_window_finalize (&priv->window);
+
+  G_OBJECT_CLASS (mx_item_view_parent_class)->finalize (object);
+}
+
+/* the number of cells on each line of the grid, for a width */
+static gint
+mx_item_view_get_n_columns (MxItemView *item_view,
+                            gfloat      width)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  MxGrid *grid = MX_GRID (item_view);
+  MxPadding padding;
+  gfloat spacing;
+  gint n_columns;
+
+  if (mx_grid_get_max_stride (grid) > 0)
+    return mx_grid_get_max_stride (grid);
+
+  if (priv->cell_width <= 0)
+    return 1;
+
+  mx_widget_get_padding (MX_WIDGET (item_view), &padding);
+  spacing = mx_grid_get_column_spacing (grid);
+
+  n_columns = (width - padding.left - padding.right + spacing)
+    / (priv->cell_width + spacing);
+
+  return MAX (1, n_columns);
+}
+
+static gfloat
+mx_item_view_get_content_height (MxItemView *item_view,
+                                 gint        n_columns)
+{
+  gint n_rows = _mx_item_window_get_n_rows (&item_view->priv->window);
+  gint n_lines;
+
+  if (n_rows < 1)
+    return 0;
+
+  n_lines = (n_rows + n_columns - 1) / n_columns;
+
+  return n_lines * item_view->priv->cell_height
+    + (n_lines - 1) * mx_grid_get_row_spacing (MX_GRID (item_view));
+}
+
+static void
+mx_item_view_get_range (ClutterActor *actor,
+                        gint          n_rows,
+                        gfloat        top,
+                        gfloat        bottom,
+                        gint         *first,
+                        gint         *last)
+{
+  MxItemView *item_view = MX_ITEM_VIEW (actor);
+  MxItemViewPrivate *priv = item_view->priv;
+  MxPadding padding;
+  gfloat pitch;
+  gint n_columns, line;
+
+  pitch = priv->cell_height + mx_grid_get_row_spacing (MX_GRID (item_view));
+
+  if (n_rows < 1 || pitch <= 0)
     {
-      g_slist_foreach (priv->attributes, (GFunc) g_free, NULL);
-      g_slist_free (priv->attributes);
-      priv->attributes = NULL;
+      *first = *last = 0;
+      return;
     }
 
-  G_OBJECT_CLASS (mx_item_view_parent_class)->finalize (object);
+  mx_widget_get_padding (MX_WIDGET (item_view), &padding);
+  n_columns = mx_item_view_get_n_columns (item_view, priv->page_width);
+
+  line = floorf ((top - padding.top) / pitch) - priv->overscan;
+  *first = CLAMP (line * n_columns, 0, n_rows);
+
+  line = ceilf ((bottom - padding.top) / pitch)
+    + priv->overscan;
+  *last = CLAMP (line * n_columns, *first, n_rows);
+}
+
+/* all the cells get the size of the first item */
+static gboolean
+mx_item_view_needs_measure (ClutterActor *actor)
+{
+  return MX_ITEM_VIEW (actor)->priv->cell_height <= 0;
+}
+
+static void
+mx_item_view_measure (ClutterActor *actor,
+                      ClutterActor *item)
+{
+  MxItemViewPrivate *priv = MX_ITEM_VIEW (actor)->priv;
+
+  clutter_actor_get_preferred_size (item, NULL, NULL,
+                                    &priv->cell_width,
+                                    &priv->cell_height);
+  priv->cell_width = MAX (1, priv->cell_width);
+  priv->cell_height = MAX (1, priv->cell_height);
+}
+
+static void
+mx_item_view_reset_measure (ClutterActor *actor)
+{
+  MxItemViewPrivate *priv = MX_ITEM_VIEW (actor)->priv;
+
+  priv->cell_width = 0;
+  priv->cell_height = 0;
+}
+
+static void
+mx_item_view_adjustment_notify_cb (GObject    *object,
+                                   GParamSpec *pspec,
+                                   MxItemView *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  MxAdjustment *vadjustment = NULL;
+
+  /* don't use mx_scrollable_get_adjustments(), creating an adjustment
+   * would notify and call this again */
+  if (priv->virtualized)
+    _mx_grid_get_adjustments (MX_GRID (item_view), NULL, &vadjustment);
+
+  _mx_item_window_set_vadjustment (&priv->window, vadjustment);
+}
+
+static void
+mx_item_view_get_preferred_height (ClutterActor *actor,
+                                   gfloat        for_width,
+                                   gfloat       *min_height_p,
+                                   gfloat       *nat_height_p)
+{
+  MxItemView *item_view = MX_ITEM_VIEW (actor);
+  MxPadding padding;
+  gfloat height;
+
+  if (!item_view->priv->virtualized)
+    {
+      CLUTTER_ACTOR_CLASS (mx_item_view_parent_class)->
+        get_preferred_height (actor, for_width, min_height_p, nat_height_p);
+      return;
+    }
+
+  if (for_width < 0)
+    for_width = item_view->priv->page_width;
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  height = padding.top + padding.bottom
+    + mx_item_view_get_content_height (item_view,
+                                       mx_item_view_get_n_columns (item_view,
+                                                                   for_width));
+
+  if (min_height_p)
+    *min_height_p = height;
+  if (nat_height_p)
+    *nat_height_p = height;
+}
+
+static void
+mx_item_view_allocate (ClutterActor           *actor,
+                       const ClutterActorBox  *box,
+                       ClutterAllocationFlags  flags)
+{
+  MxItemView *item_view = MX_ITEM_VIEW (actor);
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActorClass *widget_class;
+  gfloat column_spacing, row_spacing, avail_height;
+  MxAdjustment *hadjustment;
+  MxPadding padding;
+  gint n_columns;
+  guint i;
+
+  if (!priv->virtualized)
+    {
+      CLUTTER_ACTOR_CLASS (mx_item_view_parent_class)->
+        allocate (actor, box, flags);
+      return;
+    }
+
+  priv->window.in_allocation = TRUE;
+
+  /* the items are laid out here rather than by MxGrid, at the cell of the
+   * row they show */
+  widget_class = g_type_class_peek_parent (mx_item_view_parent_class);
+  widget_class->allocate (actor, box, flags);
+  _mx_grid_invalidate_extents (MX_GRID (actor));
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+  column_spacing = mx_grid_get_column_spacing (MX_GRID (actor));
+  row_spacing = mx_grid_get_row_spacing (MX_GRID (actor));
+
+  priv->page_width = box->x2 - box->x1;
+  priv->window.page_height = box->y2 - box->y1;
+  avail_height = priv->window.page_height - padding.top - padding.bottom;
+
+  /* a new size may show rows that don't have an item yet, or change the
+   * number of columns */
+  _mx_item_window_check_range (&priv->window);
+
+  n_columns = mx_item_view_get_n_columns (item_view, priv->page_width);
+
+  for (i = 0; i < priv->window.items->len; i++)
+    {
+      ClutterActor *item = g_ptr_array_index (priv->window.items, i);
+      ClutterActorBox child_box;
+      gint row = priv->window.first_row + i;
+
+      child_box.x1 = (int) (padding.left + (row % n_columns)
+                            * (priv->cell_width + column_spacing));
+      child_box.x2 = child_box.x1 + priv->cell_width;
+      child_box.y1 = (int) (padding.top + (row / n_columns)
+                            * (priv->cell_height + row_spacing));
+      child_box.y2 = child_box.y1 + priv->cell_height;
+
+      clutter_actor_allocate (item, &child_box, flags);
+    }
+
+  if (priv->window.vadjustment)
+    {
+      mx_adjustment_freeze (priv->window.vadjustment);
+      g_object_set (G_OBJECT (priv->window.vadjustment),
+                    "lower", 0.0,
+                    "upper", mx_item_view_get_content_height (item_view,
+                                                              n_columns),
+                    "page-size", avail_height,
+                    "step-increment", priv->cell_height + row_spacing,
+                    "page-increment", avail_height,
+                    NULL);
+      mx_adjustment_thaw (priv->window.vadjustment);
+    }
+
+  /* as with MxGrid, there is no horizontal scrolling */
+  _mx_grid_get_adjustments (MX_GRID (actor), &hadjustment, NULL);
+  if (hadjustment)
+    g_object_set (G_OBJECT (hadjustment),
+                  "lower", 0.0,
+                  "upper", 0.0,
+                  NULL);
+
+  priv->window.in_allocation = FALSE;
 }
 
 static void
 mx_item_view_class_init (MxItemViewClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
   GParamSpec *pspec;
 
   g_type_class_add_private (klass, sizeof (MxItemViewPrivate));
@@ -160,6 +417,9 @@ mx_item_view_class_init (MxItemViewClass *klass)
   object_class->dispose = mx_item_view_dispose;
   object_class->finalize = mx_item_view_finalize;
 
+  actor_class->get_preferred_height = mx_item_view_get_preferred_height;
+  actor_class->allocate = mx_item_view_allocate;
+
   pspec = g_param_spec_object ("model",
                                "model",
                                "The model for the item view",
@@ -185,21 +445,48 @@ mx_item_view_class_init (MxItemViewClass *klass)
                                G_TYPE_OBJECT /*MX_TYPE_ITEM_FACTORY*/,
                                MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_FACTORY, pspec);
+
+  pspec = g_param_spec_boolean ("virtualized",
+                                "Virtualized",
+                                "Whether to only create items for the "
+                                "visible rows",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_VIRTUALIZED, pspec);
+
+  pspec = g_param_spec_uint ("overscan",
+                             "Overscan",
+                             "Number of lines of cells to create items for "
+                             "before and after the visible ones, when "
+                             "virtualized",
+                             0, G_MAXUINT, DEFAULT_OVERSCAN,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_OVERSCAN, pspec);
 }
 
 static void
 mx_item_view_init (MxItemView *item_view)
 {
-  item_view->priv = ITEM_VIEW_PRIVATE (item_view);
-}
+  MxItemViewPrivate *priv;
 
+  priv = item_view->priv = ITEM_VIEW_PRIVATE (item_view);
+
+  _mx_item_window_init (&priv->window, CLUTTER_ACTOR (item_view),
+                        mx_item_view_get_range,
+                        mx_item_view_needs_measure,
+                        mx_item_view_measure,
+                        mx_item_view_reset_measure);
+  priv->overscan = DEFAULT_OVERSCAN;
+
+  g_signal_connect (item_view, "notify::vertical-adjustment",
+                    G_CALLBACK (mx_item_view_adjustment_notify_cb), item_view);
+}
 
 /* model monitors */
 static void
 model_changed_cb (ClutterModel *model,
                   MxItemView   *item_view)
 {
-  GSList *p;
   GList *l, *children;
   MxItemViewPrivate *priv = item_view->priv;
   ClutterModelIter *iter = NULL;
@@ -207,49 +494,53 @@ model_changed_cb (ClutterModel *model,
 
 
   /* bail out if we don't yet have an item type */
-  if (!priv->item_type && !priv->factory)
+  if (!priv->window.item_type && !priv->window.factory)
     return;
 
-  if (priv->is_frozen)
+  if (priv->window.is_frozen)
     return;
 
-  if (priv->item_type)
+  if (priv->window.item_type)
     {
       /* check the item-type is an descendant of ClutterActor */
-      if (!g_type_is_a (priv->item_type, CLUTTER_TYPE_ACTOR))
+      if (!g_type_is_a (priv->window.item_type, CLUTTER_TYPE_ACTOR))
         {
           g_warning ("%s is not a subclass of ClutterActor and therefore"
                      " cannot be used as items in an MxItemView",
-                     g_type_name (priv->item_type));
+                     g_type_name (priv->window.item_type));
           return;
         }
     }
 
+  if (priv->virtualized)
+    {
+      _mx_item_window_update (&priv->window, TRUE);
+      return;
+    }
+
   children = clutter_container_get_children (CLUTTER_CONTAINER (item_view));
   child_n = g_list_length (children);
 
   if (model)
-    model_n = clutter_model_get_n_rows (priv->model);
+    model_n = clutter_model_get_n_rows (priv->window.model);
   else
     model_n = 0;
 
   /* add children as needed */
-  while (model_n > child_n)
+  if (model_n > child_n)
     {
-      ClutterActor *new_child;
+      GList *new_children = NULL;
 
-      if (priv->item_type)
+      while (model_n > child_n)
         {
-          new_child = g_object_new (priv->item_type, NULL);
-        }
-      else
-        {
-          new_child = mx_item_factory_create (priv->factory);
+          ClutterActor *item = _mx_item_window_create_item (&priv->window);
+
+          new_children = g_list_prepend (new_children, item);
+          child_n++;
         }
 
-      clutter_container_add_actor (CLUTTER_CONTAINER (item_view),
-                                   new_child);
-      child_n++;
+      mx_grid_add_actors (MX_GRID (item_view), new_children);
+      g_list_free (new_children);
     }
 
   /* remove children as needed */
@@ -264,42 +555,68 @@ model_changed_cb (ClutterModel *model,
 
   g_list_free (children);
 
-  if (!priv->model)
+  if (!priv->window.model)
     return;
 
   children = clutter_container_get_children (CLUTTER_CONTAINER (item_view));
 
   /* set the properties on the children */
-  iter = clutter_model_get_first_iter (priv->model);
+  iter = clutter_model_get_first_iter (priv->window.model);
   l = children;
   while (iter && !clutter_model_iter_is_last (iter))
     {
-      GObject *child;
+      _mx_item_window_bind_item (&priv->window, G_OBJECT (l->data), iter);
 
-      child = G_OBJECT (l->data);
+      l = g_list_next (l);
+      clutter_model_iter_next (iter);
+    }
 
-      g_object_freeze_notify (child);
-      for (p = priv->attributes; p; p = p->next)
-        {
-          GValue value = { 0, };
-          AttributeData *attr = p->data;
+  g_list_free (children);
 
-          clutter_model_iter_get_value (iter, attr->col, &value);
+  if (iter)
+    g_object_unref (iter);
+}
 
-          g_object_set_property (child, attr->name, &value);
+static void
+row_added_cb (ClutterModel     *model,
+              ClutterModelIter *iter,
+              MxItemView       *item_view)
+{
+  MxItemViewPrivate *priv = item_view->priv;
+  ClutterActor *child, *sibling;
+  GList *children;
 
-          g_value_unset (&value);
-        }
-      g_object_thaw_notify (child);
+  if ((!priv->window.item_type && !priv->window.factory)
+      || priv->window.is_frozen)
+    return;
 
-      l = g_list_next (l);
-      clutter_model_iter_next (iter);
+  /* the row of the iter counts the rows that are filtered out, so it
+   * isn't the position of the new item */
+  if (clutter_model_get_filter_set (model))
+    {
+      if (clutter_model_filter_iter (model, iter))
+        model_changed_cb (model, item_view);
+      return;
     }
 
+  if (priv->virtualized)
+    {
+      /* the rows after the new one have moved */
+      _mx_item_window_update (&priv->window, TRUE);
+      return;
+    }
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (item_view));
+  sibling = g_list_nth_data (children, clutter_model_iter_get_row (iter));
   g_list_free (children);
 
-  if (iter)
-    g_object_unref (iter);
+  child = _mx_item_window_create_item (&priv->window);
+  _mx_item_window_bind_item (&priv->window, G_OBJECT (child), iter);
+
+  clutter_container_add_actor (CLUTTER_CONTAINER (item_view), child);
+  if (sibling)
+    clutter_container_lower_child (CLUTTER_CONTAINER (item_view),
+                                   child, sibling);
 }
 
 static void
@@ -307,7 +624,42 @@ row_changed_cb (ClutterModel     *model,
                 ClutterModelIter *iter,
                 MxItemView       *item_view)
 {
-  model_changed_cb (model, item_view);
+  MxItemViewPrivate *priv = item_view->priv;
+  GList *children;
+  GObject *child;
+  gint row;
+
+  if ((!priv->window.item_type && !priv->window.factory)
+      || priv->window.is_frozen)
+    return;
+
+  /* the change may have moved the row in or out of the filter */
+  if (clutter_model_get_filter_set (model))
+    {
+      model_changed_cb (model, item_view);
+      return;
+    }
+
+  row = clutter_model_iter_get_row (iter);
+
+  if (priv->virtualized)
+    {
+      gint index_ = row - priv->window.first_row;
+
+      if (index_ >= 0 && (guint) index_ < priv->window.items->len)
+        _mx_item_window_bind_item (&priv->window,
+                                   g_ptr_array_index (priv->window.items,
+                                                      index_),
+                                   iter);
+      return;
+    }
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (item_view));
+  child = g_list_nth_data (children, row);
+  g_list_free (children);
+
+  if (child)
+    _mx_item_window_bind_item (&priv->window, child, iter);
 }
 
 static void
@@ -316,16 +668,27 @@ row_removed_cb (ClutterModel     *model,
                 MxItemView       *item_view)
 {
   GList *children;
-  GList *l;
   ClutterActor *child;
+  gint index_;
+
+  if (item_view->priv->window.is_frozen)
+    return;
+
+  if (item_view->priv->virtualized)
+    {
+      _mx_item_window_row_removed (&item_view->priv->window, iter);
+      return;
+    }
 
-  if (item_view->priv->is_frozen)
+  /* a row that the filter rejects has no item */
+  index_ = _mx_item_window_get_iter_index (&item_view->priv->window, iter);
+  if (index_ < 0)
     return;
 
   children = clutter_container_get_children (CLUTTER_CONTAINER (item_view));
-  l = g_list_nth (children, clutter_model_iter_get_row (iter));
-  child = (ClutterActor *) l->data;
-  clutter_container_remove_actor (CLUTTER_CONTAINER (item_view), child);
+  child = g_list_nth_data (children, index_);
+  if (child)
+    clutter_container_remove_actor (CLUTTER_CONTAINER (item_view), child);
   g_list_free (children);
 }
 
@@ -357,7 +720,7 @@ mx_item_view_get_item_type (MxItemView *item_view)
 {
   g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), G_TYPE_INVALID);
 
-  return item_view->priv->item_type;
+  return item_view->priv->window.item_type;
 }
 
 
@@ -376,10 +739,10 @@ mx_item_view_set_item_type (MxItemView *item_view,
   g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
   g_return_if_fail (g_type_is_a (item_type, CLUTTER_TYPE_ACTOR));
 
-  item_view->priv->item_type = item_type;
+  item_view->priv->window.item_type = item_type;
 
   /* update the view */
-  model_changed_cb (item_view->priv->model, item_view);
+  model_changed_cb (item_view->priv->window.model, item_view);
 }
 
 /**
@@ -395,7 +758,7 @@ mx_item_view_get_model (MxItemView *item_view)
 {
   g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), NULL);
 
-  return item_view->priv->model;
+  return item_view->priv->window.model;
 }
 
 /**
@@ -416,53 +779,56 @@ mx_item_view_set_model (MxItemView   *item_view,
 
   priv = item_view->priv;
 
-  if (priv->model)
+  if (priv->window.model)
     {
-      g_signal_handlers_disconnect_by_func (priv->model,
+      g_signal_handlers_disconnect_by_func (priv->window.model,
                                             (GCallback) model_changed_cb,
                                             item_view);
-      g_signal_handlers_disconnect_by_func (priv->model,
+      g_signal_handlers_disconnect_by_func (priv->window.model,
+                                            (GCallback) row_added_cb,
+                                            item_view);
+      g_signal_handlers_disconnect_by_func (priv->window.model,
                                             (GCallback) row_changed_cb,
                                             item_view);
-      g_signal_handlers_disconnect_by_func (priv->model,
+      g_signal_handlers_disconnect_by_func (priv->window.model,
                                             (GCallback) row_removed_cb,
                                             item_view);
-      g_object_unref (priv->model);
+      g_object_unref (priv->window.model);
 
-      priv->model = NULL;
+      priv->window.model = NULL;
     }
 
   if (model)
     {
       g_return_if_fail (CLUTTER_IS_MODEL (model));
 
-      priv->model = g_object_ref (model);
+      priv->window.model = g_object_ref (model);
 
-      priv->filter_changed = g_signal_connect (priv->model,
+      priv->filter_changed = g_signal_connect (priv->window.model,
                                                "filter-changed",
                                                G_CALLBACK (model_changed_cb),
                                                item_view);
 
-      priv->row_added = g_signal_connect (priv->model,
+      priv->row_added = g_signal_connect (priv->window.model,
                                           "row-added",
-                                          G_CALLBACK (row_changed_cb),
+                                          G_CALLBACK (row_added_cb),
                                           item_view);
 
-      priv->row_changed = g_signal_connect (priv->model,
+      priv->row_changed = g_signal_connect (priv->window.model,
                                             "row-changed",
                                             G_CALLBACK (row_changed_cb),
                                             item_view);
 
       /*
-       * model_changed_cb (called from row_changed_cb) expect the row to already
-       * have been removed, thus we need to use _after
+       * The model removes the row in the default handler of row-removed,
+       * so connect before it, while the row and its iter are still valid
        */
-      priv->row_removed = g_signal_connect_after (priv->model,
-                                                  "row-removed",
-                                                  G_CALLBACK (row_removed_cb),
-                                                  item_view);
+      priv->row_removed = g_signal_connect (priv->window.model,
+                                            "row-removed",
+                                            G_CALLBACK (row_removed_cb),
+                                            item_view);
 
-      priv->sort_changed = g_signal_connect (priv->model,
+      priv->sort_changed = g_signal_connect (priv->window.model,
                                              "sort-changed",
                                              G_CALLBACK (model_changed_cb),
                                              item_view);
@@ -471,7 +837,7 @@ mx_item_view_set_model (MxItemView   *item_view,
        * Only do this inside this block, setting the model to NULL should have
        * the effect of preserving the view; just disconnect the handlers
        */
-      model_changed_cb (priv->model, item_view);
+      model_changed_cb (priv->window.model, item_view);
     }
 }
 
@@ -491,7 +857,6 @@ mx_item_view_add_attribute (MxItemView  *item_view,
                             gint         column)
 {
   MxItemViewPrivate *priv;
-  AttributeData *prop;
 
   g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
   g_return_if_fail (_attribute != NULL);
@@ -499,12 +864,8 @@ mx_item_view_add_attribute (MxItemView  *item_view,
 
   priv = item_view->priv;
 
-  prop = g_new (AttributeData, 1);
-  prop->name = g_strdup (_attribute);
-  prop->col = column;
-
-  priv->attributes = g_slist_prepend (priv->attributes, prop);
-  model_changed_cb (priv->model, item_view);
+  _mx_item_window_add_attribute (&priv->window, _attribute, column);
+  model_changed_cb (priv->window.model, item_view);
 }
 
 /**
@@ -519,7 +880,7 @@ mx_item_view_freeze (MxItemView *item_view)
 {
   g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
 
-  item_view->priv->is_frozen = TRUE;
+  item_view->priv->window.is_frozen = TRUE;
 }
 
 /**
@@ -538,10 +899,10 @@ mx_item_view_thaw (MxItemView *item_view)
 
   priv = item_view->priv;
 
-  priv->is_frozen = FALSE;
+  priv->window.is_frozen = FALSE;
 
   /* Repopulate */
-  model_changed_cb (priv->model, item_view);
+  model_changed_cb (priv->window.model, item_view);
 }
 
 /**
@@ -562,17 +923,17 @@ mx_item_view_set_factory (MxItemView    *item_view,
 
   priv = item_view->priv;
 
-  if (priv->factory == factory)
+  if (priv->window.factory == factory)
     return;
 
-  if (priv->factory)
+  if (priv->window.factory)
     {
-      g_object_unref (priv->factory);
-      priv->factory = NULL;
+      g_object_unref (priv->window.factory);
+      priv->window.factory = NULL;
     }
 
   if (factory)
-    priv->factory = g_object_ref (factory);
+    priv->window.factory = g_object_ref (factory);
 
   g_object_notify (G_OBJECT (item_view), "factory");
 }
@@ -589,5 +950,113 @@ MxItemFactory *
 mx_item_view_get_factory (MxItemView *item_view)
 {
   g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), NULL);
-  return item_view->priv->factory;
+  return item_view->priv->window.factory;
+}
+
+/**
+ * mx_item_view_set_virtualized:
+ * @item_view: A #MxItemView
+ * @virtualized: %TRUE to only create items for the visible rows
+ *
+ * Sets whether @item_view creates an item for every row in the model, or
+ * only for the rows with a cell in the visible part of the view or
+ * #MxItemView:overscan lines of cells around it. Items are then reused for
+ * other rows as the view is scrolled vertically.
+ *
+ * A virtualized item view gives every cell the natural size of the first
+ * item, and lays the cells out in rows from left to right, whatever the
+ * #MxGrid:orientation.
+ *
+ * Since: 1.6
+ */
+void
+mx_item_view_set_virtualized (MxItemView *item_view,
+                              gboolean    virtualized)
+{
+  MxItemViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
+
+  priv = item_view->priv;
+
+  if (priv->virtualized == virtualized)
+    return;
+
+  priv->virtualized = virtualized;
+  priv->cell_width = 0;
+  priv->cell_height = 0;
+
+  _mx_item_window_remove_children (&priv->window);
+  mx_item_view_adjustment_notify_cb (NULL, NULL, item_view);
+
+  g_object_notify (G_OBJECT (item_view), "virtualized");
+
+  model_changed_cb (priv->window.model, item_view);
+}
+
+/**
+ * mx_item_view_get_virtualized:
+ * @item_view: A #MxItemView
+ *
+ * Gets whether @item_view only creates items for the visible rows.
+ *
+ * Returns: %TRUE if @item_view is virtualized
+ *
+ * Since: 1.6
+ */
+gboolean
+mx_item_view_get_virtualized (MxItemView *item_view)
+{
+  g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), FALSE);
+  return item_view->priv->virtualized;
+}
+
+/**
+ * mx_item_view_set_overscan:
+ * @item_view: A #MxItemView
+ * @overscan: number of lines of cells
+ *
+ * Sets the number of lines of cells before and after the visible ones that
+ * a virtualized @item_view keeps items for, so that they are ready when the
+ * view scrolls.
+ *
+ * Since: 1.6
+ */
+void
+mx_item_view_set_overscan (MxItemView *item_view,
+                           guint       overscan)
+{
+  MxItemViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_ITEM_VIEW (item_view));
+
+  priv = item_view->priv;
+
+  if (priv->overscan == overscan)
+    return;
+
+  priv->overscan = overscan;
+
+  g_object_notify (G_OBJECT (item_view), "overscan");
+
+  if (priv->virtualized)
+    _mx_item_window_update (&priv->window, FALSE);
+}
+
+/**
+ * mx_item_view_get_overscan:
+ * @item_view: A #MxItemView
+ *
+ * Gets the number of lines of cells outside the visible area that a
+ * virtualized @item_view keeps items for.
+ *
+ * Returns: the number of lines
+ *
+ * Since: 1.6
+ */
+guint
+mx_item_view_get_overscan (MxItemView *item_view)
+{
+  g_return_val_if_fail (MX_IS_ITEM_VIEW (item_view), 0);
+  return item_view->priv->overscan;
 }
@@ -55,11 +55,24 @@ G_DEFINE_TYPE_WITH_CODE (MxKineticScrollView,
                                         MX_TYPE_KINETIC_SCROLL_VIEW, \
                                         MxKineticScrollViewPrivate))
 
+/* Number of motion events kept for velocity estimation */
+#define MOTION_BUFFER_SIZE 16
+
+/* Only the motion in this many milliseconds before the release is used to
+ * estimate the velocity */
+#define VELOCITY_WINDOW 100
+
+/* The deceleration rate and the velocity are expressed per 60th of a
+ * second, independently of the actual frame rate */
+#define FRAME_TIME (1000.0 / 60.0)
+
 typedef struct {
   /* Units to store the origin of a click when scrolling */
   gfloat   x;
   gfloat   y;
-  GTimeVal time;
+  guint32  time;
+  /* Monotonic time at which the event was received, in milliseconds */
+  guint32  local_time;
 } MxKineticScrollViewMotion;
 
 struct _MxKineticScrollViewPrivate
@@ -72,19 +85,21 @@ struct _MxKineticScrollViewPrivate
   guint                  vmoving      : 1;
   guint                  hclamping    : 1;
   guint                  vclamping    : 1;
+  guint                  use_event_time : 1;
   guint32                button;
 
-  /* Mouse motion event information */
+  /* Mouse motion event information, kept as a ring buffer */
   GArray                *motion_buffer;
   guint                  last_motion;
+  guint                  n_motions;
 
   /* Variables for storing acceleration information */
   ClutterTimeline       *deceleration_timeline;
   gfloat                 dx;
   gfloat                 dy;
+  gdouble                decel_frames;
   gdouble                decel_rate;
   gdouble                overshoot;
-  gdouble                accumulated_delta;
   gdouble                acceleration_factor;
 
   MxScrollPolicy         scroll_policy;
@@ -116,7 +131,8 @@ enum {
 
 static gboolean button_release (MxKineticScrollView *scroll,
                                 gint                 x,
-                                gint                 y);
+                                gint                 y,
+                                guint32              time);
 
 /* MxScrollableIface implementation */
 
@@ -518,6 +534,116 @@ set_state (MxKineticScrollView *scroll, MxKineticScrollViewState state)
   g_object_notify (G_OBJECT (scroll), "state");
 }
 
+/* Returns the time of an event in milliseconds. Event timestamps are used
+ * when the windowing system provides them, otherwise the monotonic clock;
+ * either can wrap, so times should only be compared by their difference.
+ *
+ * A gesture only uses one of the two clocks: if an event without a
+ * timestamp arrives part-way through, the motion buffer is moved over to
+ * the monotonic clock along with the rest of the gesture.
+ */
+static guint32
+get_event_time (MxKineticScrollView *scroll,
+                guint32              event_time)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+
+  if (priv->use_event_time)
+    {
+      guint i;
+
+      if (event_time != CLUTTER_CURRENT_TIME)
+        return event_time;
+
+      for (i = 0; i < priv->motion_buffer->len; i++)
+        {
+          MxKineticScrollViewMotion *motion =
+            &g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, i);
+
+          motion->time = motion->local_time;
+        }
+
+      priv->use_event_time = FALSE;
+    }
+
+  return (guint32)(g_get_monotonic_time () / 1000);
+}
+
+static void
+add_motion (MxKineticScrollView *scroll,
+            gfloat               x,
+            gfloat               y,
+            guint32              time)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  MxKineticScrollViewMotion *motion;
+
+  if (priv->n_motions)
+    priv->last_motion = (priv->last_motion + 1) % priv->motion_buffer->len;
+  if (priv->n_motions < priv->motion_buffer->len)
+    priv->n_motions ++;
+
+  motion = &g_array_index (priv->motion_buffer,
+                           MxKineticScrollViewMotion, priv->last_motion);
+  motion->x = x;
+  motion->y = y;
+  motion->time = time;
+  motion->local_time = (guint32)(g_get_monotonic_time () / 1000);
+}
+
+/* Estimates the velocity at @time, in units per millisecond, with a
+ * least-squares fit of the position against time over the recent motion
+ * events and the release point at (@x, @y).
+ */
+static void
+get_velocity (MxKineticScrollView *scroll,
+              gfloat               x,
+              gfloat               y,
+              guint32              time,
+              gdouble             *vx,
+              gdouble             *vy)
+{
+  MxKineticScrollViewPrivate *priv = scroll->priv;
+  gdouble st, sx, sy, stt, stx, sty, det;
+  guint i, n, len;
+
+  /* The release point is at t = 0 */
+  st = stt = stx = sty = 0;
+  sx = x;
+  sy = y;
+  n = 1;
+
+  len = priv->motion_buffer->len;
+  for (i = 0; i < priv->n_motions; i++)
+    {
+      MxKineticScrollViewMotion *motion =
+        &g_array_index (priv->motion_buffer, MxKineticScrollViewMotion,
+                        (priv->last_motion + len - i) % len);
+      gdouble t = (gint32)(motion->time - time);
+
+      if (t < -VELOCITY_WINDOW)
+        break;
+
+      st += t;
+      sx += motion->x;
+      sy += motion->y;
+      stt += t * t;
+      stx += t * motion->x;
+      sty += t * motion->y;
+      n ++;
+    }
+
+  det = n * stt - st * st;
+  if (det <= 0)
+    {
+      *vx = *vy = 0;
+      return;
+    }
+
+  *vx = (n * stx - st * sx) / det;
+  *vy = (n * sty - st * sy) / det;
+}
+
 static gboolean
 motion_event_cb (ClutterActor        *actor,
                  ClutterMotionEvent  *event,
@@ -541,23 +667,23 @@ motion_event_cb (ClutterActor        *actor,
     default:
     case 1:
       if (!(event->modifier_state & CLUTTER_BUTTON1_MASK))
-        return button_release (scroll, event->x, event->y);
+        return button_release (scroll, event->x, event->y, event->time);
       break;
     case 2:
       if (!(event->modifier_state & CLUTTER_BUTTON2_MASK))
-        return button_release (scroll, event->x, event->y);
+        return button_release (scroll, event->x, event->y, event->time);
       break;
     case 3:
       if (!(event->modifier_state & CLUTTER_BUTTON3_MASK))
-        return button_release (scroll, event->x, event->y);
+        return button_release (scroll, event->x, event->y, event->time);
       break;
     case 4:
       if (!(event->modifier_state & CLUTTER_BUTTON4_MASK))
-        return button_release (scroll, event->x, event->y);
+        return button_release (scroll, event->x, event->y, event->time);
       break;
     case 5:
       if (!(event->modifier_state & CLUTTER_BUTTON5_MASK))
-        return button_release (scroll, event->x, event->y);
+        return button_release (scroll, event->x, event->y, event->time);
       break;
     }
 
@@ -639,19 +765,7 @@ motion_event_cb (ClutterActor        *actor,
             }
         }
 
-      priv->last_motion ++;
-      if (priv->last_motion == priv->motion_buffer->len)
-        {
-          priv->motion_buffer = g_array_remove_index (priv->motion_buffer, 0);
-          g_array_set_size (priv->motion_buffer, priv->last_motion);
-          priv->last_motion --;
-        }
-
-      motion = &g_array_index (priv->motion_buffer,
-                               MxKineticScrollViewMotion, priv->last_motion);
-      motion->x = x;
-      motion->y = y;
-      g_get_current_time (&motion->time);
+      add_motion (scroll, x, y, get_event_time (scroll, event->time));
     }
 
   return TRUE;
@@ -745,6 +859,56 @@ clamp_adjustments (MxKineticScrollView *scroll,
     set_state (scroll, MX_KINETIC_SCROLL_VIEW_STATE_CLAMPING);
 }
 
+static void
+set_predicted_area (MxKineticScrollView   *scroll,
+                    const ClutterActorBox *area)
+{
+  ClutterActor *child = mx_bin_get_child (MX_BIN (scroll));
+
+  if (child)
+    mx_scrollable_set_predicted_area (MX_SCROLLABLE (child), area);
+}
+
+/* Works out the area of the child that will be scrolled over by a
+ * deceleration moving the adjustments by (dx, dy) in total */
+static void
+predict_area (MxKineticScrollView *scroll,
+              gdouble              dx,
+              gdouble              dy)
+{
+  ClutterActor *child = mx_bin_get_child (MX_BIN (scroll));
+  MxAdjustment *adjustments[2];
+  gdouble deltas[2] = { dx, dy };
+  gfloat coords[4];
+  ClutterActorBox area;
+  gint i;
+
+  mx_scrollable_get_adjustments (MX_SCROLLABLE (child),
+                                 &adjustments[0], &adjustments[1]);
+
+  for (i = 0; i < 2; i++)
+    {
+      gdouble value, lower, upper, page_size;
+
+      if (!adjustments[i])
+        {
+          coords[i] = 0;
+          coords[i + 2] = (i == 0) ? clutter_actor_get_width (child)
+                                   : clutter_actor_get_height (child);
+          continue;
+        }
+
+      mx_adjustment_get_values (adjustments[i], &value, &lower, &upper,
+                                NULL, NULL, &page_size);
+
+      coords[i] = MAX (lower, MIN (value, value + deltas[i]));
+      coords[i + 2] = MIN (upper, MAX (value, value + deltas[i]) + page_size);
+    }
+
+  clutter_actor_box_init (&area, coords[0], coords[1], coords[2], coords[3]);
+  set_predicted_area (scroll, &area);
+}
+
 static void
 deceleration_completed_cb (ClutterTimeline     *timeline,
                            MxKineticScrollView *scroll)
@@ -752,6 +916,8 @@ deceleration_completed_cb (ClutterTimeline     *timeline,
   MxKineticScrollViewPrivate *priv = scroll->priv;
   guint duration;
 
+  set_predicted_area (scroll, NULL);
+
   duration = (priv->overshoot > 0.0) ? priv->clamp_duration : 10;
   clamp_adjustments (scroll, duration, priv->hmoving, priv->vmoving);
 
@@ -770,87 +936,69 @@ deceleration_new_frame_cb (ClutterTimeline     *timeline,
   if (child)
     {
       MxAdjustment *hadjust, *vadjust;
-
-      gboolean stop = TRUE;
+      gdouble frames, decay, distance, hvalue, vvalue;
+      gboolean last_frame;
 
       mx_scrollable_get_adjustments (MX_SCROLLABLE (child),
                                      &hadjust, &vadjust);
 
-      priv->accumulated_delta += clutter_timeline_get_delta (timeline);
-
-      if (priv->accumulated_delta <= 1000.0/60.0)
-        stop = FALSE;
-
-      while (priv->accumulated_delta > 1000.0/60.0)
+      /* Advance by the time elapsed since the last frame, measured in
+       * 60ths of a second. Moving x units per 60th of a second and dividing
+       * x by the deceleration rate y every 60th of a second, the distance
+       * covered in f 60ths of a second is the geometric series
+       *
+       * d = x + x/y + ... = x * (1 - 1/y^f) / (1 - 1/y)
+       *
+       * which also holds for fractional f, so that the movement doesn't
+       * depend on the frame rate. The last frame takes whatever is left of
+       * the frames the distance was worked out for in button_release().
+       */
+      last_frame = (clutter_timeline_get_elapsed_time (timeline) >=
+                    clutter_timeline_get_duration (timeline));
+      if (last_frame)
+        frames = priv->decel_frames;
+      else
+        frames = MIN (clutter_timeline_get_delta (timeline) / FRAME_TIME,
+                      priv->decel_frames);
+      priv->decel_frames -= frames;
+
+      decay = pow (priv->decel_rate, -frames);
+      distance = (1.0 - decay) / (1.0 - 1.0 / priv->decel_rate);
+
+      if (hadjust && priv->hmoving)
         {
-          gdouble hvalue, vvalue;
+          hvalue = priv->dx * distance + mx_adjustment_get_value (hadjust);
+          mx_adjustment_set_value (hadjust, hvalue);
 
-          if (hadjust)
+          if (priv->overshoot > 0.0)
             {
-              if (ABS (priv->dx) > 5)
-                {
-                  hvalue = priv->dx + mx_adjustment_get_value (hadjust);
-                  mx_adjustment_set_value (hadjust, hvalue);
-
-                  if (priv->overshoot > 0.0)
-                    {
-                      if ((hvalue > mx_adjustment_get_upper (hadjust) -
-                           mx_adjustment_get_page_size (hadjust)) ||
-                          (hvalue < mx_adjustment_get_lower (hadjust)))
-                        priv->dx *= priv->overshoot;
-                    }
-
-                  priv->dx = priv->dx / priv->decel_rate;
-
-                  stop = FALSE;
-                }
-              else if (priv->hmoving)
-                {
-                  guint duration;
-
-                  priv->hmoving = FALSE;
-
-                  duration = (priv->overshoot > 0.0) ?
-                                priv->clamp_duration : 10;
-                  clamp_adjustments (scroll, duration, TRUE, FALSE);
-                }
+              if ((hvalue > mx_adjustment_get_upper (hadjust) -
+                   mx_adjustment_get_page_size (hadjust)) ||
+                  (hvalue < mx_adjustment_get_lower (hadjust)))
+                priv->dx *= pow (priv->overshoot, frames);
             }
 
-          if (vadjust)
-            {
-              if (ABS (priv->dy) > 5)
-                {
-                  vvalue = priv->dy + mx_adjustment_get_value (vadjust);
-                  mx_adjustment_set_value (vadjust, vvalue);
-
-                  if (priv->overshoot > 0.0)
-                    {
-                      if ((vvalue > mx_adjustment_get_upper (vadjust) -
-                           mx_adjustment_get_page_size (vadjust)) ||
-                          (vvalue < mx_adjustment_get_lower (vadjust)))
-                        priv->dy *= priv->overshoot;
-                    }
-
-                  priv->dy = priv->dy / priv->decel_rate;
-
-                  stop = FALSE;
-                }
-              else if (priv->vmoving)
-                {
-                  guint duration;
+          priv->dx *= decay;
+        }
 
-                  priv->vmoving = FALSE;
+      if (vadjust && priv->vmoving)
+        {
+          vvalue = priv->dy * distance + mx_adjustment_get_value (vadjust);
+          mx_adjustment_set_value (vadjust, vvalue);
 
-                  duration = (priv->overshoot > 0.0) ?
-                                priv->clamp_duration : 10;
-                  clamp_adjustments (scroll, duration, FALSE, TRUE);
-                }
+          if (priv->overshoot > 0.0)
+            {
+              if ((vvalue > mx_adjustment_get_upper (vadjust) -
+                   mx_adjustment_get_page_size (vadjust)) ||
+                  (vvalue < mx_adjustment_get_lower (vadjust)))
+                priv->dy *= pow (priv->overshoot, frames);
             }
 
-          priv->accumulated_delta -= 1000.0/60.0;
+          priv->dy *= decay;
         }
 
-      if (stop)
+      /* the timeline emits completed after its last frame */
+      if (priv->decel_frames <= 0 && !last_frame)
         {
           clutter_timeline_stop (timeline);
           deceleration_completed_cb (timeline, scroll);
@@ -869,13 +1017,14 @@ button_release_event_cb (ClutterActor        *stage,
       (event->button != priv->button))
     return FALSE;
 
-  return button_release (scroll, event->x, event->y);
+  return button_release (scroll, event->x, event->y, event->time);
 }
 
 static gboolean
 button_release (MxKineticScrollView *scroll,
                 gint                 x_pos,
-                gint                 y_pos)
+                gint                 y_pos,
+                guint32              time)
 {
   ClutterActor *actor = CLUTTER_ACTOR (scroll);
   ClutterActor *stage = clutter_actor_get_stage (actor);
@@ -906,52 +1055,16 @@ button_release (MxKineticScrollView *scroll,
                                                &event_x, &event_y))
         {
           gdouble value, lower, upper, step_increment, page_size,
-                  d, ax, ay, y, nx, ny, n;
-          gfloat frac, x_origin, y_origin;
-          GTimeVal release_time, motion_time;
+                  d, ax, ay, y, nx, ny, n, vx, vy, hd, vd;
           MxAdjustment *hadjust, *vadjust;
-          glong time_diff;
           guint duration;
-          gint i;
-
-          /* Get time delta */
-          g_get_current_time (&release_time);
-
-          /* Get average position/time of last x mouse events */
-          priv->last_motion ++;
-          x_origin = y_origin = 0;
-          motion_time = (GTimeVal){ 0, 0 };
-          for (i = 0; i < priv->last_motion; i++)
-            {
-              MxKineticScrollViewMotion *motion =
-                &g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, i);
-
-              /* FIXME: This doesn't guard against overflows - Should
-               *        either fix that, or calculate the correct maximum
-               *        value for the buffer size
-               */
-              x_origin += motion->x;
-              y_origin += motion->y;
-              motion_time.tv_sec += motion->time.tv_sec;
-              motion_time.tv_usec += motion->time.tv_usec;
-            }
-          x_origin = x_origin / priv->last_motion;
-          y_origin = y_origin / priv->last_motion;
-          motion_time.tv_sec /= priv->last_motion;
-          motion_time.tv_usec /= priv->last_motion;
-
-          if (motion_time.tv_sec == release_time.tv_sec)
-            time_diff = release_time.tv_usec - motion_time.tv_usec;
-          else
-            time_diff = release_time.tv_usec +
-                        (G_USEC_PER_SEC - motion_time.tv_usec);
 
-          /* Work out the fraction of 1/60th of a second that has elapsed */
-          frac = (time_diff/1000.0) / (1000.0/60.0);
+          get_velocity (scroll, event_x, event_y, get_event_time (scroll, time),
+                        &vx, &vy);
 
           /* See how many units to move in 1/60th of a second */
-          priv->dx = (x_origin - event_x) / frac * priv->acceleration_factor;
-          priv->dy = (y_origin - event_y) / frac * priv->acceleration_factor;
+          priv->dx = -vx * FRAME_TIME * priv->acceleration_factor;
+          priv->dy = -vy * FRAME_TIME * priv->acceleration_factor;
 
           /* If the delta is too low for the equations to work,
            * bump the values up a bit.
@@ -974,7 +1087,7 @@ button_release (MxKineticScrollView *scroll,
           ny = logf (ABS (priv->dy)) / logf (y);
           n = MAX (nx, ny);
 
-          duration = MAX (1, (gint)(MAX (nx, ny) * (1000/60.0)));
+          duration = MAX (1, (gint)(MAX (nx, ny) * FRAME_TIME));
 
           if (duration > 250)
             {
@@ -983,13 +1096,14 @@ button_release (MxKineticScrollView *scroll,
                *
                * Distance moved, using the above variable names:
                *
-               * d = x + x/y + x/y^2 + ... + x/y^n
+               * d = x + x/y + x/y^2 + ... + x/y^(n-1)
                *
-               * Using geometric series,
+               * over the n frames of the deceleration. Using geometric
+               * series,
                *
-               * d = (1 - 1/y^(n+1))/(1 - 1/y)*x
+               * d = (1 - 1/y^n)/(1 - 1/y)*x
                *
-               * Let a = (1 - 1/y^(n+1))/(1 - 1/y),
+               * Let a = (1 - 1/y^n)/(1 - 1/y),
                *
                * d = a * x
                *
@@ -1001,8 +1115,9 @@ button_release (MxKineticScrollView *scroll,
               /* Get adjustments, work out y^n */
               mx_scrollable_get_adjustments (MX_SCROLLABLE (child),
                                              &hadjust, &vadjust);
-              ax = (1.0 - 1.0 / pow (y, n + 1)) / (1.0 - 1.0 / y);
-              ay = (1.0 - 1.0 / pow (y, n + 1)) / (1.0 - 1.0 / y);
+              ax = (1.0 - 1.0 / pow (y, n)) / (1.0 - 1.0 / y);
+              ay = (1.0 - 1.0 / pow (y, n)) / (1.0 - 1.0 / y);
+              hd = vd = 0;
 
               /* Solving for dx */
               if (hadjust)
@@ -1028,6 +1143,7 @@ button_release (MxKineticScrollView *scroll,
                     d = ((d * step_increment) + lower) - value;
 
                   priv->dx = d / ax;
+                  hd = d;
                 }
 
               /* Solving for dy */
@@ -1051,17 +1167,19 @@ button_release (MxKineticScrollView *scroll,
                     d = ((d * step_increment) + lower) - value;
 
                   priv->dy = d / ay;
+                  vd = d;
                 }
 
+              priv->decel_frames = n;
               priv->deceleration_timeline = clutter_timeline_new (duration);
 
               g_signal_connect (priv->deceleration_timeline, "new_frame",
                                 G_CALLBACK (deceleration_new_frame_cb), scroll);
               g_signal_connect (priv->deceleration_timeline, "completed",
                                 G_CALLBACK (deceleration_completed_cb), scroll);
-              priv->accumulated_delta = 0;
               priv->hmoving = priv->vmoving = TRUE;
               clutter_timeline_start (priv->deceleration_timeline);
+              predict_area (scroll, hd, vd);
               decelerating = TRUE;
               set_state (scroll, MX_KINETIC_SCROLL_VIEW_STATE_SCROLLING);
             }
@@ -1070,6 +1188,7 @@ button_release (MxKineticScrollView *scroll,
 
   /* Reset motion event buffer */
   priv->last_motion = 0;
+  priv->n_motions = 0;
 
   if (!decelerating)
     clamp_adjustments (scroll, priv->clamp_duration, TRUE, TRUE);
@@ -1090,19 +1209,19 @@ button_press_event_cb (ClutterActor        *actor,
       (bevent->button == priv->button) &&
       stage)
     {
-      MxKineticScrollViewMotion *motion;
-
-      /* Reset motion buffer */
-      priv->last_motion = 0;
-      motion = &g_array_index (priv->motion_buffer, MxKineticScrollViewMotion, 0);
+      gfloat x, y;
 
       if (clutter_actor_transform_stage_point (actor, bevent->x, bevent->y,
-                                               &motion->x, &motion->y))
+                                               &x, &y))
         {
           guint threshold;
           MxSettings *settings = mx_settings_get_default ();
 
-          g_get_current_time (&motion->time);
+          /* Reset motion buffer, the press is the drag origin */
+          priv->last_motion = 0;
+          priv->n_motions = 0;
+          priv->use_event_time = (bevent->time != CLUTTER_CURRENT_TIME);
+          add_motion (scroll, x, y, get_event_time (scroll, bevent->time));
 
           if (priv->deceleration_timeline)
             {
@@ -1110,6 +1229,7 @@ button_press_event_cb (ClutterActor        *actor,
               g_object_unref (priv->deceleration_timeline);
               priv->deceleration_timeline = NULL;
 
+              set_predicted_area (scroll, NULL);
               clamp_adjustments (scroll, priv->clamp_duration, priv->hmoving,
                                  priv->vmoving);
             }
@@ -1188,8 +1308,9 @@ mx_kinetic_scroll_view_init (MxKineticScrollView *self)
     KINETIC_SCROLL_VIEW_PRIVATE (self);
 
   priv->motion_buffer =
-    g_array_sized_new (FALSE, TRUE, sizeof (MxKineticScrollViewMotion), 3);
-  g_array_set_size (priv->motion_buffer, 3);
+    g_array_sized_new (FALSE, TRUE, sizeof (MxKineticScrollViewMotion),
+                       MOTION_BUFFER_SIZE);
+  g_array_set_size (priv->motion_buffer, MOTION_BUFFER_SIZE);
   priv->decel_rate = 1.1f;
   priv->button = 1;
   priv->scroll_policy = MX_SCROLL_POLICY_BOTH;
@@ -1245,6 +1366,8 @@ mx_kinetic_scroll_view_stop (MxKineticScrollView *scroll)
       clutter_timeline_stop (priv->deceleration_timeline);
       g_object_unref (priv->deceleration_timeline);
       priv->deceleration_timeline = NULL;
+
+      set_predicted_area (scroll, NULL);
     }
 }
 
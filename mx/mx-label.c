@@ -73,8 +73,9 @@ struct _MxLabelPrivate
   MxAlign x_align;
   MxAlign y_align;
 
-  ClutterTimeline *fade_timeline;
-  ClutterAlpha    *fade_alpha;
+  guint   fade_transition;
+  gdouble fade_progress;
+  gdouble fade_from;
 
   gint em_width;
 
@@ -241,6 +242,49 @@ mx_label_get_preferred_height (ClutterActor *actor,
     *natural_height_p += padding.top + padding.bottom;
 }
 
+static void
+mx_label_fade_frame_cb (gdouble  alpha,
+                        gpointer user_data)
+{
+  MxLabel *self = user_data;
+  MxLabelPrivate *priv = self->priv;
+  ClutterColor color;
+  gdouble target;
+  guint8 a;
+
+  /* The transition runs from the current progress to either end, the
+   * easing is applied to the overall progress of the fade */
+  target = priv->label_should_fade ? 1.0 : 0.0;
+  priv->fade_progress = priv->fade_from + (target - priv->fade_from) * alpha;
+
+  a = (1.0 - _mx_transition_ease (CLUTTER_EASE_OUT_QUAD,
+                                  priv->fade_progress)) * 255;
+
+  color.red = a;
+  color.green = a;
+  color.blue = a;
+  color.alpha = a;
+
+  mx_fade_effect_set_color (MX_FADE_EFFECT (priv->fade_effect), &color);
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
+}
+
+static gboolean
+mx_label_fade_done_cb (gpointer user_data)
+{
+  MxLabel *label = user_data;
+  MxLabelPrivate *priv = label->priv;
+
+  priv->fade_transition = 0;
+
+  if (!priv->label_should_fade)
+    clutter_actor_meta_set_enabled (CLUTTER_ACTOR_META (priv->fade_effect),
+                                    FALSE);
+
+  return FALSE;
+}
+
 static void
 mx_label_allocate (ClutterActor          *actor,
                    const ClutterActorBox *box,
@@ -316,18 +360,24 @@ mx_label_allocate (ClutterActor          *actor,
   /* Animate in/out the faded end of the label */
   if (label_did_fade != priv->label_should_fade)
     {
-      /* Begin/reverse the fading timeline when necessary */
-      if (priv->label_should_fade)
-        clutter_timeline_set_direction (priv->fade_timeline,
-                                        CLUTTER_TIMELINE_FORWARD);
+      /* Begin/reverse the fading transition when necessary */
+      if (priv->fade_transition)
+        _mx_transition_stop (priv->fade_transition);
       else
-        clutter_timeline_set_direction (priv->fade_timeline,
-                                        CLUTTER_TIMELINE_BACKWARD);
+        priv->fade_progress = priv->label_should_fade ? 0.0 : 1.0;
 
-      if (!clutter_timeline_is_playing (priv->fade_timeline))
-        clutter_timeline_rewind (priv->fade_timeline);
+      priv->fade_from = priv->fade_progress;
 
-      clutter_timeline_start (priv->fade_timeline);
+      clutter_actor_meta_set_enabled (CLUTTER_ACTOR_META (priv->fade_effect),
+                                      TRUE);
+
+      priv->fade_transition =
+        _mx_transition_start (250 * (priv->label_should_fade ?
+                                     1.0 - priv->fade_from : priv->fade_from),
+                              CLUTTER_LINEAR,
+                              mx_label_fade_frame_cb,
+                              mx_label_fade_done_cb,
+                              actor);
     }
 }
 
@@ -382,17 +432,10 @@ mx_label_dispose (GObject *actor)
 {
   MxLabelPrivate *priv = MX_LABEL (actor)->priv;
 
-  if (priv->fade_timeline)
-    {
-      clutter_timeline_stop (priv->fade_timeline);
-      g_object_unref (priv->fade_timeline);
-      priv->fade_timeline = NULL;
-    }
-
-  if (priv->fade_alpha)
+  if (priv->fade_transition)
     {
-      g_object_unref (priv->fade_alpha);
-      priv->fade_alpha = NULL;
+      _mx_transition_stop (priv->fade_transition);
+      priv->fade_transition = 0;
     }
 
   if (priv->label)
@@ -558,47 +601,6 @@ mx_label_font_description_cb (ClutterText *text,
     }
 }
 
-static void
-mx_label_fade_new_frame_cb (ClutterTimeline *timeline,
-                            gint             msecs,
-                            MxLabel         *self)
-{
-  guint8 a;
-  ClutterColor color;
-
-  MxLabelPrivate *priv = self->priv;
-
-  a = (1.0 - clutter_alpha_get_alpha (priv->fade_alpha)) * 255;
-
-  color.red = a;
-  color.green = a;
-  color.blue = a;
-  color.alpha = a;
-
-  mx_fade_effect_set_color (MX_FADE_EFFECT (priv->fade_effect), &color);
-
-  clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
-}
-
-static void
-mx_label_fade_started_cb (ClutterTimeline *timeline,
-                          MxLabel         *label)
-{
-  clutter_actor_meta_set_enabled (CLUTTER_ACTOR_META (label->priv->fade_effect),
-                                  TRUE);
-}
-
-static void
-mx_label_fade_completed_cb (ClutterTimeline *timeline,
-                            MxLabel         *label)
-{
-  MxLabelPrivate *priv = label->priv;
-
-  if (!priv->label_should_fade)
-    clutter_actor_meta_set_enabled (CLUTTER_ACTOR_META (priv->fade_effect),
-                                    FALSE);
-}
-
 static void
 mx_label_init (MxLabel *label)
 {
@@ -625,16 +627,6 @@ mx_label_init (MxLabel *label)
                     G_CALLBACK (mx_label_single_line_mode_cb), label);
   g_signal_connect_swapped (priv->label, "queue-redraw",
                             G_CALLBACK (mx_label_label_changed_cb), label);
-
-  priv->fade_timeline = clutter_timeline_new (250);
-  priv->fade_alpha = clutter_alpha_new_full (priv->fade_timeline,
-                                             CLUTTER_EASE_OUT_QUAD);
-  g_signal_connect (priv->fade_timeline, "new-frame",
-                    G_CALLBACK (mx_label_fade_new_frame_cb), label);
-  g_signal_connect (priv->fade_timeline, "started",
-                    G_CALLBACK (mx_label_fade_started_cb), label);
-  g_signal_connect (priv->fade_timeline, "completed",
-                    G_CALLBACK (mx_label_fade_completed_cb), label);
 }
 
 /**
@@ -32,40 +32,42 @@
  *
  * Data is set on the children by mapping columns in the model to object
  * properties on the children.
+ *
+ * For large models, #MxListView can be made #MxListView:virtualized. Only
+ * the children needed to show the rows in the visible part of the view are
+ * then created, and they are reused for other rows as the view scrolls.
  */
 
+#include <math.h>
+
 #include "mx-list-view.h"
 #include "mx-box-layout.h"
 #include "mx-private.h"
 #include "mx-item-factory.h"
+#include "mx-scrollable.h"
 
 G_DEFINE_TYPE (MxListView, mx_list_view, MX_TYPE_BOX_LAYOUT)
 
 #define LIST_VIEW_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_LIST_VIEW, MxListViewPrivate))
 
-typedef struct
-{
-  gchar *name;
-  gint   col;
-} AttributeData;
-
 enum
 {
   PROP_0,
 
   PROP_MODEL,
   PROP_ITEM_TYPE,
-  PROP_FACTORY
+  PROP_FACTORY,
+  PROP_VIRTUALIZED,
+  PROP_OVERSCAN,
+  PROP_ROW_HEIGHT
 };
 
+#define DEFAULT_OVERSCAN 4
+
 struct _MxListViewPrivate
 {
-  ClutterModel  *model;
-  GSList        *attributes;
-  GType          item_type;
-
-  MxItemFactory *factory;
+  MxItemWindow   window;
 
   gulong         filter_changed;
   gulong         row_added;
@@ -73,7 +75,10 @@ struct _MxListViewPrivate
   gulong         row_removed;
   gulong         sort_changed;
 
-  guint          is_frozen : 1;
+  guint          virtualized : 1;
+  guint          overscan;
+  gfloat         row_height;
+  gfloat         estimated_row_height;
 };
 
 /* gobject implementations */
@@ -88,13 +93,22 @@ mx_list_view_get_property (GObject    *object,
   switch (property_id)
     {
     case PROP_MODEL:
-      g_value_set_object (value, priv->model);
+      g_value_set_object (value, priv->window.model);
       break;
     case PROP_ITEM_TYPE:
-      g_value_set_gtype (value, priv->item_type);
+      g_value_set_gtype (value, priv->window.item_type);
       break;
     case PROP_FACTORY:
-      g_value_set_object (value, priv->factory);
+      g_value_set_object (value, priv->window.factory);
+      break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, priv->virtualized);
+      break;
+    case PROP_OVERSCAN:
+      g_value_set_uint (value, priv->overscan);
+      break;
+    case PROP_ROW_HEIGHT:
+      g_value_set_float (value, priv->row_height);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -121,6 +135,18 @@ mx_list_view_set_property (GObject      *object,
       mx_list_view_set_factory ((MxListView*) object,
                                 (MxItemFactory*) g_value_get_object (value));
       break;
+    case PROP_VIRTUALIZED:
+      mx_list_view_set_virtualized ((MxListView*) object,
+                                    g_value_get_boolean (value));
+      break;
+    case PROP_OVERSCAN:
+      mx_list_view_set_overscan ((MxListView*) object,
+                                 g_value_get_uint (value));
+      break;
+    case PROP_ROW_HEIGHT:
+      mx_list_view_set_row_height ((MxListView*) object,
+                                   g_value_get_float (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -134,41 +160,236 @@ mx_list_view_dispose (GObject *object)
   /* This will cause the unref of the model and also disconnect the signals */
   mx_list_view_set_model (MX_LIST_VIEW (object), NULL);
 
-  if (priv->factory)
+  _mx_item_window_dispose (&priv->window);
+
+  G_OBJECT_CLASS (mx_list_view_parent_class)->dispose (object);
+}
+
+static void
+mx_list_view_finalize (GObject *object)
+{
+  MxListViewPrivate *priv = MX_LIST_VIEW (object)->priv;
+
+  _mx_item_window_finalize (&priv->window);
+
+  G_OBJECT_CLASS (mx_list_view_parent_class)->finalize (object);
+}
+
+static gfloat
+mx_list_view_get_item_height (MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+
+  if (priv->row_height > 0)
+    return priv->row_height;
+
+  return priv->estimated_row_height;
+}
+
+static gfloat
+mx_list_view_get_content_height (MxListView *list_view)
+{
+  gint n_rows = _mx_item_window_get_n_rows (&list_view->priv->window);
+  guint spacing = mx_box_layout_get_spacing (MX_BOX_LAYOUT (list_view));
+
+  if (n_rows < 1)
+    return 0;
+
+  return n_rows * mx_list_view_get_item_height (list_view)
+    + (n_rows - 1) * spacing;
+}
+
+static void
+mx_list_view_get_range (ClutterActor *actor,
+                        gint          n_rows,
+                        gfloat        top,
+                        gfloat        bottom,
+                        gint         *first,
+                        gint         *last)
+{
+  MxListView *list_view = MX_LIST_VIEW (actor);
+  MxPadding padding;
+  gfloat pitch;
+
+  pitch = mx_list_view_get_item_height (list_view)
+    + mx_box_layout_get_spacing (MX_BOX_LAYOUT (list_view));
+
+  if (n_rows < 1 || pitch <= 0)
     {
-      g_object_unref (priv->factory);
-      priv->factory = NULL;
+      *first = *last = 0;
+      return;
     }
 
-  G_OBJECT_CLASS (mx_list_view_parent_class)->dispose (object);
+  mx_widget_get_padding (MX_WIDGET (list_view), &padding);
+
+  *first = floorf ((top - padding.top) / pitch) - list_view->priv->overscan;
+  *first = CLAMP (*first, 0, n_rows);
+
+  *last = ceilf ((bottom - padding.top) / pitch)
+    + list_view->priv->overscan;
+  *last = CLAMP (*last, *first, n_rows);
+}
+
+/* the height of all the rows is estimated from the first one, unless it
+ * was set */
+static gboolean
+mx_list_view_needs_measure (ClutterActor *actor)
+{
+  return mx_list_view_get_item_height (MX_LIST_VIEW (actor)) <= 0;
 }
 
 static void
-free_attribute (AttributeData *data)
+mx_list_view_measure (ClutterActor *actor,
+                      ClutterActor *item)
 {
-  g_free (data->name);
-  g_free (data);
+  gfloat height;
+
+  clutter_actor_get_preferred_height (item, -1, NULL, &height);
+  MX_LIST_VIEW (actor)->priv->estimated_row_height = MAX (1, height);
 }
 
 static void
-mx_list_view_finalize (GObject *object)
+mx_list_view_reset_measure (ClutterActor *actor)
 {
-  MxListViewPrivate *priv = MX_LIST_VIEW (object)->priv;
+  MX_LIST_VIEW (actor)->priv->estimated_row_height = 0;
+}
+
+static void
+mx_list_view_adjustment_notify_cb (GObject    *object,
+                                   GParamSpec *pspec,
+                                   MxListView *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  MxAdjustment *vadjustment = NULL;
+
+  /* don't use mx_scrollable_get_adjustments(), creating an adjustment
+   * would notify and call this again */
+  if (priv->virtualized)
+    _mx_box_layout_get_adjustments (MX_BOX_LAYOUT (list_view),
+                                    NULL, &vadjustment);
+
+  _mx_item_window_set_vadjustment (&priv->window, vadjustment);
+}
+
+static void
+mx_list_view_get_preferred_height (ClutterActor *actor,
+                                   gfloat        for_width,
+                                   gfloat       *min_height_p,
+                                   gfloat       *nat_height_p)
+{
+  MxListView *list_view = MX_LIST_VIEW (actor);
+  MxPadding padding;
+  gfloat height;
 
-  if (priv->attributes)
+  if (!list_view->priv->virtualized)
     {
-      g_slist_foreach (priv->attributes, (GFunc) free_attribute, NULL);
-      g_slist_free (priv->attributes);
-      priv->attributes = NULL;
+      CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->
+        get_preferred_height (actor, for_width, min_height_p, nat_height_p);
+      return;
     }
 
-  G_OBJECT_CLASS (mx_list_view_parent_class)->finalize (object);
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+
+  height = padding.top + padding.bottom
+    + mx_list_view_get_content_height (list_view);
+
+  if (min_height_p)
+    *min_height_p = height;
+  if (nat_height_p)
+    *nat_height_p = height;
+}
+
+static void
+mx_list_view_allocate (ClutterActor           *actor,
+                       const ClutterActorBox  *box,
+                       ClutterAllocationFlags  flags)
+{
+  MxListView *list_view = MX_LIST_VIEW (actor);
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActorClass *widget_class;
+  MxAdjustment *hadjustment;
+  gfloat item_height, avail_width, avail_height;
+  MxPadding padding;
+  guint spacing, i;
+
+  if (!priv->virtualized)
+    {
+      CLUTTER_ACTOR_CLASS (mx_list_view_parent_class)->
+        allocate (actor, box, flags);
+      return;
+    }
+
+  priv->window.in_allocation = TRUE;
+
+  /* the items are laid out here rather than by MxBoxLayout, at the
+   * position of the row they show */
+  widget_class = g_type_class_peek_parent (mx_list_view_parent_class);
+  widget_class->allocate (actor, box, flags);
+  _mx_box_layout_invalidate_extents (MX_BOX_LAYOUT (actor));
+
+  mx_widget_get_padding (MX_WIDGET (actor), &padding);
+  spacing = mx_box_layout_get_spacing (MX_BOX_LAYOUT (actor));
+
+  avail_width = box->x2 - box->x1 - padding.left - padding.right;
+  avail_height = box->y2 - box->y1 - padding.top - padding.bottom;
+  priv->window.page_height = box->y2 - box->y1;
+
+  /* a new size may show rows that don't have an item yet */
+  _mx_item_window_check_range (&priv->window);
+
+  item_height = mx_list_view_get_item_height (list_view);
+
+  for (i = 0; i < priv->window.items->len; i++)
+    {
+      ClutterActor *item = g_ptr_array_index (priv->window.items, i);
+      ClutterActorBox child_box;
+
+      child_box.x1 = padding.left;
+      child_box.x2 = padding.left + avail_width;
+      child_box.y1 = (int) (padding.top
+                            + (priv->window.first_row + i)
+                            * (item_height + spacing));
+      child_box.y2 = child_box.y1 + item_height;
+
+      clutter_actor_allocate (item, &child_box, flags);
+    }
+
+  if (priv->window.vadjustment)
+    {
+      mx_adjustment_freeze (priv->window.vadjustment);
+      g_object_set (G_OBJECT (priv->window.vadjustment),
+                    "lower", 0.0,
+                    "upper", mx_list_view_get_content_height (list_view),
+                    "page-size", avail_height,
+                    "step-increment", item_height + spacing,
+                    "page-increment", avail_height,
+                    NULL);
+      mx_adjustment_thaw (priv->window.vadjustment);
+    }
+
+  /* the items are as wide as the view */
+  _mx_box_layout_get_adjustments (MX_BOX_LAYOUT (actor), &hadjustment, NULL);
+  if (hadjustment)
+    {
+      mx_adjustment_freeze (hadjustment);
+      g_object_set (G_OBJECT (hadjustment),
+                    "lower", 0.0,
+                    "upper", avail_width,
+                    "page-size", avail_width,
+                    "step-increment", avail_width / 6,
+                    "page-increment", avail_width,
+                    NULL);
+      mx_adjustment_thaw (hadjustment);
+    }
+
+  priv->window.in_allocation = FALSE;
 }
 
 static void
 mx_list_view_class_init (MxListViewClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
   GParamSpec *pspec;
 
   g_type_class_add_private (klass, sizeof (MxListViewPrivate));
@@ -178,6 +399,9 @@ mx_list_view_class_init (MxListViewClass *klass)
   object_class->dispose = mx_list_view_dispose;
   object_class->finalize = mx_list_view_finalize;
 
+  actor_class->get_preferred_height = mx_list_view_get_preferred_height;
+  actor_class->allocate = mx_list_view_allocate;
+
   pspec = g_param_spec_object ("model",
                                "model",
                                "The model for the item view",
@@ -203,14 +427,50 @@ mx_list_view_class_init (MxListViewClass *klass)
                                G_TYPE_OBJECT /*MX_TYPE_ITEM_FACTORY*/,
                                MX_PARAM_READWRITE);
   g_object_class_install_property (object_class, PROP_FACTORY, pspec);
+
+  pspec = g_param_spec_boolean ("virtualized",
+                                "Virtualized",
+                                "Whether to only create items for the "
+                                "visible rows",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_VIRTUALIZED, pspec);
+
+  pspec = g_param_spec_uint ("overscan",
+                             "Overscan",
+                             "Number of rows to create items for before "
+                             "and after the visible rows, when virtualized",
+                             0, G_MAXUINT, DEFAULT_OVERSCAN,
+                             MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_OVERSCAN, pspec);
+
+  pspec = g_param_spec_float ("row-height",
+                              "Row height",
+                              "Height of the rows when virtualized, or 0 to "
+                              "use the height of the first row",
+                              0, G_MAXFLOAT, 0,
+                              MX_PARAM_READWRITE);
+  g_object_class_install_property (object_class, PROP_ROW_HEIGHT, pspec);
 }
 
 static void
 mx_list_view_init (MxListView *list_view)
 {
-  list_view->priv = LIST_VIEW_PRIVATE (list_view);
+  MxListViewPrivate *priv;
+
+  priv = list_view->priv = LIST_VIEW_PRIVATE (list_view);
 
   mx_box_layout_set_orientation (MX_BOX_LAYOUT (list_view), MX_ORIENTATION_VERTICAL);
+
+  _mx_item_window_init (&priv->window, CLUTTER_ACTOR (list_view),
+                        mx_list_view_get_range,
+                        mx_list_view_needs_measure,
+                        mx_list_view_measure,
+                        mx_list_view_reset_measure);
+  priv->overscan = DEFAULT_OVERSCAN;
+
+  g_signal_connect (list_view, "notify::vertical-adjustment",
+                    G_CALLBACK (mx_list_view_adjustment_notify_cb), list_view);
 }
 
 
@@ -219,7 +479,6 @@ static void
 model_changed_cb (ClutterModel *model,
                   MxListView   *list_view)
 {
-  GSList *p;
   GList *l, *children;
   MxListViewPrivate *priv = list_view->priv;
   ClutterModelIter *iter = NULL;
@@ -227,49 +486,53 @@ model_changed_cb (ClutterModel *model,
 
 
   /* bail out if we don't yet have an item type or a factory */
-  if (!priv->item_type && !priv->factory)
+  if (!priv->window.item_type && !priv->window.factory)
     return;
 
-  if (priv->is_frozen)
+  if (priv->window.is_frozen)
     return;
 
-  if (priv->item_type)
+  if (priv->window.item_type)
     {
       /* check the item-type is an descendant of ClutterActor */
-      if (!g_type_is_a (priv->item_type, CLUTTER_TYPE_ACTOR))
+      if (!g_type_is_a (priv->window.item_type, CLUTTER_TYPE_ACTOR))
         {
           g_warning ("%s is not a subclass of ClutterActor and therefore"
                      " cannot be used as items in an MxListView",
-                     g_type_name (priv->item_type));
+                     g_type_name (priv->window.item_type));
           return;
         }
     }
 
+  if (priv->virtualized)
+    {
+      _mx_item_window_update (&priv->window, TRUE);
+      return;
+    }
+
   children = clutter_container_get_children (CLUTTER_CONTAINER (list_view));
   child_n = g_list_length (children);
 
   if (model)
-    model_n = clutter_model_get_n_rows (priv->model);
+    model_n = clutter_model_get_n_rows (priv->window.model);
   else
     model_n = 0;
 
   /* add children as needed */
-  while (model_n > child_n)
+  if (model_n > child_n)
     {
-      ClutterActor *new_child;
+      GList *new_children = NULL;
 
-      if (priv->item_type)
-        {
-          new_child = g_object_new (priv->item_type, NULL);
-        }
-      else
+      while (model_n > child_n)
         {
-          new_child = mx_item_factory_create (priv->factory);
+          ClutterActor *item = _mx_item_window_create_item (&priv->window);
+
+          new_children = g_list_prepend (new_children, item);
+          child_n++;
         }
 
-      clutter_container_add_actor (CLUTTER_CONTAINER (list_view),
-                                   new_child);
-      child_n++;
+      mx_box_layout_add_actors (MX_BOX_LAYOUT (list_view), new_children, -1);
+      g_list_free (new_children);
     }
 
   /* remove children as needed */
@@ -284,42 +547,68 @@ model_changed_cb (ClutterModel *model,
 
   g_list_free (children);
 
-  if (!priv->model)
+  if (!priv->window.model)
     return;
 
   children = clutter_container_get_children (CLUTTER_CONTAINER (list_view));
 
   /* set the properties on the children */
-  iter = clutter_model_get_first_iter (priv->model);
+  iter = clutter_model_get_first_iter (priv->window.model);
   l = children;
   while (iter && !clutter_model_iter_is_last (iter))
     {
-      GObject *child;
+      _mx_item_window_bind_item (&priv->window, G_OBJECT (l->data), iter);
 
-      child = G_OBJECT (l->data);
+      l = g_list_next (l);
+      clutter_model_iter_next (iter);
+    }
 
-      g_object_freeze_notify (child);
-      for (p = priv->attributes; p; p = p->next)
-        {
-          GValue value = { 0, };
-          AttributeData *attr = p->data;
+  g_list_free (children);
 
-          clutter_model_iter_get_value (iter, attr->col, &value);
+  if (iter)
+    g_object_unref (iter);
+}
 
-          g_object_set_property (child, attr->name, &value);
+static void
+row_added_cb (ClutterModel     *model,
+              ClutterModelIter *iter,
+              MxListView       *list_view)
+{
+  MxListViewPrivate *priv = list_view->priv;
+  ClutterActor *child, *sibling;
+  GList *children;
 
-          g_value_unset (&value);
-        }
-      g_object_thaw_notify (child);
+  if ((!priv->window.item_type && !priv->window.factory)
+      || priv->window.is_frozen)
+    return;
 
-      l = g_list_next (l);
-      clutter_model_iter_next (iter);
+  /* the row of the iter counts the rows that are filtered out, so it
+   * isn't the position of the new item */
+  if (clutter_model_get_filter_set (model))
+    {
+      if (clutter_model_filter_iter (model, iter))
+        model_changed_cb (model, list_view);
+      return;
     }
 
+  if (priv->virtualized)
+    {
+      /* the rows after the new one have moved */
+      _mx_item_window_update (&priv->window, TRUE);
+      return;
+    }
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (list_view));
+  sibling = g_list_nth_data (children, clutter_model_iter_get_row (iter));
   g_list_free (children);
 
-  if (iter)
-    g_object_unref (iter);
+  child = _mx_item_window_create_item (&priv->window);
+  _mx_item_window_bind_item (&priv->window, G_OBJECT (child), iter);
+
+  clutter_container_add_actor (CLUTTER_CONTAINER (list_view), child);
+  if (sibling)
+    clutter_container_lower_child (CLUTTER_CONTAINER (list_view),
+                                   child, sibling);
 }
 
 static void
@@ -327,7 +616,42 @@ row_changed_cb (ClutterModel     *model,
                 ClutterModelIter *iter,
                 MxListView       *list_view)
 {
-  model_changed_cb (model, list_view);
+  MxListViewPrivate *priv = list_view->priv;
+  GList *children;
+  GObject *child;
+  gint row;
+
+  if ((!priv->window.item_type && !priv->window.factory)
+      || priv->window.is_frozen)
+    return;
+
+  /* the change may have moved the row in or out of the filter */
+  if (clutter_model_get_filter_set (model))
+    {
+      model_changed_cb (model, list_view);
+      return;
+    }
+
+  row = clutter_model_iter_get_row (iter);
+
+  if (priv->virtualized)
+    {
+      gint index_ = row - priv->window.first_row;
+
+      if (index_ >= 0 && (guint) index_ < priv->window.items->len)
+        _mx_item_window_bind_item (&priv->window,
+                                   g_ptr_array_index (priv->window.items,
+                                                      index_),
+                                   iter);
+      return;
+    }
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (list_view));
+  child = g_list_nth_data (children, row);
+  g_list_free (children);
+
+  if (child)
+    _mx_item_window_bind_item (&priv->window, child, iter);
 }
 
 static void
@@ -336,16 +660,27 @@ row_removed_cb (ClutterModel     *model,
                 MxListView       *list_view)
 {
   GList *children;
-  GList *l;
   ClutterActor *child;
+  gint index_;
 
-  if (list_view->priv->is_frozen)
+  if (list_view->priv->window.is_frozen)
+    return;
+
+  if (list_view->priv->virtualized)
+    {
+      _mx_item_window_row_removed (&list_view->priv->window, iter);
+      return;
+    }
+
+  /* a row that the filter rejects has no item */
+  index_ = _mx_item_window_get_iter_index (&list_view->priv->window, iter);
+  if (index_ < 0)
     return;
 
   children = clutter_container_get_children (CLUTTER_CONTAINER (list_view));
-  l = g_list_nth (children, clutter_model_iter_get_row (iter));
-  child = (ClutterActor *) l->data;
-  clutter_container_remove_actor (CLUTTER_CONTAINER (list_view), child);
+  child = g_list_nth_data (children, index_);
+  if (child)
+    clutter_container_remove_actor (CLUTTER_CONTAINER (list_view), child);
   g_list_free (children);
 }
 
@@ -377,7 +712,7 @@ mx_list_view_get_item_type (MxListView *list_view)
 {
   g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), G_TYPE_INVALID);
 
-  return list_view->priv->item_type;
+  return list_view->priv->window.item_type;
 }
 
 
@@ -396,10 +731,10 @@ mx_list_view_set_item_type (MxListView *list_view,
   g_return_if_fail (MX_IS_LIST_VIEW (list_view));
   g_return_if_fail (g_type_is_a (item_type, CLUTTER_TYPE_ACTOR));
 
-  list_view->priv->item_type = item_type;
+  list_view->priv->window.item_type = item_type;
 
   /* update the view */
-  model_changed_cb (list_view->priv->model, list_view);
+  model_changed_cb (list_view->priv->window.model, list_view);
 }
 
 /**
@@ -415,7 +750,7 @@ mx_list_view_get_model (MxListView *list_view)
 {
   g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), NULL);
 
-  return list_view->priv->model;
+  return list_view->priv->window.model;
 }
 
 /**
@@ -436,53 +771,56 @@ mx_list_view_set_model (MxListView   *list_view,
 
   priv = list_view->priv;
 
-  if (priv->model)
+  if (priv->window.model)
     {
-      g_signal_handlers_disconnect_by_func (priv->model,
+      g_signal_handlers_disconnect_by_func (priv->window.model,
                                             (GCallback) model_changed_cb,
                                             list_view);
-      g_signal_handlers_disconnect_by_func (priv->model,
+      g_signal_handlers_disconnect_by_func (priv->window.model,
+                                            (GCallback) row_added_cb,
+                                            list_view);
+      g_signal_handlers_disconnect_by_func (priv->window.model,
                                             (GCallback) row_changed_cb,
                                             list_view);
-      g_signal_handlers_disconnect_by_func (priv->model,
+      g_signal_handlers_disconnect_by_func (priv->window.model,
                                             (GCallback) row_removed_cb,
                                             list_view);
-      g_object_unref (priv->model);
+      g_object_unref (priv->window.model);
 
-      priv->model = NULL;
+      priv->window.model = NULL;
     }
 
   if (model)
     {
       g_return_if_fail (CLUTTER_IS_MODEL (model));
 
-      priv->model = g_object_ref (model);
+      priv->window.model = g_object_ref (model);
 
-      priv->filter_changed = g_signal_connect (priv->model,
+      priv->filter_changed = g_signal_connect (priv->window.model,
                                                "filter-changed",
                                                G_CALLBACK (model_changed_cb),
                                                list_view);
 
-      priv->row_added = g_signal_connect (priv->model,
+      priv->row_added = g_signal_connect (priv->window.model,
                                           "row-added",
-                                          G_CALLBACK (row_changed_cb),
+                                          G_CALLBACK (row_added_cb),
                                           list_view);
 
-      priv->row_changed = g_signal_connect (priv->model,
+      priv->row_changed = g_signal_connect (priv->window.model,
                                             "row-changed",
                                             G_CALLBACK (row_changed_cb),
                                             list_view);
 
       /*
-       * model_changed_cb (called from row_changed_cb) expect the row to already
-       * have been removed, thus we need to use _after
+       * The model removes the row in the default handler of row-removed,
+       * so connect before it, while the row and its iter are still valid
        */
-      priv->row_removed = g_signal_connect_after (priv->model,
-                                                  "row-removed",
-                                                  G_CALLBACK (row_removed_cb),
-                                                  list_view);
+      priv->row_removed = g_signal_connect (priv->window.model,
+                                            "row-removed",
+                                            G_CALLBACK (row_removed_cb),
+                                            list_view);
 
-      priv->sort_changed = g_signal_connect (priv->model,
+      priv->sort_changed = g_signal_connect (priv->window.model,
                                              "sort-changed",
                                              G_CALLBACK (model_changed_cb),
                                              list_view);
@@ -491,7 +829,7 @@ mx_list_view_set_model (MxListView   *list_view,
        * Only do this inside this block, setting the model to NULL should have
        * the effect of preserving the view; just disconnect the handlers
        */
-      model_changed_cb (priv->model, list_view);
+      model_changed_cb (priv->window.model, list_view);
     }
 }
 
@@ -511,7 +849,6 @@ mx_list_view_add_attribute (MxListView  *list_view,
                             gint         column)
 {
   MxListViewPrivate *priv;
-  AttributeData *prop;
 
   g_return_if_fail (MX_IS_LIST_VIEW (list_view));
   g_return_if_fail (_attribute != NULL);
@@ -519,12 +856,8 @@ mx_list_view_add_attribute (MxListView  *list_view,
 
   priv = list_view->priv;
 
-  prop = g_new (AttributeData, 1);
-  prop->name = g_strdup (_attribute);
-  prop->col = column;
-
-  priv->attributes = g_slist_prepend (priv->attributes, prop);
-  model_changed_cb (priv->model, list_view);
+  _mx_item_window_add_attribute (&priv->window, _attribute, column);
+  model_changed_cb (priv->window.model, list_view);
 }
 
 /**
@@ -543,7 +876,7 @@ mx_list_view_freeze (MxListView *list_view)
 
   priv = list_view->priv;
 
-  priv->is_frozen = TRUE;
+  priv->window.is_frozen = TRUE;
 }
 
 /**
@@ -562,10 +895,10 @@ mx_list_view_thaw (MxListView *list_view)
 
   priv = list_view->priv;
 
-  priv->is_frozen = FALSE;
+  priv->window.is_frozen = FALSE;
 
   /* Repopulate */
-  model_changed_cb (priv->model, list_view);
+  model_changed_cb (priv->window.model, list_view);
 }
 
 /**
@@ -586,17 +919,17 @@ mx_list_view_set_factory (MxListView    *list_view,
 
   priv = list_view->priv;
 
-  if (priv->factory == factory)
+  if (priv->window.factory == factory)
     return;
 
-  if (priv->factory)
+  if (priv->window.factory)
     {
-      g_object_unref (priv->factory);
-      priv->factory = NULL;
+      g_object_unref (priv->window.factory);
+      priv->window.factory = NULL;
     }
 
   if (factory)
-    priv->factory = g_object_ref (factory);
+    priv->window.factory = g_object_ref (factory);
 
   g_object_notify (G_OBJECT (list_view), "factory");
 }
@@ -613,5 +946,164 @@ MxItemFactory *
 mx_list_view_get_factory (MxListView *list_view)
 {
   g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), NULL);
-  return list_view->priv->factory;
+  return list_view->priv->window.factory;
+}
+
+/**
+ * mx_list_view_set_virtualized:
+ * @list_view: A #MxListView
+ * @virtualized: %TRUE to only create items for the visible rows
+ *
+ * Sets whether @list_view creates an item for every row in the model, or
+ * only for the rows in the visible part of the view and
+ * #MxListView:overscan rows around it. Items are then reused for other
+ * rows as the view is scrolled.
+ *
+ * A virtualized list view gives every row the same height, either the
+ * #MxListView:row-height or the natural height of the first row.
+ *
+ * Since: 1.6
+ */
+void
+mx_list_view_set_virtualized (MxListView *list_view,
+                              gboolean    virtualized)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->virtualized == virtualized)
+    return;
+
+  priv->virtualized = virtualized;
+  priv->estimated_row_height = 0;
+
+  _mx_item_window_remove_children (&priv->window);
+  mx_list_view_adjustment_notify_cb (NULL, NULL, list_view);
+
+  g_object_notify (G_OBJECT (list_view), "virtualized");
+
+  model_changed_cb (priv->window.model, list_view);
+}
+
+/**
+ * mx_list_view_get_virtualized:
+ * @list_view: A #MxListView
+ *
+ * Gets whether @list_view only creates items for the visible rows.
+ *
+ * Returns: %TRUE if @list_view is virtualized
+ *
+ * Since: 1.6
+ */
+gboolean
+mx_list_view_get_virtualized (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), FALSE);
+  return list_view->priv->virtualized;
+}
+
+/**
+ * mx_list_view_set_overscan:
+ * @list_view: A #MxListView
+ * @overscan: number of rows
+ *
+ * Sets the number of rows before and after the visible ones that a
+ * virtualized @list_view keeps items for, so that they are ready when
+ * the view scrolls.
+ *
+ * Since: 1.6
+ */
+void
+mx_list_view_set_overscan (MxListView *list_view,
+                           guint       overscan)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+
+  priv = list_view->priv;
+
+  if (priv->overscan == overscan)
+    return;
+
+  priv->overscan = overscan;
+
+  g_object_notify (G_OBJECT (list_view), "overscan");
+
+  if (priv->virtualized)
+    _mx_item_window_update (&priv->window, FALSE);
+}
+
+/**
+ * mx_list_view_get_overscan:
+ * @list_view: A #MxListView
+ *
+ * Gets the number of rows outside the visible area that a virtualized
+ * @list_view keeps items for.
+ *
+ * Returns: the number of rows
+ *
+ * Since: 1.6
+ */
+guint
+mx_list_view_get_overscan (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), 0);
+  return list_view->priv->overscan;
+}
+
+/**
+ * mx_list_view_set_row_height:
+ * @list_view: A #MxListView
+ * @row_height: height of each row, or 0
+ *
+ * Sets the height of the rows of a virtualized @list_view. If @row_height
+ * is 0, the natural height of the first row is used for all rows.
+ *
+ * Since: 1.6
+ */
+void
+mx_list_view_set_row_height (MxListView *list_view,
+                             gfloat      row_height)
+{
+  MxListViewPrivate *priv;
+
+  g_return_if_fail (MX_IS_LIST_VIEW (list_view));
+  g_return_if_fail (row_height >= 0);
+
+  priv = list_view->priv;
+
+  if (priv->row_height == row_height)
+    return;
+
+  priv->row_height = row_height;
+  priv->estimated_row_height = 0;
+
+  g_object_notify (G_OBJECT (list_view), "row-height");
+
+  if (priv->virtualized)
+    {
+      _mx_item_window_remove_children (&priv->window);
+      _mx_item_window_update (&priv->window, FALSE);
+    }
+}
+
+/**
+ * mx_list_view_get_row_height:
+ * @list_view: A #MxListView
+ *
+ * Gets the row height set with mx_list_view_set_row_height().
+ *
+ * Returns: the height of the rows, or 0
+ *
+ * Since: 1.6
+ */
+gfloat
+mx_list_view_get_row_height (MxListView *list_view)
+{
+  g_return_val_if_fail (MX_IS_LIST_VIEW (list_view), 0);
+  return list_view->priv->row_height;
 }
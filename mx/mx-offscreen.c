@@ -31,13 +31,33 @@
  *
  * This is often useful for applying a #ClutterShader effect to an actor
  * or group of actors that is not a texture.
+ *
+ * When the child is updated automatically, #MxOffscreen tracks which parts
+ * of the child have queued a redraw since the last update, and only redraws
+ * those areas into the offscreen texture, and blends them into the
+ * accumulation buffer. The pending damage can be retrieved with
+ * mx_offscreen_get_damaged_area(), and areas that changed without queueing
+ * a redraw can be marked with mx_offscreen_damage_area().
  */
 
+#include <math.h>
+#include <string.h>
+
 #include "mx-offscreen.h"
 #include "mx-private.h"
 
+/* The number of separate damaged rectangles kept before they are merged
+ * into their bounding box */
+#define MAX_DAMAGE_RECTS 4
+
+/* The number of paints the damaged area keeps being blended into the
+ * accumulation buffer after it was last updated, so the accumulated image
+ * can settle */
+#define ACCUMULATION_SETTLE_FRAMES 16
+
 static void clutter_container_iface_init (ClutterContainerIface *iface);
 static void mx_focusable_iface_init (MxFocusableIface *iface);
+static void mx_offscreen_update_damage (MxOffscreen *offscreen);
 
 G_DEFINE_TYPE_WITH_CODE (MxOffscreen, mx_offscreen, CLUTTER_TYPE_TEXTURE,
                          G_IMPLEMENT_INTERFACE (CLUTTER_TYPE_CONTAINER,
@@ -60,8 +80,25 @@ struct _MxOffscreenPrivate
 
   guint         in_dispose  : 1;
 
+  guint         damage_all  : 1;
+  guint         paint_area_set : 1;
+  guint         clip_pushed : 1;
+
   ClutterActor *child;
 
+  /* Pending damage, as ClutterActorBox in texture coordinates */
+  GArray       *damage;
+
+  /* The area being redrawn by the current update */
+  ClutterActorBox paint_area;
+
+  /* The last damaged box of each actor that queued a redraw, so the area
+   * it moved away from is also redrawn */
+  GHashTable   *damage_boxes;
+
+  ClutterActorBox acc_damage;
+  guint         acc_frames;
+
   CoglHandle    fbo;
   CoglHandle    acc_material;
   CoglHandle    acc_fbo;
@@ -291,12 +328,19 @@ mx_offscreen_dispose (GObject *object)
       priv->acc_fbo = NULL;
     }
 
+  _mx_damage_boxes_clear (priv->damage_boxes);
+
   G_OBJECT_CLASS (mx_offscreen_parent_class)->dispose (object);
 }
 
 static void
 mx_offscreen_finalize (GObject *object)
 {
+  MxOffscreenPrivate *priv = MX_OFFSCREEN (object)->priv;
+
+  g_array_free (priv->damage, TRUE);
+  _mx_damage_boxes_free (priv->damage_boxes);
+
   G_OBJECT_CLASS (mx_offscreen_parent_class)->finalize (object);
 }
 
@@ -494,6 +538,10 @@ mx_offscreen_ensure_accumulation_buffer (MxOffscreen *offscreen)
           cogl_clear (&color, COGL_BUFFER_BIT_COLOR);
           cogl_pop_framebuffer ();
 
+          /* The whole of the new buffer needs to be accumulated */
+          clutter_actor_box_init (&priv->acc_damage, 0, 0, width, height);
+          priv->acc_frames = ACCUMULATION_SETTLE_FRAMES;
+
           cogl_handle_unref (texture);
 
           return TRUE;
@@ -505,6 +553,44 @@ mx_offscreen_ensure_accumulation_buffer (MxOffscreen *offscreen)
   return TRUE;
 }
 
+static void
+mx_offscreen_accumulate (MxOffscreen           *self,
+                         const ClutterActorBox *area)
+{
+  CoglColor zero_color;
+  CoglHandle texture, material;
+  gfloat width, height, tx1, ty1, tx2, ty2;
+
+  MxOffscreenPrivate *priv = self->priv;
+
+  texture = clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (self));
+  material = clutter_texture_get_cogl_material (CLUTTER_TEXTURE (self));
+
+  width = cogl_texture_get_width (texture);
+  height = cogl_texture_get_height (texture);
+
+  tx1 = area->x1 / width;
+  ty1 = area->y1 / height;
+  tx2 = area->x2 / width;
+  ty2 = area->y2 / height;
+
+  if (tx1 >= tx2 || ty1 >= ty2)
+    return;
+
+  /* The accumulation buffer is drawn to with identity matrices, so the area
+   * is given in normalised device coordinates */
+  cogl_push_framebuffer (priv->acc_fbo);
+  cogl_color_set_from_4ub (&zero_color, 0, 0, 0, 0);
+  cogl_clear (&zero_color,
+              COGL_BUFFER_BIT_STENCIL |
+              COGL_BUFFER_BIT_DEPTH);
+  cogl_set_source (material);
+  cogl_rectangle_with_texture_coords (tx1 * 2 - 1, 1 - ty1 * 2,
+                                      tx2 * 2 - 1, 1 - ty2 * 2,
+                                      tx1, ty1, tx2, ty2);
+  cogl_pop_framebuffer ();
+}
+
 static void
 mx_offscreen_paint (ClutterActor *actor)
 {
@@ -527,25 +613,18 @@ mx_offscreen_paint (ClutterActor *actor)
     {
       if (priv->auto_update &&
           (clutter_actor_get_parent (priv->child) == actor))
-        mx_offscreen_update (self);
+        mx_offscreen_update_damage (self);
 
       if (priv->acc_enabled && mx_offscreen_ensure_accumulation_buffer (self))
         {
           ClutterActorBox box;
-          CoglColor zero_color;
 
-          CoglHandle material =
-            clutter_texture_get_cogl_material (CLUTTER_TEXTURE (actor));
-
-          /* Blend the texture onto the accumulation buffer */
-          cogl_push_framebuffer (priv->acc_fbo);
-          cogl_color_set_from_4ub (&zero_color, 0, 0, 0, 0);
-          cogl_clear (&zero_color,
-                      COGL_BUFFER_BIT_STENCIL |
-                      COGL_BUFFER_BIT_DEPTH);
-          cogl_set_source (material);
-          cogl_rectangle (-1, 1, 1, -1);
-          cogl_pop_framebuffer ();
+          /* Blend the recently updated area onto the accumulation buffer */
+          if (priv->acc_frames)
+            {
+              mx_offscreen_accumulate (self, &priv->acc_damage);
+              priv->acc_frames --;
+            }
 
           /* Draw the accumulation buffer */
           clutter_actor_get_allocation_box (actor, &box);
@@ -693,6 +772,8 @@ mx_offscreen_cogl_texture_notify (MxOffscreen *self)
       priv->fbo = NULL;
     }
 
+  priv->damage_all = TRUE;
+
   if (!texture)
     return;
 
@@ -771,24 +852,230 @@ mx_offscreen_init (MxOffscreen *self)
   priv->auto_update = TRUE;
   priv->redirect_enabled = TRUE;
 
+  priv->damage = g_array_new (FALSE, FALSE, sizeof (ClutterActorBox));
+  priv->damage_boxes = _mx_damage_boxes_new ();
+  priv->damage_all = TRUE;
+
   g_signal_connect (self, "notify::cogl-texture",
                     G_CALLBACK (mx_offscreen_cogl_texture_notify), NULL);
 }
 
+static void
+mx_offscreen_get_texture_size (MxOffscreen *offscreen,
+                               gfloat      *width,
+                               gfloat      *height)
+{
+  MxOffscreenPrivate *priv = offscreen->priv;
+  CoglHandle texture =
+    clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (offscreen));
+
+  if (texture)
+    {
+      *width = cogl_texture_get_width (texture);
+      *height = cogl_texture_get_height (texture);
+    }
+  else if (priv->child)
+    {
+      clutter_actor_get_size (priv->child, width, height);
+      *width = (guint)*width;
+      *height = (guint)*height;
+    }
+  else
+    *width = *height = 0;
+}
+
+static gboolean
+mx_offscreen_box_is_empty (const ClutterActorBox *box)
+{
+  return (box->x1 >= box->x2) || (box->y1 >= box->y2);
+}
+
+static void
+mx_offscreen_add_damage (MxOffscreen           *offscreen,
+                         const ClutterActorBox *box)
+{
+  guint i;
+  ClutterActorBox *rect;
+
+  MxOffscreenPrivate *priv = offscreen->priv;
+
+  if (priv->damage_all || mx_offscreen_box_is_empty (box))
+    return;
+
+  /* Merge with an existing rectangle if the two overlap */
+  for (i = 0; i < priv->damage->len; i++)
+    {
+      rect = &g_array_index (priv->damage, ClutterActorBox, i);
+
+      if ((box->x1 <= rect->x2) && (box->x2 >= rect->x1) &&
+          (box->y1 <= rect->y2) && (box->y2 >= rect->y1))
+        {
+          clutter_actor_box_union (rect, box, rect);
+          return;
+        }
+    }
+
+  if (priv->damage->len < MAX_DAMAGE_RECTS)
+    {
+      g_array_append_val (priv->damage, *box);
+      return;
+    }
+
+  /* Too many separate rectangles, collapse them into their bounding box */
+  rect = &g_array_index (priv->damage, ClutterActorBox, 0);
+  clutter_actor_box_union (rect, box, rect);
+  for (i = 1; i < priv->damage->len; i++)
+    clutter_actor_box_union (rect,
+                             &g_array_index (priv->damage, ClutterActorBox, i),
+                             rect);
+  g_array_set_size (priv->damage, 1);
+}
+
+static void
+mx_offscreen_add_acc_damage (MxOffscreen           *offscreen,
+                             const ClutterActorBox *box)
+{
+  MxOffscreenPrivate *priv = offscreen->priv;
+
+  if (mx_offscreen_box_is_empty (box))
+    return;
+
+  if (priv->acc_frames)
+    clutter_actor_box_union (&priv->acc_damage, box, &priv->acc_damage);
+  else
+    priv->acc_damage = *box;
+
+  priv->acc_frames = ACCUMULATION_SETTLE_FRAMES;
+}
+
+/* Removes all pending damage, returning its bounding box */
+static void
+mx_offscreen_take_damage (MxOffscreen     *offscreen,
+                          ClutterActorBox *box)
+{
+  MxOffscreenPrivate *priv = offscreen->priv;
+
+  if (!mx_offscreen_get_damaged_area (offscreen, box))
+    clutter_actor_box_init (box, 0, 0, 0, 0);
+
+  priv->damage_all = FALSE;
+  g_array_set_size (priv->damage, 0);
+
+  mx_offscreen_add_acc_damage (offscreen, box);
+}
+
+static void
+mx_offscreen_damage_cb (ClutterActor *source,
+                        ClutterActor *origin,
+                        MxOffscreen  *offscreen)
+{
+  gint i;
+  gfloat width, height;
+  ClutterActorBox box, old_box;
+  ClutterVertex origin_point, corner;
+  const ClutterPaintVolume *volume;
+  ClutterActor *ancestor;
+
+  MxOffscreenPrivate *priv = offscreen->priv;
+
+  /* A stage child clears and redraws the whole buffer itself */
+  volume = NULL;
+  if (!CLUTTER_IS_STAGE (priv->child))
+    volume = clutter_actor_get_paint_volume (origin);
+
+  if (!volume)
+    {
+      priv->damage_all = TRUE;
+      return;
+    }
+
+  /* The child is drawn in the coordinates of its parent when owned, and
+   * its own coordinates when it is only redirected.
+   */
+  if (clutter_actor_get_parent (priv->child) == (ClutterActor *)offscreen)
+    ancestor = (ClutterActor *)offscreen;
+  else
+    ancestor = priv->child;
+
+  clutter_paint_volume_get_origin (volume, &origin_point);
+  width = clutter_paint_volume_get_width (volume);
+  height = clutter_paint_volume_get_height (volume);
+
+  for (i = 0; i < 8; i++)
+    {
+      corner = origin_point;
+      if (i & 1)
+        corner.x += width;
+      if (i & 2)
+        corner.y += height;
+      if (i & 4)
+        corner.z += clutter_paint_volume_get_depth (volume);
+
+      clutter_actor_apply_relative_transform_to_point (origin, ancestor,
+                                                       &corner, &corner);
+
+      /* Anything off the z=0 plane is subject to the perspective of the
+       * buffer, so don't try to guess where it ends up.
+       */
+      if (corner.z != 0.f)
+        {
+          priv->damage_all = TRUE;
+          return;
+        }
+
+      if (i == 0)
+        clutter_actor_box_init (&box, corner.x, corner.y, corner.x, corner.y);
+      else
+        {
+          box.x1 = MIN (box.x1, corner.x);
+          box.y1 = MIN (box.y1, corner.y);
+          box.x2 = MAX (box.x2, corner.x);
+          box.y2 = MAX (box.y2, corner.y);
+        }
+    }
+
+  mx_offscreen_get_texture_size (offscreen, &width, &height);
+  box.x1 = CLAMP (floorf (box.x1), 0, width);
+  box.y1 = CLAMP (floorf (box.y1), 0, height);
+  box.x2 = CLAMP (ceilf (box.x2), 0, width);
+  box.y2 = CLAMP (ceilf (box.y2), 0, height);
+
+  /* Also redraw the area the actor was last damaged at, in case it moved.
+   * If we don't know where that is, redraw everything.
+   */
+  if (_mx_damage_boxes_update (priv->damage_boxes, origin, &box, &old_box))
+    mx_offscreen_add_damage (offscreen, &old_box);
+  else
+    priv->damage_all = TRUE;
+
+  mx_offscreen_add_damage (offscreen, &box);
+}
+
 static gboolean
 mx_offscreen_pre_paint_cb (ClutterActor *actor,
                            MxOffscreen  *offscreen)
 {
   CoglColor zero_colour;
+  ClutterActorBox area;
 
   MxOffscreenPrivate *priv = offscreen->priv;
 
+  priv->clip_pushed = FALSE;
+
   if (!mx_offscreen_ensure_buffers (offscreen))
     {
       g_warning (G_STRLOC ": Unable to create necessary buffers");
       return FALSE;
     }
 
+  /* When the paint wasn't started by an update, redraw the bounding box
+   * of whatever was damaged since the last paint.
+   */
+  if (priv->paint_area_set)
+    area = priv->paint_area;
+  else
+    mx_offscreen_take_damage (offscreen, &area);
+
   /* Disable shaders when we paint our off-screen children */
   mx_offscreen_toggle_shaders (offscreen, &priv->disabled_shaders, FALSE);
 
@@ -796,6 +1083,12 @@ mx_offscreen_pre_paint_cb (ClutterActor *actor,
   cogl_push_framebuffer (priv->fbo);
   cogl_push_matrix ();
 
+  /* Restrict drawing to the damaged area */
+  cogl_clip_push_window_rectangle (area.x1, area.y1,
+                                   area.x2 - area.x1,
+                                   area.y2 - area.y1);
+  priv->clip_pushed = TRUE;
+
   /* Clear. If the source actor is a stage then it will clear the
      buffer itself so we should avoid duplicating that work here */
   if (!CLUTTER_IS_STAGE (priv->child))
@@ -816,10 +1109,12 @@ mx_offscreen_post_paint_cb (ClutterActor *actor,
 {
   MxOffscreenPrivate *priv = offscreen->priv;
 
-  if (!priv->fbo)
+  if (!priv->clip_pushed)
     return;
 
   /* Restore state */
+  priv->clip_pushed = FALSE;
+  cogl_clip_pop ();
   cogl_pop_matrix ();
   cogl_pop_framebuffer ();
 
@@ -843,6 +1138,65 @@ mx_offscreen_queue_redraw_cb (ClutterActor *source,
     }
 }
 
+static void
+mx_offscreen_update_damage (MxOffscreen *offscreen)
+{
+  guint i, n_rects;
+  ClutterActorBox rects[MAX_DAMAGE_RECTS];
+
+  MxOffscreenPrivate *priv = offscreen->priv;
+
+  if (!priv->child)
+    return;
+
+  /* When the child isn't ours, its paint handlers redraw the damage */
+  if (clutter_actor_get_parent (priv->child) != (ClutterActor *)offscreen)
+    {
+      MX_OFFSCREEN_GET_CLASS (offscreen)->paint_child (offscreen);
+      return;
+    }
+
+  /* Make sure the buffers are up to date first, as recreating the texture
+   * damages all of it.
+   */
+  if (!mx_offscreen_ensure_buffers (offscreen))
+    {
+      g_warning (G_STRLOC ": Unable to create necessary buffers");
+      return;
+    }
+
+  /* Take the damage, so that anything damaged while painting is kept for
+   * the next update.
+   */
+  if (priv->damage_all)
+    {
+      mx_offscreen_take_damage (offscreen, &rects[0]);
+      n_rects = 1;
+    }
+  else
+    {
+      n_rects = priv->damage->len;
+      memcpy (rects, priv->damage->data, n_rects * sizeof (ClutterActorBox));
+      g_array_set_size (priv->damage, 0);
+    }
+
+  /* Draw the child once for each damaged rectangle */
+  priv->paint_area_set = TRUE;
+  for (i = 0; i < n_rects; i++)
+    {
+      priv->paint_area = rects[i];
+      mx_offscreen_add_acc_damage (offscreen, &priv->paint_area);
+
+      if (!mx_offscreen_pre_paint_cb (priv->child, offscreen))
+        break;
+
+      MX_OFFSCREEN_GET_CLASS (offscreen)->paint_child (offscreen);
+
+      mx_offscreen_post_paint_cb (priv->child, offscreen);
+    }
+  priv->paint_area_set = FALSE;
+}
+
 /**
  * mx_offscreen_new:
  *
@@ -881,6 +1235,10 @@ mx_offscreen_set_child (MxOffscreen *offscreen, ClutterActor *actor)
     {
       ClutterActor *old_child = g_object_ref (priv->child);
 
+      g_signal_handlers_disconnect_by_func (priv->child,
+                                            mx_offscreen_damage_cb,
+                                            offscreen);
+
       if (clutter_actor_get_parent (priv->child) ==
           (ClutterActor *)offscreen)
         {
@@ -906,10 +1264,15 @@ mx_offscreen_set_child (MxOffscreen *offscreen, ClutterActor *actor)
       g_object_unref (old_child);
     }
 
+  priv->damage_all = TRUE;
+
   if (actor)
     {
       priv->child = actor;
 
+      g_signal_connect (priv->child, "queue-redraw",
+                        G_CALLBACK (mx_offscreen_damage_cb), offscreen);
+
       if (!clutter_actor_get_parent (actor) &&
           !CLUTTER_IS_STAGE (actor))
         {
@@ -1035,29 +1398,103 @@ mx_offscreen_get_auto_update (MxOffscreen *offscreen)
  * @offscreen: A #MxOffscreen
  *
  * Updates the offscreen surface. This causes the child of @offscreen to be
- * drawn into the texture of @offscreen.
+ * drawn into the texture of @offscreen. The whole of the texture is redrawn,
+ * regardless of the damaged area.
  */
 void
 mx_offscreen_update (MxOffscreen *offscreen)
 {
-  gboolean child_owned;
-  MxOffscreenPrivate *priv = offscreen->priv;
+  g_return_if_fail (MX_IS_OFFSCREEN (offscreen));
 
-  if (!priv->child)
-    return;
+  offscreen->priv->damage_all = TRUE;
+  mx_offscreen_update_damage (offscreen);
+}
+
+/**
+ * mx_offscreen_damage_area:
+ * @offscreen: A #MxOffscreen
+ * @area: (allow-none): the damaged area, in texture coordinates, or %NULL
+ *
+ * Marks @area of the offscreen texture as needing to be redrawn on the next
+ * update, and queues a redraw. This is only necessary when part of the
+ * child changes without queueing a redraw. If @area is %NULL, the whole of
+ * the texture is marked.
+ *
+ * Since: 1.6
+ */
+void
+mx_offscreen_damage_area (MxOffscreen           *offscreen,
+                          const ClutterActorBox *area)
+{
+  MxOffscreenPrivate *priv;
 
-  child_owned = (clutter_actor_get_parent (priv->child) ==
-                 (ClutterActor *)offscreen);
+  g_return_if_fail (MX_IS_OFFSCREEN (offscreen));
 
-  if (child_owned)
-    if (!mx_offscreen_pre_paint_cb (priv->child, offscreen))
-      return;
+  priv = offscreen->priv;
+
+  if (area)
+    {
+      ClutterActorBox box;
+
+      box.x1 = floorf (area->x1);
+      box.y1 = floorf (area->y1);
+      box.x2 = ceilf (area->x2);
+      box.y2 = ceilf (area->y2);
+
+      mx_offscreen_add_damage (offscreen, &box);
+    }
+  else
+    priv->damage_all = TRUE;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (offscreen));
+}
+
+/**
+ * mx_offscreen_get_damaged_area:
+ * @offscreen: A #MxOffscreen
+ * @area: (out) (allow-none): return location for the damaged area, or %NULL
+ *
+ * Gets the bounding box of the areas of the offscreen texture that will be
+ * redrawn on the next update, in texture coordinates.
+ *
+ * Returns: %TRUE if any of the texture is damaged
+ *
+ * Since: 1.6
+ */
+gboolean
+mx_offscreen_get_damaged_area (MxOffscreen     *offscreen,
+                               ClutterActorBox *area)
+{
+  guint i;
+  gfloat width, height;
+  ClutterActorBox box;
+  MxOffscreenPrivate *priv;
 
-  /* Draw actor */
-  MX_OFFSCREEN_GET_CLASS (offscreen)->paint_child (offscreen);
+  g_return_val_if_fail (MX_IS_OFFSCREEN (offscreen), FALSE);
+
+  priv = offscreen->priv;
 
-  if (child_owned)
-    mx_offscreen_post_paint_cb (priv->child, offscreen);
+  if (priv->damage_all)
+    {
+      mx_offscreen_get_texture_size (offscreen, &width, &height);
+      clutter_actor_box_init (&box, 0, 0, width, height);
+    }
+  else if (priv->damage->len)
+    {
+      box = g_array_index (priv->damage, ClutterActorBox, 0);
+      for (i = 1; i < priv->damage->len; i++)
+        clutter_actor_box_union (&box,
+                                 &g_array_index (priv->damage,
+                                                 ClutterActorBox, i),
+                                 &box);
+    }
+  else
+    return FALSE;
+
+  if (area)
+    *area = box;
+
+  return TRUE;
 }
 
 /**
@@ -1084,18 +1521,24 @@ mx_offscreen_set_redirect_enabled (MxOffscreen *offscreen,
     {
       priv->redirect_enabled = enabled;
 
-      if (enabled && priv->acc_fbo)
+      if (enabled)
         {
-          CoglColor color;
+          /* The child may have changed without us tracking it */
+          priv->damage_all = TRUE;
 
-          /* Clear the accumulation buffer when the offscreen is
-           * enabled. As the child has been drawn without updating,
-           * the contents of the accumulation buffer is invalid.
-           */
-          cogl_color_set_from_4ub (&color, 0, 0, 0, 0);
-          cogl_push_framebuffer (priv->fbo);
-          cogl_clear (&color, COGL_BUFFER_BIT_COLOR);
-          cogl_pop_framebuffer ();
+          if (priv->acc_fbo)
+            {
+              CoglColor color;
+
+              /* Clear the accumulation buffer when the offscreen is
+               * enabled. As the child has been drawn without updating,
+               * the contents of the accumulation buffer is invalid.
+               */
+              cogl_color_set_from_4ub (&color, 0, 0, 0, 0);
+              cogl_push_framebuffer (priv->acc_fbo);
+              cogl_clear (&color, COGL_BUFFER_BIT_COLOR);
+              cogl_pop_framebuffer ();
+            }
         }
 
       g_object_notify (G_OBJECT (offscreen), "redirect-enabled");
@@ -109,6 +109,11 @@ CoglHandle mx_offscreen_get_buffer (MxOffscreen *offscreen);
 
 void mx_offscreen_update (MxOffscreen *offscreen);
 
+void     mx_offscreen_damage_area      (MxOffscreen           *offscreen,
+                                        const ClutterActorBox *area);
+gboolean mx_offscreen_get_damaged_area (MxOffscreen           *offscreen,
+                                        ClutterActorBox       *area);
+
 void mx_offscreen_set_accumulation_enabled (MxOffscreen *offscreen,
                                            gboolean     enable);
 gboolean mx_offscreen_get_accumulation_enabled (MxOffscreen *offscreen);
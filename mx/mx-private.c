@@ -92,3 +92,808 @@ _mx_string_to_enum (GType        type,
 
   return ret;
 }
+
+/*
+ * _mx_check_new_children:
+ * @actors: A #GList of the actors to add to a container
+ *
+ * Checks that all of @actors can be added to a container: that they are
+ * actors, that they don't have a parent yet and that none of them appears
+ * more than once. The add_actors() functions of the containers check this
+ * before adding any of the actors, so that a bad list adds nothing.
+ *
+ * Returns: %TRUE if the actors can be added
+ */
+gboolean
+_mx_check_new_children (GList *actors)
+{
+  GHashTable *seen;
+  GList *l;
+  gboolean valid = TRUE;
+
+  seen = g_hash_table_new (NULL, NULL);
+
+  for (l = actors; l && valid; l = l->next)
+    {
+      valid = FALSE;
+
+      if (!CLUTTER_IS_ACTOR (l->data))
+        g_warning (G_STRLOC ": %p is not a ClutterActor", l->data);
+      else if (clutter_actor_get_parent (l->data))
+        g_warning (G_STRLOC ": Actor of type %s already has a parent",
+                   G_OBJECT_TYPE_NAME (l->data));
+      else if (g_hash_table_lookup (seen, l->data))
+        g_warning (G_STRLOC ": Actor of type %s is in the list twice",
+                   G_OBJECT_TYPE_NAME (l->data));
+      else
+        {
+          g_hash_table_insert (seen, l->data, l->data);
+          valid = TRUE;
+        }
+    }
+
+  g_hash_table_destroy (seen);
+
+  return valid;
+}
+
+/*
+ * _mx_child_extents_append:
+ * @extents: A #GArray of #MxChildExtent
+ * @actor: The allocated child
+ * @box: The allocation of @actor
+ * @start: Start of the space given to @actor along the sorted axis
+ * @end: End of the space given to @actor along the sorted axis
+ *
+ * Adds a child to the end of @extents. Children must be appended in
+ * increasing order of @start. The stored end is the maximum end of all the
+ * children so far, so that both the start and the end of the extents are
+ * sorted.
+ */
+void
+_mx_child_extents_append (GArray                *extents,
+                          ClutterActor          *actor,
+                          const ClutterActorBox *box,
+                          gfloat                 start,
+                          gfloat                 end)
+{
+  MxChildExtent extent;
+
+  extent.actor = actor;
+  extent.box = *box;
+  extent.start = start;
+  extent.end = end;
+
+  if (extents->len)
+    {
+      MxChildExtent *last =
+        &g_array_index (extents, MxChildExtent, extents->len - 1);
+
+      if (last->end > extent.end)
+        extent.end = last->end;
+    }
+
+  g_array_append_val (extents, extent);
+}
+
+/*
+ * _mx_child_extents_paint:
+ * @extents: A #GArray of #MxChildExtent
+ * @axis: The axis the extents are sorted along
+ * @visible_box: The visible area, in the coordinates of the children
+ *
+ * Paints the children in @extents that intersect @visible_box. The first
+ * visible child is found with a binary search, so the cost depends on the
+ * number of visible children rather than the total number of children.
+ */
+void
+_mx_child_extents_paint (GArray                *extents,
+                         MxOrientation          axis,
+                         const ClutterActorBox *visible_box)
+{
+  gfloat visible_start, visible_end;
+  guint low, high;
+
+  if (axis == MX_ORIENTATION_VERTICAL)
+    {
+      visible_start = visible_box->y1;
+      visible_end = visible_box->y2;
+    }
+  else
+    {
+      visible_start = visible_box->x1;
+      visible_end = visible_box->x2;
+    }
+
+  /* find the first child that ends after the start of the visible area */
+  low = 0;
+  high = extents->len;
+  while (low < high)
+    {
+      guint middle = (low + high) / 2;
+
+      if (g_array_index (extents, MxChildExtent, middle).end <= visible_start)
+        low = middle + 1;
+      else
+        high = middle;
+    }
+
+  for (; low < extents->len; low++)
+    {
+      MxChildExtent *extent = &g_array_index (extents, MxChildExtent, low);
+
+      if (extent->start >= visible_end)
+        break;
+
+      if ((extent->box.x1 < visible_box->x2)
+          && (extent->box.x2 > visible_box->x1)
+          && (extent->box.y1 < visible_box->y2)
+          && (extent->box.y2 > visible_box->y1)
+          && CLUTTER_ACTOR_IS_VISIBLE (extent->actor))
+        {
+          clutter_actor_paint (extent->actor);
+        }
+    }
+}
+
+static void
+mx_damage_boxes_actor_destroyed_cb (gpointer  data,
+                                    GObject  *old_actor)
+{
+  g_hash_table_remove ((GHashTable *) data, old_actor);
+}
+
+static gboolean
+mx_damage_boxes_remove_cb (gpointer key,
+                           gpointer value,
+                           gpointer user_data)
+{
+  g_object_weak_unref (G_OBJECT (key),
+                       mx_damage_boxes_actor_destroyed_cb,
+                       user_data);
+  return TRUE;
+}
+
+GHashTable *
+_mx_damage_boxes_new (void)
+{
+  return g_hash_table_new_full (NULL, NULL, NULL,
+                                (GDestroyNotify) clutter_actor_box_free);
+}
+
+void
+_mx_damage_boxes_free (GHashTable *boxes)
+{
+  _mx_damage_boxes_clear (boxes);
+  g_hash_table_destroy (boxes);
+}
+
+/*
+ * _mx_damage_boxes_update:
+ * @boxes: A table created with _mx_damage_boxes_new()
+ * @actor: The actor that queued a redraw
+ * @box: Where @actor is damaged now
+ * @old_box: (out): Where @actor was last damaged
+ *
+ * Records @box as the last damaged box of @actor.
+ *
+ * Returns: %TRUE if @old_box was set, %FALSE if it isn't known where
+ *   @actor was last damaged, in which case everything should be redrawn
+ */
+gboolean
+_mx_damage_boxes_update (GHashTable            *boxes,
+                         ClutterActor          *actor,
+                         const ClutterActorBox *box,
+                         ClutterActorBox       *old_box)
+{
+  ClutterActorBox *last_box;
+
+  last_box = g_hash_table_lookup (boxes, actor);
+  if (last_box)
+    {
+      *old_box = *last_box;
+      *last_box = *box;
+      return TRUE;
+    }
+
+  g_object_weak_ref (G_OBJECT (actor), mx_damage_boxes_actor_destroyed_cb,
+                     boxes);
+  g_hash_table_insert (boxes, actor, clutter_actor_box_copy (box));
+
+  return FALSE;
+}
+
+/* forgets where @actor was last damaged, e.g. because where it is now
+ * isn't known either */
+void
+_mx_damage_boxes_remove (GHashTable   *boxes,
+                         ClutterActor *actor)
+{
+  if (g_hash_table_lookup (boxes, actor))
+    {
+      g_object_weak_unref (G_OBJECT (actor),
+                           mx_damage_boxes_actor_destroyed_cb,
+                           boxes);
+      g_hash_table_remove (boxes, actor);
+    }
+}
+
+/* forgets all the boxes, e.g. after a relayout, when the actors may no
+ * longer be where they were last damaged */
+void
+_mx_damage_boxes_clear (GHashTable *boxes)
+{
+  g_hash_table_foreach_remove (boxes, mx_damage_boxes_remove_cb, boxes);
+}
+
+typedef struct
+{
+  gchar *name;
+  gint   col;
+} MxItemAttribute;
+
+static gboolean
+mx_item_window_update_idle_cb (MxItemWindow *window)
+{
+  window->update_id = 0;
+
+  _mx_item_window_update (window, FALSE);
+
+  return FALSE;
+}
+
+static void
+mx_item_window_queue_update (MxItemWindow *window)
+{
+  if (!window->update_id)
+    window->update_id =
+      g_idle_add_full (CLUTTER_PRIORITY_REDRAW,
+                       (GSourceFunc) mx_item_window_update_idle_cb,
+                       window, NULL);
+}
+
+static void
+mx_item_window_value_notify_cb (MxAdjustment *adjustment,
+                                GParamSpec   *pspec,
+                                MxItemWindow *window)
+{
+  /* while allocating, the adjustment is set after the items have been
+   * allocated, so new items would not be allocated until the next frame */
+  if (window->in_allocation)
+    mx_item_window_queue_update (window);
+  else
+    _mx_item_window_update (window, FALSE);
+}
+
+static void
+mx_item_window_predicted_area_changed_cb (MxScrollable *scrollable,
+                                          MxItemWindow *window)
+{
+  /* only a virtualized view watches its adjustment */
+  if (window->vadjustment)
+    mx_item_window_value_notify_cb (window->vadjustment, NULL, window);
+}
+
+static void
+mx_item_window_invalidate_measure (MxItemWindow *window)
+{
+  /* only a virtualized view that has items has measured one */
+  if (window->items->len == 0)
+    return;
+
+  /* the view measures a new item when it is next allocated */
+  window->reset (window->view);
+  clutter_actor_queue_relayout (window->view);
+}
+
+static void
+mx_item_window_style_changed_cb (MxStylable          *stylable,
+                                 MxStyleChangedFlags  flags,
+                                 MxItemWindow        *window)
+{
+  mx_item_window_invalidate_measure (window);
+}
+
+static void
+mx_item_window_mapped_notify_cb (ClutterActor *view,
+                                 GParamSpec   *pspec,
+                                 MxItemWindow *window)
+{
+  if (CLUTTER_ACTOR_IS_MAPPED (view))
+    mx_item_window_invalidate_measure (window);
+}
+
+/*
+ * _mx_item_window_init:
+ * @window: An #MxItemWindow
+ * @view: The #MxScrollable container of the items
+ * @get_range: Gives the rows that need an item when virtualized
+ * @needs_measure: Whether @measure must be called before @get_range
+ * @measure: Sets the size of the items from the first one
+ * @reset: Forgets the size set by @measure, when the style of the items
+ *   may have changed
+ *
+ * Initialises @window, which is usually part of the private structure of
+ * @view.
+ */
+void
+_mx_item_window_init (MxItemWindow            *window,
+                      ClutterActor            *view,
+                      MxItemWindowRangeFunc    get_range,
+                      MxItemWindowNeedsFunc    needs_measure,
+                      MxItemWindowMeasureFunc  measure,
+                      MxItemWindowResetFunc    reset)
+{
+  window->view = view;
+  window->items = g_ptr_array_new ();
+  window->removed_row = -1;
+  window->get_range = get_range;
+  window->needs_measure = needs_measure;
+  window->measure = measure;
+  window->reset = reset;
+
+  g_signal_connect (view, "predicted-area-changed",
+                    G_CALLBACK (mx_item_window_predicted_area_changed_cb),
+                    window);
+  g_signal_connect (view, "style-changed",
+                    G_CALLBACK (mx_item_window_style_changed_cb), window);
+  g_signal_connect (view, "notify::mapped",
+                    G_CALLBACK (mx_item_window_mapped_notify_cb), window);
+}
+
+/* the view must have disconnected from the model and unreffed it */
+void
+_mx_item_window_dispose (MxItemWindow *window)
+{
+  if (window->factory)
+    {
+      g_object_unref (window->factory);
+      window->factory = NULL;
+    }
+
+  if (window->update_id)
+    {
+      g_source_remove (window->update_id);
+      window->update_id = 0;
+    }
+
+  _mx_item_window_set_vadjustment (window, NULL);
+}
+
+void
+_mx_item_window_finalize (MxItemWindow *window)
+{
+  GSList *l;
+
+  for (l = window->attributes; l; l = l->next)
+    {
+      MxItemAttribute *attr = l->data;
+
+      g_free (attr->name);
+      g_free (attr);
+    }
+  g_slist_free (window->attributes);
+  window->attributes = NULL;
+
+  g_ptr_array_free (window->items, TRUE);
+  window->items = NULL;
+}
+
+void
+_mx_item_window_add_attribute (MxItemWindow *window,
+                               const gchar  *name,
+                               gint          column)
+{
+  MxItemAttribute *attr;
+
+  attr = g_new (MxItemAttribute, 1);
+  attr->name = g_strdup (name);
+  attr->col = column;
+
+  window->attributes = g_slist_prepend (window->attributes, attr);
+}
+
+ClutterActor *
+_mx_item_window_create_item (MxItemWindow *window)
+{
+  if (window->item_type)
+    return g_object_new (window->item_type, NULL);
+  else
+    return mx_item_factory_create (window->factory);
+}
+
+/* sets the values of the attributes in the row of @iter on @item */
+void
+_mx_item_window_bind_item (MxItemWindow     *window,
+                           GObject          *item,
+                           ClutterModelIter *iter)
+{
+  GSList *p;
+
+  g_object_freeze_notify (item);
+  for (p = window->attributes; p; p = p->next)
+    {
+      GValue value = { 0, };
+      MxItemAttribute *attr = p->data;
+
+      clutter_model_iter_get_value (iter, attr->col, &value);
+
+      g_object_set_property (item, attr->name, &value);
+
+      g_value_unset (&value);
+    }
+  g_object_thaw_notify (item);
+}
+
+gint
+_mx_item_window_get_n_rows (MxItemWindow *window)
+{
+  gint n_rows;
+
+  if (!window->model)
+    return 0;
+
+  n_rows = clutter_model_get_n_rows (window->model);
+
+  /* the views handle row-removed before the default handler of the
+   * model, so a row that is being removed is still counted */
+  if (window->removed_row >= 0)
+    n_rows--;
+
+  return n_rows;
+}
+
+static ClutterModelIter *
+mx_item_window_get_iter_at_row (MxItemWindow *window,
+                                gint          row)
+{
+  if (window->removed_row >= 0 && row >= window->removed_row)
+    row++;
+
+  return clutter_model_get_iter_at_row (window->model, row);
+}
+
+static void
+mx_item_window_iter_next (MxItemWindow     *window,
+                          ClutterModelIter *iter)
+{
+  clutter_model_iter_next (iter);
+
+  if (window->removed_row >= 0
+      && !clutter_model_iter_is_last (iter)
+      && clutter_model_iter_get_row (iter) == window->removed_model_row)
+    clutter_model_iter_next (iter);
+}
+
+/*
+ * _mx_item_window_get_range:
+ * @window: An #MxItemWindow
+ * @first: (out): The first row that needs an item
+ * @last: (out): The row after the last one that needs an item
+ *
+ * Gets the rows that a virtualized view needs items for, at the current
+ * scroll position.
+ */
+void
+_mx_item_window_get_range (MxItemWindow *window,
+                           gint         *first,
+                           gint         *last)
+{
+  ClutterActorBox area;
+  gfloat value, top, bottom;
+
+  if (window->vadjustment)
+    value = mx_adjustment_get_value (window->vadjustment);
+  else
+    value = 0;
+
+  top = value;
+  bottom = value + window->page_height;
+
+  /* extend the window by up to a page towards where a kinetic scroll is
+   * predicted to go, so the items exist before they scroll into view */
+  if (mx_scrollable_get_predicted_area (MX_SCROLLABLE (window->view), &area))
+    {
+      top = MAX (MIN (top, area.y1), value - window->page_height);
+      bottom = MIN (MAX (bottom, area.y2), value + 2 * window->page_height);
+    }
+
+  window->get_range (window->view, _mx_item_window_get_n_rows (window),
+                     top, bottom, first, last);
+}
+
+/*
+ * _mx_item_window_set_vadjustment:
+ * @window: An #MxItemWindow
+ * @vadjustment: (allow-none): The vertical adjustment of the view
+ *
+ * Sets the adjustment that a virtualized view follows to update its items.
+ * Non-virtualized views set %NULL.
+ */
+void
+_mx_item_window_set_vadjustment (MxItemWindow *window,
+                                 MxAdjustment *vadjustment)
+{
+  if (vadjustment == window->vadjustment)
+    return;
+
+  if (window->vadjustment)
+    {
+      g_signal_handlers_disconnect_by_func (window->vadjustment,
+                                            mx_item_window_value_notify_cb,
+                                            window);
+      g_object_unref (window->vadjustment);
+      window->vadjustment = NULL;
+    }
+
+  if (vadjustment)
+    {
+      window->vadjustment = g_object_ref (vadjustment);
+      g_signal_connect (vadjustment, "notify::value",
+                        G_CALLBACK (mx_item_window_value_notify_cb), window);
+    }
+}
+
+/* sets the size of the items from an item showing the first row, which is
+ * kept to show it if there are no items yet */
+static void
+mx_item_window_measure (MxItemWindow *window)
+{
+  ClutterContainer *container = CLUTTER_CONTAINER (window->view);
+  ClutterModelIter *iter;
+  ClutterActor *item;
+
+  item = _mx_item_window_create_item (window);
+  clutter_container_add_actor (container, item);
+
+  iter = mx_item_window_get_iter_at_row (window, 0);
+  _mx_item_window_bind_item (window, G_OBJECT (item), iter);
+  g_object_unref (iter);
+
+  /* the item isn't mapped yet, and unmapped actors aren't styled, so it
+   * would be measured with the default padding and font */
+  if (MX_IS_STYLABLE (item))
+    mx_stylable_style_changed (MX_STYLABLE (item), MX_STYLE_CHANGED_FORCE);
+
+  window->measure (window->view, item);
+
+  if (window->items->len == 0)
+    {
+      g_ptr_array_add (window->items, item);
+      window->first_row = 0;
+    }
+  else
+    clutter_container_remove_actor (container, item);
+}
+
+/*
+ * _mx_item_window_update:
+ * @window: An #MxItemWindow
+ * @rebind: Whether to set the data again on the items of rows that were
+ *   already shown
+ *
+ * Creates, reuses and removes the items of a virtualized view, so that
+ * there is one for each row returned by the range function.
+ */
+void
+_mx_item_window_update (MxItemWindow *window,
+                        gboolean      rebind)
+{
+  ClutterContainer *container = CLUTTER_CONTAINER (window->view);
+  ClutterModelIter *iter = NULL;
+  GPtrArray *old_items;
+  gboolean reordered, measured;
+  gint n_rows, first, last, row, old_first;
+  guint i, spare;
+
+  if (window->update_id)
+    {
+      g_source_remove (window->update_id);
+      window->update_id = 0;
+    }
+
+  if ((!window->item_type && !window->factory) || window->is_frozen)
+    return;
+
+  n_rows = _mx_item_window_get_n_rows (window);
+
+  /* the size of all the items is taken from the first one */
+  measured = FALSE;
+  if (n_rows > 0 && window->needs_measure (window->view))
+    {
+      mx_item_window_measure (window);
+      measured = TRUE;
+    }
+
+  _mx_item_window_get_range (window, &first, &last);
+
+  /* scrolling within the overscan doesn't change anything */
+  if (!rebind
+      && first == window->first_row
+      && last - first == window->items->len)
+    {
+      if (measured)
+        clutter_actor_queue_relayout (window->view);
+      return;
+    }
+
+  old_items = window->items;
+  old_first = window->first_row;
+
+  window->items = g_ptr_array_sized_new (last - first);
+  g_ptr_array_set_size (window->items, last - first);
+  window->first_row = first;
+
+  /* keep the items of the rows that are still shown */
+  if (!rebind)
+    {
+      for (i = 0; i < old_items->len; i++)
+        {
+          row = old_first + i;
+
+          if (row >= first && row < last)
+            {
+              g_ptr_array_index (window->items, row - first) =
+                g_ptr_array_index (old_items, i);
+              g_ptr_array_index (old_items, i) = NULL;
+            }
+        }
+    }
+
+  /* give the other rows the items that are no longer needed, or new ones */
+  reordered = FALSE;
+  spare = 0;
+  if (first < last)
+    iter = mx_item_window_get_iter_at_row (window, first);
+
+  for (row = first; row < last && iter; row++)
+    {
+      ClutterActor *item = g_ptr_array_index (window->items, row - first);
+      gboolean bind = rebind;
+
+      if (!item)
+        {
+          while (spare < old_items->len
+                 && !g_ptr_array_index (old_items, spare))
+            spare++;
+
+          if (spare < old_items->len)
+            {
+              item = g_ptr_array_index (old_items, spare);
+              g_ptr_array_index (old_items, spare) = NULL;
+            }
+          else
+            {
+              item = _mx_item_window_create_item (window);
+              clutter_container_add_actor (container, item);
+            }
+
+          g_ptr_array_index (window->items, row - first) = item;
+          reordered = TRUE;
+          bind = TRUE;
+        }
+
+      if (bind)
+        _mx_item_window_bind_item (window, G_OBJECT (item), iter);
+
+      mx_item_window_iter_next (window, iter);
+    }
+
+  if (iter)
+    g_object_unref (iter);
+
+  for (i = 0; i < old_items->len; i++)
+    {
+      ClutterActor *item = g_ptr_array_index (old_items, i);
+
+      if (item)
+        clutter_container_remove_actor (container, item);
+    }
+  g_ptr_array_free (old_items, TRUE);
+
+  /* keep the children in the order of the rows for keyboard navigation */
+  if (reordered)
+    {
+      for (i = 0; i < window->items->len; i++)
+        clutter_container_raise_child (container,
+                                       g_ptr_array_index (window->items, i),
+                                       NULL);
+    }
+
+  /* when allocating, the view lays out the items right after this, but a
+   * new size of the items also changes the preferred size of the view */
+  if (!window->in_allocation || measured)
+    clutter_actor_queue_relayout (window->view);
+}
+
+/* updates the items if the rows that need one have changed, e.g. because
+ * the view was allocated a new size. This is called while allocating, and
+ * before the items are allocated, so that newly exposed rows are shown in
+ * the same frame */
+void
+_mx_item_window_check_range (MxItemWindow *window)
+{
+  gint first, last;
+
+  if (_mx_item_window_get_n_rows (window) > 0
+      && window->needs_measure (window->view))
+    {
+      _mx_item_window_update (window, FALSE);
+      return;
+    }
+
+  _mx_item_window_get_range (window, &first, &last);
+
+  if (first != window->first_row || last - first != window->items->len)
+    _mx_item_window_update (window, FALSE);
+}
+
+/* the position of @iter among the rows that pass the filter of the model,
+ * which is the position of its item, or -1 if the filter rejects it. The
+ * row of an iter counts the rows that are filtered out. The filter reads
+ * the row of @iter, so in a row-removed handler this must be called before
+ * the default handler of the model frees the row */
+gint
+_mx_item_window_get_iter_index (MxItemWindow     *window,
+                                ClutterModelIter *iter)
+{
+  ClutterModelIter *first;
+  guint row;
+  gint index_;
+
+  if (!clutter_model_get_filter_set (window->model))
+    return clutter_model_iter_get_row (iter);
+
+  if (!clutter_model_filter_iter (window->model, iter))
+    return -1;
+
+  row = clutter_model_iter_get_row (iter);
+
+  first = clutter_model_get_first_iter (window->model);
+  if (!first)
+    return -1;
+
+  for (index_ = 0;
+       !clutter_model_iter_is_last (first)
+       && clutter_model_iter_get_row (first) < row;
+       index_++)
+    clutter_model_iter_next (first);
+
+  g_object_unref (first);
+
+  return index_;
+}
+
+/* called from the row-removed handler, which runs before the default
+ * handler of the model removes the row of @iter */
+void
+_mx_item_window_row_removed (MxItemWindow     *window,
+                             ClutterModelIter *iter)
+{
+  gint index_;
+
+  /* a row that the filter rejects has no item */
+  index_ = _mx_item_window_get_iter_index (window, iter);
+  if (index_ < 0)
+    return;
+
+  window->removed_row = index_;
+  window->removed_model_row = clutter_model_iter_get_row (iter);
+  _mx_item_window_update (window, TRUE);
+  window->removed_row = -1;
+}
+
+void
+_mx_item_window_remove_children (MxItemWindow *window)
+{
+  GList *l, *children;
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (window->view));
+  for (l = children; l; l = l->next)
+    clutter_container_remove_actor (CLUTTER_CONTAINER (window->view),
+                                    (ClutterActor *) l->data);
+  g_list_free (children);
+
+  g_ptr_array_set_size (window->items, 0);
+  window->first_row = 0;
+}
@@ -72,6 +72,141 @@ typedef enum
 ClutterActor *_mx_widget_get_dnd_clone (MxWidget *widget);
 
 void _mx_box_layout_start_animation (MxBoxLayout *box);
+void _mx_box_layout_invalidate_extents (MxBoxLayout *box);
+void _mx_box_layout_get_adjustments    (MxBoxLayout   *box,
+                                        MxAdjustment **hadjustment,
+                                        MxAdjustment **vadjustment);
+
+void _mx_grid_invalidate_extents (MxGrid *grid);
+void _mx_grid_get_adjustments    (MxGrid        *grid,
+                                  MxAdjustment **hadjustment,
+                                  MxAdjustment **vadjustment);
+
+void _mx_viewport_get_adjustments (MxViewport    *viewport,
+                                   MxAdjustment **hadjustment,
+                                   MxAdjustment **vadjustment);
+
+/* cached size requests of MxBoxLayout children */
+void _mx_box_layout_child_get_preferred_width  (MxBoxLayoutChild *child,
+                                                gfloat            for_height,
+                                                gfloat           *min_width_p,
+                                                gfloat           *nat_width_p);
+void _mx_box_layout_child_get_preferred_height (MxBoxLayoutChild *child,
+                                                gfloat            for_width,
+                                                gfloat           *min_height_p,
+                                                gfloat           *nat_height_p);
+
+gboolean _mx_check_new_children (GList *actors);
+
+/* Allocated children of a scrollable container, sorted by their position
+ * along the scrolling axis, used to only visit the visible children when
+ * painting and picking */
+typedef struct
+{
+  ClutterActor    *actor;
+  ClutterActorBox  box;
+  gfloat           start;
+  gfloat           end;
+} MxChildExtent;
+
+void _mx_child_extents_append (GArray                *extents,
+                               ClutterActor          *actor,
+                               const ClutterActorBox *box,
+                               gfloat                 start,
+                               gfloat                 end);
+void _mx_child_extents_paint  (GArray                *extents,
+                               MxOrientation          axis,
+                               const ClutterActorBox *visible_box);
+
+/* The box each actor that queued a redraw was last damaged at, used by
+ * MxViewport and MxOffscreen to also redraw the area an actor moved or
+ * shrank from. The actors are weakly referenced */
+GHashTable *_mx_damage_boxes_new    (void);
+void        _mx_damage_boxes_free   (GHashTable            *boxes);
+gboolean    _mx_damage_boxes_update (GHashTable            *boxes,
+                                     ClutterActor          *actor,
+                                     const ClutterActorBox *box,
+                                     ClutterActorBox       *old_box);
+void        _mx_damage_boxes_remove (GHashTable            *boxes,
+                                     ClutterActor          *actor);
+void        _mx_damage_boxes_clear  (GHashTable            *boxes);
+
+/* The items of MxListView and MxItemView. When virtualized, items are only
+ * created for the rows in and around the visible part of the view, and
+ * they are reused for other rows as the view scrolls */
+typedef struct _MxItemWindow MxItemWindow;
+
+/* the rows, out of @n_rows, that need an item to show the area of the
+ * view between @top and @bottom */
+typedef void     (* MxItemWindowRangeFunc)   (ClutterActor *view,
+                                              gint          n_rows,
+                                              gfloat        top,
+                                              gfloat        bottom,
+                                              gint         *first,
+                                              gint         *last);
+/* whether the size of the items is still unknown */
+typedef gboolean (* MxItemWindowNeedsFunc)   (ClutterActor *view);
+/* sets the size of the items from @item, which shows the first row */
+typedef void     (* MxItemWindowMeasureFunc) (ClutterActor *view,
+                                              ClutterActor *item);
+/* forgets the size set by the measure function */
+typedef void     (* MxItemWindowResetFunc)   (ClutterActor *view);
+
+struct _MxItemWindow
+{
+  ClutterActor           *view;
+
+  ClutterModel           *model;
+  GSList                 *attributes;
+  GType                   item_type;
+  MxItemFactory          *factory;
+  guint                   is_frozen : 1;
+
+  /* virtualized views: items[i] shows the row first_row + i */
+  guint                   in_allocation : 1;
+  GPtrArray              *items;
+  gint                    first_row;
+  gint                    removed_row;
+  guint                   removed_model_row;
+  gfloat                  page_height;
+  MxAdjustment           *vadjustment;
+  guint                   update_id;
+
+  MxItemWindowRangeFunc   get_range;
+  MxItemWindowNeedsFunc   needs_measure;
+  MxItemWindowMeasureFunc measure;
+  MxItemWindowResetFunc   reset;
+};
+
+void _mx_item_window_init            (MxItemWindow            *window,
+                                     ClutterActor            *view,
+                                     MxItemWindowRangeFunc    get_range,
+                                     MxItemWindowNeedsFunc    needs_measure,
+                                     MxItemWindowMeasureFunc  measure,
+                                     MxItemWindowResetFunc    reset);
+void _mx_item_window_dispose         (MxItemWindow     *window);
+void _mx_item_window_finalize        (MxItemWindow     *window);
+void _mx_item_window_add_attribute   (MxItemWindow     *window,
+                                     const gchar      *name,
+                                     gint              column);
+ClutterActor *_mx_item_window_create_item (MxItemWindow *window);
+void _mx_item_window_bind_item       (MxItemWindow     *window,
+                                     GObject          *item,
+                                     ClutterModelIter *iter);
+gint _mx_item_window_get_n_rows      (MxItemWindow     *window);
+void _mx_item_window_get_range       (MxItemWindow     *window,
+                                     gint             *first,
+                                     gint             *last);
+void _mx_item_window_set_vadjustment (MxItemWindow     *window,
+                                     MxAdjustment     *vadjustment);
+void _mx_item_window_update          (MxItemWindow     *window,
+                                     gboolean          rebind);
+void _mx_item_window_check_range     (MxItemWindow     *window);
+gint _mx_item_window_get_iter_index  (MxItemWindow     *window,
+                                     ClutterModelIter *iter);
+void _mx_item_window_row_removed     (MxItemWindow     *window,
+                                     ClutterModelIter *iter);
+void _mx_item_window_remove_children (MxItemWindow     *window);
 
 void _mx_bin_get_align_factors (MxBin   *bin,
                                 gdouble *x_align,
@@ -81,6 +216,9 @@ void _mx_bin_get_align_factors (MxBin   *bin,
 void _mx_table_update_row_col (MxTable *table,
                                gint     row,
                                gint     col);
+void _mx_table_invalidate_cells (MxTable *table);
+
+void _mx_deform_texture_class_set_thread_safe (MxDeformTextureClass *klass);
 
 CoglHandle _mx_window_get_icon_cogl_texture (MxWindow *window);
 
@@ -101,6 +239,25 @@ void     _mx_fade_effect_set_freeze_update (MxFadeEffect *effect,
                                             gboolean      freeze);
 gboolean _mx_fade_effect_get_freeze_update (MxFadeEffect *effect);
 
+/* transitions ticked from a single shared frame clock */
+typedef void     (* MxTransitionFunc)     (gdouble  alpha,
+                                           gpointer user_data);
+typedef gboolean (* MxTransitionDoneFunc) (gpointer user_data);
+
+guint   _mx_transition_start (guint                duration,
+                              gulong               mode,
+                              MxTransitionFunc     frame_func,
+                              MxTransitionDoneFunc done_func,
+                              gpointer             user_data);
+guint   _mx_transition_start_stepped (guint                duration,
+                                      guint                n_steps,
+                                      MxTransitionFunc     frame_func,
+                                      MxTransitionDoneFunc done_func,
+                                      gpointer             user_data);
+void    _mx_transition_stop  (guint                id);
+gdouble _mx_transition_ease  (gulong               mode,
+                              gdouble              progress);
+
 typedef enum
 {
   MX_DEBUG_LAYOUT      = 1 << 0,
@@ -26,6 +26,8 @@
 #include "mx-scrollable.h"
 #include "mx-private.h"
 
+static GQuark predicted_area_quark = 0;
+
 static void
 mx_scrollable_base_init (gpointer g_iface)
 {
@@ -34,6 +36,9 @@ mx_scrollable_base_init (gpointer g_iface)
   if (!initialized)
     {
       GParamSpec *pspec;
+
+      predicted_area_quark =
+        g_quark_from_static_string ("mx-scrollable-predicted-area");
       pspec = g_param_spec_object ("horizontal-adjustment",
                                    "Horizontal adjustment",
                                    "The MxAdjustment for horizontal scrolling.",
@@ -48,6 +53,22 @@ mx_scrollable_base_init (gpointer g_iface)
                                    MX_PARAM_READWRITE);
       g_object_interface_install_property (g_iface, pspec);
 
+      /**
+       * MxScrollable::predicted-area-changed:
+       * @scrollable: the object that received the signal
+       *
+       * Emitted when the area predicted to become visible changes, see
+       * mx_scrollable_set_predicted_area().
+       *
+       * Since: 1.6
+       */
+      g_signal_new (g_intern_static_string ("predicted-area-changed"),
+                    G_TYPE_FROM_INTERFACE (g_iface),
+                    G_SIGNAL_RUN_LAST,
+                    0, NULL, NULL,
+                    g_cclosure_marshal_VOID__VOID,
+                    G_TYPE_NONE, 0);
+
       initialized = TRUE;
     }
 }
@@ -97,3 +118,65 @@ mx_scrollable_get_adjustments (MxScrollable  *scrollable,
                                                          hadjustment,
                                                          vadjustment);
 }
+
+/**
+ * mx_scrollable_set_predicted_area:
+ * @scrollable: A #MxScrollable
+ * @area: (allow-none): the predicted area, or %NULL
+ *
+ * Publishes the area of @scrollable that is predicted to become visible,
+ * for example while a kinetic scroll decelerates, so that content can be
+ * created and loaded before it scrolls into view. The area is in the same
+ * units as the values of the adjustments of @scrollable, and covers the
+ * currently visible area as well as the predicted one. Passing %NULL
+ * clears the prediction.
+ *
+ * Since: 1.6
+ */
+void
+mx_scrollable_set_predicted_area (MxScrollable          *scrollable,
+                                  const ClutterActorBox *area)
+{
+  g_return_if_fail (MX_IS_SCROLLABLE (scrollable));
+
+  if (!area && !g_object_get_qdata (G_OBJECT (scrollable),
+                                    predicted_area_quark))
+    return;
+
+  g_object_set_qdata_full (G_OBJECT (scrollable), predicted_area_quark,
+                           area ? clutter_actor_box_copy (area) : NULL,
+                           (GDestroyNotify) clutter_actor_box_free);
+
+  g_signal_emit_by_name (scrollable, "predicted-area-changed");
+}
+
+/**
+ * mx_scrollable_get_predicted_area:
+ * @scrollable: A #MxScrollable
+ * @area: (out): location to store the predicted area
+ *
+ * Retrieves the area set with mx_scrollable_set_predicted_area().
+ *
+ * Returns: %TRUE if an area is predicted to become visible, %FALSE
+ *   otherwise
+ *
+ * Since: 1.6
+ */
+gboolean
+mx_scrollable_get_predicted_area (MxScrollable    *scrollable,
+                                  ClutterActorBox *area)
+{
+  ClutterActorBox *predicted;
+
+  g_return_val_if_fail (MX_IS_SCROLLABLE (scrollable), FALSE);
+
+  predicted = g_object_get_qdata (G_OBJECT (scrollable),
+                                  predicted_area_quark);
+  if (!predicted)
+    return FALSE;
+
+  if (area)
+    *area = *predicted;
+
+  return TRUE;
+}
@@ -72,6 +72,11 @@ void mx_scrollable_get_adjustments (MxScrollable  *scrollable,
                                     MxAdjustment **hadjustment,
                                     MxAdjustment **vadjustment);
 
+void     mx_scrollable_set_predicted_area (MxScrollable          *scrollable,
+                                           const ClutterActorBox *area);
+gboolean mx_scrollable_get_predicted_area (MxScrollable          *scrollable,
+                                           ClutterActorBox       *area);
+
 G_END_DECLS
 
 #endif /* __MX_SCROLLABLE_H__ */
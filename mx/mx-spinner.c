@@ -64,7 +64,7 @@ struct _MxSpinnerPrivate
   guint       anim_duration;
 
   guint       current_frame;
-  guint       update_id;
+  guint       transition;
 
   guint       animating : 1;
 };
@@ -115,10 +115,10 @@ mx_spinner_dispose (GObject *object)
 {
   MxSpinnerPrivate *priv = MX_SPINNER (object)->priv;
 
-  if (priv->update_id)
+  if (priv->transition)
     {
-      g_source_remove (priv->update_id);
-      priv->update_id = 0;
+      _mx_transition_stop (priv->transition);
+      priv->transition = 0;
     }
 
   if (priv->material)
@@ -325,21 +325,35 @@ mx_spinner_class_init (MxSpinnerClass *klass)
                   G_TYPE_NONE, 0);
 }
 
+static void
+mx_spinner_frame_cb (gdouble  alpha,
+                     gpointer user_data)
+{
+  MxSpinner *spinner = user_data;
+  MxSpinnerPrivate *priv = spinner->priv;
+  guint frame;
+
+  frame = MIN (priv->frames - 1, (guint)(alpha * priv->frames));
+  if (frame != priv->current_frame)
+    {
+      priv->current_frame = frame;
+      clutter_actor_queue_redraw (CLUTTER_ACTOR (spinner));
+    }
+}
+
 static gboolean
-mx_spinner_timeout_cb (MxSpinner *spinner)
+mx_spinner_loop_cb (gpointer user_data)
 {
+  MxSpinner *spinner = user_data;
   MxSpinnerPrivate *priv = spinner->priv;
 
   /* We may be destroyed during the signal emission, so
    * queue the redraw here instead of below.
    */
+  priv->current_frame = 0;
   clutter_actor_queue_redraw (CLUTTER_ACTOR (spinner));
 
-  if (++priv->current_frame == priv->frames)
-    {
-      priv->current_frame = 0;
-      g_signal_emit (spinner, signals[LOOPED], 0);
-    }
+  g_signal_emit (spinner, signals[LOOPED], 0);
 
   return TRUE;
 }
@@ -349,22 +363,21 @@ mx_spinner_update_timeout (MxSpinner *spinner)
 {
   MxSpinnerPrivate *priv = spinner->priv;
 
-  if (priv->update_id)
+  if (priv->transition)
     {
-      g_source_remove (priv->update_id);
-      priv->update_id = 0;
+      _mx_transition_stop (priv->transition);
+      priv->transition = 0;
     }
 
+  priv->current_frame = 0;
+
   if (priv->animating && priv->frames && priv->material)
-    priv->update_id = clutter_threads_add_timeout_full (CLUTTER_PRIORITY_REDRAW,
-                                                        MAX (1, priv->anim_duration /
-                                                             priv->frames),
-                                                        (GSourceFunc)
-                                                        mx_spinner_timeout_cb,
-                                                        spinner,
-                                                        NULL);
-  else
-    priv->current_frame = 0;
+    priv->transition =
+      _mx_transition_start_stepped (MAX (1, priv->anim_duration),
+                                    priv->frames,
+                                    mx_spinner_frame_cb,
+                                    mx_spinner_loop_cb,
+                                    spinner);
 }
 
 static void
@@ -79,10 +79,12 @@ table_child_set_property (GObject      *gobject,
       break;
     case CHILD_PROP_COLUMN_SPAN:
       child->col_span = g_value_get_int (value);
+      _mx_table_invalidate_cells (table);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
       break;
     case CHILD_PROP_ROW_SPAN:
       child->row_span = g_value_get_int (value);
+      _mx_table_invalidate_cells (table);
       clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
       break;
     case CHILD_PROP_X_EXPAND:
@@ -379,6 +381,7 @@ mx_table_child_set_column_span (MxTable      *table,
 
   meta->col_span = span;
 
+  _mx_table_invalidate_cells (table);
   clutter_actor_queue_relayout (child);
 }
 
@@ -429,6 +432,7 @@ mx_table_child_set_row_span (MxTable      *table,
 
   meta->row_span = span;
 
+  _mx_table_invalidate_cells (table);
   clutter_actor_queue_relayout (child);
 }
 
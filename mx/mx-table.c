@@ -90,6 +90,12 @@ typedef struct
 
 } DimensionData;
 
+typedef struct
+{
+  ClutterActor *actor;
+  MxTableChild *meta;
+} ChildData;
+
 struct _MxTablePrivate
 {
   GList *children;
@@ -111,6 +117,34 @@ struct _MxTablePrivate
   GArray *columns;
   GArray *rows;
 
+  /* ChildData of the children, in the order of the children list */
+  GArray *child_data;
+  guint   child_data_valid : 1;
+
+  /* The column and row sizes requested by the children, before being
+   * distributed in the available space. The row requests depend on the
+   * final column widths they were requested for. */
+  GArray *col_requests;
+  GArray *row_requests;
+  guint   col_requests_valid : 1;
+  guint   row_requests_valid : 1;
+  gint    row_requests_for_width;
+
+  /* The final column widths and row heights are kept for the last size
+   * they were calculated for */
+  guint   columns_valid : 1;
+  guint   rows_valid : 1;
+  gint    columns_for_width;
+  gint    rows_for_width;
+  gint    rows_for_height;
+
+  /* The child occupying each cell, row by row, used to look up the child
+   * at a given position */
+  ClutterActor **cells;
+  gint           cells_rows;
+  gint           cells_cols;
+  guint          cells_valid : 1;
+
   MxFocusable *last_focus;
 };
 
@@ -126,6 +160,108 @@ G_DEFINE_TYPE_WITH_CODE (MxTable, mx_table, MX_TYPE_WIDGET,
                          G_IMPLEMENT_INTERFACE (MX_TYPE_FOCUSABLE,
                                                 mx_focusable_iface_init));
 
+static void
+mx_table_invalidate_dimensions (MxTable *table)
+{
+  MxTablePrivate *priv = table->priv;
+
+  priv->col_requests_valid = FALSE;
+  priv->row_requests_valid = FALSE;
+  priv->columns_valid = FALSE;
+  priv->rows_valid = FALSE;
+}
+
+static void
+mx_table_invalidate_children (MxTable *table)
+{
+  table->priv->child_data_valid = FALSE;
+  table->priv->cells_valid = FALSE;
+
+  mx_table_invalidate_dimensions (table);
+}
+
+static void
+mx_table_queue_relayout_cb (ClutterActor *actor,
+                            gpointer      user_data)
+{
+  mx_table_invalidate_dimensions (MX_TABLE (actor));
+}
+
+static GArray *
+mx_table_get_child_data (MxTable *table)
+{
+  MxTablePrivate *priv = table->priv;
+  GList *l;
+
+  if (priv->child_data_valid)
+    return priv->child_data;
+
+  g_array_set_size (priv->child_data, 0);
+  for (l = priv->children; l; l = g_list_next (l))
+    {
+      ChildData data;
+
+      data.actor = CLUTTER_ACTOR (l->data);
+      data.meta = (MxTableChild *)
+        clutter_container_get_child_meta (CLUTTER_CONTAINER (table),
+                                          data.actor);
+
+      g_array_append_val (priv->child_data, data);
+    }
+
+  priv->child_data_valid = TRUE;
+
+  return priv->child_data;
+}
+
+
+static void
+mx_table_update_cells (MxTable *table)
+{
+  MxTablePrivate *priv = table->priv;
+  GArray *child_data;
+  guint n;
+
+  if (priv->cells_rows != priv->n_rows || priv->cells_cols != priv->n_cols)
+    {
+      g_free (priv->cells);
+      priv->cells = g_new0 (ClutterActor *, priv->n_rows * priv->n_cols);
+      priv->cells_rows = priv->n_rows;
+      priv->cells_cols = priv->n_cols;
+    }
+  else
+    memset (priv->cells, 0,
+            sizeof (ClutterActor *) * priv->n_rows * priv->n_cols);
+
+  /* when children overlap, the first child in the list takes the cell */
+  child_data = mx_table_get_child_data (table);
+  for (n = 0; n < child_data->len; n++)
+    {
+      ChildData *data = &g_array_index (child_data, ChildData, n);
+      gint row, col, last_row, last_col;
+
+      /* clamp the span to the table the same way allocate does, so children
+       * spanning past the last row or column still own the cells they are
+       * allocated over */
+      last_row = MIN (data->meta->row + MAX (data->meta->row_span, 1),
+                      priv->n_rows);
+      last_col = MIN (data->meta->col + MAX (data->meta->col_span, 1),
+                      priv->n_cols);
+
+      for (row = MAX (data->meta->row, 0); row < last_row; row++)
+        {
+          for (col = MAX (data->meta->col, 0); col < last_col; col++)
+            {
+              ClutterActor **cell = &priv->cells[row * priv->n_cols + col];
+
+              if (!*cell)
+                *cell = data->actor;
+            }
+        }
+    }
+
+  priv->cells_valid = TRUE;
+}
 
 static ClutterActor*
 mx_table_find_actor_at (MxTable *table,
@@ -133,24 +269,16 @@ mx_table_find_actor_at (MxTable *table,
                         int      column)
 {
   MxTablePrivate *priv;
-  GList *l;
 
   priv = table->priv;
 
-  for (l = priv->children; l; l = g_list_next (l))
-    {
-      MxTableChild *child;
-      ClutterActor *actor_child = CLUTTER_ACTOR (l->data);
-
-      child = (MxTableChild *) clutter_container_get_child_meta (CLUTTER_CONTAINER (table),
-                                                                 actor_child);
+  if (row < 0 || row >= priv->n_rows || column < 0 || column >= priv->n_cols)
+    return NULL;
 
-      if ((row >= child->row && row <= child->row + (child->row_span - 1)) &&
-          (column >= child->col && column <= child->col + (child->col_span - 1)))
-        return actor_child;
-    }
+  if (!priv->cells_valid)
+    mx_table_update_cells (table);
 
-  return NULL;
+  return priv->cells[row * priv->n_cols + column];
 }
 
 static MxFocusable*
@@ -426,6 +554,7 @@ mx_container_add_actor (ClutterContainer *container,
   clutter_actor_set_parent (actor, CLUTTER_ACTOR (container));
 
   priv->children = g_list_append (priv->children, actor);
+  mx_table_invalidate_children (MX_TABLE (container));
 
   /* default position of the actor is 0, 0 */
   _mx_table_update_row_col (MX_TABLE (container), 0, 0);
@@ -444,7 +573,8 @@ mx_container_remove_actor (ClutterContainer *container,
 
   GList *item = NULL;
   MxTableChild *meta;
-  GList *l;
+  GArray *child_data;
+  guint i;
 
   item = g_list_find (priv->children, actor);
 
@@ -463,15 +593,15 @@ mx_container_remove_actor (ClutterContainer *container,
 
   priv->children = g_list_delete_link (priv->children, item);
   clutter_actor_unparent (actor);
+  mx_table_invalidate_children (MX_TABLE (container));
 
   /* update row/column count */
   rows = 0;
   cols = 0;
-  for (l = priv->children; l; l = l->next)
+  child_data = mx_table_get_child_data (MX_TABLE (container));
+  for (i = 0; i < child_data->len; i++)
     {
-      ClutterActor *child = CLUTTER_ACTOR (l->data);
-      meta = (MxTableChild *) clutter_container_get_child_meta (container,
-                                                                  child);
+      meta = g_array_index (child_data, ChildData, i).meta;
       rows = MAX (rows, meta->row + meta->row_span);
       cols = MAX (cols, meta->col + meta->col_span);
     }
@@ -528,6 +658,7 @@ mx_container_lower (ClutterContainer *container,
 
   priv->children = g_list_delete_link (priv->children, actor_link);
   priv->children = g_list_insert_before (priv->children, position, actor);
+  mx_table_invalidate_children (MX_TABLE (container));
 
   clutter_actor_queue_redraw (CLUTTER_ACTOR (container));
 }
@@ -565,6 +696,7 @@ mx_container_raise (ClutterContainer *container,
 
   priv->children = g_list_delete_link (priv->children, actor_link);
   priv->children = g_list_insert (priv->children, actor, position);
+  mx_table_invalidate_children (MX_TABLE (container));
 
   clutter_actor_queue_redraw (CLUTTER_ACTOR (container));
 }
@@ -590,6 +722,7 @@ mx_container_sort_depth_order (ClutterContainer *container)
   MxTablePrivate *priv = MX_TABLE (container)->priv;
 
   priv->children = g_list_sort (priv->children, mx_table_depth_sort_cb);
+  mx_table_invalidate_children (MX_TABLE (container));
 
   clutter_actor_queue_redraw (CLUTTER_ACTOR (container));
 }
@@ -699,6 +832,10 @@ mx_table_finalize (GObject *gobject)
 
   g_array_free (priv->columns, TRUE);
   g_array_free (priv->rows, TRUE);
+  g_array_free (priv->child_data, TRUE);
+  g_array_free (priv->col_requests, TRUE);
+  g_array_free (priv->row_requests, TRUE);
+  g_free (priv->cells);
 
   G_OBJECT_CLASS (mx_table_parent_class)->finalize (gobject);
 }
@@ -719,24 +856,16 @@ mx_table_dispose (GObject *gobject)
 }
 
 static void
-mx_table_calculate_col_widths (MxTable *table,
-                               gint     for_width)
+mx_table_request_col_widths (MxTable *table)
 {
-  gint i;
   MxTablePrivate *priv = table->priv;
   DimensionData *columns;
-  GList *l;
-  MxPadding padding;
+  GArray *child_data;
+  guint n;
+  gint i;
 
-  g_array_set_size (priv->columns, 0);
-  g_array_set_size (priv->columns, priv->n_cols);
   columns = &g_array_index (priv->columns, DimensionData, 0);
-
-
-  /* take off the padding values to calculate the allocatable width */
-  mx_widget_get_padding (MX_WIDGET (table), &padding);
-
-  for_width -= (int)(padding.left + padding.right);
+  child_data = mx_table_get_child_data (table);
 
   /* Reset all the visible attributes for the columns */
   priv->visible_cols = 0;
@@ -744,20 +873,19 @@ mx_table_calculate_col_widths (MxTable *table,
     columns[i].is_visible = FALSE;
 
   /* STAGE ONE: calculate column widths for non-spanned children */
-  for (l = priv->children; l; l = g_list_next (l))
+  for (n = 0; n < child_data->len; n++)
     {
       MxTableChild *meta;
       ClutterActor *child;
       DimensionData *col;
       gfloat c_min, c_pref;
 
-      child = CLUTTER_ACTOR (l->data);
+      child = g_array_index (child_data, ChildData, n).actor;
 
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
-      meta = (MxTableChild *)
-        clutter_container_get_child_meta (CLUTTER_CONTAINER (table), child);
+      meta = g_array_index (child_data, ChildData, n).meta;
 
       if (meta->col_span > 1)
         continue;
@@ -779,7 +907,7 @@ mx_table_calculate_col_widths (MxTable *table,
     }
 
   /* STAGE TWO: take spanning children into account */
-  for (l = priv->children; l; l = g_list_next (l))
+  for (n = 0; n < child_data->len; n++)
     {
       MxTableChild *meta;
       ClutterActor *child;
@@ -788,13 +916,12 @@ mx_table_calculate_col_widths (MxTable *table,
       gint start_col, end_col;
       gint n_expand;
 
-      child = CLUTTER_ACTOR (l->data);
+      child = g_array_index (child_data, ChildData, n).actor;
 
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
-      meta = (MxTableChild *)
-        clutter_container_get_child_meta (CLUTTER_CONTAINER (table), child);
+      meta = g_array_index (child_data, ChildData, n).meta;
 
       if (meta->col_span < 2)
         continue;
@@ -891,7 +1018,49 @@ mx_table_calculate_col_widths (MxTable *table,
 
 
     }
+}
+
+static void
+mx_table_calculate_col_widths (MxTable *table,
+                               gint     for_width)
+{
+  gint i;
+  MxTablePrivate *priv = table->priv;
+  DimensionData *columns;
+  MxPadding padding;
+
+  if (priv->columns_valid && priv->columns_for_width == for_width)
+    return;
+
+  g_array_set_size (priv->columns, 0);
+
+  if (priv->col_requests_valid)
+    {
+      g_array_append_vals (priv->columns, priv->col_requests->data,
+                           priv->col_requests->len);
+    }
+  else
+    {
+      g_array_set_size (priv->columns, priv->n_cols);
+      mx_table_request_col_widths (table);
+
+      /* keep the requests, so that other widths don't need to query the
+       * children again */
+      g_array_set_size (priv->col_requests, 0);
+      g_array_append_vals (priv->col_requests, priv->columns->data,
+                           priv->columns->len);
+      priv->col_requests_valid = TRUE;
+    }
+
+  priv->columns_valid = TRUE;
+  priv->columns_for_width = for_width;
+
+  columns = &g_array_index (priv->columns, DimensionData, 0);
+
+  /* take off the padding values to calculate the allocatable width */
+  mx_widget_get_padding (MX_WIDGET (table), &padding);
 
+  for_width -= (int)(padding.left + padding.right);
 
   /* calculate final widths */
   if (for_width >= 0)
@@ -1005,25 +1174,17 @@ mx_table_calculate_col_widths (MxTable *table,
 }
 
 static void
-mx_table_calculate_row_heights (MxTable *table,
-                                gint     for_height)
+mx_table_request_row_heights (MxTable *table)
 {
-  MxTablePrivate *priv = MX_TABLE (table)->priv;
-  GList *l;
-  gint i;
+  MxTablePrivate *priv = table->priv;
   DimensionData *rows, *columns;
-  MxPadding padding;
-
-  mx_widget_get_padding (MX_WIDGET (table), &padding);
-
-  /* take padding off available height */
-  for_height -= (int)(padding.top + padding.bottom);
+  GArray *child_data;
+  guint n;
+  gint i;
 
-  g_array_set_size (priv->rows, 0);
-  g_array_set_size (priv->rows, priv->n_rows);
   rows = &g_array_index (priv->rows, DimensionData, 0);
-
   columns = &g_array_index (priv->columns, DimensionData, 0);
+  child_data = mx_table_get_child_data (table);
 
   /* Reset the visible rows */
   priv->visible_rows = 0;
@@ -1031,20 +1192,19 @@ mx_table_calculate_row_heights (MxTable *table,
     rows[i].is_visible = FALSE;
 
   /* STAGE ONE: calculate row heights for non-spanned children */
-  for (l = priv->children; l; l = g_list_next (l))
+  for (n = 0; n < child_data->len; n++)
     {
       MxTableChild *meta;
       ClutterActor *child;
       DimensionData *row;
       gfloat c_min, c_pref;
 
-      child = CLUTTER_ACTOR (l->data);
+      child = g_array_index (child_data, ChildData, n).actor;
 
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
-      meta = (MxTableChild *)
-        clutter_container_get_child_meta (CLUTTER_CONTAINER (table), child);
+      meta = g_array_index (child_data, ChildData, n).meta;
 
       if (meta->row_span > 1)
         continue;
@@ -1069,7 +1229,7 @@ mx_table_calculate_row_heights (MxTable *table,
 
 
   /* STAGE TWO: take spanning children into account */
-  for (l = priv->children; l; l = g_list_next (l))
+  for (n = 0; n < child_data->len; n++)
     {
       MxTableChild *meta;
       ClutterActor *child;
@@ -1078,13 +1238,12 @@ mx_table_calculate_row_heights (MxTable *table,
       gint start_row, end_row;
       gint n_expand;
 
-      child = CLUTTER_ACTOR (l->data);
+      child = g_array_index (child_data, ChildData, n).actor;
 
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
-      meta = (MxTableChild *)
-        clutter_container_get_child_meta (CLUTTER_CONTAINER (table), child);
+      meta = g_array_index (child_data, ChildData, n).meta;
 
       if (meta->row_span < 2)
         continue;
@@ -1190,7 +1349,54 @@ mx_table_calculate_row_heights (MxTable *table,
         }
 
     }
+}
+
+static void
+mx_table_calculate_row_heights (MxTable *table,
+                                gint     for_height)
+{
+  MxTablePrivate *priv = MX_TABLE (table)->priv;
+  gint i;
+  DimensionData *rows;
+  MxPadding padding;
+
+  /* the row heights depend on the column widths, as the children are asked
+   * for their height for the width of their column */
+  if (priv->rows_valid
+      && priv->rows_for_height == for_height
+      && priv->rows_for_width == priv->columns_for_width)
+    return;
+
+  g_array_set_size (priv->rows, 0);
+
+  if (priv->row_requests_valid
+      && priv->row_requests_for_width == priv->columns_for_width)
+    {
+      g_array_append_vals (priv->rows, priv->row_requests->data,
+                           priv->row_requests->len);
+    }
+  else
+    {
+      g_array_set_size (priv->rows, priv->n_rows);
+      mx_table_request_row_heights (table);
+
+      g_array_set_size (priv->row_requests, 0);
+      g_array_append_vals (priv->row_requests, priv->rows->data,
+                           priv->rows->len);
+      priv->row_requests_valid = TRUE;
+      priv->row_requests_for_width = priv->columns_for_width;
+    }
+
+  priv->rows_valid = TRUE;
+  priv->rows_for_width = priv->columns_for_width;
+  priv->rows_for_height = for_height;
+
+  rows = &g_array_index (priv->rows, DimensionData, 0);
 
+  mx_widget_get_padding (MX_WIDGET (table), &padding);
+
+  /* take padding off available height */
+  for_height -= (int)(padding.top + padding.bottom);
 
   /* calculate final heights */
   if (for_height >= 0)
@@ -1317,7 +1523,8 @@ mx_table_preferred_allocate (ClutterActor          *self,
                              const ClutterActorBox *box,
                              gboolean               flags)
 {
-  GList *list;
+  GArray *child_data;
+  guint n;
   gint row_spacing, col_spacing;
   gint i;
   MxTable *table;
@@ -1338,7 +1545,9 @@ mx_table_preferred_allocate (ClutterActor          *self,
   rows = &g_array_index (priv->rows, DimensionData, 0);
   columns = &g_array_index (priv->columns, DimensionData, 0);
 
-  for (list = priv->children; list; list = g_list_next (list))
+  child_data = mx_table_get_child_data (table);
+
+  for (n = 0; n < child_data->len; n++)
     {
       gint row, col, row_span, col_span;
       gint col_width, row_height;
@@ -1350,9 +1559,8 @@ mx_table_preferred_allocate (ClutterActor          *self,
       gboolean x_fill, y_fill;
       MxAlign x_align, y_align;
 
-      child = CLUTTER_ACTOR (list->data);
-
-      meta = (MxTableChild *) clutter_container_get_child_meta (CLUTTER_CONTAINER (self), child);
+      child = g_array_index (child_data, ChildData, n).actor;
+      meta = g_array_index (child_data, ChildData, n).meta;
 
       if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
@@ -1741,8 +1949,19 @@ mx_table_init (MxTable *table)
   table->priv->columns = g_array_new (FALSE, TRUE, sizeof (DimensionData));
   table->priv->rows = g_array_new (FALSE, TRUE, sizeof (DimensionData));
 
+  table->priv->child_data = g_array_new (FALSE, FALSE, sizeof (ChildData));
+  table->priv->col_requests =
+    g_array_new (FALSE, FALSE, sizeof (DimensionData));
+  table->priv->row_requests =
+    g_array_new (FALSE, FALSE, sizeof (DimensionData));
+
   g_signal_connect (table, "style-changed",
                     G_CALLBACK (mx_table_style_changed), NULL);
+
+  /* any change to the children, their child properties, the spacing or the
+   * padding queues a relayout */
+  g_signal_connect (table, "queue-relayout",
+                    G_CALLBACK (mx_table_queue_relayout_cb), NULL);
 }
 
 /* used by MxTableChild to update row/column count */
@@ -1756,6 +1975,15 @@ void _mx_table_update_row_col (MxTable *table,
   if (row > -1)
     table->priv->n_rows = MAX (table->priv->n_rows, row + 1);
 
+  table->priv->cells_valid = FALSE;
+  mx_table_invalidate_dimensions (table);
+}
+
+/* used by MxTableChild when the span of a child changes */
+void
+_mx_table_invalidate_cells (MxTable *table)
+{
+  table->priv->cells_valid = FALSE;
 }
 
 /*** Public Functions ***/
@@ -1913,6 +2141,78 @@ mx_table_add_actor (MxTable      *table,
   clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
 }
 
+/**
+ * mx_table_add_actors:
+ * @table: a #MxTable
+ * @actors: (element-type ClutterActor): the actors to add
+ * @row: the row of the first actor
+ * @column: the column of the first actor
+ * @n_columns: the number of columns to fill on each row
+ *
+ * Adds all the actors in @actors to @table, filling @n_columns cells of
+ * each row from @column, starting at @row. This is the same as calling
+ * mx_table_add_actor() for each actor, but the children list is only
+ * walked once, and the layout is only invalidated once for all the actors.
+ *
+ * Since: 1.6
+ */
+void
+mx_table_add_actors (MxTable *table,
+                     GList   *actors,
+                     gint     row,
+                     gint     column,
+                     gint     n_columns)
+{
+  ClutterContainer *container;
+  MxTablePrivate *priv;
+  GList *l, *new_children;
+  gint i;
+
+  g_return_if_fail (MX_IS_TABLE (table));
+  g_return_if_fail (row >= 0);
+  g_return_if_fail (column >= 0);
+  g_return_if_fail (n_columns > 0);
+
+  if (!actors)
+    return;
+
+  /* Check all the actors first, so that nothing is added on failure */
+  if (!_mx_check_new_children (actors))
+    return;
+
+  priv = table->priv;
+  container = CLUTTER_CONTAINER (table);
+
+  new_children = NULL;
+  for (l = actors, i = 0; l; l = l->next, i++)
+    {
+      ClutterActor *actor = l->data;
+      MxTableChild *meta;
+
+      clutter_container_create_child_meta (container, actor);
+      clutter_actor_set_parent (actor, CLUTTER_ACTOR (table));
+
+      meta = (MxTableChild *) clutter_container_get_child_meta (container,
+                                                                actor);
+      meta->row = row + i / n_columns;
+      meta->col = column + i % n_columns;
+
+      new_children = g_list_prepend (new_children, actor);
+    }
+
+  priv->children = g_list_concat (priv->children,
+                                  g_list_reverse (new_children));
+  mx_table_invalidate_children (table);
+
+  _mx_table_update_row_col (table, row + (i - 1) / n_columns,
+                            column + MIN (i, n_columns) - 1);
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (table));
+
+  for (l = actors; l; l = l->next)
+    g_signal_emit_by_name (table, "actor-added", l->data);
+}
+
 /**
  * mx_table_add_actor_with_properties
  * @table: a #MxTable
@@ -96,6 +96,12 @@ void mx_table_add_actor_with_properties (MxTable      *table,
                                          const gchar  *first_property_name,
                                          ...);
 
+void mx_table_add_actors (MxTable *table,
+                          GList   *actors,
+                          gint     row,
+                          gint     column,
+                          gint     n_columns);
+
 gint mx_table_get_row_count    (MxTable *table);
 gint mx_table_get_column_count (MxTable *table);
 
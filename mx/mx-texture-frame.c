@@ -54,6 +54,34 @@ G_DEFINE_TYPE (MxTextureFrame, mx_texture_frame, CLUTTER_TYPE_ACTOR);
 
 #define MX_TEXTURE_FRAME_GET_PRIVATE(obj)     (G_TYPE_INSTANCE_GET_PRIVATE ((obj), MX_TYPE_TEXTURE_FRAME, MxTextureFramePrivate))
 
+/* The parameters the geometry of a frame depends on */
+typedef struct
+{
+  gfloat tex_width;
+  gfloat tex_height;
+
+  gfloat top;
+  gfloat right;
+  gfloat bottom;
+  gfloat left;
+
+  gfloat width;
+  gfloat height;
+} MxTextureFrameKey;
+
+/* The rectangles and texture coordinates of the nine slices, in the format
+ * cogl_rectangles_with_texture_coords() takes. They are shared between all
+ * the frames with the same key.
+ */
+typedef struct
+{
+  MxTextureFrameKey key;
+  gint              ref_count;
+
+  gint              n_rectangles;
+  gfloat            rectangles[9 * 8];
+} MxTextureFrameGeometry;
+
 struct _MxTextureFramePrivate
 {
   ClutterTexture *parent_texture;
@@ -62,8 +90,183 @@ struct _MxTextureFramePrivate
   gfloat          right;
   gfloat          bottom;
   gfloat          left;
+
+  MxTextureFrameGeometry *geometry;
 };
 
+static GHashTable *mx_texture_frame_geometries = NULL;
+
+static guint
+mx_texture_frame_key_hash (gconstpointer data)
+{
+  const MxTextureFrameKey *key = data;
+
+  return ((guint) key->width) ^ (((guint) key->height) << 16) ^
+         (((guint) key->tex_width) << 8) ^ (((guint) key->tex_height) << 24) ^
+         ((guint) (key->top + key->bottom) << 4) ^
+         ((guint) (key->left + key->right) << 12);
+}
+
+static gboolean
+mx_texture_frame_key_equal (gconstpointer a,
+                            gconstpointer b)
+{
+  const MxTextureFrameKey *key_a = a;
+  const MxTextureFrameKey *key_b = b;
+
+  return (key_a->tex_width == key_b->tex_width &&
+          key_a->tex_height == key_b->tex_height &&
+          key_a->top == key_b->top &&
+          key_a->right == key_b->right &&
+          key_a->bottom == key_b->bottom &&
+          key_a->left == key_b->left &&
+          key_a->width == key_b->width &&
+          key_a->height == key_b->height);
+}
+
+static void
+mx_texture_frame_geometry_add (MxTextureFrameGeometry *geometry,
+                               gfloat                  x1,
+                               gfloat                  y1,
+                               gfloat                  x2,
+                               gfloat                  y2,
+                               gfloat                  tx1,
+                               gfloat                  ty1,
+                               gfloat                  tx2,
+                               gfloat                  ty2)
+{
+  gfloat *rectangle;
+
+  /* Leave out the slices of borders with no width */
+  if (x1 >= x2 || y1 >= y2)
+    return;
+
+  rectangle = geometry->rectangles + geometry->n_rectangles * 8;
+  rectangle[0] = x1;
+  rectangle[1] = y1;
+  rectangle[2] = x2;
+  rectangle[3] = y2;
+  rectangle[4] = tx1;
+  rectangle[5] = ty1;
+  rectangle[6] = tx2;
+  rectangle[7] = ty2;
+
+  geometry->n_rectangles ++;
+}
+
+static MxTextureFrameGeometry *
+mx_texture_frame_geometry_get (const MxTextureFrameKey *key)
+{
+  MxTextureFrameGeometry *geometry;
+  gfloat ex, ey, right, bottom;
+  gfloat tx1, ty1, tx2, ty2;
+
+  if (G_UNLIKELY (!mx_texture_frame_geometries))
+    mx_texture_frame_geometries =
+      g_hash_table_new (mx_texture_frame_key_hash,
+                        mx_texture_frame_key_equal);
+
+  geometry = g_hash_table_lookup (mx_texture_frame_geometries, key);
+  if (geometry)
+    {
+      geometry->ref_count ++;
+      return geometry;
+    }
+
+  geometry = g_slice_new (MxTextureFrameGeometry);
+  geometry->key = *key;
+  geometry->ref_count = 1;
+  geometry->n_rectangles = 0;
+
+  tx1 = key->left / key->tex_width;
+  tx2 = (key->tex_width - key->right) / key->tex_width;
+  ty1 = key->top / key->tex_height;
+  ty2 = (key->tex_height - key->bottom) / key->tex_height;
+
+  ex = key->width - key->right;
+  if (ex < key->left)
+    ex = key->left;
+
+  ey = key->height - key->bottom;
+  if (ey < key->top)
+    ey = key->top;
+
+  right = MAX (ex + key->right, key->width);
+  bottom = MAX (ey + key->bottom, key->height);
+
+  /* top left corner */
+  mx_texture_frame_geometry_add (geometry,
+                                 0, 0, key->left, key->top,
+                                 0.0, 0.0, tx1, ty1);
+  /* top middle */
+  mx_texture_frame_geometry_add (geometry,
+                                 key->left, 0, MAX (key->left, ex), key->top,
+                                 tx1, 0.0, tx2, ty1);
+  /* top right */
+  mx_texture_frame_geometry_add (geometry,
+                                 ex, 0, right, key->top,
+                                 tx2, 0.0, 1.0, ty1);
+  /* mid left */
+  mx_texture_frame_geometry_add (geometry,
+                                 0, key->top, key->left, ey,
+                                 0.0, ty1, tx1, ty2);
+  /* center */
+  mx_texture_frame_geometry_add (geometry,
+                                 key->left, key->top, ex, ey,
+                                 tx1, ty1, tx2, ty2);
+  /* mid right */
+  mx_texture_frame_geometry_add (geometry,
+                                 ex, key->top, right, ey,
+                                 tx2, ty1, 1.0, ty2);
+  /* bottom left */
+  mx_texture_frame_geometry_add (geometry,
+                                 0, ey, key->left, bottom,
+                                 0.0, ty2, tx1, 1.0);
+  /* bottom center */
+  mx_texture_frame_geometry_add (geometry,
+                                 key->left, ey, ex, bottom,
+                                 tx1, ty2, tx2, 1.0);
+  /* bottom right */
+  mx_texture_frame_geometry_add (geometry,
+                                 ex, ey, right, bottom,
+                                 tx2, ty2, 1.0, 1.0);
+
+  g_hash_table_insert (mx_texture_frame_geometries, &geometry->key, geometry);
+
+  return geometry;
+}
+
+static void
+mx_texture_frame_geometry_unref (MxTextureFrameGeometry *geometry)
+{
+  if (--geometry->ref_count > 0)
+    return;
+
+  g_hash_table_remove (mx_texture_frame_geometries, &geometry->key);
+  g_slice_free (MxTextureFrameGeometry, geometry);
+}
+
+static void
+mx_texture_frame_invalidate_geometry (MxTextureFrame *frame)
+{
+  MxTextureFramePrivate *priv = frame->priv;
+
+  if (priv->geometry)
+    {
+      mx_texture_frame_geometry_unref (priv->geometry);
+      priv->geometry = NULL;
+    }
+}
+
+static void
+mx_texture_frame_size_change_cb (ClutterTexture *texture,
+                                 gint            width,
+                                 gint            height,
+                                 MxTextureFrame *frame)
+{
+  mx_texture_frame_invalidate_geometry (frame);
+}
+
 static void
 mx_texture_frame_get_preferred_width (ClutterActor *self,
                                       gfloat        for_height,
@@ -130,6 +333,23 @@ mx_texture_frame_get_preferred_height (ClutterActor *self,
     }
 }
 
+static void
+mx_texture_frame_allocate (ClutterActor           *self,
+                           const ClutterActorBox  *box,
+                           ClutterAllocationFlags  flags)
+{
+  MxTextureFramePrivate *priv = MX_TEXTURE_FRAME (self)->priv;
+
+  if (priv->geometry &&
+      ((priv->geometry->key.width != box->x2 - box->x1) ||
+       (priv->geometry->key.height != box->y2 - box->y1)))
+    mx_texture_frame_invalidate_geometry (MX_TEXTURE_FRAME (self));
+
+  CLUTTER_ACTOR_CLASS (mx_texture_frame_parent_class)->allocate (self,
+                                                                 box,
+                                                                 flags);
+}
+
 static void
 mx_texture_frame_paint (ClutterActor *self)
 {
@@ -137,10 +357,6 @@ mx_texture_frame_paint (ClutterActor *self)
   CoglHandle cogl_texture = COGL_INVALID_HANDLE;
   CoglHandle cogl_material = COGL_INVALID_HANDLE;
   ClutterActorBox box = { 0, };
-  gfloat width, height;
-  gfloat tex_width, tex_height;
-  gfloat ex, ey;
-  gfloat tx1, ty1, tx2, ty2;
   guint8 opacity;
 
   /* no need to paint stuff if we don't have a texture */
@@ -160,14 +376,6 @@ mx_texture_frame_paint (ClutterActor *self)
   if (cogl_material == COGL_INVALID_HANDLE)
     return;
 
-  tex_width  = cogl_texture_get_width (cogl_texture);
-  tex_height = cogl_texture_get_height (cogl_texture);
-
-  clutter_actor_get_allocation_box (self, &box);
-  width = box.x2 - box.x1;
-  height = box.y2 - box.y1;
-
-
   opacity = clutter_actor_get_paint_opacity (self);
 
   /* Paint using the parent texture's material. It should already have
@@ -181,84 +389,37 @@ mx_texture_frame_paint (ClutterActor *self)
   if (priv->left == 0 && priv->right == 0 && priv->top == 0
       && priv->bottom == 0)
     {
-      cogl_rectangle (0, 0, width, height);
+      clutter_actor_get_allocation_box (self, &box);
+      cogl_rectangle (0, 0, box.x2 - box.x1, box.y2 - box.y1);
       return;
     }
 
-  tx1 = priv->left / tex_width;
-  tx2 = (tex_width - priv->right) / tex_width;
-  ty1 = priv->top / tex_height;
-  ty2 = (tex_height - priv->bottom) / tex_height;
+  /* The slices only change with the allocation, the borders and the size
+   * of the texture, so they're kept until one of those changes.
+   */
+  if (!priv->geometry)
+    {
+      MxTextureFrameKey key;
 
-  ex = width - priv->right;
-  if (ex < priv->left)
-    ex = priv->left;
+      clutter_actor_get_allocation_box (self, &box);
 
-  ey = height - priv->bottom;
-  if (ey < priv->top)
-    ey = priv->top;
+      key.tex_width = cogl_texture_get_width (cogl_texture);
+      key.tex_height = cogl_texture_get_height (cogl_texture);
+      key.top = priv->top;
+      key.right = priv->right;
+      key.bottom = priv->bottom;
+      key.left = priv->left;
+      key.width = box.x2 - box.x1;
+      key.height = box.y2 - box.y1;
 
+      priv->geometry = mx_texture_frame_geometry_get (&key);
+    }
 
-  {
-    GLfloat rectangles[] =
-    {
-      /* top left corner */
-      0, 0,
-      priv->left, priv->top,
-      0.0, 0.0,
-      tx1, ty1,
-
-      /* top middle */
-      priv->left, 0,
-      MAX (priv->left, ex), priv->top,
-      tx1, 0.0,
-      tx2, ty1,
-
-      /* top right */
-      ex, 0,
-      MAX (ex + priv->right, width), priv->top,
-      tx2, 0.0,
-      1.0, ty1,
-
-      /* mid left */
-      0, priv->top,
-      priv->left,  ey,
-      0.0, ty1,
-      tx1, ty2,
-
-      /* center */
-      priv->left, priv->top,
-      ex, ey,
-      tx1, ty1,
-      tx2, ty2,
-
-      /* mid right */
-      ex, priv->top,
-      MAX (ex + priv->right, width), ey,
-      tx2, ty1,
-      1.0, ty2,
-
-      /* bottom left */
-      0, ey,
-      priv->left, MAX (ey + priv->bottom, height),
-      0.0, ty2,
-      tx1, 1.0,
-
-      /* bottom center */
-      priv->left, ey,
-      ex, MAX (ey + priv->bottom, height),
-      tx1, ty2,
-      tx2, 1.0,
-
-      /* bottom right */
-      ex, ey,
-      MAX (ex + priv->right, width), MAX (ey + priv->bottom, height),
-      tx2, ty2,
-      1.0, 1.0
-    };
-
-    cogl_rectangles_with_texture_coords (rectangles, 9);
-  }
+  /* Drawing rectangles rather than a vertex buffer lets the journal batch
+   * frames that share a material.
+   */
+  cogl_rectangles_with_texture_coords (priv->geometry->rectangles,
+                                       priv->geometry->n_rectangles);
 }
 
 static inline void
@@ -302,8 +463,13 @@ mx_texture_frame_set_frame_internal (MxTextureFrame *frame,
       changed = TRUE;
     }
 
-  if (changed && CLUTTER_ACTOR_IS_VISIBLE (frame))
-    clutter_actor_queue_redraw (CLUTTER_ACTOR (frame));
+  if (changed)
+    {
+      mx_texture_frame_invalidate_geometry (frame);
+
+      if (CLUTTER_ACTOR_IS_VISIBLE (frame))
+        clutter_actor_queue_redraw (CLUTTER_ACTOR (frame));
+    }
 
   g_object_thaw_notify (gobject);
 }
@@ -405,10 +571,15 @@ mx_texture_frame_dispose (GObject *gobject)
 
   if (priv->parent_texture)
     {
+      g_signal_handlers_disconnect_by_func (priv->parent_texture,
+                                            mx_texture_frame_size_change_cb,
+                                            gobject);
       g_object_unref (priv->parent_texture);
       priv->parent_texture = NULL;
     }
 
+  mx_texture_frame_invalidate_geometry (MX_TEXTURE_FRAME (gobject));
+
   G_OBJECT_CLASS (mx_texture_frame_parent_class)->dispose (gobject);
 }
 
@@ -435,6 +606,7 @@ mx_texture_frame_class_init (MxTextureFrameClass *klass)
     mx_texture_frame_get_preferred_width;
   actor_class->get_preferred_height =
     mx_texture_frame_get_preferred_height;
+  actor_class->allocate = mx_texture_frame_allocate;
   actor_class->paint = mx_texture_frame_paint;
   actor_class->get_paint_volume = mx_texture_frame_get_paint_volume;
 
@@ -569,8 +741,13 @@ mx_texture_frame_set_parent_texture (MxTextureFrame *frame,
   if (priv->parent_texture == texture)
     return;
 
+  mx_texture_frame_invalidate_geometry (frame);
+
   if (priv->parent_texture)
     {
+      g_signal_handlers_disconnect_by_func (priv->parent_texture,
+                                            mx_texture_frame_size_change_cb,
+                                            frame);
       g_object_unref (priv->parent_texture);
       priv->parent_texture = NULL;
 
@@ -583,6 +760,8 @@ mx_texture_frame_set_parent_texture (MxTextureFrame *frame,
       CoglHandle cogl_material = COGL_INVALID_HANDLE;
 
       priv->parent_texture = g_object_ref_sink (texture);
+      g_signal_connect (priv->parent_texture, "size-change",
+                        G_CALLBACK (mx_texture_frame_size_change_cb), frame);
 
       if (was_visible && CLUTTER_ACTOR_IS_VISIBLE (priv->parent_texture))
         clutter_actor_show (CLUTTER_ACTOR (frame));
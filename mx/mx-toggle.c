@@ -141,7 +141,9 @@ struct _MxTogglePrivate
   gchar        *handle_filename;
 
 
-  ClutterAlpha *alpha;
+  guint         transition;
+  gfloat        start_position;
+  gfloat        end_position;
   gfloat        position;
 
   gfloat        drag_offset;
@@ -210,6 +212,12 @@ mx_toggle_dispose (GObject *object)
 {
   MxTogglePrivate *priv = MX_TOGGLE (object)->priv;
 
+  if (priv->transition)
+    {
+      _mx_transition_stop (priv->transition);
+      priv->transition = 0;
+    }
+
   if (priv->handle)
     {
       clutter_actor_destroy (priv->handle);
@@ -484,17 +492,26 @@ mx_toggle_class_init (MxToggleClass *klass)
 }
 
 static void
-mx_toggle_update_position (ClutterTimeline *timeline,
-                           gint             msecs,
-                           MxToggle        *toggle)
+mx_toggle_update_position (gdouble  alpha,
+                           gpointer user_data)
 {
+  MxToggle *toggle = user_data;
   MxTogglePrivate *priv = toggle->priv;
 
-  priv->position = clutter_alpha_get_alpha (priv->alpha);
+  priv->position = priv->start_position +
+    (priv->end_position - priv->start_position) * alpha;
 
   clutter_actor_queue_relayout (CLUTTER_ACTOR (toggle));
 }
 
+static gboolean
+mx_toggle_transition_done (gpointer user_data)
+{
+  MX_TOGGLE (user_data)->priv->transition = 0;
+
+  return FALSE;
+}
+
 static void
 mx_toggle_style_changed (MxToggle *toggle)
 {
@@ -504,21 +521,12 @@ mx_toggle_style_changed (MxToggle *toggle)
 static void
 mx_toggle_init (MxToggle *self)
 {
-  ClutterTimeline *timeline;
-
   self->priv = TOGGLE_PRIVATE (self);
 
   self->priv->handle = g_object_new (MX_TYPE_TOGGLE_HANDLE,
                                      "reactive", TRUE, NULL);
   clutter_actor_set_parent (self->priv->handle, CLUTTER_ACTOR (self));
 
-  timeline = clutter_timeline_new (300);
-  g_signal_connect (timeline, "new-frame",
-                    G_CALLBACK (mx_toggle_update_position), self);
-
-  self->priv->alpha = clutter_alpha_new_full (timeline,
-                                              CLUTTER_EASE_IN_OUT_CUBIC);
-
   clutter_actor_set_reactive (CLUTTER_ACTOR (self), TRUE);
   clutter_actor_set_reactive (CLUTTER_ACTOR (self->priv->handle), TRUE);
 
@@ -554,8 +562,6 @@ mx_toggle_set_active (MxToggle *toggle,
   if (priv->active != active
       || (priv->position > 0 && priv->position < 1))
     {
-      ClutterTimeline *timeline;
-
       priv->active = active;
 
       if (active)
@@ -573,29 +579,32 @@ mx_toggle_set_active (MxToggle *toggle,
           return;
         }
 
-      timeline = clutter_alpha_get_timeline (priv->alpha);
-
-      if (clutter_timeline_is_playing (timeline))
+      if (priv->transition)
         return;
 
-      if (active)
-        clutter_timeline_set_direction (timeline, CLUTTER_TIMELINE_FORWARD);
-      else
-        clutter_timeline_set_direction (timeline, CLUTTER_TIMELINE_BACKWARD);
-
-      clutter_timeline_rewind (timeline);
+      priv->end_position = (active) ? 1 : 0;
 
+      /* after a drag, slide linearly on from where the handle was let go */
       if (priv->drag_offset > -1)
         {
-          clutter_alpha_set_mode (priv->alpha, CLUTTER_LINEAR);
-          clutter_timeline_advance (timeline, priv->position * 300);
+          priv->start_position = priv->position;
+          priv->transition =
+            _mx_transition_start (ABS (priv->end_position -
+                                       priv->start_position) * 300,
+                                  CLUTTER_LINEAR,
+                                  mx_toggle_update_position,
+                                  mx_toggle_transition_done,
+                                  toggle);
         }
       else
         {
-          clutter_alpha_set_mode (priv->alpha, CLUTTER_EASE_IN_OUT_CUBIC);
+          priv->start_position = 1 - priv->end_position;
+          priv->transition =
+            _mx_transition_start (300, CLUTTER_EASE_IN_OUT_CUBIC,
+                                  mx_toggle_update_position,
+                                  mx_toggle_transition_done,
+                                  toggle);
         }
-
-      clutter_timeline_start (timeline);
     }
 }
 
@@ -0,0 +1,527 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+/*
+ * mx-transition.c: Transitions driven by a shared frame clock
+ *
+ * Copyright 2011 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Widget transitions are short and numerous, so rather than running a
+ * ClutterTimeline (and its signal emissions) for each of them, they are
+ * kept in a single array and advanced together from the new-frame signal
+ * of one looping timeline. The timeline only runs while there are active
+ * transitions.
+ *
+ * Stepped transitions, such as the frames of a spinner, only change a few
+ * times a second. When they are the only active transitions, the timeline
+ * is stopped and a timeout advances them at their next step instead.
+ */
+
+#include <math.h>
+
+#include "mx-private.h"
+
+typedef struct
+{
+  guint                 id;
+  guint                 duration;
+  guint                 n_steps;
+  gulong                mode;
+  gdouble               elapsed;
+
+  MxTransitionFunc      frame_func;
+  MxTransitionDoneFunc  done_func;
+  gpointer              user_data;
+} MxTransition;
+
+static GArray *transitions = NULL;
+static ClutterTimeline *transition_clock = NULL;
+static guint transition_step_source = 0;
+static gint64 transition_last_time = 0;
+static guint transition_last_id = 0;
+
+static void mx_transition_schedule (void);
+
+static void
+mx_transition_tick (void)
+{
+  guint i, j, n_transitions;
+  gint64 now;
+  gdouble delta;
+
+  now = g_get_monotonic_time ();
+  delta = (now - transition_last_time) / 1000.0;
+  transition_last_time = now;
+
+  /* Transitions started during this loop are appended to the array and
+   * only advanced from the next frame. Stopped transitions are marked with
+   * an id of 0 and removed afterwards, so the indices stay valid while the
+   * callbacks run. The array may be reallocated by the callbacks, so the
+   * entries are looked up again after each of them.
+   */
+  n_transitions = transitions->len;
+  for (i = 0; i < n_transitions; i++)
+    {
+      MxTransition *transition;
+      MxTransitionFunc frame_func;
+      MxTransitionDoneFunc done_func;
+      gpointer user_data;
+      gdouble progress;
+      gboolean repeat;
+      guint id;
+
+      transition = &g_array_index (transitions, MxTransition, i);
+      if (!transition->id)
+        continue;
+
+      transition->elapsed += delta;
+
+      id = transition->id;
+      frame_func = transition->frame_func;
+      done_func = transition->done_func;
+      user_data = transition->user_data;
+
+      if (transition->duration)
+        progress = MIN (1.0, transition->elapsed / transition->duration);
+      else
+        progress = 1.0;
+
+      if (frame_func)
+        frame_func (_mx_transition_ease (transition->mode, progress),
+                    user_data);
+
+      if (progress < 1.0)
+        continue;
+
+      transition = &g_array_index (transitions, MxTransition, i);
+      if (transition->id != id)
+        continue;
+
+      repeat = done_func ? done_func (user_data) : FALSE;
+
+      transition = &g_array_index (transitions, MxTransition, i);
+      if (transition->id != id)
+        continue;
+
+      if (repeat && transition->duration)
+        transition->elapsed = fmod (transition->elapsed,
+                                    transition->duration);
+      else
+        transition->id = 0;
+    }
+
+  /* Remove the transitions that have finished or were stopped */
+  for (i = 0, j = 0; i < transitions->len; i++)
+    {
+      MxTransition *transition = &g_array_index (transitions, MxTransition, i);
+
+      if (!transition->id)
+        continue;
+
+      if (i != j)
+        g_array_index (transitions, MxTransition, j) = *transition;
+      j++;
+    }
+  g_array_set_size (transitions, j);
+
+  mx_transition_schedule ();
+}
+
+static void
+mx_transition_clock_new_frame_cb (ClutterTimeline *timeline,
+                                  gint             msecs,
+                                  gpointer         user_data)
+{
+  mx_transition_tick ();
+}
+
+static gboolean
+mx_transition_step_cb (gpointer user_data)
+{
+  transition_step_source = 0;
+  mx_transition_tick ();
+
+  return FALSE;
+}
+
+/* Runs the timeline while there are transitions that change on every
+ * frame, otherwise waits for the next step of the stepped ones */
+static void
+mx_transition_schedule (void)
+{
+  gdouble next_step = -1;
+  guint i;
+
+  if (transition_step_source)
+    {
+      g_source_remove (transition_step_source);
+      transition_step_source = 0;
+    }
+
+  for (i = 0; i < transitions->len; i++)
+    {
+      MxTransition *transition = &g_array_index (transitions, MxTransition, i);
+      gdouble step, remaining;
+
+      if (!transition->id)
+        continue;
+
+      if (!transition->n_steps || !transition->duration)
+        {
+          if (!clutter_timeline_is_playing (transition_clock))
+            clutter_timeline_start (transition_clock);
+          return;
+        }
+
+      step = transition->duration / (gdouble) transition->n_steps;
+      remaining = step - fmod (transition->elapsed, step);
+      if (next_step < 0 || remaining < next_step)
+        next_step = remaining;
+    }
+
+  clutter_timeline_stop (transition_clock);
+
+  if (next_step >= 0)
+    transition_step_source =
+      clutter_threads_add_timeout_full (CLUTTER_PRIORITY_REDRAW,
+                                        MAX (1, (guint) ceil (next_step)),
+                                        mx_transition_step_cb,
+                                        NULL, NULL);
+}
+
+static guint
+mx_transition_add (guint                duration,
+                   guint                n_steps,
+                   gulong               mode,
+                   MxTransitionFunc     frame_func,
+                   MxTransitionDoneFunc done_func,
+                   gpointer             user_data)
+{
+  MxTransition transition;
+  gint64 now;
+
+  if (!transitions)
+    {
+      transitions = g_array_new (FALSE, FALSE, sizeof (MxTransition));
+
+      /* The duration is irrelevant, the time is measured on each tick */
+      transition_clock = clutter_timeline_new (1000);
+      clutter_timeline_set_loop (transition_clock, TRUE);
+      g_signal_connect (transition_clock, "new-frame",
+                        G_CALLBACK (mx_transition_clock_new_frame_cb), NULL);
+    }
+
+  if (++transition_last_id == 0)
+    transition_last_id = 1;
+
+  /* The next tick adds the time since the last one, so start from the
+   * time of the last tick to only count the time since now */
+  now = g_get_monotonic_time ();
+  if (!transitions->len)
+    transition_last_time = now;
+
+  transition.id = transition_last_id;
+  transition.duration = duration;
+  transition.n_steps = n_steps;
+  transition.mode = mode;
+  transition.elapsed = (transition_last_time - now) / 1000.0;
+  transition.frame_func = frame_func;
+  transition.done_func = done_func;
+  transition.user_data = user_data;
+
+  g_array_append_val (transitions, transition);
+
+  /* A running timeline ticks every transition, otherwise the clock may
+   * need to start or wake up earlier */
+  if (!clutter_timeline_is_playing (transition_clock))
+    mx_transition_schedule ();
+
+  return transition.id;
+}
+
+/*
+ * _mx_transition_start:
+ * @duration: The duration of the transition, in milliseconds
+ * @mode: The #ClutterAnimationMode used to ease the progress
+ * @frame_func: (allow-none): Function called on each frame
+ * @done_func: (allow-none): Function called when the transition completes
+ * @user_data: Data passed to @frame_func and @done_func
+ *
+ * Starts a transition ticked by the shared frame clock. @frame_func is
+ * called on each frame with the eased progress, including a final call
+ * with the progress at 1.0, after which @done_func is called. If
+ * @done_func returns %TRUE, the transition starts over.
+ *
+ * Returns: An identifier for the transition, to pass to
+ *   _mx_transition_stop()
+ */
+guint
+_mx_transition_start (guint                duration,
+                      gulong               mode,
+                      MxTransitionFunc     frame_func,
+                      MxTransitionDoneFunc done_func,
+                      gpointer             user_data)
+{
+  return mx_transition_add (duration, 0, mode,
+                            frame_func, done_func, user_data);
+}
+
+/*
+ * _mx_transition_start_stepped:
+ * @duration: The duration of the transition, in milliseconds
+ * @n_steps: The number of steps the transition is shown in
+ * @frame_func: (allow-none): Function called to update the transition
+ * @done_func: (allow-none): Function called when the transition completes
+ * @user_data: Data passed to @frame_func and @done_func
+ *
+ * Like _mx_transition_start() with %CLUTTER_LINEAR, for a transition that
+ * only changes @n_steps times over @duration. While only stepped
+ * transitions are running, @frame_func is called at each step rather than
+ * on every frame.
+ *
+ * Returns: An identifier for the transition, to pass to
+ *   _mx_transition_stop()
+ */
+guint
+_mx_transition_start_stepped (guint                duration,
+                              guint                n_steps,
+                              MxTransitionFunc     frame_func,
+                              MxTransitionDoneFunc done_func,
+                              gpointer             user_data)
+{
+  return mx_transition_add (duration, n_steps, CLUTTER_LINEAR,
+                            frame_func, done_func, user_data);
+}
+
+/*
+ * _mx_transition_stop:
+ * @id: A transition identifier returned by _mx_transition_start()
+ *
+ * Stops a transition without calling its done function.
+ */
+void
+_mx_transition_stop (guint id)
+{
+  guint i;
+
+  if (!id || !transitions)
+    return;
+
+  for (i = 0; i < transitions->len; i++)
+    {
+      MxTransition *transition = &g_array_index (transitions, MxTransition, i);
+
+      if (transition->id == id)
+        {
+          transition->id = 0;
+          break;
+        }
+    }
+}
+
+static gdouble
+mx_transition_ease_out_bounce (gdouble p)
+{
+  if (p < 1 / 2.75)
+    return 7.5625 * p * p;
+  else if (p < 2 / 2.75)
+    {
+      p -= 1.5 / 2.75;
+      return 7.5625 * p * p + 0.75;
+    }
+  else if (p < 2.5 / 2.75)
+    {
+      p -= 2.25 / 2.75;
+      return 7.5625 * p * p + 0.9375;
+    }
+  else
+    {
+      p -= 2.625 / 2.75;
+      return 7.5625 * p * p + 0.984375;
+    }
+}
+
+/*
+ * _mx_transition_ease:
+ * @mode: A #ClutterAnimationMode
+ * @p: The progress, between 0.0 and 1.0
+ *
+ * Applies the easing function of @mode to @p, with the same results as a
+ * #ClutterAlpha using @mode.
+ *
+ * Returns: The eased progress
+ */
+gdouble
+_mx_transition_ease (gulong  mode,
+                     gdouble p)
+{
+  static ClutterTimeline *ease_timeline = NULL;
+  static ClutterAlpha *ease_alpha = NULL;
+  gdouble s, period;
+
+  switch (mode)
+    {
+    case CLUTTER_CUSTOM_MODE:
+    case CLUTTER_LINEAR:
+      return p;
+
+    case CLUTTER_EASE_IN_QUAD:
+      return p * p;
+    case CLUTTER_EASE_OUT_QUAD:
+      return -p * (p - 2);
+    case CLUTTER_EASE_IN_OUT_QUAD:
+      p *= 2;
+      if (p < 1)
+        return 0.5 * p * p;
+      p -= 1;
+      return -0.5 * (p * (p - 2) - 1);
+
+    case CLUTTER_EASE_IN_CUBIC:
+      return p * p * p;
+    case CLUTTER_EASE_OUT_CUBIC:
+      p -= 1;
+      return p * p * p + 1;
+    case CLUTTER_EASE_IN_OUT_CUBIC:
+      p *= 2;
+      if (p < 1)
+        return 0.5 * p * p * p;
+      p -= 2;
+      return 0.5 * (p * p * p + 2);
+
+    case CLUTTER_EASE_IN_QUART:
+      return p * p * p * p;
+    case CLUTTER_EASE_OUT_QUART:
+      p -= 1;
+      return -(p * p * p * p - 1);
+    case CLUTTER_EASE_IN_OUT_QUART:
+      p *= 2;
+      if (p < 1)
+        return 0.5 * p * p * p * p;
+      p -= 2;
+      return -0.5 * (p * p * p * p - 2);
+
+    case CLUTTER_EASE_IN_QUINT:
+      return p * p * p * p * p;
+    case CLUTTER_EASE_OUT_QUINT:
+      p -= 1;
+      return p * p * p * p * p + 1;
+    case CLUTTER_EASE_IN_OUT_QUINT:
+      p *= 2;
+      if (p < 1)
+        return 0.5 * p * p * p * p * p;
+      p -= 2;
+      return 0.5 * (p * p * p * p * p + 2);
+
+    case CLUTTER_EASE_IN_SINE:
+      return -cos (p * G_PI_2) + 1;
+    case CLUTTER_EASE_OUT_SINE:
+      return sin (p * G_PI_2);
+    case CLUTTER_EASE_IN_OUT_SINE:
+      return -0.5 * (cos (p * G_PI) - 1);
+
+    case CLUTTER_EASE_IN_EXPO:
+      return (p == 0) ? 0 : pow (2, 10 * (p - 1));
+    case CLUTTER_EASE_OUT_EXPO:
+      return (p == 1) ? 1 : -pow (2, -10 * p) + 1;
+    case CLUTTER_EASE_IN_OUT_EXPO:
+      if (p == 0)
+        return 0;
+      if (p == 1)
+        return 1;
+      p *= 2;
+      if (p < 1)
+        return 0.5 * pow (2, 10 * (p - 1));
+      p -= 1;
+      return 0.5 * (-pow (2, -10 * p) + 2);
+
+    case CLUTTER_EASE_IN_CIRC:
+      return -(sqrt (1 - p * p) - 1);
+    case CLUTTER_EASE_OUT_CIRC:
+      p -= 1;
+      return sqrt (1 - p * p);
+    case CLUTTER_EASE_IN_OUT_CIRC:
+      p *= 2;
+      if (p < 1)
+        return -0.5 * (sqrt (1 - p * p) - 1);
+      p -= 2;
+      return 0.5 * (sqrt (1 - p * p) + 1);
+
+    /* The elastic period is relative to the duration, so these are
+     * written in terms of the progress */
+    case CLUTTER_EASE_IN_ELASTIC:
+      if (p == 1)
+        return 1;
+      period = 0.3;
+      s = period / 4;
+      p -= 1;
+      return -(pow (2, 10 * p) * sin ((p - s) * (2 * G_PI) / period));
+    case CLUTTER_EASE_OUT_ELASTIC:
+      if (p == 1)
+        return 1;
+      period = 0.3;
+      s = period / 4;
+      return pow (2, -10 * p) * sin ((p - s) * (2 * G_PI) / period) + 1;
+    case CLUTTER_EASE_IN_OUT_ELASTIC:
+      if (p == 1)
+        return 1;
+      period = 0.3 * 1.5;
+      s = period / 4;
+      p = p * 2 - 1;
+      if (p < 0)
+        return -0.5 * (pow (2, 10 * p) * sin ((p - s) * (2 * G_PI) / period));
+      return pow (2, -10 * p) * sin ((p - s) * (2 * G_PI) / period) * 0.5 + 1;
+
+    case CLUTTER_EASE_IN_BACK:
+      s = 1.70158;
+      return p * p * ((s + 1) * p - s);
+    case CLUTTER_EASE_OUT_BACK:
+      s = 1.70158;
+      p -= 1;
+      return p * p * ((s + 1) * p + s) + 1;
+    case CLUTTER_EASE_IN_OUT_BACK:
+      s = 1.70158 * 1.525;
+      p *= 2;
+      if (p < 1)
+        return 0.5 * (p * p * ((s + 1) * p - s));
+      p -= 2;
+      return 0.5 * (p * p * ((s + 1) * p + s) + 2);
+
+    case CLUTTER_EASE_IN_BOUNCE:
+      return 1 - mx_transition_ease_out_bounce (1 - p);
+    case CLUTTER_EASE_OUT_BOUNCE:
+      return mx_transition_ease_out_bounce (p);
+    case CLUTTER_EASE_IN_OUT_BOUNCE:
+      if (p < 0.5)
+        return (1 - mx_transition_ease_out_bounce (1 - p * 2)) * 0.5;
+      return mx_transition_ease_out_bounce (p * 2 - 1) * 0.5 + 0.5;
+
+    default:
+      /* Modes registered with clutter_alpha_register_func() can only be
+       * evaluated by a ClutterAlpha, so use one on a stopped timeline */
+      if (!ease_alpha)
+        {
+          ease_timeline = clutter_timeline_new (10000);
+          ease_alpha = clutter_alpha_new_full (ease_timeline, mode);
+        }
+      else
+        clutter_alpha_set_mode (ease_alpha, mode);
+
+      clutter_timeline_advance (ease_timeline, p * 10000);
+
+      return clutter_alpha_get_alpha (ease_alpha);
+    }
+}
@@ -47,12 +47,18 @@
  * be selective about the area of its child that is painted/picked. Therefore
  * if the child is very large or contains a lot of children, you will experience
  * poor performance.
+ *
+ * If the child is expensive to paint but rarely changes, scrolling can be
+ * made cheaper by enabling #MxViewport:cached-scrolling. The child is then
+ * rendered into offscreen tiles, and only the tiles that become visible or
+ * that the child redraws are rendered again.
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
 #include <string.h>
+#include <math.h>
 #include <clutter/clutter.h>
 
 #include "mx-viewport.h"
@@ -79,6 +85,25 @@ G_DEFINE_TYPE_WITH_CODE (MxViewport, mx_viewport, MX_TYPE_BIN,
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), MX_TYPE_VIEWPORT, \
                                 MxViewportPrivate))
 
+/* size in pixels of the square tiles used for cached scrolling */
+#define TILE_SIZE 256
+
+/* tiles are keyed by their column and row packed into an integer */
+#define TILE_KEY(column, row) \
+  GUINT_TO_POINTER (((guint) (column) << 16) | ((guint) (row) & 0xffff))
+
+typedef struct
+{
+  gint        column;
+  gint        row;
+
+  CoglHandle  texture;
+  CoglHandle  fbo;
+  CoglHandle  material;
+
+  guint       valid : 1;
+} MxViewportTile;
+
 struct _MxViewportPrivate
 {
   gfloat        x;
@@ -89,6 +114,17 @@ struct _MxViewportPrivate
   MxAdjustment *vadjustment;
 
   gboolean      sync_adjustments;
+
+  /* cached scrolling */
+  gboolean         cached_scrolling;
+  GHashTable      *tiles;
+  ClutterActor    *child;
+  ClutterActorBox  child_box;
+  guint8           tiles_opacity;
+
+  /* The last damaged box of each actor that queued a redraw, so the area
+   * it moved or shrank from is rendered again */
+  GHashTable      *damage_boxes;
 };
 
 enum
@@ -100,7 +136,8 @@ enum
   PROP_Z_ORIGIN,
   PROP_HADJUST,
   PROP_VADJUST,
-  PROP_SYNC_ADJUST
+  PROP_SYNC_ADJUST,
+  PROP_CACHED_SCROLLING
 };
 
 static void
@@ -141,6 +178,10 @@ mx_viewport_get_property (GObject    *object,
       g_value_set_boolean (value, priv->sync_adjustments);
       break;
 
+    case PROP_CACHED_SCROLLING:
+      g_value_set_boolean (value, priv->cached_scrolling);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -195,17 +236,246 @@ mx_viewport_set_property (GObject      *object,
       mx_viewport_set_sync_adjustments (viewport, g_value_get_boolean (value));
       break;
 
+    case PROP_CACHED_SCROLLING:
+      mx_viewport_set_cached_scrolling (viewport, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
     }
 }
 
+static void
+mx_viewport_tile_free (MxViewportTile *tile)
+{
+  cogl_handle_unref (tile->material);
+  cogl_handle_unref (tile->fbo);
+  cogl_handle_unref (tile->texture);
+
+  g_slice_free (MxViewportTile, tile);
+}
+
+static MxViewportTile *
+mx_viewport_tile_new (gint column,
+                      gint row)
+{
+  MxViewportTile *tile;
+  CoglHandle texture, fbo;
+
+  texture = cogl_texture_new_with_size (TILE_SIZE, TILE_SIZE,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  if (texture == COGL_INVALID_HANDLE)
+    return NULL;
+
+  fbo = cogl_offscreen_new_to_texture (texture);
+  if (fbo == COGL_INVALID_HANDLE)
+    {
+      cogl_handle_unref (texture);
+      return NULL;
+    }
+
+  tile = g_slice_new0 (MxViewportTile);
+  tile->column = column;
+  tile->row = row;
+  tile->texture = texture;
+  tile->fbo = fbo;
+  tile->material = cogl_material_new ();
+  cogl_material_set_layer (tile->material, 0, texture);
+
+  /* the child is painted in the coordinates of the viewport, offset to
+   * the position of the tile */
+  cogl_push_framebuffer (fbo);
+  cogl_set_viewport (0, 0, TILE_SIZE, TILE_SIZE);
+  cogl_ortho (0, TILE_SIZE, TILE_SIZE, 0, -1000, 1000);
+  cogl_pop_framebuffer ();
+
+  return tile;
+}
+
+static void
+mx_viewport_tile_render (MxViewportTile *tile,
+                         ClutterActor   *child)
+{
+  CoglColor zero_color;
+
+  cogl_push_framebuffer (tile->fbo);
+  cogl_push_matrix ();
+
+  cogl_color_set_from_4ub (&zero_color, 0x00, 0x00, 0x00, 0x00);
+  cogl_clear (&zero_color,
+              COGL_BUFFER_BIT_COLOR |
+              COGL_BUFFER_BIT_STENCIL |
+              COGL_BUFFER_BIT_DEPTH);
+
+  cogl_translate (-tile->column * TILE_SIZE, -tile->row * TILE_SIZE, 0);
+  clutter_actor_paint (child);
+
+  cogl_pop_matrix ();
+  cogl_pop_framebuffer ();
+
+  tile->valid = TRUE;
+}
+
+/* after a relayout, the actors may no longer be where they were last
+ * damaged */
+static void
+mx_viewport_forget_damage_boxes (MxViewport *viewport)
+{
+  MxViewportPrivate *priv = viewport->priv;
+
+  if (priv->damage_boxes)
+    _mx_damage_boxes_clear (priv->damage_boxes);
+}
+
+static void
+mx_viewport_invalidate_tiles (MxViewport            *viewport,
+                              const ClutterActorBox *box)
+{
+  MxViewportPrivate *priv = viewport->priv;
+  GHashTableIter iter;
+  MxViewportTile *tile;
+
+  if (!priv->tiles)
+    return;
+
+  g_hash_table_iter_init (&iter, priv->tiles);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &tile))
+    {
+      if (box &&
+          ((tile->column + 1) * TILE_SIZE <= box->x1 ||
+           tile->column * TILE_SIZE >= box->x2 ||
+           (tile->row + 1) * TILE_SIZE <= box->y1 ||
+           tile->row * TILE_SIZE >= box->y2))
+        continue;
+
+      tile->valid = FALSE;
+    }
+}
+
+static void
+mx_viewport_child_queue_redraw_cb (ClutterActor *child,
+                                   ClutterActor *origin,
+                                   MxViewport   *viewport)
+{
+  MxViewportPrivate *priv = viewport->priv;
+  ClutterActorBox paint_box, damage, old_box;
+  gfloat x[4], y[4];
+  gint i;
+
+  /* The damage is the paint box of the actor that queued the redraw, in
+   * the coordinates of the viewport. The scroll offset is only applied
+   * when painting, so it isn't part of the transformation.
+   */
+  if (origin == child)
+    {
+      mx_viewport_invalidate_tiles (viewport, NULL);
+      return;
+    }
+
+  if (!clutter_actor_get_paint_box (origin, &paint_box))
+    goto unknown_damage;
+
+  x[0] = x[2] = paint_box.x1;
+  x[1] = x[3] = paint_box.x2;
+  y[0] = y[1] = paint_box.y1;
+  y[2] = y[3] = paint_box.y2;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (!clutter_actor_transform_stage_point (CLUTTER_ACTOR (viewport),
+                                                x[i], y[i], &x[i], &y[i]))
+        goto unknown_damage;
+    }
+
+  damage.x1 = MIN (MIN (x[0], x[1]), MIN (x[2], x[3]));
+  damage.x2 = MAX (MAX (x[0], x[1]), MAX (x[2], x[3]));
+  damage.y1 = MIN (MIN (y[0], y[1]), MIN (y[2], y[3]));
+  damage.y2 = MAX (MAX (y[0], y[1]), MAX (y[2], y[3]));
+
+  /* Also render again the area the actor was last damaged at, in case it
+   * shrank or moved, e.g. with a new scale or rotation. If we don't know
+   * where that is, render everything.
+   */
+  if (_mx_damage_boxes_update (priv->damage_boxes, origin, &damage,
+                               &old_box))
+    mx_viewport_invalidate_tiles (viewport, &old_box);
+  else
+    mx_viewport_invalidate_tiles (viewport, NULL);
+
+  mx_viewport_invalidate_tiles (viewport, &damage);
+  return;
+
+unknown_damage:
+  /* the next damage can't be limited to where the actor is now either */
+  _mx_damage_boxes_remove (priv->damage_boxes, origin);
+
+  mx_viewport_invalidate_tiles (viewport, NULL);
+}
+
+static void
+mx_viewport_child_queue_relayout_cb (ClutterActor *child,
+                                     MxViewport   *viewport)
+{
+  /* anything inside the child may move */
+  mx_viewport_forget_damage_boxes (viewport);
+  mx_viewport_invalidate_tiles (viewport, NULL);
+}
+
+static void
+mx_viewport_child_notify_cb (MxViewport *viewport)
+{
+  MxViewportPrivate *priv = viewport->priv;
+  ClutterActor *child;
+
+  child = priv->cached_scrolling ? mx_bin_get_child (MX_BIN (viewport)) : NULL;
+
+  if (priv->child == child)
+    return;
+
+  if (priv->child)
+    {
+      g_signal_handlers_disconnect_by_func (priv->child,
+                                            mx_viewport_child_queue_redraw_cb,
+                                            viewport);
+      g_signal_handlers_disconnect_by_func (priv->child,
+                                            mx_viewport_child_queue_relayout_cb,
+                                            viewport);
+    }
+
+  priv->child = child;
+  mx_viewport_forget_damage_boxes (viewport);
+
+  if (child)
+    {
+      g_signal_connect (child, "queue-redraw",
+                        G_CALLBACK (mx_viewport_child_queue_redraw_cb),
+                        viewport);
+      g_signal_connect (child, "queue-relayout",
+                        G_CALLBACK (mx_viewport_child_queue_relayout_cb),
+                        viewport);
+    }
+
+  mx_viewport_invalidate_tiles (viewport, NULL);
+}
+
 static void
 mx_viewport_dispose (GObject *gobject)
 {
   MxViewportPrivate *priv = MX_VIEWPORT (gobject)->priv;
 
+  if (priv->tiles)
+    {
+      priv->cached_scrolling = FALSE;
+      mx_viewport_child_notify_cb (MX_VIEWPORT (gobject));
+
+      g_hash_table_destroy (priv->tiles);
+      priv->tiles = NULL;
+      _mx_damage_boxes_free (priv->damage_boxes);
+      priv->damage_boxes = NULL;
+    }
+
   if (priv->hadjustment)
     {
       g_object_unref (priv->hadjustment);
@@ -221,6 +491,96 @@ mx_viewport_dispose (GObject *gobject)
   G_OBJECT_CLASS (mx_viewport_parent_class)->dispose (gobject);
 }
 
+static gboolean
+mx_viewport_remove_hidden_tile (gpointer        key,
+                                MxViewportTile *tile,
+                                gint           *range)
+{
+  return (tile->column < range[0] || tile->column > range[1] ||
+          tile->row < range[2] || tile->row > range[3]);
+}
+
+static void
+mx_viewport_paint_tiles (MxViewport *viewport)
+{
+  MxViewportPrivate *priv = viewport->priv;
+  ClutterActorBox box, visible;
+  gint column, row, range[4];
+  guint8 opacity;
+
+  /* the opacity of the ancestors is part of the rendered tiles */
+  opacity = clutter_actor_get_paint_opacity (priv->child);
+  if (opacity != priv->tiles_opacity)
+    {
+      mx_viewport_invalidate_tiles (viewport, NULL);
+      priv->tiles_opacity = opacity;
+    }
+
+  clutter_actor_get_allocation_box (CLUTTER_ACTOR (viewport), &box);
+
+  visible.x1 = MAX ((int) priv->x, priv->child_box.x1);
+  visible.y1 = MAX ((int) priv->y, priv->child_box.y1);
+  visible.x2 = MIN ((int) priv->x + box.x2 - box.x1, priv->child_box.x2);
+  visible.y2 = MIN ((int) priv->y + box.y2 - box.y1, priv->child_box.y2);
+
+  if (visible.x2 <= visible.x1 || visible.y2 <= visible.y1)
+    {
+      g_hash_table_remove_all (priv->tiles);
+      return;
+    }
+
+  range[0] = floorf (visible.x1 / TILE_SIZE);
+  range[1] = ceilf (visible.x2 / TILE_SIZE) - 1;
+  range[2] = floorf (visible.y1 / TILE_SIZE);
+  range[3] = ceilf (visible.y2 / TILE_SIZE) - 1;
+
+  /* create the missing tiles before drawing any, so that the child isn't
+   * painted on top of some tiles if there is no offscreen support */
+  for (row = range[2]; row <= range[3]; row++)
+    for (column = range[0]; column <= range[1]; column++)
+      {
+        MxViewportTile *tile;
+
+        if (g_hash_table_lookup (priv->tiles, TILE_KEY (column, row)))
+          continue;
+
+        tile = mx_viewport_tile_new (column, row);
+        if (!tile)
+          {
+            /* no offscreen support, paint the child directly */
+            clutter_actor_paint (priv->child);
+            return;
+          }
+
+        g_hash_table_insert (priv->tiles, TILE_KEY (column, row), tile);
+      }
+
+  for (row = range[2]; row <= range[3]; row++)
+    for (column = range[0]; column <= range[1]; column++)
+      {
+        MxViewportTile *tile;
+
+        tile = g_hash_table_lookup (priv->tiles, TILE_KEY (column, row));
+
+        if (!tile->valid)
+          mx_viewport_tile_render (tile, priv->child);
+
+        cogl_set_source (tile->material);
+        cogl_rectangle (column * TILE_SIZE, row * TILE_SIZE,
+                        (column + 1) * TILE_SIZE, (row + 1) * TILE_SIZE);
+      }
+
+  /* keep a margin of one tile so that scrolling back and forth doesn't
+   * keep creating the same tiles */
+  range[0]--;
+  range[1]++;
+  range[2]--;
+  range[3]++;
+  g_hash_table_foreach_remove (priv->tiles,
+                               (GHRFunc) mx_viewport_remove_hidden_tile,
+                               range);
+}
+
 static void
 mx_viewport_paint (ClutterActor *self)
 {
@@ -232,7 +592,16 @@ mx_viewport_paint (ClutterActor *self)
                   (int) priv->y * -1,
                   (int) priv->z * -1);
 
-  CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->paint (self);
+  if (priv->cached_scrolling && priv->child)
+    {
+      /* paint the background, then the cached child */
+      CLUTTER_ACTOR_CLASS (g_type_class_peek (MX_TYPE_WIDGET))->paint (self);
+
+      if (CLUTTER_ACTOR_IS_VISIBLE (priv->child))
+        mx_viewport_paint_tiles (MX_VIEWPORT (self));
+    }
+  else
+    CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->paint (self);
 
   cogl_pop_matrix ();
 }
@@ -241,7 +610,18 @@ static void
 mx_viewport_pick (ClutterActor       *self,
                   const ClutterColor *color)
 {
-  mx_viewport_paint (self);
+  MxViewportPrivate *priv = MX_VIEWPORT (self)->priv;
+
+  /* picking always goes through the real child */
+  cogl_push_matrix ();
+
+  cogl_translate ((int) priv->x * -1,
+                  (int) priv->y * -1,
+                  (int) priv->z * -1);
+
+  CLUTTER_ACTOR_CLASS (mx_viewport_parent_class)->paint (self);
+
+  cogl_pop_matrix ();
 }
 
 static void
@@ -327,6 +707,12 @@ mx_viewport_allocate (ClutterActor          *self,
       child_box.y2 = child_box.y1 + height;
 
       clutter_actor_allocate (child, &child_box, flags);
+
+      if (!clutter_actor_box_equal (&child_box, &priv->child_box))
+        {
+          priv->child_box = child_box;
+          mx_viewport_invalidate_tiles (MX_VIEWPORT (self), NULL);
+        }
     }
   else
     {
@@ -341,6 +727,7 @@ mx_viewport_allocate (ClutterActor          *self,
     {
       if (priv->hadjustment)
         {
+          mx_adjustment_freeze (priv->hadjustment);
           g_object_set (G_OBJECT (priv->hadjustment),
                         "lower", 0.0,
                         "page-size", available_width,
@@ -348,10 +735,12 @@ mx_viewport_allocate (ClutterActor          *self,
                         "page-increment", available_width / 3,
                         "step-increment", available_width / 12,
                         NULL);
+          mx_adjustment_thaw (priv->hadjustment);
         }
 
       if (priv->vadjustment)
         {
+          mx_adjustment_freeze (priv->vadjustment);
           g_object_set (G_OBJECT (priv->vadjustment),
                         "lower", 0.0,
                         "page-size", available_height,
@@ -359,6 +748,7 @@ mx_viewport_allocate (ClutterActor          *self,
                         "page-increment", available_height / 3,
                         "step-increment", available_height / 12,
                         NULL);
+          mx_adjustment_thaw (priv->vadjustment);
         }
     }
 }
@@ -410,6 +800,15 @@ mx_viewport_class_init (MxViewportClass *klass)
                                 MX_PARAM_READWRITE);
   g_object_class_install_property (gobject_class, PROP_SYNC_ADJUST, pspec);
 
+  pspec = g_param_spec_boolean ("cached-scrolling",
+                                "Cached scrolling",
+                                "Whether to render the child into offscreen "
+                                "tiles that are reused when scrolling",
+                                FALSE,
+                                MX_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_CACHED_SCROLLING,
+                                   pspec);
+
   g_object_class_override_property (gobject_class,
                                     PROP_HADJUST,
                                     "horizontal-adjustment");
@@ -503,6 +902,18 @@ scrollable_set_adjustments (MxScrollable *scrollable,
     }
 }
 
+/* unlike mx_scrollable_get_adjustments(), doesn't create the adjustments */
+void
+_mx_viewport_get_adjustments (MxViewport    *viewport,
+                              MxAdjustment **hadjustment,
+                              MxAdjustment **vadjustment)
+{
+  if (hadjustment)
+    *hadjustment = viewport->priv->hadjustment;
+  if (vadjustment)
+    *vadjustment = viewport->priv->vadjustment;
+}
+
 static void
 scrollable_get_adjustments (MxScrollable  *scrollable,
                             MxAdjustment **hadjustment,
@@ -581,6 +992,9 @@ mx_viewport_init (MxViewport *self)
                 "x-align", MX_ALIGN_START,
                 "y-align", MX_ALIGN_START,
                 NULL);
+
+  g_signal_connect (self, "notify::child",
+                    G_CALLBACK (mx_viewport_child_notify_cb), NULL);
 }
 
 ClutterActor *
@@ -678,3 +1092,72 @@ mx_viewport_get_sync_adjustments (MxViewport *viewport)
   g_return_val_if_fail (MX_IS_VIEWPORT (viewport), FALSE);
   return viewport->priv->sync_adjustments;
 }
+
+/**
+ * mx_viewport_set_cached_scrolling:
+ * @viewport: A #MxViewport
+ * @cached_scrolling: %TRUE to enable cached scrolling
+ *
+ * Sets whether the child of @viewport is rendered into offscreen tiles
+ * that are kept while scrolling. Only the tiles that become visible, and
+ * the tiles covering the parts of the child that are redrawn, are
+ * rendered again.
+ *
+ * The tiles are rendered with an orthographic projection, so this should
+ * not be used for children with perspective transformations.
+ *
+ * Since: 1.6
+ */
+void
+mx_viewport_set_cached_scrolling (MxViewport *viewport,
+                                  gboolean    cached_scrolling)
+{
+  MxViewportPrivate *priv;
+
+  g_return_if_fail (MX_IS_VIEWPORT (viewport));
+
+  priv = viewport->priv;
+  if (priv->cached_scrolling == cached_scrolling)
+    return;
+
+  priv->cached_scrolling = cached_scrolling;
+
+  if (cached_scrolling)
+    {
+      priv->tiles =
+        g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                               (GDestroyNotify) mx_viewport_tile_free);
+      priv->damage_boxes = _mx_damage_boxes_new ();
+    }
+
+  mx_viewport_child_notify_cb (viewport);
+
+  if (!cached_scrolling)
+    {
+      g_hash_table_destroy (priv->tiles);
+      priv->tiles = NULL;
+      _mx_damage_boxes_free (priv->damage_boxes);
+      priv->damage_boxes = NULL;
+    }
+
+  g_object_notify (G_OBJECT (viewport), "cached-scrolling");
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (viewport));
+}
+
+/**
+ * mx_viewport_get_cached_scrolling:
+ * @viewport: A #MxViewport
+ *
+ * Gets whether cached scrolling is enabled on @viewport.
+ *
+ * Returns: %TRUE if the child is rendered into offscreen tiles
+ *
+ * Since: 1.6
+ */
+gboolean
+mx_viewport_get_cached_scrolling (MxViewport *viewport)
+{
+  g_return_val_if_fail (MX_IS_VIEWPORT (viewport), FALSE);
+  return viewport->priv->cached_scrolling;
+}
@@ -90,6 +90,10 @@ void mx_viewport_set_sync_adjustments (MxViewport *viewport,
                                        gboolean    sync);
 gboolean mx_viewport_get_sync_adjustments (MxViewport *viewport);
 
+void mx_viewport_set_cached_scrolling (MxViewport *viewport,
+                                       gboolean    cached_scrolling);
+gboolean mx_viewport_get_cached_scrolling (MxViewport *viewport);
+
 G_END_DECLS
 
 #endif /* __MX_VIEWPORT_H__ */
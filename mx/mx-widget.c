@@ -60,6 +60,8 @@ struct _MxWidgetPrivate
 
   ClutterActor *border_image;
   ClutterActor *old_border_image;
+  guint         old_border_image_fade;
+  guint8        old_border_image_opacity;
   ClutterActor *background_image;
   ClutterColor *bg_color;
 
@@ -261,6 +263,27 @@ mx_widget_set_tooltip_timeout (MxWidget *widget)
                                  widget);
 }
 
+/* removes the border-image that is fading out, if any */
+static void
+mx_widget_remove_old_border_image (MxWidget *self)
+{
+  MxWidgetPrivate *priv = self->priv;
+
+  if (priv->old_border_image_fade)
+    {
+      _mx_transition_stop (priv->old_border_image_fade);
+      priv->old_border_image_fade = 0;
+    }
+
+  if (priv->old_border_image)
+    {
+      g_object_remove_weak_pointer (G_OBJECT (priv->old_border_image),
+                                    (gpointer)&priv->old_border_image);
+      clutter_actor_unparent (priv->old_border_image);
+      priv->old_border_image = NULL;
+    }
+}
+
 static void
 mx_widget_dispose (GObject *gobject)
 {
@@ -279,13 +302,7 @@ mx_widget_dispose (GObject *gobject)
       priv->border_image = NULL;
     }
 
-  if (priv->old_border_image)
-    {
-      g_object_remove_weak_pointer (G_OBJECT (priv->old_border_image),
-                                    (gpointer)&priv->old_border_image);
-      clutter_actor_unparent (priv->old_border_image);
-      priv->old_border_image = NULL;
-    }
+  mx_widget_remove_old_border_image (actor);
 
   if (priv->background_image)
     {
@@ -562,9 +579,25 @@ mx_widget_unmap (ClutterActor *actor)
 }
 
 static void
-old_background_faded_cb (ClutterAnimation *animation, ClutterActor *self)
+old_background_fade_cb (gdouble  alpha,
+                        gpointer user_data)
 {
-  clutter_actor_unparent (self);
+  MxWidgetPrivate *priv = MX_WIDGET (user_data)->priv;
+
+  if (priv->old_border_image)
+    clutter_actor_set_opacity (priv->old_border_image,
+                               priv->old_border_image_opacity * (1 - alpha));
+}
+
+static gboolean
+old_background_faded_cb (gpointer user_data)
+{
+  MxWidget *self = user_data;
+
+  self->priv->old_border_image_fade = 0;
+  mx_widget_remove_old_border_image (self);
+
+  return FALSE;
 }
 
 /* TODO: move to mx-types.c */
@@ -679,24 +712,18 @@ mx_widget_style_changed (MxStylable *self, MxStyleChangedFlags flags)
         }
       else
         {
-          if (priv->old_border_image)
-            {
-              g_object_remove_weak_pointer (G_OBJECT (priv->old_border_image),
-                                            (gpointer)&priv->old_border_image);
-              clutter_actor_unparent (priv->old_border_image);
-            }
+          mx_widget_remove_old_border_image (MX_WIDGET (self));
 
           priv->old_border_image = priv->border_image;
+          priv->old_border_image_opacity =
+            clutter_actor_get_opacity (priv->old_border_image);
           g_object_add_weak_pointer (G_OBJECT (priv->old_border_image),
                                      (gpointer)&priv->old_border_image);
-          clutter_actor_animate (priv->old_border_image,
-                                 CLUTTER_LINEAR,
-                                 duration,
-                                 "opacity", 0x0,
-                                 "signal-after::completed",
-                                   old_background_faded_cb,
-                                   priv->old_border_image,
-                                 NULL);
+          priv->old_border_image_fade =
+            _mx_transition_start (duration, CLUTTER_LINEAR,
+                                  old_background_fade_cb,
+                                  old_background_faded_cb,
+                                  self);
         }
 
       priv->border_image = NULL;
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * perf-deform: benchmark the MxDeformTexture deformation paths.
+ *
+ * Each deformation is painted for a number of frames, with its period
+ * changing every frame ("animated") or not at all ("static"), deforming on
+ * the CPU with one thread or with the default number of threads, and in a
+ * vertex shader. Every case is run in a freshly forked process, as the
+ * number of deformation threads is fixed once it has been read from
+ * MX_DEFORM_THREADS.
+ *
+ * Nothing needs to be interacted with, so it can be run on a virtual
+ * display such as Xvfb. One CSV row is printed per case:
+ *
+ *   deformation,tiles_x,tiles_y,path,threads,mode,frames,
+ *   mean_ms,min_ms,max_ms,status
+ *
+ * Frames are painted with clutter_stage_read_pixels(), so the timings
+ * include waiting for the GPU to finish drawing.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <mx/mx.h>
+
+#define STAGE_SIZE 512
+#define TEXTURE_SIZE 256
+
+typedef enum
+{
+  PATH_CPU_SINGLE,
+  PATH_CPU_THREADED,
+  PATH_SHADER,
+
+  N_PATHS
+} PerfPath;
+
+static const gchar *path_names[N_PATHS] =
+{
+  "cpu",
+  "cpu",
+  "shader"
+};
+
+static const gchar *modes[] = { "animated", "static" };
+
+static gint tiles = 200;
+static gint frames = 100;
+static gchar *output_file = NULL;
+
+static GOptionEntry entries[] =
+{
+  { "tiles", 't', 0, G_OPTION_ARG_INT, &tiles,
+    "Number of tiles on each axis of the mesh (default: 200)", "N" },
+  { "frames", 'f', 0, G_OPTION_ARG_INT, &frames,
+    "Number of frames painted for each case (default: 100)", "N" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_file,
+    "Write the results to FILE instead of stdout", "FILE" },
+  { NULL }
+};
+
+static ClutterActor *
+create_texture (void)
+{
+  gint x, y;
+  guchar *data, *p;
+  ClutterActor *texture;
+
+  p = data = g_malloc (TEXTURE_SIZE * TEXTURE_SIZE * 3);
+  for (y = 0; y < TEXTURE_SIZE; y++)
+    for (x = 0; x < TEXTURE_SIZE; x++)
+      {
+        p[0] = x;
+        p[1] = y;
+        p[2] = ((x / 16) + (y / 16)) % 2 ? 0xff : 0x00;
+        p += 3;
+      }
+
+  texture = clutter_texture_new ();
+  clutter_texture_set_from_rgb_data (CLUTTER_TEXTURE (texture), data, FALSE,
+                                     TEXTURE_SIZE, TEXTURE_SIZE,
+                                     TEXTURE_SIZE * 3, 3, 0, NULL);
+  g_free (data);
+
+  return texture;
+}
+
+static void
+run_case (FILE        *out,
+          GType        type,
+          PerfPath     path,
+          const gchar *mode)
+{
+  gint i;
+  GTimer *timer;
+  gboolean animated;
+  ClutterActor *stage, *deform;
+  gdouble elapsed, total, min, max;
+
+  if ((path == PATH_SHADER) &&
+      !cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+    {
+      fprintf (out, "%s,%d,%d,%s,%s,%s,0,0,0,0,unsupported\n",
+               g_type_name (type), tiles, tiles, path_names[path], "1",
+               mode);
+      return;
+    }
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_set_size (stage, STAGE_SIZE, STAGE_SIZE);
+  clutter_actor_show (stage);
+
+  deform = g_object_new (type, NULL);
+  mx_deform_texture_set_resolution (MX_DEFORM_TEXTURE (deform), tiles, tiles);
+  mx_deform_texture_set_textures (MX_DEFORM_TEXTURE (deform),
+                                  (ClutterTexture *)create_texture (),
+                                  NULL);
+  mx_deform_texture_set_use_shader (MX_DEFORM_TEXTURE (deform),
+                                    path == PATH_SHADER);
+  clutter_actor_set_size (deform, STAGE_SIZE, STAGE_SIZE);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), deform);
+
+  g_object_set (G_OBJECT (deform), "period", 0.5, NULL);
+
+  /* Paint once to create the buffers */
+  g_free (clutter_stage_read_pixels (CLUTTER_STAGE (stage), 0, 0, 1, 1));
+
+  animated = g_str_equal (mode, "animated");
+  timer = g_timer_new ();
+  total = max = 0.0;
+  min = G_MAXDOUBLE;
+
+  for (i = 0; i < frames; i++)
+    {
+      g_timer_start (timer);
+
+      if (animated)
+        g_object_set (G_OBJECT (deform),
+                      "period", 0.25 + (0.5 * i) / frames,
+                      NULL);
+
+      g_free (clutter_stage_read_pixels (CLUTTER_STAGE (stage), 0, 0, 1, 1));
+
+      elapsed = g_timer_elapsed (timer, NULL) * 1000.0;
+      total += elapsed;
+      min = MIN (min, elapsed);
+      max = MAX (max, elapsed);
+    }
+
+  fprintf (out, "%s,%d,%d,%s,%s,%s,%d,%.3f,%.3f,%.3f,ok\n",
+           g_type_name (type), tiles, tiles, path_names[path],
+           (path == PATH_CPU_THREADED) ? "auto" : "1", mode, frames,
+           total / frames, min, max);
+  fflush (out);
+
+  g_timer_destroy (timer);
+  clutter_actor_destroy (deform);
+}
+
+static gboolean
+run_case_in_child (FILE        *out,
+                   int         *argc,
+                   char      ***argv,
+                   GType        type,
+                   PerfPath     path,
+                   const gchar *mode)
+{
+  pid_t pid;
+  int status;
+
+  /* Flush before forking so buffered output isn't written twice */
+  fflush (out);
+
+  pid = fork ();
+  if (pid < 0)
+    return FALSE;
+
+  if (pid == 0)
+    {
+      if (path == PATH_CPU_THREADED)
+        g_unsetenv ("MX_DEFORM_THREADS");
+      else
+        g_setenv ("MX_DEFORM_THREADS", "1", TRUE);
+
+      if (clutter_init (argc, argv) != CLUTTER_INIT_SUCCESS)
+        _exit (1);
+
+      run_case (out, type, path, mode);
+
+      _exit (0);
+    }
+
+  if (waitpid (pid, &status, 0) < 0)
+    return FALSE;
+
+  return WIFEXITED (status) && (WEXITSTATUS (status) == 0);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GType types[3];
+  gint i, j, path;
+  FILE *out;
+
+  context = g_option_context_new ("- MxDeformTexture benchmark");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, clutter_get_option_group_without_init ());
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  if ((tiles < 1) || (frames < 1))
+    {
+      g_printerr ("The number of tiles and frames must be positive\n");
+      return 1;
+    }
+
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+  g_thread_init (NULL);
+#endif
+  g_type_init ();
+
+  types[0] = MX_TYPE_DEFORM_PAGE_TURN;
+  types[1] = MX_TYPE_DEFORM_WAVES;
+  types[2] = MX_TYPE_DEFORM_BOW_TIE;
+
+  if (output_file)
+    {
+      out = fopen (output_file, "w");
+      if (!out)
+        {
+          g_printerr ("Unable to open '%s' for writing\n", output_file);
+          return 1;
+        }
+    }
+  else
+    out = stdout;
+
+  fprintf (out, "deformation,tiles_x,tiles_y,path,threads,mode,frames,"
+                "mean_ms,min_ms,max_ms,status\n");
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++)
+    for (path = 0; path < N_PATHS; path++)
+      for (j = 0; j < G_N_ELEMENTS (modes); j++)
+        if (!run_case_in_child (out, &argc, &argv, types[i], path, modes[j]))
+          g_printerr ("Case %s/%s/%s failed to run\n",
+                      g_type_name (types[i]), path_names[path], modes[j]);
+
+  if (out != stdout)
+    fclose (out);
+
+  return 0;
+}
@@ -0,0 +1,574 @@
+/*
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * perf-image: benchmark the MxImage decode/scale/upload pipeline.
+ *
+ * A corpus of PNG and JPEG files is generated from a fixed seed, so the
+ * results are comparable between runs and machines. Every case is run in
+ * freshly forked processes, which keeps the texture cache cold and gives a
+ * meaningful peak RSS for each case.
+ *
+ * One CSV row is printed per case and iteration:
+ *
+ *   format,width,height,method,iteration,file_bytes,
+ *   decode_ms,upload_ms,loaded_ms,peak_rss_kb,status
+ *
+ * decode_ms is the time gdk-pixbuf takes to decode (and scale) the file on
+ * its own and upload_ms is the time Cogl takes to create a texture from the
+ * decoded pixels. Both are measured in a process of their own, so they
+ * don't warm up the file cache or the pixbuf loaders for the MxImage run.
+ * loaded_ms is the time from the MxImage call until the image is ready
+ * (for the asynchronous path, until #MxImage::image-loaded) and
+ * peak_rss_kb is the peak RSS of the process that ran it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include <mx/mx.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#define CORPUS_SEED 0x6d78
+
+typedef enum
+{
+  METHOD_FILE,
+  METHOD_FILE_AT_SIZE,
+  METHOD_BUFFER,
+  METHOD_ASYNC_FILE,
+
+  N_METHODS
+} PerfMethod;
+
+static const gchar *method_names[N_METHODS] =
+{
+  "file",
+  "file-at-size",
+  "buffer",
+  "async-file"
+};
+
+static const gchar *formats[] = { "png", "jpeg" };
+static const gint sizes[] = { 128, 512, 1024, 2048 };
+
+static gint iterations = 3;
+static gchar *corpus_dir = NULL;
+static gchar *output_file = NULL;
+static gchar *only_method = NULL;
+
+static GOptionEntry entries[] =
+{
+  { "iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+    "Number of runs of each case (default: 3)", "N" },
+  { "corpus", 'c', 0, G_OPTION_ARG_FILENAME, &corpus_dir,
+    "Directory to generate the image corpus in", "DIR" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_file,
+    "Write the results to FILE instead of stdout", "FILE" },
+  { "method", 'm', 0, G_OPTION_ARG_STRING, &only_method,
+    "Only run METHOD (file, file-at-size, buffer or async-file)", "METHOD" },
+  { NULL }
+};
+
+typedef struct
+{
+  gsize    file_bytes;
+  gdouble  decode;
+  gdouble  upload;
+  gdouble  loaded;
+  glong    peak_rss;
+  gboolean success;
+} PerfResult;
+
+typedef void (*PerfFunc) (const gchar *filename,
+                          gint         size,
+                          PerfMethod   method,
+                          PerfResult  *result);
+
+typedef struct
+{
+  GMainLoop *loop;
+  GTimer    *timer;
+  gdouble    loaded;
+  gboolean   success;
+} PerfAsyncData;
+
+static gchar *
+corpus_filename (const gchar *format,
+                 gint         size)
+{
+  gchar *basename, *filename;
+
+  basename = g_strdup_printf ("perf-image-%d.%s", size,
+                              g_str_equal (format, "jpeg") ? "jpg" : "png");
+  filename = g_build_filename (corpus_dir, basename, NULL);
+  g_free (basename);
+
+  return filename;
+}
+
+static gboolean
+generate_corpus (GError **error)
+{
+  GRand *rand;
+  gint i, j;
+
+  if (g_mkdir_with_parents (corpus_dir, 0755) != 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   "Unable to create corpus directory '%s'", corpus_dir);
+      return FALSE;
+    }
+
+  rand = g_rand_new_with_seed (CORPUS_SEED);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      GdkPixbuf *pixbuf;
+      gint x, y, size, rowstride;
+      guchar *pixels;
+
+      size = sizes[i];
+      pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, size, size);
+      pixels = gdk_pixbuf_get_pixels (pixbuf);
+      rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+      /* A gradient with some noise, so that neither format can compress the
+       * image down to nothing */
+      for (y = 0; y < size; y++)
+        {
+          guchar *p = pixels + y * rowstride;
+
+          for (x = 0; x < size; x++, p += 4)
+            {
+              guint noise = g_rand_int_range (rand, 0, 32);
+
+              p[0] = (x * 255 / size) ^ noise;
+              p[1] = (y * 255 / size) ^ noise;
+              p[2] = ((x + y) * 127 / size) ^ noise;
+              p[3] = 0xff;
+            }
+        }
+
+      for (j = 0; j < G_N_ELEMENTS (formats); j++)
+        {
+          gboolean success;
+          gchar *filename = corpus_filename (formats[j], size);
+
+          if (g_str_equal (formats[j], "jpeg"))
+            {
+              GdkPixbuf *opaque = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE,
+                                                  8, size, size);
+
+              gdk_pixbuf_copy_area (pixbuf, 0, 0, size, size, opaque, 0, 0);
+              success = gdk_pixbuf_save (opaque, filename, "jpeg", error,
+                                         "quality", "90", NULL);
+              g_object_unref (opaque);
+            }
+          else
+            success = gdk_pixbuf_save (pixbuf, filename, "png", error, NULL);
+
+          g_free (filename);
+
+          if (!success)
+            {
+              g_object_unref (pixbuf);
+              g_rand_free (rand);
+              return FALSE;
+            }
+        }
+
+      g_object_unref (pixbuf);
+    }
+
+  g_rand_free (rand);
+
+  return TRUE;
+}
+
+static glong
+get_peak_rss (void)
+{
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    return -1;
+
+  /* ru_maxrss is in kilobytes on Linux */
+  return usage.ru_maxrss;
+}
+
+static gdouble
+measure_decode (const gchar  *filename,
+                PerfMethod    method,
+                gint          size,
+                GdkPixbuf   **pixbuf_out)
+{
+  GdkPixbuf *pixbuf;
+  GTimer *timer;
+  gdouble elapsed;
+
+  timer = g_timer_new ();
+
+  if (method == METHOD_FILE_AT_SIZE)
+    pixbuf = gdk_pixbuf_new_from_file_at_size (filename, size / 2, size / 2,
+                                               NULL);
+  else
+    pixbuf = gdk_pixbuf_new_from_file (filename, NULL);
+
+  elapsed = g_timer_elapsed (timer, NULL) * 1000.0;
+
+  g_timer_destroy (timer);
+
+  *pixbuf_out = pixbuf;
+
+  return elapsed;
+}
+
+static gdouble
+measure_upload (GdkPixbuf *pixbuf)
+{
+  CoglHandle texture;
+  GTimer *timer;
+  gdouble elapsed;
+
+  if (!pixbuf)
+    return 0.0;
+
+  timer = g_timer_new ();
+
+  texture =
+    cogl_texture_new_from_data (gdk_pixbuf_get_width (pixbuf),
+                                gdk_pixbuf_get_height (pixbuf),
+                                COGL_TEXTURE_NO_ATLAS,
+                                gdk_pixbuf_get_has_alpha (pixbuf)
+                                ? COGL_PIXEL_FORMAT_RGBA_8888
+                                : COGL_PIXEL_FORMAT_RGB_888,
+                                COGL_PIXEL_FORMAT_ANY,
+                                gdk_pixbuf_get_rowstride (pixbuf),
+                                gdk_pixbuf_get_pixels (pixbuf));
+  cogl_flush ();
+
+  elapsed = g_timer_elapsed (timer, NULL) * 1000.0;
+
+  g_timer_destroy (timer);
+
+  if (texture != COGL_INVALID_HANDLE)
+    cogl_handle_unref (texture);
+
+  return elapsed;
+}
+
+static void
+image_loaded_cb (MxImage       *image,
+                 PerfAsyncData *data)
+{
+  cogl_flush ();
+
+  data->loaded = g_timer_elapsed (data->timer, NULL) * 1000.0;
+  data->success = TRUE;
+
+  g_main_loop_quit (data->loop);
+}
+
+static void
+image_load_error_cb (MxImage       *image,
+                     GError        *error,
+                     PerfAsyncData *data)
+{
+  data->loaded = g_timer_elapsed (data->timer, NULL) * 1000.0;
+  data->success = FALSE;
+
+  g_main_loop_quit (data->loop);
+}
+
+/* times decoding and uploading the file without MxImage, to break
+ * loaded_ms down */
+static void
+run_breakdown (const gchar *filename,
+               gint         size,
+               PerfMethod   method,
+               PerfResult  *result)
+{
+  GdkPixbuf *pixbuf;
+
+  result->decode = measure_decode (filename, method, size, &pixbuf);
+  result->upload = measure_upload (pixbuf);
+  result->success = (pixbuf != NULL);
+
+  if (pixbuf)
+    g_object_unref (pixbuf);
+}
+
+static void
+run_load (const gchar *filename,
+          gint         size,
+          PerfMethod   method,
+          PerfResult  *result)
+{
+  ClutterActor *image;
+  gchar *contents;
+  gsize length;
+  gboolean success;
+  GTimer *timer;
+  GError *error;
+
+  error = NULL;
+  if (!g_file_get_contents (filename, &contents, &length, &error))
+    {
+      g_warning ("%s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  image = mx_image_new ();
+  g_object_ref_sink (image);
+  mx_image_set_transition_duration (MX_IMAGE (image), 0);
+
+  timer = g_timer_new ();
+
+  switch (method)
+    {
+    case METHOD_FILE:
+      success = mx_image_set_from_file (MX_IMAGE (image), filename, NULL);
+      break;
+
+    case METHOD_FILE_AT_SIZE:
+      success = mx_image_set_from_file_at_size (MX_IMAGE (image), filename,
+                                                size / 2, size / 2, NULL);
+      break;
+
+    case METHOD_BUFFER:
+      /* The buffer is handed over to the image, which frees it */
+      success = mx_image_set_from_buffer (MX_IMAGE (image),
+                                          (guchar *) contents, length,
+                                          g_free, NULL);
+      contents = NULL;
+      break;
+
+    case METHOD_ASYNC_FILE:
+      {
+        PerfAsyncData data = { 0, };
+
+        data.loop = g_main_loop_new (NULL, FALSE);
+        data.timer = timer;
+
+        g_signal_connect (image, "image-loaded",
+                          G_CALLBACK (image_loaded_cb), &data);
+        g_signal_connect (image, "image-load-error",
+                          G_CALLBACK (image_load_error_cb), &data);
+
+        g_timer_start (timer);
+        mx_image_set_load_async (MX_IMAGE (image), TRUE);
+        success = mx_image_set_from_file (MX_IMAGE (image), filename, NULL);
+
+        if (success)
+          {
+            g_main_loop_run (data.loop);
+            success = data.success;
+          }
+
+        g_main_loop_unref (data.loop);
+      }
+      break;
+
+    default:
+      g_assert_not_reached ();
+      success = FALSE;
+    }
+
+  cogl_flush ();
+
+  result->file_bytes = length;
+  result->loaded = g_timer_elapsed (timer, NULL) * 1000.0;
+  result->peak_rss = get_peak_rss ();
+  result->success = success;
+
+  g_timer_destroy (timer);
+  g_object_unref (image);
+  g_free (contents);
+}
+
+/* runs @func in a freshly forked process and passes its result back
+ * through a pipe */
+static gboolean
+run_in_child (int          *argc,
+              char       ***argv,
+              PerfFunc      func,
+              const gchar  *filename,
+              gint          size,
+              PerfMethod    method,
+              PerfResult   *result)
+{
+  pid_t pid;
+  int status, fds[2];
+  ssize_t n_read;
+
+  if (pipe (fds) != 0)
+    return FALSE;
+
+  pid = fork ();
+  if (pid < 0)
+    {
+      close (fds[0]);
+      close (fds[1]);
+      return FALSE;
+    }
+
+  if (pid == 0)
+    {
+      PerfResult child_result = { 0, };
+
+      close (fds[0]);
+
+      if (clutter_init (argc, argv) != CLUTTER_INIT_SUCCESS)
+        _exit (1);
+
+      func (filename, size, method, &child_result);
+
+      if (write (fds[1], &child_result, sizeof (child_result)) !=
+          sizeof (child_result))
+        _exit (1);
+
+      _exit (0);
+    }
+
+  close (fds[1]);
+  n_read = read (fds[0], result, sizeof (PerfResult));
+  close (fds[0]);
+
+  if (waitpid (pid, &status, 0) < 0)
+    return FALSE;
+
+  return (n_read == sizeof (PerfResult)) &&
+    WIFEXITED (status) && (WEXITSTATUS (status) == 0);
+}
+
+static gboolean
+run_case (FILE         *out,
+          int          *argc,
+          char       ***argv,
+          const gchar  *format,
+          gint          size,
+          PerfMethod    method,
+          gint          iteration)
+{
+  PerfResult breakdown = { 0, }, load = { 0, };
+  gchar *filename;
+  gboolean success;
+
+  filename = corpus_filename (format, size);
+
+  success = run_in_child (argc, argv, run_breakdown, filename, size, method,
+                          &breakdown) &&
+    run_in_child (argc, argv, run_load, filename, size, method, &load);
+
+  g_free (filename);
+
+  if (!success)
+    return FALSE;
+
+  fprintf (out, "%s,%d,%d,%s,%d,%" G_GSIZE_FORMAT ",%.3f,%.3f,%.3f,%ld,%s\n",
+           format, size, size, method_names[method], iteration,
+           load.file_bytes, breakdown.decode, breakdown.upload, load.loaded,
+           load.peak_rss,
+           (breakdown.success && load.success) ? "ok" : "error");
+  fflush (out);
+
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  gint i, j, method, iteration;
+  FILE *out;
+
+  context = g_option_context_new ("- MxImage loading benchmark");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, clutter_get_option_group_without_init ());
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+  g_option_context_free (context);
+
+#if !GLIB_CHECK_VERSION (2, 31, 0)
+  g_thread_init (NULL);
+#endif
+  g_type_init ();
+
+  if (!corpus_dir)
+    corpus_dir = g_build_filename (g_get_tmp_dir (), "mx-perf-image", NULL);
+
+  if (!generate_corpus (&error))
+    {
+      g_printerr ("Failed to generate corpus: %s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+
+  if (output_file)
+    {
+      out = fopen (output_file, "w");
+      if (!out)
+        {
+          g_printerr ("Unable to open '%s' for writing\n", output_file);
+          return 1;
+        }
+    }
+  else
+    out = stdout;
+
+  fprintf (out, "format,width,height,method,iteration,file_bytes,"
+                "decode_ms,upload_ms,loaded_ms,peak_rss_kb,status\n");
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    for (j = 0; j < G_N_ELEMENTS (sizes); j++)
+      for (method = 0; method < N_METHODS; method++)
+        {
+          if (only_method && !g_str_equal (only_method, method_names[method]))
+            continue;
+
+          for (iteration = 0; iteration < iterations; iteration++)
+            if (!run_case (out, &argc, &argv, formats[i], sizes[j],
+                           method, iteration))
+              g_printerr ("Case %s/%d/%s failed to run\n",
+                          formats[i], sizes[j], method_names[method]);
+        }
+
+  if (out != stdout)
+    fclose (out);
+
+  return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2012 Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * test-deform-shader: check that the vertex shader deformations of
+ * MxDeformPageTurn, MxDeformBowTie and MxDeformWaves match the CPU ones.
+ *
+ * Each deformation is drawn at a few points of its animation, once with
+ * MxDeformTexture:use-shader disabled and once with it enabled, and the
+ * contents of the stage are compared. Run it with a software renderer (for
+ * example with LIBGL_ALWAYS_SOFTWARE=1) for reproducible results.
+ *
+ * Rasterisation of the two paths may differ by a pixel along the edges of
+ * the mesh, so a small fraction of pixels is allowed to differ by more than
+ * the colour tolerance. The exit status is 0 when everything matches, 1 on
+ * a mismatch and 77 when GLSL isn't available.
+ *
+ * MxDeformTexture falls back to the CPU with a warning when a shader fails
+ * to compile or link, which would make both reads come from the CPU, so
+ * warnings abort the test.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+
+#include <mx/mx.h>
+
+#define STAGE_SIZE 256
+#define TEXTURE_SIZE 64
+
+/* The maximum difference of a colour channel, to cover rounding */
+#define COLOR_TOLERANCE 4
+
+/* The maximum fraction of pixels allowed to exceed the tolerance */
+#define MAX_MISMATCH_FRACTION 0.01
+
+static ClutterActor *
+create_texture (guint8 r, guint8 g, guint8 b)
+{
+  gint x, y;
+  guchar *data, *p;
+  ClutterActor *texture;
+
+  /* A checker board, so that misplaced vertices show up */
+  p = data = g_malloc (TEXTURE_SIZE * TEXTURE_SIZE * 3);
+  for (y = 0; y < TEXTURE_SIZE; y++)
+    for (x = 0; x < TEXTURE_SIZE; x++)
+      {
+        gboolean light = ((x / 8) + (y / 8)) % 2;
+
+        p[0] = light ? r : r / 4;
+        p[1] = light ? g : g / 4;
+        p[2] = light ? b : b / 4;
+        p += 3;
+      }
+
+  texture = clutter_texture_new ();
+  clutter_texture_set_from_rgb_data (CLUTTER_TEXTURE (texture), data, FALSE,
+                                     TEXTURE_SIZE, TEXTURE_SIZE,
+                                     TEXTURE_SIZE * 3, 3, 0, NULL);
+  g_free (data);
+
+  return texture;
+}
+
+static guchar *
+read_stage (ClutterActor *stage,
+            ClutterActor *deform,
+            gboolean      use_shader)
+{
+  mx_deform_texture_set_use_shader (MX_DEFORM_TEXTURE (deform), use_shader);
+
+  return clutter_stage_read_pixels (CLUTTER_STAGE (stage), 0, 0,
+                                    STAGE_SIZE, STAGE_SIZE);
+}
+
+static gboolean
+compare (ClutterActor *stage,
+         ClutterActor *deform,
+         const gchar  *description)
+{
+  gint i, c, max_diff, n_mismatched;
+  guchar *cpu, *shader;
+  gdouble fraction;
+
+  cpu = read_stage (stage, deform, FALSE);
+  shader = read_stage (stage, deform, TRUE);
+
+  max_diff = n_mismatched = 0;
+  for (i = 0; i < STAGE_SIZE * STAGE_SIZE; i++)
+    {
+      gboolean mismatched = FALSE;
+
+      for (c = 0; c < 4; c++)
+        {
+          gint diff = ABS (cpu[i * 4 + c] - shader[i * 4 + c]);
+
+          max_diff = MAX (max_diff, diff);
+          if (diff > COLOR_TOLERANCE)
+            mismatched = TRUE;
+        }
+
+      if (mismatched)
+        n_mismatched ++;
+    }
+
+  g_free (cpu);
+  g_free (shader);
+
+  fraction = n_mismatched / (gdouble)(STAGE_SIZE * STAGE_SIZE);
+  printf ("%-32s max difference %3d, %5.2f%% of pixels differ: %s\n",
+          description, max_diff, fraction * 100.0,
+          (fraction <= MAX_MISMATCH_FRACTION) ? "ok" : "FAIL");
+
+  return (fraction <= MAX_MISMATCH_FRACTION);
+}
+
+static ClutterActor *
+create_deform (ClutterActor *stage,
+               GType         type)
+{
+  ClutterActor *deform = g_object_new (type, NULL);
+
+  mx_deform_texture_set_resolution (MX_DEFORM_TEXTURE (deform), 64, 64);
+  mx_deform_texture_set_textures (MX_DEFORM_TEXTURE (deform),
+                                  (ClutterTexture *)
+                                  create_texture (0xff, 0xc0, 0x40),
+                                  (ClutterTexture *)
+                                  create_texture (0x40, 0xc0, 0xff));
+  clutter_actor_set_size (deform, STAGE_SIZE, STAGE_SIZE);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), deform);
+
+  return deform;
+}
+
+int
+main (int argc, char *argv[])
+{
+  guint i;
+  gchar *description;
+  gboolean success;
+  ClutterActor *stage, *deform;
+
+  static const gdouble periods[] = { 0.0, 0.25, 0.5, 0.75 };
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  if (!cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+    {
+      printf ("GLSL is not available, skipping\n");
+      return 77;
+    }
+
+  g_log_set_always_fatal (G_LOG_LEVEL_WARNING | G_LOG_LEVEL_CRITICAL);
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_set_size (stage, STAGE_SIZE, STAGE_SIZE);
+  clutter_actor_show (stage);
+
+  success = TRUE;
+
+  deform = create_deform (stage, MX_TYPE_DEFORM_PAGE_TURN);
+  for (i = 0; i < G_N_ELEMENTS (periods); i++)
+    {
+      g_object_set (G_OBJECT (deform),
+                    "period", periods[i],
+                    "angle", G_PI / 4,
+                    NULL);
+      description = g_strdup_printf ("page-turn, period %.2f", periods[i]);
+      success &= compare (stage, deform, description);
+      g_free (description);
+    }
+  clutter_actor_destroy (deform);
+
+  deform = create_deform (stage, MX_TYPE_DEFORM_BOW_TIE);
+  for (i = 0; i < G_N_ELEMENTS (periods); i++)
+    {
+      g_object_set (G_OBJECT (deform), "period", periods[i], NULL);
+      description = g_strdup_printf ("bow-tie, period %.2f", periods[i]);
+      success &= compare (stage, deform, description);
+      g_free (description);
+    }
+  clutter_actor_destroy (deform);
+
+  deform = create_deform (stage, MX_TYPE_DEFORM_WAVES);
+  for (i = 0; i < G_N_ELEMENTS (periods); i++)
+    {
+      g_object_set (G_OBJECT (deform),
+                    "period", periods[i] * 4,
+                    "amplitude", 0.5,
+                    NULL);
+      description = g_strdup_printf ("waves, period %.2f", periods[i] * 4);
+      success &= compare (stage, deform, description);
+      g_free (description);
+    }
+  clutter_actor_destroy (deform);
+
+  return success ? 0 : 1;
+}
@@ -41,6 +41,72 @@ notify_elastic_cb (MxToggle     *toggle,
   mx_adjustment_set_elastic (vadjust, on);
 }
 
+/* Where a kinetic scroll predicted it would stop, checked against where
+ * it actually stops */
+static gdouble predicted_values[2];
+
+static void
+predict_value (MxAdjustment *adjustment,
+               gfloat        area_start,
+               gfloat        area_end,
+               gdouble      *predicted)
+{
+  gdouble value, page_size;
+
+  value = mx_adjustment_get_value (adjustment);
+  page_size = mx_adjustment_get_page_size (adjustment);
+
+  /* the predicted area spans from the current page to the final one */
+  if (area_start < value)
+    *predicted = area_start;
+  else
+    *predicted = area_end - page_size;
+}
+
+static void
+check_value (MxAdjustment *adjustment,
+             const gchar  *name,
+             gdouble       predicted)
+{
+  gdouble value = mx_adjustment_get_value (adjustment);
+
+  if (ABS (value - predicted) > 1.0)
+    g_warning ("Kinetic scroll predicted a %s value of %.2f, but stopped "
+               "at %.2f", name, predicted, value);
+  else
+    g_print ("Kinetic scroll stopped at the predicted %s value %.2f\n",
+             name, value);
+}
+
+static void
+notify_state_cb (MxKineticScrollView *kinetic,
+                 GParamSpec          *pspec,
+                 MxScrollable        *view)
+{
+  static MxKineticScrollViewState old_state = MX_KINETIC_SCROLL_VIEW_STATE_IDLE;
+  MxKineticScrollViewState state;
+  MxAdjustment *hadjust, *vadjust;
+  ClutterActorBox area;
+
+  mx_scrollable_get_adjustments (view, &hadjust, &vadjust);
+  g_object_get (kinetic, "state", &state, NULL);
+
+  if (state == MX_KINETIC_SCROLL_VIEW_STATE_SCROLLING &&
+      mx_scrollable_get_predicted_area (view, &area))
+    {
+      predict_value (hadjust, area.x1, area.x2, &predicted_values[0]);
+      predict_value (vadjust, area.y1, area.y2, &predicted_values[1]);
+    }
+  else if (old_state == MX_KINETIC_SCROLL_VIEW_STATE_SCROLLING &&
+           mx_kinetic_scroll_view_get_overshoot (kinetic) <= 0.0)
+    {
+      check_value (hadjust, "horizontal", predicted_values[0]);
+      check_value (vadjust, "vertical", predicted_values[1]);
+    }
+
+  old_state = state;
+}
+
 static gboolean
 true_cb ()
 {
@@ -106,6 +172,8 @@ scroll_view_main (ClutterContainer *stage)
 
   g_signal_connect (overshoot, "notify::active",
                     G_CALLBACK (notify_overshoot_cb), kinetic);
+  g_signal_connect (kinetic, "notify::state",
+                    G_CALLBACK (notify_state_cb), view);
 
   label = mx_label_new_with_text ("Toggle elasticity:");
   elastic = mx_toggle_new ();
@@ -23,6 +23,11 @@
 #include <clutter/clutter.h>
 #include <mx/mx.h>
 
+#define N_ROWS 360
+
+/* the number of rows in the model, including those hidden by the filter */
+static gint n_model_rows = N_ROWS;
+
 static gint
 sort_func (ClutterModel *model,
            const GValue *a,
@@ -91,6 +96,18 @@ key_release_cb (ClutterActor *actor,
       filter_set = !filter_set;
     }
 
+  /* with the filter set, the row of the removed item differs from its row
+   * in the model, and rows hidden by the filter can't be removed */
+  if (event->keyval == 'r' && n_model_rows > 0)
+    {
+      gint n_rows = clutter_model_get_n_rows (model);
+
+      clutter_model_remove (model, g_random_int_range (0, n_model_rows));
+
+      if (clutter_model_get_n_rows (model) < n_rows)
+        n_model_rows--;
+    }
+
   return FALSE;
 }
 
@@ -151,7 +168,7 @@ main (int argc, char *argv[])
   model = clutter_list_model_new (2, CLUTTER_TYPE_COLOR, "color",
                                   G_TYPE_FLOAT, "size");
 
-  for (i = 0; i < 360; i++)
+  for (i = 0; i < N_ROWS; i++)
     {
       clutter_color_from_hls (&color,
                               g_random_double_range (0.0, 360.0), 0.6, 0.6);